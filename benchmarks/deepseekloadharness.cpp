@@ -0,0 +1,386 @@
+// Arnés de carga: lanza peticiones de chat contra DeepSeekMockServer (o
+// contra cualquier URL compatible) a través del mismo planificador, lectores
+// de respuesta (streaming o no) y clasificación de errores que usa el chat,
+// y resume el rendimiento y la distribución de latencias con
+// DeepSeekRequestMetrics.
+//
+//   deepseek_loadharness --requests 500 --concurrency 8 --stream
+//   deepseek_loadharness --serve 8080 --latency 200 --rate-limit 0.05
+//   deepseek_loadharness --serve 8080 --record transcripts.jsonl \
+//       --upstream https://api.deepseek.com --api-key $DEEPSEEK_API_KEY
+//   deepseek_loadharness --replay transcripts.jsonl --concurrency 4
+//
+// Con --serve solo arranca el servidor, para apuntar el plugin a él.
+
+#include "deepseekmockserver.h"
+#include "../deepseekreplyreader.h"
+#include "../deepseekrequestmetrics.h"
+#include "../deepseekrequestscheduler.h"
+#include "../deepseekstreamparser.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QSaveFile>
+#include <QTextStream>
+
+#include <algorithm>
+#include <memory>
+
+using namespace DeepSeek;
+
+namespace {
+
+struct RequestState
+{
+    QElapsedTimer timer;
+    qint64 startedMs = -1;
+    DeepSeekRequestMetrics::Sample sample;
+    std::shared_ptr<DeepSeekStreamParser> parser;
+    std::shared_ptr<DeepSeekReplyReader> reader;
+};
+
+struct Summary
+{
+    int requests = 0;
+    int failed = 0;
+    int protocolErrors = 0;
+    qint64 wallMs = 0;
+    qint64 completionTokens = 0;
+    QHash<QString, int> errors; // por clase
+};
+
+QJsonObject sampleRequest(const QString &model, bool stream, int index)
+{
+    QJsonObject request{
+        {"model", model},
+        {"messages", QJsonArray{
+            QJsonObject{{"role", "system"}, {"content", "You are a helpful AI assistant"}},
+            QJsonObject{{"role", "user"},
+                        {"content", QString("Explain what QPointer is for (request %1).").arg(index)}}}},
+        {"temperature", 0.7},
+        {"max_tokens", 256},
+        {"stream", stream}
+    };
+    if (stream)
+        request["stream_options"] = QJsonObject{{"include_usage", true}};
+    return request;
+}
+
+QJsonObject percentilesJson(const DeepSeekRequestMetrics::Percentiles &p)
+{
+    return QJsonObject{{"samples", p.samples}, {"p50", p.p50}, {"p95", p.p95}, {"p99", p.p99}};
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("deepseek_loadharness");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Load harness and mock server for the DeepSeek plugin");
+    parser.addHelpOption();
+    const QCommandLineOption serveOption("serve", "Only run the mock server on <port>.", "port");
+    const QCommandLineOption urlOption("url", "Target an existing server instead of the mock.", "url");
+    const QCommandLineOption requestsOption("requests", "Requests to send.", "n", "200");
+    const QCommandLineOption concurrencyOption("concurrency", "Concurrent requests.", "n", "4");
+    const QCommandLineOption streamOption("stream", "Use streaming responses.");
+    const QCommandLineOption modelOption("model", "Model name.", "name", "deepseek-chat");
+    const QCommandLineOption latencyOption("latency", "Mock latency before replying.", "ms", "50");
+    const QCommandLineOption tokenRateOption("token-rate", "Mock tokens per second (0 = burst).",
+                                             "n", "200");
+    const QCommandLineOption tokensOption("tokens", "Mock completion tokens.", "n", "64");
+    const QCommandLineOption rateLimitOption("rate-limit", "Fraction answered with 429.", "p", "0");
+    const QCommandLineOption serverErrorOption("server-errors", "Fraction answered with 5xx.",
+                                               "p", "0");
+    const QCommandLineOption stallOption("stalls", "Fraction of responses that stall.", "p", "0");
+    const QCommandLineOption stallMsOption("stall-ms", "How long a stall lasts.", "ms", "60000");
+    const QCommandLineOption seedOption("seed", "Seed for error injection.", "n", "1");
+    const QCommandLineOption idleTimeoutOption("idle-timeout", "Client idle timeout.", "ms",
+                                               "30000");
+    const QCommandLineOption replayOption("replay", "Serve (and send) recorded transcripts.", "file");
+    const QCommandLineOption recordOption("record", "Record transcripts from --upstream.", "file");
+    const QCommandLineOption upstreamOption("upstream", "Real API used when recording.", "url",
+                                            "https://api.deepseek.com");
+    const QCommandLineOption apiKeyOption("api-key", "API key for --upstream or --url "
+                                          "(default: $DEEPSEEK_API_KEY).", "key");
+    const QCommandLineOption jsonOption("json", "Also write the report as JSON.", "file");
+    parser.addOptions({serveOption, urlOption, requestsOption, concurrencyOption, streamOption,
+                       modelOption, latencyOption, tokenRateOption, tokensOption, rateLimitOption,
+                       serverErrorOption, stallOption, stallMsOption, seedOption,
+                       idleTimeoutOption, replayOption, recordOption, upstreamOption,
+                       apiKeyOption, jsonOption});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    const QString apiKey = parser.isSet(apiKeyOption) ? parser.value(apiKeyOption)
+                                                      : qEnvironmentVariable("DEEPSEEK_API_KEY");
+
+    DeepSeekMockServer server;
+    DeepSeekMockServer::Options options;
+    options.latencyMs = parser.value(latencyOption).toInt();
+    options.tokensPerSecond = parser.value(tokenRateOption).toInt();
+    options.completionTokens = parser.value(tokensOption).toInt();
+    options.rateLimitRate = parser.value(rateLimitOption).toDouble();
+    options.serverErrorRate = parser.value(serverErrorOption).toDouble();
+    options.stallRate = parser.value(stallOption).toDouble();
+    options.stallMs = parser.value(stallMsOption).toInt();
+    options.seed = parser.value(seedOption).toUInt();
+    server.setOptions(options);
+
+    QString errorString;
+    if (parser.isSet(replayOption) && !server.loadTranscripts(parser.value(replayOption), &errorString)) {
+        err << "Cannot load transcripts: " << errorString << Qt::endl;
+        return 2;
+    }
+    if (parser.isSet(recordOption))
+        server.setRecording(QUrl(parser.value(upstreamOption)), apiKey, parser.value(recordOption));
+
+    if (parser.isSet(serveOption)) {
+        if (!server.listen(QHostAddress::LocalHost, quint16(parser.value(serveOption).toUInt()),
+                           &errorString)) {
+            err << "Cannot listen: " << errorString << Qt::endl;
+            return 2;
+        }
+        out << "Mock server listening on " << server.baseUrl().toString() << Qt::endl;
+        return app.exec();
+    }
+
+    QUrl baseUrl;
+    if (parser.isSet(urlOption)) {
+        baseUrl = QUrl(parser.value(urlOption));
+    } else {
+        if (!server.listen(QHostAddress::LocalHost, 0, &errorString)) {
+            err << "Cannot listen: " << errorString << Qt::endl;
+            return 2;
+        }
+        baseUrl = server.baseUrl();
+    }
+    QUrl chatUrl = baseUrl;
+    if (!chatUrl.path().endsWith("/v1"))
+        chatUrl.setPath("/v1");
+    chatUrl.setPath(chatUrl.path() + "/chat/completions");
+
+    // Con grabaciones se repiten sus peticiones, para que el servidor las reconozca
+    const QList<QJsonObject> replayRequests = server.transcriptRequests();
+    const int requestCount = parser.value(requestsOption).toInt();
+    const int concurrency = std::max(1, parser.value(concurrencyOption).toInt());
+    const bool stream = parser.isSet(streamOption);
+
+    QNetworkAccessManager manager;
+    DeepSeekRequestScheduler scheduler(&manager);
+    scheduler.setMaxConcurrentPerHost(concurrency);
+    DeepSeekRequestMetrics metrics(std::max(1, requestCount));
+    QHash<DeepSeekRequestScheduler::RequestId, RequestState> states;
+    Summary summary;
+    summary.requests = requestCount;
+    QElapsedTimer wall;
+
+    QObject::connect(&scheduler, &DeepSeekRequestScheduler::started, &app,
+                     [&states, &scheduler](DeepSeekRequestScheduler::RequestId id,
+                                           QNetworkReply *reply) {
+        RequestState &state = states[id];
+        if (scheduler.restarts(id) == 0) {
+            state.startedMs = state.timer.elapsed();
+            state.sample.queueMs = state.startedMs;
+        }
+        if (state.parser)
+            state.parser->reset();
+        if (state.reader)
+            state.reader->reset();
+
+        QObject::connect(reply, &QNetworkReply::requestSent, reply, [&states, id]() {
+            const auto it = states.find(id);
+            if (it != states.end() && it->sample.connectMs < 0)
+                it->sample.connectMs = it->timer.elapsed() - it->startedMs;
+        });
+        QObject::connect(reply, &QNetworkReply::metaDataChanged, reply, [&states, id]() {
+            const auto it = states.find(id);
+            if (it != states.end() && it->sample.firstByteMs < 0)
+                it->sample.firstByteMs = it->timer.elapsed() - it->startedMs;
+        });
+        QObject::connect(reply, &QNetworkReply::downloadProgress, reply,
+                         [&states, id](qint64 received, qint64) {
+                             const auto it = states.find(id);
+                             if (it != states.end())
+                                 it->sample.responseBytes = received;
+                         });
+        QObject::connect(reply, &QNetworkReply::readyRead, reply, [&states, id, reply]() {
+            const auto it = states.find(id);
+            if (it == states.end()
+                || reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() >= 400)
+                return;
+            if (it->parser)
+                it->parser->feed(reply->readAll());
+            else if (it->reader && !it->reader->feed(reply->readAll()))
+                reply->abort(); // como el chat: un documento roto no se sigue leyendo
+        });
+    });
+
+    QObject::connect(&scheduler, &DeepSeekRequestScheduler::finished, &app,
+                     [&](DeepSeekRequestScheduler::RequestId id, QNetworkReply *reply,
+                         DeepSeekRequestScheduler::FinishReason reason) {
+        using ErrorClass = DeepSeekRequestMetrics::ErrorClass;
+        RequestState state = states.take(id);
+        DeepSeekRequestMetrics::Sample &sample = state.sample;
+        sample.totalMs = state.timer.elapsed();
+
+        // Como en el chat: un documento roto es de protocolo aunque se abortara
+        if (state.reader && state.reader->hasError()) {
+            sample.error = ErrorClass::Protocol;
+            ++summary.protocolErrors;
+        }
+        DeepSeekRequestMetrics::classifyFinish(sample, reply, reason);
+
+        // Misma interpretación de la respuesta que el chat
+        if (sample.error == ErrorClass::None) {
+            QJsonObject usage;
+            bool valid = false;
+            if (state.parser) {
+                state.parser->feed(reply->readAll());
+                state.parser->finish();
+                usage = state.parser->usage();
+                valid = !state.parser->hasError() && !state.parser->content().isEmpty();
+            } else if (state.reader) {
+                state.reader->feed(reply->readAll());
+                state.reader->finish();
+                usage = state.reader->usage();
+                valid = !state.reader->hasError() && !state.reader->content().isEmpty();
+            }
+            if (!valid) {
+                sample.error = ErrorClass::Protocol;
+                ++summary.protocolErrors;
+            }
+            sample.promptTokens = usage["prompt_tokens"].toInt(-1);
+            sample.completionTokens = usage["completion_tokens"].toInt(-1);
+            if (sample.completionTokens > 0)
+                summary.completionTokens += sample.completionTokens;
+        }
+
+        if (sample.error != ErrorClass::None) {
+            ++summary.failed;
+            ++summary.errors[DeepSeekRequestMetrics::errorClassName(sample.error)];
+        }
+        metrics.add(sample);
+
+        if (metrics.size() == requestCount) {
+            summary.wallMs = wall.elapsed();
+            QCoreApplication::quit();
+        }
+    });
+
+    wall.start();
+    for (int i = 0; i < requestCount; ++i) {
+        const QJsonObject body = replayRequests.isEmpty()
+                                     ? sampleRequest(parser.value(modelOption), stream, i)
+                                     : replayRequests.at(i % replayRequests.size());
+        const bool streamed = body["stream"].toBool();
+
+        DeepSeekRequestScheduler::Request request;
+        request.request = QNetworkRequest(chatUrl);
+        request.request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+        if (streamed)
+            request.request.setRawHeader("Accept", "text/event-stream");
+        if (!apiKey.isEmpty() && parser.isSet(urlOption))
+            request.request.setRawHeader("Authorization", "Bearer " + apiKey.toUtf8());
+        request.body = QJsonDocument(body).toJson(QJsonDocument::Compact);
+        request.idleTimeoutMs = parser.value(idleTimeoutOption).toInt();
+
+        RequestState state;
+        state.timer.start();
+        state.sample.timestamp = QDateTime::currentDateTime();
+        state.sample.model = body["model"].toString();
+        state.sample.streamed = streamed;
+        state.sample.requestBytes = request.body.size();
+        if (streamed)
+            state.parser = std::make_shared<DeepSeekStreamParser>();
+        else
+            state.reader = std::make_shared<DeepSeekReplyReader>();
+        // enqueue() nunca arranca la petición dentro de la llamada
+        states.insert(scheduler.enqueue(request), state);
+    }
+
+    if (requestCount > 0)
+        app.exec();
+
+    using Field = DeepSeekRequestMetrics::Field;
+    const QList<QPair<QString, Field>> fields{{"queue_ms", Field::Queue},
+                                              {"connect_ms", Field::Connect},
+                                              {"first_byte_ms", Field::FirstByte},
+                                              {"total_ms", Field::Total},
+                                              {"completion_tokens", Field::CompletionTokens}};
+    const double seconds = std::max<qint64>(1, summary.wallMs) / 1000.0;
+    const double requestsPerSecond = (summary.requests - summary.failed) / seconds;
+    const double tokensPerSecond = summary.completionTokens / seconds;
+
+    out << QString("%1 requests to %2, concurrency %3, %4\n")
+               .arg(summary.requests)
+               .arg(chatUrl.toString())
+               .arg(concurrency)
+               .arg(stream ? "streaming" : "non-streaming");
+    out << QString("wall %1 ms, %2 req/s, %3 completion tokens/s, %4 failed\n")
+               .arg(summary.wallMs)
+               .arg(requestsPerSecond, 0, 'f', 1)
+               .arg(tokensPerSecond, 0, 'f', 1)
+               .arg(summary.failed);
+    for (auto it = summary.errors.cbegin(); it != summary.errors.cend(); ++it)
+        out << QString("  %1: %2\n").arg(it.key()).arg(it.value());
+    out << QString("%1 %2 %3 %4\n").arg("", -18).arg("p50", 8).arg("p95", 8).arg("p99", 8);
+    QJsonObject latency;
+    for (const auto &[name, field] : fields) {
+        const DeepSeekRequestMetrics::Percentiles p = metrics.percentiles(field);
+        out << QString("%1 %2 %3 %4\n").arg(name, -18).arg(p.p50, 8).arg(p.p95, 8).arg(p.p99, 8);
+        latency[name] = percentilesJson(p);
+    }
+    const DeepSeekMockServer::Stats serverStats = server.stats();
+    if (serverStats.requests > 0) {
+        out << QString("server: %1 rate limited, %2 server errors, %3 stalled, %4 replayed\n")
+                   .arg(serverStats.rateLimited)
+                   .arg(serverStats.serverErrors)
+                   .arg(serverStats.stalled)
+                   .arg(serverStats.replayed);
+    }
+    out.flush();
+
+    if (parser.isSet(jsonOption)) {
+        QJsonObject errors;
+        for (auto it = summary.errors.cbegin(); it != summary.errors.cend(); ++it)
+            errors[it.key()] = it.value();
+        const QJsonObject report{
+            {"url", chatUrl.toString()},
+            {"requests", summary.requests},
+            {"concurrency", concurrency},
+            {"stream", stream},
+            {"wallMs", summary.wallMs},
+            {"requestsPerSecond", requestsPerSecond},
+            {"completionTokensPerSecond", tokensPerSecond},
+            {"failed", summary.failed},
+            {"errors", errors},
+            {"percentiles", latency}
+        };
+        QSaveFile file(parser.value(jsonOption));
+        if (!file.open(QIODevice::WriteOnly)
+            || file.write(QJsonDocument(report).toJson()) < 0 || !file.commit()) {
+            err << "Cannot write report: " << file.errorString() << Qt::endl;
+            return 2;
+        }
+    }
+
+    // Sin errores inyectados cualquier fallo es una regresión; con ellos,
+    // solo las respuestas 200 que no se pueden interpretar.
+    const bool injecting = options.rateLimitRate > 0 || options.serverErrorRate > 0
+                           || options.stallRate > 0;
+    if (summary.protocolErrors > 0 || (!injecting && summary.failed > 0))
+        return 1;
+    return 0;
+}
@@ -0,0 +1,566 @@
+#include "deepseekmockserver.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QPointer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include <algorithm>
+#include <memory>
+
+namespace DeepSeek {
+
+static constexpr qsizetype MaxHeaderSize = 64 * 1024;
+static constexpr qsizetype MaxBodySize = 64 * 1024 * 1024;
+
+static QByteArray reasonPhrase(int status)
+{
+    switch (status) {
+    case 200: return "OK";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 429: return "Too Many Requests";
+    case 500: return "Internal Server Error";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    default: return "Unknown";
+    }
+}
+
+DeepSeekMockServer::DeepSeekMockServer(QObject *parent)
+    : QObject(parent)
+    , m_server(new QTcpServer(this))
+    , m_random(m_options.seed)
+{
+    connect(m_server, &QTcpServer::newConnection, this, &DeepSeekMockServer::onNewConnection);
+}
+
+DeepSeekMockServer::~DeepSeekMockServer() = default;
+
+void DeepSeekMockServer::setOptions(const Options &options)
+{
+    m_options = options;
+    m_random.seed(options.seed);
+}
+
+bool DeepSeekMockServer::listen(const QHostAddress &address, quint16 port, QString *errorString)
+{
+    if (m_server->listen(address, port))
+        return true;
+    if (errorString)
+        *errorString = m_server->errorString();
+    return false;
+}
+
+quint16 DeepSeekMockServer::port() const
+{
+    return m_server->serverPort();
+}
+
+QUrl DeepSeekMockServer::baseUrl() const
+{
+    QUrl url;
+    url.setScheme("http");
+    url.setHost(m_server->serverAddress().toString());
+    url.setPort(m_server->serverPort());
+    url.setPath("/v1");
+    return url;
+}
+
+QByteArray DeepSeekMockServer::transcriptKey(const QJsonObject &request)
+{
+    // QJsonObject ordena las claves: el JSON compacto ya es canónico
+    return QCryptographicHash::hash(QJsonDocument(request).toJson(QJsonDocument::Compact),
+                                    QCryptographicHash::Sha256);
+}
+
+bool DeepSeekMockServer::loadTranscripts(const QString &filePath, QString *errorString)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorString)
+            *errorString = file.errorString();
+        return false;
+    }
+
+    int lineNumber = 0;
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty())
+            continue;
+
+        QJsonParseError parseError;
+        const QJsonObject object = QJsonDocument::fromJson(line, &parseError).object();
+        if (parseError.error != QJsonParseError::NoError || !object["request"].isObject()) {
+            if (errorString)
+                *errorString = tr("%1:%2: invalid transcript entry").arg(filePath).arg(lineNumber);
+            return false;
+        }
+
+        Transcript transcript;
+        transcript.request = object["request"].toObject();
+        transcript.status = object["status"].toInt(200);
+        transcript.contentType = object["contentType"].toString("application/json").toUtf8();
+        transcript.body = object["body"].toString().toUtf8();
+        m_transcriptIndex.insert(transcriptKey(transcript.request), int(m_transcripts.size()));
+        m_transcripts.append(transcript);
+    }
+    return true;
+}
+
+QList<QJsonObject> DeepSeekMockServer::transcriptRequests() const
+{
+    QList<QJsonObject> requests;
+    requests.reserve(m_transcripts.size());
+    for (const Transcript &transcript : m_transcripts)
+        requests.append(transcript.request);
+    return requests;
+}
+
+void DeepSeekMockServer::setRecording(const QUrl &upstream, const QString &apiKey,
+                                      const QString &filePath)
+{
+    m_upstream = upstream;
+    m_apiKey = apiKey;
+    m_recordPath = filePath;
+    if (!m_upstreamManager)
+        m_upstreamManager = new QNetworkAccessManager(this);
+}
+
+void DeepSeekMockServer::onNewConnection()
+{
+    while (QTcpSocket *socket = m_server->nextPendingConnection()) {
+        m_buffers.insert(socket, {});
+        m_busy.insert(socket, false);
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { onReadyRead(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            m_buffers.remove(socket);
+            m_busy.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void DeepSeekMockServer::onReadyRead(QTcpSocket *socket)
+{
+    if (!m_buffers.contains(socket))
+        return;
+    QByteArray &buffer = m_buffers[socket];
+    buffer += socket->readAll();
+
+    // Una petición por conexión a la vez; el resto espera en el buffer
+    if (m_busy.value(socket))
+        return;
+
+    HttpRequest request;
+    bool malformed = false;
+    if (!takeRequest(buffer, request, malformed)) {
+        if (malformed) {
+            sendError(socket, 400, "invalid_request_error", "Malformed HTTP request", false);
+            m_buffers.remove(socket);
+        }
+        return;
+    }
+
+    m_busy[socket] = true;
+    handleRequest(socket, request);
+}
+
+bool DeepSeekMockServer::takeRequest(QByteArray &buffer, HttpRequest &request, bool &malformed)
+{
+    const qsizetype headerEnd = buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        malformed = buffer.size() > MaxHeaderSize;
+        return false;
+    }
+
+    const QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+    const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+    if (requestLine.size() != 3) {
+        malformed = true;
+        return false;
+    }
+
+    QHash<QByteArray, QByteArray> headers;
+    for (qsizetype i = 1; i < lines.size(); ++i) {
+        const qsizetype colon = lines.at(i).indexOf(':');
+        if (colon > 0)
+            headers.insert(lines.at(i).left(colon).trimmed().toLower(),
+                           lines.at(i).mid(colon + 1).trimmed());
+    }
+
+    bool ok = true;
+    const qint64 length = headers.value("content-length", "0").toLongLong(&ok);
+    if (!ok || length < 0 || length > MaxBodySize) {
+        malformed = true;
+        return false;
+    }
+    if (buffer.size() < headerEnd + 4 + length)
+        return false;
+
+    request.method = requestLine.at(0);
+    request.path = requestLine.at(1);
+    request.headers = headers;
+    request.body = buffer.mid(headerEnd + 4, length);
+    buffer.remove(0, headerEnd + 4 + length);
+    return true;
+}
+
+void DeepSeekMockServer::handleRequest(QTcpSocket *socket, const HttpRequest &request)
+{
+    const bool keepAlive = request.headers.value("connection").toLower() != "close";
+    QByteArray path = request.path;
+    if (const qsizetype query = path.indexOf('?'); query >= 0)
+        path.truncate(query);
+
+    if (path == "/v1/models" || path == "/models") {
+        if (request.method != "GET") {
+            sendError(socket, 405, "invalid_request_error", "Use GET", keepAlive);
+            return;
+        }
+        QJsonArray data;
+        for (const QString &model : std::as_const(m_options.models))
+            data.append(QJsonObject{{"id", model}, {"object", "model"}, {"owned_by", "deepseek"}});
+        const QByteArray body = QJsonDocument(QJsonObject{{"object", "list"}, {"data", data}})
+                                    .toJson(QJsonDocument::Compact);
+        // Peticiones condicionales, como las del catálogo de modelos del plugin
+        const QByteArray etag = '"' + QByteArray::number(qHash(body), 16) + '"';
+        const bool notModified = request.headers.value("if-none-match") == etag;
+        sendResponse(socket, notModified ? 304 : 200, "application/json",
+                     notModified ? QByteArray() : body, keepAlive, {{"ETag", etag}});
+        return;
+    }
+
+    if (path == "/v1/chat/completions" || path == "/chat/completions") {
+        if (request.method != "POST") {
+            sendError(socket, 405, "invalid_request_error", "Use POST", keepAlive);
+            return;
+        }
+        handleChat(socket, request, keepAlive);
+        return;
+    }
+
+    sendError(socket, 404, "invalid_request_error",
+              QString("Unknown endpoint %1").arg(QString::fromUtf8(path)), keepAlive);
+}
+
+void DeepSeekMockServer::handleChat(QTcpSocket *socket, const HttpRequest &request, bool keepAlive)
+{
+    QJsonParseError parseError;
+    const QJsonObject body = QJsonDocument::fromJson(request.body, &parseError).object();
+    if (parseError.error != QJsonParseError::NoError || !body["messages"].isArray()) {
+        sendError(socket, 400, "invalid_request_error", "Body must be a chat completion request",
+                  keepAlive);
+        return;
+    }
+
+    ++m_stats.requests;
+    const bool stream = body["stream"].toBool();
+    if (stream)
+        ++m_stats.streamed;
+
+    if (!m_recordPath.isEmpty()) {
+        record(socket, body, keepAlive);
+        return;
+    }
+
+    // El fallo se decide al llegar, para que la secuencia dependa solo de la semilla
+    const double roll = m_random.generateDouble();
+    const double rateLimitEnd = m_options.rateLimitRate;
+    const double serverErrorEnd = rateLimitEnd + m_options.serverErrorRate;
+    const double stallEnd = serverErrorEnd + m_options.stallRate;
+    const int serverStatus = QList<int>{500, 502, 503}.at(m_random.bounded(3));
+
+    QPointer<QTcpSocket> guard(socket);
+    QTimer::singleShot(m_options.latencyMs, this, [this, guard, body, stream, keepAlive, roll,
+                                                   rateLimitEnd, serverErrorEnd, stallEnd,
+                                                   serverStatus]() {
+        QTcpSocket *socket = guard.data();
+        if (!socket)
+            return;
+
+        if (roll < rateLimitEnd) {
+            ++m_stats.rateLimited;
+            sendResponse(socket, 429, "application/json",
+                         QJsonDocument(QJsonObject{{"error", QJsonObject{
+                                           {"message", "Rate limit reached for requests"},
+                                           {"type", "rate_limit_error"}}}})
+                             .toJson(QJsonDocument::Compact),
+                         keepAlive, {{"Retry-After", "1"}});
+            return;
+        }
+        if (roll < serverErrorEnd) {
+            ++m_stats.serverErrors;
+            sendError(socket, serverStatus, "server_error", "Injected server error", keepAlive);
+            return;
+        }
+        if (roll < stallEnd) {
+            // Con streaming llegan las cabeceras y nada más; sin él, nada
+            ++m_stats.stalled;
+            if (stream) {
+                socket->write("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+                              "Transfer-Encoding: chunked\r\n\r\n");
+            }
+            QTimer::singleShot(m_options.stallMs, socket, [socket]() { socket->abort(); });
+            return;
+        }
+
+        const auto transcript = m_transcriptIndex.constFind(transcriptKey(body));
+        if (transcript != m_transcriptIndex.cend()) {
+            ++m_stats.replayed;
+            const Transcript &recorded = m_transcripts.at(*transcript);
+            if (recorded.status == 200 && recorded.contentType.startsWith("text/event-stream"))
+                sendStream(socket, splitEvents(recorded.body), keepAlive);
+            else
+                sendResponse(socket, recorded.status, recorded.contentType, recorded.body,
+                             keepAlive);
+            return;
+        }
+
+        if (stream)
+            sendStream(socket, syntheticEvents(body), keepAlive);
+        else
+            sendResponse(socket, 200, "application/json",
+                         QJsonDocument(syntheticCompletion(body)).toJson(QJsonDocument::Compact),
+                         keepAlive);
+    });
+}
+
+void DeepSeekMockServer::record(QTcpSocket *socket, const QJsonObject &request, bool keepAlive)
+{
+    // Misma normalización de la URL que el plugin
+    QUrl url = m_upstream;
+    if (!url.path().endsWith("/v1"))
+        url.setPath("/v1");
+    url.setPath(url.path() + "/chat/completions");
+
+    QNetworkRequest upstreamRequest(url);
+    upstreamRequest.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    if (!m_apiKey.isEmpty())
+        upstreamRequest.setRawHeader("Authorization", "Bearer " + m_apiKey.toUtf8());
+
+    QNetworkReply *reply = m_upstreamManager->post(
+        upstreamRequest, QJsonDocument(request).toJson(QJsonDocument::Compact));
+    QPointer<QTcpSocket> guard(socket);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, guard, request, keepAlive]() {
+        reply->deleteLater();
+
+        Transcript transcript;
+        transcript.request = request;
+        transcript.status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        transcript.contentType = reply->header(QNetworkRequest::ContentTypeHeader).toByteArray();
+        transcript.body = reply->readAll();
+        if (transcript.status == 0) {
+            // Sin respuesta HTTP (DNS, TLS...): no hay nada que grabar
+            if (guard)
+                sendError(guard, 502, "server_error", reply->errorString(), keepAlive);
+            return;
+        }
+
+        QFile file(m_recordPath);
+        if (file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            const QJsonObject line{{"request", transcript.request},
+                                   {"status", transcript.status},
+                                   {"contentType", QString::fromUtf8(transcript.contentType)},
+                                   {"body", QString::fromUtf8(transcript.body)}};
+            file.write(QJsonDocument(line).toJson(QJsonDocument::Compact) + '\n');
+            ++m_stats.recorded;
+        } else {
+            qWarning() << "Cannot record transcript:" << file.errorString();
+        }
+        m_transcriptIndex.insert(transcriptKey(request), int(m_transcripts.size()));
+        m_transcripts.append(transcript);
+
+        // La respuesta grabada se reenvía entera; grabar no es para medir tiempos
+        if (guard)
+            sendResponse(guard, transcript.status, transcript.contentType, transcript.body,
+                         keepAlive);
+    });
+}
+
+void DeepSeekMockServer::sendResponse(QTcpSocket *socket, int status,
+                                      const QByteArray &contentType, const QByteArray &body,
+                                      bool keepAlive,
+                                      const QList<QPair<QByteArray, QByteArray>> &extraHeaders)
+{
+    QByteArray response = "HTTP/1.1 " + QByteArray::number(status) + ' ' + reasonPhrase(status)
+                          + "\r\nContent-Type: " + contentType
+                          + "\r\nContent-Length: " + QByteArray::number(body.size())
+                          + (keepAlive ? "\r\nConnection: keep-alive" : "\r\nConnection: close");
+    for (const auto &header : extraHeaders)
+        response += "\r\n" + header.first + ": " + header.second;
+    response += "\r\n\r\n" + body;
+    socket->write(response);
+    finishRequest(socket, keepAlive);
+}
+
+void DeepSeekMockServer::sendError(QTcpSocket *socket, int status, const QString &type,
+                                   const QString &message, bool keepAlive)
+{
+    const QJsonObject error{{"error", QJsonObject{{"message", message}, {"type", type}}}};
+    sendResponse(socket, status, "application/json",
+                 QJsonDocument(error).toJson(QJsonDocument::Compact), keepAlive);
+}
+
+void DeepSeekMockServer::sendStream(QTcpSocket *socket, const QList<QByteArray> &events,
+                                    bool keepAlive)
+{
+    socket->write("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+                  "Cache-Control: no-cache\r\nTransfer-Encoding: chunked\r\n"
+                  + QByteArray(keepAlive ? "Connection: keep-alive" : "Connection: close")
+                  + "\r\n\r\n");
+
+    const auto writeChunk = [socket](const QByteArray &data) {
+        socket->write(QByteArray::number(data.size(), 16) + "\r\n" + data + "\r\n");
+    };
+
+    if (m_options.tokensPerSecond <= 0) {
+        for (const QByteArray &event : events)
+            writeChunk(event);
+        socket->write("0\r\n\r\n");
+        finishRequest(socket, keepAlive);
+        return;
+    }
+
+    // Un evento es un token. El temporizador no baja de 1 ms, así que en
+    // cada tick se envían los que tocan según el tiempo transcurrido; muere
+    // con el socket.
+    auto timer = new QTimer(socket);
+    timer->setInterval(std::max(1, 1000 / m_options.tokensPerSecond));
+    auto next = std::make_shared<qsizetype>(0);
+    auto clock = std::make_shared<QElapsedTimer>();
+    clock->start();
+    const qint64 rate = m_options.tokensPerSecond;
+    connect(timer, &QTimer::timeout, this, [this, socket, timer, events, next, clock, rate,
+                                            keepAlive, writeChunk]() {
+        if (*next < events.size()) {
+            const qsizetype due = std::clamp<qsizetype>(clock->elapsed() * rate / 1000, 1,
+                                                        events.size());
+            while (*next < due)
+                writeChunk(events.at((*next)++));
+            return;
+        }
+        timer->stop();
+        timer->deleteLater();
+        socket->write("0\r\n\r\n");
+        finishRequest(socket, keepAlive);
+    });
+    timer->start();
+}
+
+void DeepSeekMockServer::finishRequest(QTcpSocket *socket, bool keepAlive)
+{
+    if (!keepAlive) {
+        socket->disconnectFromHost();
+        return;
+    }
+    if (!m_busy.contains(socket))
+        return;
+    m_busy[socket] = false;
+
+    // La siguiente petición pudo llegar mientras se respondía a esta
+    if (!m_buffers.value(socket).isEmpty()) {
+        QMetaObject::invokeMethod(this, [this, socket = QPointer<QTcpSocket>(socket)]() {
+            if (socket)
+                onReadyRead(socket);
+        }, Qt::QueuedConnection);
+    }
+}
+
+static int promptTokens(const QJsonObject &request)
+{
+    // Aproximación de ~4 caracteres por token, suficiente para el "usage"
+    qsizetype chars = 0;
+    for (const QJsonValue &message : request["messages"].toArray())
+        chars += message["content"].toString().size();
+    return int(std::max<qsizetype>(1, chars / 4));
+}
+
+QJsonObject DeepSeekMockServer::syntheticCompletion(const QJsonObject &request) const
+{
+    QStringList words;
+    for (int i = 0; i < m_options.completionTokens; ++i)
+        words << QString("token%1").arg(i);
+
+    const int prompt = promptTokens(request);
+    return QJsonObject{
+        {"id", "chatcmpl-mock"},
+        {"object", "chat.completion"},
+        {"created", QDateTime::currentSecsSinceEpoch()},
+        {"model", request["model"].toString(m_options.models.value(0))},
+        {"choices", QJsonArray{QJsonObject{
+            {"index", 0},
+            {"message", QJsonObject{{"role", "assistant"}, {"content", words.join(' ')}}},
+            {"finish_reason", "stop"}}}},
+        {"usage", QJsonObject{{"prompt_tokens", prompt},
+                              {"completion_tokens", m_options.completionTokens},
+                              {"total_tokens", prompt + m_options.completionTokens},
+                              {"prompt_cache_hit_tokens", 0},
+                              {"prompt_cache_miss_tokens", prompt}}}
+    };
+}
+
+QList<QByteArray> DeepSeekMockServer::syntheticEvents(const QJsonObject &request) const
+{
+    const QString model = request["model"].toString(m_options.models.value(0));
+    const auto event = [&model](const QJsonObject &delta, const QJsonValue &finishReason) {
+        const QJsonObject chunk{
+            {"id", "chatcmpl-mock"},
+            {"object", "chat.completion.chunk"},
+            {"model", model},
+            {"choices", QJsonArray{QJsonObject{
+                {"index", 0}, {"delta", delta}, {"finish_reason", finishReason}}}}
+        };
+        return "data: " + QJsonDocument(chunk).toJson(QJsonDocument::Compact) + "\n\n";
+    };
+
+    QList<QByteArray> events;
+    events.reserve(m_options.completionTokens + 3);
+    events.append(event(QJsonObject{{"role", "assistant"}, {"content", ""}}, QJsonValue::Null));
+    for (int i = 0; i < m_options.completionTokens; ++i) {
+        const QString word = QString(i ? " token%1" : "token%1").arg(i);
+        events.append(event(QJsonObject{{"content", word}}, QJsonValue::Null));
+    }
+    events.append(event(QJsonObject{}, "stop"));
+
+    if (request["stream_options"].toObject()["include_usage"].toBool()) {
+        const int prompt = promptTokens(request);
+        const QJsonObject usage{{"choices", QJsonArray{}},
+                                {"usage", QJsonObject{
+                                    {"prompt_tokens", prompt},
+                                    {"completion_tokens", m_options.completionTokens},
+                                    {"total_tokens", prompt + m_options.completionTokens},
+                                    {"prompt_cache_hit_tokens", 0},
+                                    {"prompt_cache_miss_tokens", prompt}}}};
+        events.append("data: " + QJsonDocument(usage).toJson(QJsonDocument::Compact) + "\n\n");
+    }
+    events.append("data: [DONE]\n\n");
+    return events;
+}
+
+QList<QByteArray> DeepSeekMockServer::splitEvents(const QByteArray &body)
+{
+    QList<QByteArray> events;
+    qsizetype start = 0;
+    while (start < body.size()) {
+        qsizetype end = body.indexOf("\n\n", start);
+        end = end < 0 ? body.size() : end + 2;
+        events.append(body.mid(start, end - start));
+        start = end;
+    }
+    return events;
+}
+
+} // namespace DeepSeek
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QHostAddress>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QUrl>
+
+QT_BEGIN_NAMESPACE
+class QNetworkAccessManager;
+class QTcpServer;
+class QTcpSocket;
+QT_END_NAMESPACE
+
+namespace DeepSeek {
+
+// Servidor HTTP/1.1 mínimo que imita la API compatible con OpenAI de
+// DeepSeek: GET /v1/models y POST /v1/chat/completions, con y sin streaming.
+// Sirve para medir el plugin y el arnés de carga sin tocar la API real.
+//
+// Las respuestas son sintéticas (tantas palabras como completionTokens, al
+// ritmo de tokensPerSecond) salvo que se haya cargado una grabación: en ese
+// caso una petición idéntica a una grabada recibe la respuesta real. Con
+// setRecording() el servidor hace de proxy hacia la API real y guarda cada
+// par petición/respuesta; mientras graba no se inyectan errores ni retardos.
+//
+// Formato de las grabaciones (JSONL, una línea por petición):
+//   {"request": {...}, "status": 200, "contentType": "...", "body": "..."}
+class DeepSeekMockServer : public QObject
+{
+    Q_OBJECT
+public:
+    struct Options
+    {
+        int latencyMs = 50;           // hasta la primera respuesta
+        int tokensPerSecond = 200;    // ritmo del streaming; 0 = todo de golpe
+        int completionTokens = 64;
+        double rateLimitRate = 0.0;   // probabilidad de responder 429
+        double serverErrorRate = 0.0; // probabilidad de 500/502/503
+        double stallRate = 0.0;       // probabilidad de dejar la respuesta colgada
+        int stallMs = 60000;          // después se cierra la conexión
+        quint32 seed = 1;             // errores reproducibles entre ejecuciones
+        QStringList models{"deepseek-chat", "deepseek-reasoner"};
+    };
+
+    struct Stats
+    {
+        int requests = 0;
+        int streamed = 0;
+        int rateLimited = 0;
+        int serverErrors = 0;
+        int stalled = 0;
+        int replayed = 0;
+        int recorded = 0;
+    };
+
+    explicit DeepSeekMockServer(QObject *parent = nullptr);
+    ~DeepSeekMockServer() override;
+
+    void setOptions(const Options &options);
+    Options options() const { return m_options; }
+
+    bool listen(const QHostAddress &address = QHostAddress::LocalHost, quint16 port = 0,
+                QString *errorString = nullptr);
+    quint16 port() const;
+    QUrl baseUrl() const; // http://host:port/v1
+
+    bool loadTranscripts(const QString &filePath, QString *errorString = nullptr);
+    // Peticiones grabadas, en orden, para repetirlas tal cual
+    QList<QJsonObject> transcriptRequests() const;
+
+    // upstream: URL base de la API real (p. ej. https://api.deepseek.com)
+    void setRecording(const QUrl &upstream, const QString &apiKey, const QString &filePath);
+
+    Stats stats() const { return m_stats; }
+
+private:
+    struct HttpRequest
+    {
+        QByteArray method;
+        QByteArray path;
+        QHash<QByteArray, QByteArray> headers; // nombres en minúsculas
+        QByteArray body;
+    };
+
+    struct Transcript
+    {
+        QJsonObject request;
+        int status = 200;
+        QByteArray contentType;
+        QByteArray body;
+    };
+
+    void onNewConnection();
+    void onReadyRead(QTcpSocket *socket);
+    static bool takeRequest(QByteArray &buffer, HttpRequest &request, bool &malformed);
+    void handleRequest(QTcpSocket *socket, const HttpRequest &request);
+    void handleChat(QTcpSocket *socket, const HttpRequest &request, bool keepAlive);
+    void record(QTcpSocket *socket, const QJsonObject &request, bool keepAlive);
+
+    void sendResponse(QTcpSocket *socket, int status, const QByteArray &contentType,
+                      const QByteArray &body, bool keepAlive,
+                      const QList<QPair<QByteArray, QByteArray>> &extraHeaders = {});
+    void sendError(QTcpSocket *socket, int status, const QString &type, const QString &message,
+                   bool keepAlive);
+    // Cuerpo SSE troceado por eventos ("\n\n") y enviado con chunked encoding
+    void sendStream(QTcpSocket *socket, const QList<QByteArray> &events, bool keepAlive);
+    void finishRequest(QTcpSocket *socket, bool keepAlive);
+
+    QJsonObject syntheticCompletion(const QJsonObject &request) const;
+    QList<QByteArray> syntheticEvents(const QJsonObject &request) const;
+    static QList<QByteArray> splitEvents(const QByteArray &body);
+    static QByteArray transcriptKey(const QJsonObject &request);
+
+    QTcpServer *m_server = nullptr;
+    Options m_options;
+    QRandomGenerator m_random;
+    QHash<QTcpSocket *, QByteArray> m_buffers;
+    QHash<QTcpSocket *, bool> m_busy; // hay una respuesta en curso en esa conexión
+
+    QList<Transcript> m_transcripts;
+    QHash<QByteArray, int> m_transcriptIndex;
+
+    QNetworkAccessManager *m_upstreamManager = nullptr;
+    QUrl m_upstream;
+    QString m_apiKey;
+    QString m_recordPath;
+
+    Stats m_stats;
+};
+
+} // namespace DeepSeek
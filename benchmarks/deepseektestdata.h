@@ -0,0 +1,80 @@
+#pragma once
+
+// Datos de prueba compartidos por las pruebas y los microbenchmarks: un
+// historial, una respuesta típica de la API y el registro JSONL del historial.
+
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTest>
+
+namespace DeepSeekTestData {
+
+inline constexpr int MaxTokens = 2048;
+inline const QString SystemPrompt = "You are a helpful AI assistant";
+
+// Respuesta típica: explicación, un bloque de código y una lista
+inline QString sampleReply(int codeLines)
+{
+    QString reply = "The crash comes from dereferencing `m_widget` after the panel was closed.\n\n"
+                    "Guard the access and reset the pointer when the widget is destroyed:\n\n"
+                    "```cpp\n";
+    for (int i = 0; i < codeLines; ++i)
+        reply += QString("    if (m_widget) m_widget->setProperty(\"row%1\", %1); // line %1\n").arg(i);
+    reply += "```\n\n"
+             "- The `destroyed` signal fires before the children are deleted.\n"
+             "- **QPointer** would do the same without the explicit connection.\n";
+    return reply;
+}
+
+inline QJsonObject historyEntry(int index)
+{
+    return QJsonObject{
+        {"timestamp", QDateTime::fromSecsSinceEpoch(1700000000 + index).toString(Qt::ISODate)},
+        {"message", QString("Why does the panel crash when I close it? (question %1)").arg(index)},
+        {"response", sampleReply(8)},
+        {"context", QJsonObject{{"file", QString("/src/project/file%1.cpp").arg(index % 50)},
+                                {"project", "project"}}}
+    };
+}
+
+inline QJsonArray makeHistory(int entries)
+{
+    QJsonArray history;
+    for (int i = 0; i < entries; ++i)
+        history.append(historyEntry(i));
+    return history;
+}
+
+// Escribe el registro JSONL directamente: mucho más rápido que append()
+// entrada a entrada, y open() lo indexa igual que uno heredado.
+inline void writeHistoryLog(const QString &path, int entries)
+{
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    for (int i = 0; i < entries; ++i) {
+        QByteArray line = QJsonDocument(historyEntry(i)).toJson(QJsonDocument::Compact);
+        line.append('\n');
+        QCOMPARE(file.write(line), line.size());
+    }
+}
+
+inline QByteArray apiReplyBody(const QString &content)
+{
+    const QJsonObject reply{
+        {"id", "chatcmpl-0"},
+        {"object", "chat.completion"},
+        {"model", "deepseek-chat"},
+        {"choices", QJsonArray{QJsonObject{
+            {"index", 0},
+            {"message", QJsonObject{{"role", "assistant"}, {"content", content}}},
+            {"finish_reason", "stop"}}}},
+        {"usage", QJsonObject{{"prompt_tokens", 1200}, {"completion_tokens", 400},
+                              {"prompt_cache_hit_tokens", 1024}, {"prompt_cache_miss_tokens", 176}}}
+    };
+    return QJsonDocument(reply).toJson(QJsonDocument::Compact);
+}
+
+} // namespace DeepSeekTestData
@@ -0,0 +1,459 @@
+// Microbenchmarks de las partes del chat que dependen del tamaño del
+// historial o de la respuesta: construir la petición, interpretar la
+// respuesta, guardar y cargar el historial y convertir Markdown a HTML.
+//
+// No cargan Qt Creator: cada benchmark reproduce lo que hace
+// DeepSeekNavigationChat con las mismas clases que usa el plugin.
+//
+// Con --json <fichero> los resultados se escriben además en JSON (a partir
+// de la salida XML de QtTest) para comparar entre ejecuciones.
+
+#include "../deepseekbatchanalysis.h"
+#include "../deepseekcontextwindow.h"
+#include "../deepseekhistorystore.h"
+#include "../deepseekmarkdownrenderer.h"
+#include "../deepseekreplyreader.h"
+#include "../deepseekrequestserializer.h"
+#include "../deepseekresponsecache.h"
+#include "../deepseeksessionindex.h"
+#include "../deepseekstreamparser.h"
+#include "deepseektestdata.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QXmlStreamReader>
+
+using namespace DeepSeek;
+using namespace DeepSeekTestData;
+
+namespace {
+
+constexpr int ContextLength = 64 * 1024;
+
+// El mismo contenido en fragmentos SSE de unos pocos caracteres, como llegan
+QByteArray streamBody(const QString &content, int charsPerDelta)
+{
+    QByteArray body;
+    for (qsizetype i = 0; i < content.size(); i += charsPerDelta) {
+        const QJsonObject chunk{
+            {"choices", QJsonArray{QJsonObject{
+                {"index", 0},
+                {"delta", QJsonObject{{"content", content.mid(i, charsPerDelta)}}}}}}
+        };
+        body += "data: " + QJsonDocument(chunk).toJson(QJsonDocument::Compact) + "\n\n";
+    }
+    body += "data: [DONE]\n\n";
+    return body;
+}
+
+} // namespace
+
+class DeepSeekBenchmarks : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void requestPayload_data();
+    void requestPayload();
+    void apiReplyParse_data();
+    void apiReplyParse();
+    void apiReplyRead_data();
+    void apiReplyRead();
+    void streamReplyParse_data();
+    void streamReplyParse();
+    void historySave_data();
+    void historySave();
+    void historyLoad_data();
+    void historyLoad();
+    void sessionSwitch_data();
+    void sessionSwitch();
+    void analysisChunks_data();
+    void analysisChunks();
+    void markdownRender_data();
+    void markdownRender();
+
+private:
+    QTemporaryDir m_dir;
+};
+
+static void addHistorySizes()
+{
+    QTest::addColumn<int>("entries");
+    for (int entries : {100, 10000, 100000})
+        QTest::addRow("%d", entries) << entries;
+}
+
+void DeepSeekBenchmarks::requestPayload_data()
+{
+    QTest::addColumn<int>("entries");
+    QTest::addColumn<bool>("stablePrefix");
+    QTest::addColumn<bool>("incremental");
+    for (int entries : {100, 10000, 100000}) {
+        QTest::addRow("%d/file-ranked/cold", entries) << entries << false << false;
+        QTest::addRow("%d/stable-prefix/cold", entries) << entries << true << false;
+        QTest::addRow("%d/stable-prefix/incremental", entries) << entries << true << true;
+    }
+}
+
+// Lo que hace sendApiRequest hasta tener el cuerpo y la clave de la caché.
+// "incremental" reutiliza el serializador entre iteraciones, como en una
+// conversación en la que solo cambia el último turno; "cold" parte de cero.
+void DeepSeekBenchmarks::requestPayload()
+{
+    QFETCH(int, entries);
+    QFETCH(bool, stablePrefix);
+    QFETCH(bool, incremental);
+    const QJsonArray history = makeHistory(entries);
+    const QString message = "How do I avoid the crash when the panel closes?";
+    const QString currentFile = "/src/project/file7.cpp";
+    DeepSeekRequestSerializer serializer;
+
+    QBENCHMARK {
+        const int budget = DeepSeekContextWindow::historyBudget(ContextLength, MaxTokens,
+                                                                SystemPrompt, message);
+        const DeepSeekContextWindow::Result window
+            = stablePrefix ? DeepSeekContextWindow::buildStablePrefix(history, budget)
+                           : DeepSeekContextWindow::build(history, budget, currentFile);
+
+        DeepSeekRequestSerializer::Parts parts;
+        parts.head.append(QJsonObject{{"role", "system"}, {"content", SystemPrompt}});
+        for (int index : window.turns) {
+            const QJsonObject entry = history.at(index).toObject();
+            parts.history.append({index, entry.value("message").toString(),
+                                  entry.value("response").toString()});
+        }
+        parts.tail.append(QJsonObject{{"role", "user"}, {"content", message}});
+
+        if (!incremental)
+            serializer.reset();
+        const QJsonObject fields{{"model", "deepseek-chat"},
+                                 {"temperature", 0.0},
+                                 {"max_tokens", MaxTokens}};
+        const QByteArray messages = serializer.messagesJson(parts);
+        const QByteArray key = DeepSeekResponseCache::keyFor(
+            QUrl("https://api.deepseek.com/v1/chat/completions"),
+            DeepSeekRequestSerializer::assemble(fields, messages));
+        QJsonObject sendFields = fields;
+        sendFields["stream"] = false;
+        const QByteArray body = DeepSeekRequestSerializer::assemble(sendFields, messages);
+        QVERIFY(!key.isEmpty() && !body.isEmpty());
+    }
+}
+
+static void addReplySizes()
+{
+    QTest::addColumn<int>("codeLines");
+    QTest::newRow("short") << 5;
+    QTest::newRow("medium") << 60;
+    QTest::newRow("long") << 600;
+}
+
+void DeepSeekBenchmarks::apiReplyParse_data()
+{
+    addReplySizes();
+}
+
+// La parte de handleApiReply que no toca la interfaz
+void DeepSeekBenchmarks::apiReplyParse()
+{
+    QFETCH(int, codeLines);
+    const QByteArray body = apiReplyBody(sampleReply(codeLines));
+
+    QBENCHMARK {
+        QJsonParseError parseError;
+        const QJsonDocument doc = QJsonDocument::fromJson(body, &parseError);
+        const QJsonObject response = doc.object();
+        const QString content = response["choices"].toArray().first()
+                                    .toObject()["message"].toObject()["content"].toString();
+        const QJsonObject usage = response["usage"].toObject();
+        QVERIFY(!content.isEmpty() && usage.contains("prompt_tokens"));
+    }
+}
+
+void DeepSeekBenchmarks::apiReplyRead_data()
+{
+    addReplySizes();
+}
+
+// Lo mismo con DeepSeekReplyReader, en trozos de 1 KiB como en readyRead
+void DeepSeekBenchmarks::apiReplyRead()
+{
+    QFETCH(int, codeLines);
+    const QString content = sampleReply(codeLines);
+    const QByteArray body = apiReplyBody(content);
+    QList<QByteArray> packets;
+    for (qsizetype i = 0; i < body.size(); i += 1024)
+        packets.append(body.mid(i, 1024));
+
+    QBENCHMARK {
+        DeepSeekReplyReader reader;
+        for (const QByteArray &packet : std::as_const(packets))
+            reader.feed(packet);
+        QVERIFY(reader.finish());
+        QCOMPARE(reader.content().size(), content.size());
+    }
+}
+
+void DeepSeekBenchmarks::streamReplyParse_data()
+{
+    addReplySizes();
+}
+
+void DeepSeekBenchmarks::streamReplyParse()
+{
+    QFETCH(int, codeLines);
+    const QString content = sampleReply(codeLines);
+    const QByteArray body = streamBody(content, 4);
+    // Trozos de red de 1 KiB, como los entrega readyRead
+    QList<QByteArray> packets;
+    for (qsizetype i = 0; i < body.size(); i += 1024)
+        packets.append(body.mid(i, 1024));
+
+    QBENCHMARK {
+        DeepSeekStreamParser parser;
+        for (const QByteArray &packet : std::as_const(packets))
+            parser.feed(packet);
+        parser.finish();
+        QCOMPARE(parser.content().size(), content.size());
+    }
+}
+
+void DeepSeekBenchmarks::historySave_data()
+{
+    addHistorySizes();
+}
+
+// saveConversationHistory: un append al registro con N entradas previas
+void DeepSeekBenchmarks::historySave()
+{
+    QFETCH(int, entries);
+    const QString path = m_dir.filePath(QString("save_%1.jsonl").arg(entries));
+    writeHistoryLog(path, entries);
+    if (QTest::currentTestFailed())
+        return;
+
+    DeepSeekHistoryStore store(path);
+    store.setRetention(entries);
+    QString errorString;
+    QVERIFY2(store.open(&errorString), qPrintable(errorString));
+    const QJsonObject entry = historyEntry(entries);
+
+    QBENCHMARK {
+        QVERIFY2(store.append(entry, &errorString), qPrintable(errorString));
+    }
+}
+
+void DeepSeekBenchmarks::historyLoad_data()
+{
+    addHistorySizes();
+}
+
+// loadConversationHistory: abrir el registro ya indexado y leer la cola
+void DeepSeekBenchmarks::historyLoad()
+{
+    QFETCH(int, entries);
+    const QString path = m_dir.filePath(QString("load_%1.jsonl").arg(entries));
+    writeHistoryLog(path, entries);
+    if (QTest::currentTestFailed())
+        return;
+    {
+        // Primera apertura: genera el índice, que es lo que se encuentra al arrancar
+        DeepSeekHistoryStore store(path);
+        QVERIFY(store.open());
+    }
+
+    QBENCHMARK {
+        DeepSeekHistoryStore store(path);
+        store.setRetention(entries);
+        QString errorString;
+        QVERIFY2(store.open(&errorString), qPrintable(errorString));
+        const QJsonArray tail = store.readTail(100, &errorString);
+        QCOMPARE(tail.size(), qMin(entries, 100));
+    }
+}
+
+void DeepSeekBenchmarks::sessionSwitch_data()
+{
+    QTest::addColumn<int>("sessions");
+    for (int sessions : {10, 100, 1000})
+        QTest::addRow("%d", sessions) << sessions;
+}
+
+// switchSession: con cientos de sesiones solo se toca la elegida. Cada vuelta
+// lee el índice (como al arrancar) y la cola de una sesión distinta.
+void DeepSeekBenchmarks::sessionSwitch()
+{
+    QFETCH(int, sessions);
+    const QString directory = m_dir.filePath(QString("sessions_%1").arg(sessions));
+    QStringList ids;
+    {
+        DeepSeekSessionIndex index(directory);
+        for (int i = 0; i < sessions; ++i) {
+            const DeepSeekSessionIndex::Session session
+                = index.create(QString("/projects/p%1/CMakeLists.txt").arg(i % 10),
+                               QString("Session %1").arg(i));
+            index.touch(session.id, 200);
+            ids.append(session.id);
+        }
+        QString errorString;
+        QVERIFY2(index.save(&errorString), qPrintable(errorString));
+        // El contenido no importa: todas comparten tamaño
+        for (const QString &id : std::as_const(ids)) {
+            writeHistoryLog(index.logPath(id), 200);
+            if (QTest::currentTestFailed())
+                return;
+            DeepSeekHistoryStore store(index.logPath(id));
+            QVERIFY(store.open());
+        }
+    }
+
+    int next = 0;
+    QBENCHMARK {
+        DeepSeekSessionIndex index(directory);
+        QString errorString;
+        QVERIFY2(index.load(&errorString), qPrintable(errorString));
+        const QString id = ids.at(next++ % ids.size());
+        const DeepSeekSessionIndex::Session *session = index.find(id);
+        QVERIFY(session);
+        QVERIFY(!index.sessions(session->projectKey).isEmpty());
+
+        DeepSeekHistoryStore store(index.logPath(id));
+        store.setRetention(100);
+        QVERIFY2(store.open(&errorString), qPrintable(errorString));
+        QVERIFY(!store.readTail(100, &errorString).isEmpty());
+    }
+}
+
+void DeepSeekBenchmarks::analysisChunks_data()
+{
+    QTest::addColumn<int>("lines");
+    for (int lines : {100, 5000, 50000})
+        QTest::addRow("%d", lines) << lines;
+}
+
+// Troceado de un fichero para el análisis del proyecto
+void DeepSeekBenchmarks::analysisChunks()
+{
+    QFETCH(int, lines);
+    QString text;
+    for (int i = 0; i < lines; ++i)
+        text += QString("    result += compute(values[%1], offset); // %2\n").arg(i).arg(i * 7);
+
+    QBENCHMARK {
+        const QList<DeepSeekBatchAnalysis::Chunk> chunks = DeepSeekBatchAnalysis::chunkText(text);
+        QVERIFY(!chunks.isEmpty());
+    }
+}
+
+void DeepSeekBenchmarks::markdownRender_data()
+{
+    QTest::addColumn<int>("codeLines");
+    QTest::addColumn<int>("charsPerDelta");
+    for (int codeLines : {5, 60, 600}) {
+        QTest::addRow("%d-lines/whole", codeLines) << codeLines << 0;
+        QTest::addRow("%d-lines/streamed", codeLines) << codeLines << 16;
+    }
+}
+
+// appendToChatHistory en Markdown: lo que hace el hilo del renderizador, de
+// una vez o con los fragmentos del streaming
+void DeepSeekBenchmarks::markdownRender()
+{
+    QFETCH(int, codeLines);
+    QFETCH(int, charsPerDelta);
+    const QString reply = sampleReply(codeLines);
+
+    QBENCHMARK {
+        DeepSeekMarkdownRenderer renderer;
+        qsizetype fragments = 0;
+        if (charsPerDelta == 0) {
+            fragments += renderer.feed(reply).fragments.size();
+        } else {
+            for (qsizetype i = 0; i < reply.size(); i += charsPerDelta)
+                fragments += renderer.feed(QStringView(reply).mid(i, charsPerDelta)).fragments.size();
+        }
+        fragments += renderer.finish().fragments.size();
+        QVERIFY(fragments > 0);
+    }
+}
+
+// Convierte los <BenchmarkResult> del XML de QtTest en un JSON plano
+static bool writeJsonResults(const QString &xmlPath, const QString &jsonPath)
+{
+    QFile xml(xmlPath);
+    if (!xml.open(QIODevice::ReadOnly)) {
+        qWarning() << "Cannot read benchmark results:" << xml.errorString();
+        return false;
+    }
+
+    QJsonArray results;
+    QString function;
+    QXmlStreamReader reader(&xml);
+    while (!reader.atEnd()) {
+        if (!reader.readNextStartElement())
+            continue;
+        const QXmlStreamAttributes attributes = reader.attributes();
+        if (reader.name() == u"TestFunction") {
+            function = attributes.value("name").toString();
+        } else if (reader.name() == u"BenchmarkResult") {
+            results.append(QJsonObject{
+                {"benchmark", function},
+                {"tag", attributes.value("tag").toString()},
+                {"metric", attributes.value("metric").toString()},
+                {"value", attributes.value("value").toDouble()},
+                {"iterations", attributes.value("iterations").toInt()}
+            });
+        }
+    }
+    if (reader.hasError()) {
+        qWarning() << "Malformed benchmark results:" << reader.errorString();
+        return false;
+    }
+
+    const QJsonObject root{
+        {"timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate)},
+        {"qtVersion", QString::fromLatin1(qVersion())},
+        {"results", results}
+    };
+    QSaveFile file(jsonPath);
+    if (!file.open(QIODevice::WriteOnly)
+        || file.write(QJsonDocument(root).toJson()) < 0 || !file.commit()) {
+        qWarning() << "Cannot write" << jsonPath << ":" << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QStringList arguments = app.arguments();
+    QString jsonPath;
+    const qsizetype jsonIndex = arguments.indexOf("--json");
+    if (jsonIndex > 0 && jsonIndex + 1 < arguments.size()) {
+        jsonPath = arguments.at(jsonIndex + 1);
+        arguments.remove(jsonIndex, 2);
+    }
+
+    DeepSeekBenchmarks benchmarks;
+    if (jsonPath.isEmpty())
+        return QTest::qExec(&benchmarks, arguments);
+
+    QTemporaryDir dir;
+    const QString xmlPath = dir.filePath("results.xml");
+    arguments << "-o" << xmlPath + ",xml" << "-o" << "-,txt";
+    const int result = QTest::qExec(&benchmarks, arguments);
+    if (!writeJsonResults(xmlPath, jsonPath))
+        return result ? result : 1;
+    return result;
+}
+
+#include "tst_deepseekbenchmarks.moc"
@@ -0,0 +1,1397 @@
+// Pruebas de corrección de las clases del plugin que no dependen de Qt
+// Creator: serialización de la petición, lectura de la respuesta (completa y
+// en streaming), historial, sesiones, cachés, diff y aplicación de cambios,
+// búsqueda léxica y semántica, tokenizador, métricas y análisis del
+// proyecto. Los tiempos están en tst_deepseekbenchmarks.
+
+#include "../deepseekbatchanalysis.h"
+#include "../deepseekcontextwindow.h"
+#include "../deepseekedittransaction.h"
+#include "../deepseekhistorystore.h"
+#include "../deepseekprojectindex.h"
+#include "../deepseekreplyreader.h"
+#include "../deepseekrequestmetrics.h"
+#include "../deepseekrequestserializer.h"
+#include "../deepseekresponsecache.h"
+#include "../deepseeksessionindex.h"
+#include "../deepseeksimilarity.h"
+#include "../deepseekstreamparser.h"
+#include "../deepseektextdiff.h"
+#include "../deepseektokenizer.h"
+#include "../deepseekvectorstore.h"
+#include "deepseektestdata.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkReply>
+#include <QRandomGenerator>
+#include <QScopeGuard>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace DeepSeek;
+using namespace DeepSeekTestData;
+
+Q_DECLARE_METATYPE(DeepSeek::DeepSeekBatchAnalysis::ReplyClass)
+Q_DECLARE_METATYPE(DeepSeek::DeepSeekRequestMetrics::ErrorClass)
+Q_DECLARE_METATYPE(DeepSeek::DeepSeekVectorStore::Precision)
+
+class DeepSeekTests : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void serializerMatchesQJsonDocument();
+    void replyReaderMatchesQJsonDocument();
+    void replyReaderRejectsMalformed_data();
+    void replyReaderRejectsMalformed();
+    void replyReaderLimits();
+    void sessionsByProject();
+    void analysisChunks_data();
+    void analysisChunks();
+    void analysisIssues();
+    void tokenBucket();
+    void analysisReplyClass_data();
+    void analysisReplyClass();
+    void analysisThrottleLimit();
+    void streamParserChunks();
+    void streamParserEvents();
+    void historyStoreIndex();
+    void historyStoreCompaction();
+    void responseCacheEviction();
+    void responseCacheExpiry();
+    void diffRoundTrip_data();
+    void diffRoundTrip();
+    void diffLimits();
+    void editTransactionCommit();
+    void editTransactionStageFailure();
+    void editTransactionRecover();
+    void projectIndexSearch();
+    void reciprocalRankFusion();
+    void similarityMatchesScalar_data();
+    void similarityMatchesScalar();
+    void similarityTopK();
+    void vectorStoreCompaction_data();
+    void vectorStoreCompaction();
+    void tokenizerMerges_data();
+    void tokenizerMerges();
+    void tokenizerRejects();
+    void metricsPercentiles();
+    void metricsRingBuffer();
+    void metricsClassifyFinish_data();
+    void metricsClassifyFinish();
+
+private:
+    QTemporaryDir m_dir;
+};
+
+// El cuerpo ensamblado por partes debe coincidir con el de QJsonDocument:
+// de eso dependen las claves de la caché de respuestas
+void DeepSeekTests::serializerMatchesQJsonDocument()
+{
+    const QJsonArray history = makeHistory(20);
+    DeepSeekRequestSerializer serializer;
+    DeepSeekRequestSerializer::Parts parts;
+    parts.head.append(QJsonObject{{"role", "system"}, {"content", SystemPrompt}});
+    QList<int> turns;
+    for (int i = 0; i < history.size(); ++i) {
+        const QJsonObject entry = history.at(i).toObject();
+        parts.history.append({i, entry.value("message").toString(),
+                              entry.value("response").toString()});
+        turns.append(i);
+    }
+    parts.tail.append(QJsonObject{{"role", "user"}, {"content", "\"quoted\" \u00e9\n"}});
+
+    QJsonArray messages = parts.head;
+    for (const QJsonValue &item : DeepSeekContextWindow::messages(history, turns))
+        messages.append(item);
+    messages.append(parts.tail.first());
+
+    const QJsonObject fields{{"model", "deepseek-chat"},
+                             {"temperature", 0.7},
+                             {"max_tokens", MaxTokens},
+                             {"stream", true},
+                             {"stream_options", QJsonObject{{"include_usage", true}}}};
+    QJsonObject payload = fields;
+    payload["messages"] = messages;
+    const QByteArray expected = QJsonDocument(payload).toJson(QJsonDocument::Compact);
+
+    // Dos veces: en frío y reutilizando el prefijo
+    QCOMPARE(DeepSeekRequestSerializer::assemble(fields, serializer.messagesJson(parts)), expected);
+    QCOMPARE(DeepSeekRequestSerializer::assemble(fields, serializer.messagesJson(parts)), expected);
+    QCOMPARE(serializer.stats().reusedTurns, int(history.size()));
+}
+
+// Cualquier corte de la respuesta debe dar el mismo resultado que el DOM
+void DeepSeekTests::replyReaderMatchesQJsonDocument()
+{
+    const QString content = sampleReply(3) + QString::fromUtf8("\t\"quoted\" \\ ñ € 😀 \x01");
+    QJsonObject reply = QJsonDocument::fromJson(apiReplyBody(content)).object();
+    QJsonObject choice = reply["choices"].toArray().first().toObject();
+    QJsonObject message = choice["message"].toObject();
+    message["reasoning_content"] = "Check the destroyed() signal";
+    choice["message"] = message;
+    reply["choices"] = QJsonArray{choice, QJsonObject{{"index", 1}, {"message", QJsonObject{
+                                                         {"content", "second choice"}}}}};
+    reply["system_fingerprint"] = QJsonValue::Null;
+    reply["extra"] = QJsonArray{1.5e3, -0.25, true, false, QJsonArray{}, QJsonObject{}};
+    const QByteArray body = QJsonDocument(reply).toJson(QJsonDocument::Indented);
+
+    for (qsizetype cut = 0; cut <= body.size(); ++cut) {
+        DeepSeekReplyReader reader;
+        QVERIFY(reader.feed(QByteArrayView(body).first(cut)));
+        QVERIFY(reader.feed(QByteArrayView(body).sliced(cut)));
+        QVERIFY2(reader.finish(), qPrintable(reader.error()));
+        QVERIFY(reader.hasMessage());
+        QCOMPARE(reader.content(), content);
+        QCOMPARE(reader.reasoningContent(), QString("Check the destroyed() signal"));
+        QCOMPARE(reader.finishReason(), QString("stop"));
+        QCOMPARE(reader.usage(), reply["usage"].toObject());
+        QVERIFY(!reader.hasApiError());
+    }
+
+    // Pares suplentes escapados; el que queda suelto se sustituye por U+FFFD
+    DeepSeekReplyReader surrogates;
+    QVERIFY(surrogates.feed(R"({"choices":[{"message":{"content":"\ud83d\ude00 \ud83d!"}}]})"));
+    QVERIFY(surrogates.finish());
+    QCOMPARE(surrogates.content(), QString::fromUtf8("😀 \uFFFD!"));
+
+    DeepSeekReplyReader reader;
+    QVERIFY(reader.feed(R"({"error":{"message":"Insufficient Balance","type":"unknown_error"}})"));
+    QVERIFY(reader.finish());
+    QVERIFY(reader.hasApiError());
+    QCOMPARE(reader.apiErrorMessage(), QString("Insufficient Balance"));
+    QVERIFY(!reader.hasMessage());
+}
+
+void DeepSeekTests::replyReaderRejectsMalformed_data()
+{
+    QTest::addColumn<QByteArray>("body");
+    QTest::newRow("empty") << QByteArray();
+    QTest::newRow("truncated") << apiReplyBody("hello").chopped(3);
+    QTest::newRow("trailing data") << QByteArray(R"({"choices":[]} x)");
+    QTest::newRow("missing colon") << QByteArray(R"({"choices" []})");
+    QTest::newRow("trailing comma") << QByteArray(R"({"choices":[1,]})");
+    QTest::newRow("bad literal") << QByteArray(R"({"usage":nul})");
+    QTest::newRow("bad number") << QByteArray(R"({"usage":01})");
+    QTest::newRow("bad escape") << QByteArray(R"({"a":"\x"})");
+    QTest::newRow("html") << QByteArray("<html><body>502 Bad Gateway</body></html>");
+    QTest::newRow("too deep") << QByteArray(DeepSeekReplyReader::MaxDepth + 1, '[');
+}
+
+void DeepSeekTests::replyReaderRejectsMalformed()
+{
+    QFETCH(QByteArray, body);
+    DeepSeekReplyReader reader;
+    reader.feed(body);
+    QVERIFY(!reader.finish());
+    QVERIFY(reader.hasError());
+    QVERIFY(!reader.feed("{}")); // una vez en error no consume más
+}
+
+void DeepSeekTests::replyReaderLimits()
+{
+    // Límite del contenido: el lector se detiene sin guardar el resto
+    DeepSeekReplyReader limited;
+    limited.setLimits(1024, DeepSeekReplyReader::DefaultMaxInputBytes);
+    QVERIFY(!limited.feed(apiReplyBody(QString(4096, 'x'))));
+    QVERIFY(limited.content().size() <= 1024);
+    QCOMPARE(limited.preview().size(), DeepSeekReplyReader::PreviewBytes);
+}
+
+// Las sesiones se agrupan por proyecto y cada una lee su propio registro
+void DeepSeekTests::sessionsByProject()
+{
+    const QString directory = m_dir.filePath("sessions");
+    QStringList ids;
+    {
+        DeepSeekSessionIndex index(directory);
+        for (int i = 0; i < 30; ++i) {
+            const DeepSeekSessionIndex::Session session
+                = index.create(QString("/projects/p%1/CMakeLists.txt").arg(i % 10),
+                               QString("Session %1").arg(i));
+            index.touch(session.id, 200);
+            ids.append(session.id);
+        }
+        QString errorString;
+        QVERIFY2(index.save(&errorString), qPrintable(errorString));
+        for (const QString &id : std::as_const(ids)) {
+            writeHistoryLog(index.logPath(id), 200);
+            if (QTest::currentTestFailed())
+                return;
+        }
+    }
+
+    DeepSeekSessionIndex index(directory);
+    QString errorString;
+    QVERIFY2(index.load(&errorString), qPrintable(errorString));
+    for (const QString &id : std::as_const(ids)) {
+        const DeepSeekSessionIndex::Session *session = index.find(id);
+        QVERIFY(session);
+        QCOMPARE(index.sessions(session->projectKey).size(), 3);
+
+        DeepSeekHistoryStore store(index.logPath(id));
+        store.setRetention(100);
+        QVERIFY2(store.open(&errorString), qPrintable(errorString));
+        QCOMPARE(store.readTail(100, &errorString).size(), 100);
+    }
+}
+
+void DeepSeekTests::analysisChunks_data()
+{
+    QTest::addColumn<int>("lines");
+    for (int lines : {0, 1, 100, 5000})
+        QTest::addRow("%d", lines) << lines;
+}
+
+// Troceado de un fichero para el análisis del proyecto: los fragmentos
+// cubren todas las líneas, en orden y sin pasar de los límites
+void DeepSeekTests::analysisChunks()
+{
+    QFETCH(int, lines);
+    QString text;
+    for (int i = 0; i < lines; ++i)
+        text += QString("    result += compute(values[%1], offset); // %2\n").arg(i).arg(i * 7);
+
+    int next = 0;
+    for (const DeepSeekBatchAnalysis::Chunk &chunk : DeepSeekBatchAnalysis::chunkText(text)) {
+        QCOMPARE(chunk.startLine, next);
+        QVERIFY(chunk.lineCount <= DeepSeekBatchAnalysis::ChunkLines);
+        QVERIFY(chunk.text.size() <= DeepSeekBatchAnalysis::MaxChunkChars);
+        QVERIFY(chunk.text.startsWith(QString::number(next + 1).rightJustified(5) + "| "));
+        next += chunk.lineCount;
+    }
+    // La línea vacía tras el último salto solo cuenta si no queda sola
+    QVERIFY(next == lines || next == lines + 1);
+}
+
+static void addIssue(QJsonArray &issues, int line, const char *severity, const char *message)
+{
+    issues.append(QJsonObject{{"line", line}, {"severity", severity}, {"message", message}});
+}
+
+void DeepSeekTests::analysisIssues()
+{
+    DeepSeekBatchAnalysis::Chunk chunk;
+    chunk.startLine = 300;
+    chunk.lineCount = 300;
+
+    QJsonArray items;
+    addIssue(items, 301, "error", "Data race on m_cache");
+    addIssue(items, 600, "Warning", "Lock held while emitting");
+    addIssue(items, 12, "warning", "Line outside the fragment");
+    addIssue(items, 450, "warning", "  ");
+    const QString json = QJsonDocument(QJsonObject{{"issues", items}}).toJson();
+
+    const QString path = "/project/src/cache.cpp";
+    QString errorString;
+    for (const QString &content : {json, "```json\n" + json + "```"}) {
+        const QList<DeepSeekBatchAnalysis::Issue> issues
+            = DeepSeekBatchAnalysis::parseIssues(content, path, chunk, &errorString);
+        QVERIFY2(errorString.isEmpty(), qPrintable(errorString));
+        QCOMPARE(issues.size(), 3);
+        QCOMPARE(issues.at(0).line, 301);
+        QVERIFY(issues.at(0).error);
+        QCOMPARE(issues.at(0).filePath, path);
+        QCOMPARE(issues.at(1).line, 600);
+        QVERIFY(!issues.at(1).error);
+        QCOMPARE(issues.at(2).line, 0);
+    }
+
+    QVERIFY(DeepSeekBatchAnalysis::parseIssues("No issues found.", path, chunk, &errorString)
+                .isEmpty());
+    QVERIFY(!errorString.isEmpty());
+    errorString.clear();
+    DeepSeekBatchAnalysis::parseIssues(R"({"result": []})", path, chunk, &errorString);
+    QVERIFY(!errorString.isEmpty());
+}
+
+void DeepSeekTests::tokenBucket()
+{
+    // Dos de ráfaga y después una por segundo
+    DeepSeekTokenBucket bucket;
+    bucket.setRate(1.0, 2.0);
+    bucket.reset(0);
+    QVERIFY(bucket.tryTake(0));
+    QVERIFY(bucket.tryTake(0));
+    QVERIFY(!bucket.tryTake(0));
+    QCOMPARE(bucket.msUntilAvailable(0), 1000);
+    QCOMPARE(bucket.msUntilAvailable(400), 600);
+    QVERIFY(!bucket.tryTake(999));
+    QVERIFY(bucket.tryTake(1000));
+    // Parado mucho tiempo no acumula más que la ráfaga
+    QVERIFY(bucket.tryTake(60000));
+    QVERIFY(bucket.tryTake(60000));
+    QVERIFY(!bucket.tryTake(60000));
+}
+
+void DeepSeekTests::analysisReplyClass_data()
+{
+    using ReplyClass = DeepSeekBatchAnalysis::ReplyClass;
+    QTest::addColumn<int>("status");
+    QTest::addColumn<bool>("networkError");
+    QTest::addColumn<bool>("timedOut");
+    QTest::addColumn<ReplyClass>("expected");
+    QTest::newRow("200") << 200 << false << false << ReplyClass::Ok;
+    QTest::newRow("429") << 429 << true << false << ReplyClass::Throttled;
+    QTest::newRow("503") << 503 << true << false << ReplyClass::Throttled;
+    QTest::newRow("500") << 500 << true << false << ReplyClass::Transient;
+    QTest::newRow("502") << 502 << true << false << ReplyClass::Transient;
+    QTest::newRow("408") << 408 << true << false << ReplyClass::Transient;
+    QTest::newRow("network") << 0 << true << false << ReplyClass::Transient;
+    QTest::newRow("timeout") << 0 << true << true << ReplyClass::Transient;
+    QTest::newRow("400") << 400 << true << false << ReplyClass::Rejected;
+    QTest::newRow("404") << 404 << true << false << ReplyClass::Rejected;
+    QTest::newRow("401") << 401 << true << false << ReplyClass::Unauthorized;
+    QTest::newRow("403") << 403 << true << false << ReplyClass::Unauthorized;
+}
+
+void DeepSeekTests::analysisReplyClass()
+{
+    QFETCH(int, status);
+    QFETCH(bool, networkError);
+    QFETCH(bool, timedOut);
+    QFETCH(DeepSeekBatchAnalysis::ReplyClass, expected);
+    QCOMPARE(DeepSeekBatchAnalysis::classifyReply(status, networkError, timedOut), expected);
+}
+
+// Un servidor que responde 503 siempre: el fragmento se envía, al ritmo del
+// limitador y esperando el Retry-After, hasta MaxThrottles veces y se da por fallido
+void DeepSeekTests::analysisThrottleLimit()
+{
+    using ReplyClass = DeepSeekBatchAnalysis::ReplyClass;
+    DeepSeekTokenBucket bucket;
+    bucket.setRate(1.0, 2.0);
+    bucket.reset(0);
+
+    DeepSeekBatchAnalysis::Attempts attempts;
+    qint64 now = 0;
+    int sends = 0;
+    for (;;) {
+        now += bucket.msUntilAvailable(now);
+        QVERIFY(bucket.tryTake(now));
+        ++sends;
+        QVERIFY(sends <= DeepSeekBatchAnalysis::MaxThrottles);
+        if (!DeepSeekBatchAnalysis::countAttempt(attempts,
+                                                 DeepSeekBatchAnalysis::classifyReply(503, true,
+                                                                                      false)))
+            break;
+        now += 1000; // Retry-After: 1
+    }
+    QCOMPARE(sends, DeepSeekBatchAnalysis::MaxThrottles);
+    QCOMPARE(attempts.failures, 0);
+
+    // Los 429/503 no gastan los intentos de los errores transitorios
+    DeepSeekBatchAnalysis::Attempts mixed;
+    QVERIFY(DeepSeekBatchAnalysis::countAttempt(mixed, ReplyClass::Throttled));
+    QVERIFY(DeepSeekBatchAnalysis::countAttempt(mixed, ReplyClass::Transient));
+    QVERIFY(DeepSeekBatchAnalysis::countAttempt(mixed, ReplyClass::Transient));
+    QVERIFY(!DeepSeekBatchAnalysis::countAttempt(mixed, ReplyClass::Transient));
+
+    DeepSeekBatchAnalysis::Attempts rejected;
+    QVERIFY(!DeepSeekBatchAnalysis::countAttempt(rejected, ReplyClass::Rejected));
+}
+
+static QByteArray streamChunk(const QJsonObject &delta, const QString &finishReason = {})
+{
+    QJsonObject choice{{"index", 0}, {"delta", delta}};
+    choice["finish_reason"] = finishReason.isEmpty() ? QJsonValue(QJsonValue::Null)
+                                                     : QJsonValue(finishReason);
+    const QJsonObject chunk{{"object", "chat.completion.chunk"}, {"choices", QJsonArray{choice}}};
+    return "data: " + QJsonDocument(chunk).toJson(QJsonDocument::Compact) + "\r\n\r\n";
+}
+
+// El flujo SSE cortado en cualquier punto da el mismo contenido
+void DeepSeekTests::streamParserChunks()
+{
+    const QStringList deltas{"The crash", " comes from ", QString::fromUtf8("ñ € 😀"),
+                             "\n```cpp\nif (m_widget)\n```"};
+    const QJsonObject usage{{"prompt_tokens", 1200}, {"completion_tokens", 12}};
+
+    QByteArray body = ": keep-alive\r\n\r\n";
+    body += streamChunk(QJsonObject{{"role", "assistant"}, {"reasoning_content", "Check"}});
+    for (const QString &delta : deltas)
+        body += streamChunk(QJsonObject{{"content", delta}});
+    body += streamChunk(QJsonObject{}, "stop");
+    body += "data: " + QJsonDocument(QJsonObject{{"choices", QJsonArray{}}, {"usage", usage}})
+                           .toJson(QJsonDocument::Compact)
+            + "\n\n";
+    body += "data: [DONE]\n\n";
+
+    for (qsizetype cut = 0; cut <= body.size(); ++cut) {
+        DeepSeekStreamParser parser;
+        QList<DeepSeekStreamParser::Event> events = parser.feed(body.left(cut));
+        events += parser.feed(body.mid(cut));
+        events += parser.finish();
+
+        QString content;
+        QString reasoning;
+        QString finishReason;
+        for (const DeepSeekStreamParser::Event &event : std::as_const(events)) {
+            QVERIFY(event.error.isEmpty());
+            content += event.delta;
+            reasoning += event.reasoningDelta;
+            if (!event.finishReason.isEmpty())
+                finishReason = event.finishReason;
+        }
+        QCOMPARE(events.size(), deltas.size() + 4);
+        QVERIFY(events.last().done);
+        QCOMPARE(content, deltas.join(QString()));
+        QCOMPARE(parser.content(), content);
+        QCOMPARE(reasoning, QString("Check"));
+        QCOMPARE(finishReason, QString("stop"));
+        QCOMPARE(parser.usage(), usage);
+        QVERIFY(parser.isDone());
+        QVERIFY(!parser.hasError());
+    }
+}
+
+void DeepSeekTests::streamParserEvents()
+{
+    // Un evento en varias líneas "data:" se une con '\n'
+    DeepSeekStreamParser multiline;
+    QList<DeepSeekStreamParser::Event> events
+        = multiline.feed("event: message\nid: 1\ndata: {\"choices\":\ndata: [{\"delta\":"
+                         "{\"content\":\"hi\"}}]}\n\n");
+    QCOMPARE(events.size(), 1);
+    QCOMPARE(events.first().delta, QString("hi"));
+
+    // El último evento sin línea en blanco se entrega en finish()
+    QVERIFY(multiline.feed("data: [DONE]").isEmpty());
+    QVERIFY(!multiline.isDone());
+    events = multiline.finish();
+    QCOMPARE(events.size(), 1);
+    QVERIFY(multiline.isDone());
+
+    DeepSeekStreamParser apiError;
+    events = apiError.feed("data: {\"error\":{\"message\":\"Rate limit reached\"}}\n\n");
+    QCOMPARE(events.size(), 1);
+    QCOMPARE(events.first().error, QString("Rate limit reached"));
+    QCOMPARE(apiError.error(), QString("Rate limit reached"));
+
+    DeepSeekStreamParser invalid;
+    invalid.feed("data: {\"choices\": [\n\n");
+    QVERIFY(invalid.hasError());
+    invalid.reset();
+    QVERIFY(!invalid.hasError());
+    QVERIFY(invalid.content().isEmpty());
+}
+
+// El índice se carga sin recorrer el registro y se repara si no cuadra con él
+void DeepSeekTests::historyStoreIndex()
+{
+    const QString path = m_dir.filePath("history/index.jsonl");
+    QString errorString;
+    {
+        DeepSeekHistoryStore store(path);
+        store.setRetention(50);
+        QVERIFY2(store.open(&errorString), qPrintable(errorString));
+        for (int i = 0; i < 10; ++i)
+            QVERIFY2(store.append(historyEntry(i), &errorString), qPrintable(errorString));
+        QCOMPARE(store.count(), 10);
+        QCOMPARE(QFileInfo(store.indexPath()).size(), qint64(8 + 10 * sizeof(qint64)));
+    }
+
+    DeepSeekHistoryStore store(path);
+    store.setRetention(50);
+    QVERIFY2(store.open(&errorString), qPrintable(errorString));
+    QCOMPARE(store.count(), 10);
+    const QJsonArray tail = store.readTail(3, &errorString);
+    QCOMPARE(tail.size(), 3);
+    for (int i = 0; i < 3; ++i)
+        QCOMPARE(tail.at(i).toObject(), historyEntry(7 + i));
+
+    // Un registro escrito sin llegar al índice y otro cortado a medias
+    {
+        QFile log(path);
+        QVERIFY(log.open(QIODevice::WriteOnly | QIODevice::Append));
+        log.write(QJsonDocument(historyEntry(10)).toJson(QJsonDocument::Compact) + '\n');
+        log.write(R"({"message":"cut)");
+    }
+    DeepSeekHistoryStore recovered(path);
+    QVERIFY2(recovered.open(&errorString), qPrintable(errorString));
+    QCOMPARE(recovered.count(), 11);
+    QCOMPARE(recovered.logSize(), QFileInfo(path).size());
+    QCOMPARE(recovered.readTail(1, &errorString).first().toObject(), historyEntry(10));
+
+    // Índice dañado: se reconstruye desde el registro
+    {
+        QFile index(recovered.indexPath());
+        QVERIFY(index.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        index.write("garbage");
+    }
+    DeepSeekHistoryStore rebuilt(path);
+    QVERIFY2(rebuilt.open(&errorString), qPrintable(errorString));
+    const QJsonArray all = rebuilt.readTail(100, &errorString);
+    QCOMPARE(all.size(), 11);
+    for (int i = 0; i < all.size(); ++i)
+        QCOMPARE(all.at(i).toObject(), historyEntry(i));
+}
+
+void DeepSeekTests::historyStoreCompaction()
+{
+    const QString path = m_dir.filePath("history/compaction.jsonl");
+    QString errorString;
+    DeepSeekHistoryStore store(path);
+    store.setRetention(5);
+    for (int i = 0; i < 9; ++i)
+        QVERIFY2(store.append(historyEntry(i), &errorString), qPrintable(errorString));
+    QCOMPARE(store.count(), 9);
+
+    // Al llegar a CompactionFactor veces la retención quedan los más recientes
+    QVERIFY2(store.append(historyEntry(9), &errorString), qPrintable(errorString));
+    QCOMPARE(store.count(), 5);
+    QCOMPARE(store.logSize(), QFileInfo(path).size());
+
+    DeepSeekHistoryStore reopened(path);
+    QVERIFY2(reopened.open(&errorString), qPrintable(errorString));
+    const QJsonArray entries = reopened.readTail(10, &errorString);
+    QCOMPARE(entries.size(), 5);
+    for (int i = 0; i < entries.size(); ++i)
+        QCOMPARE(entries.at(i).toObject(), historyEntry(5 + i));
+
+    QVERIFY2(reopened.clear(&errorString), qPrintable(errorString));
+    QVERIFY(!QFile::exists(path));
+    QVERIFY(!QFile::exists(reopened.indexPath()));
+}
+
+static QString cacheFile(const QString &directory, const QByteArray &key)
+{
+    return directory + '/' + QString::fromLatin1(key) + ".json";
+}
+
+// Se desaloja la entrada usada hace más tiempo, no la creada antes
+void DeepSeekTests::responseCacheEviction()
+{
+    const QString directory = m_dir.filePath("cache-lru");
+    const QUrl endpoint("https://api.deepseek.com/chat/completions");
+    QList<QByteArray> keys;
+    for (int i = 0; i < 4; ++i)
+        keys.append(DeepSeekResponseCache::keyFor(endpoint, "body " + QByteArray::number(i)));
+
+    QString errorString;
+    qint64 entrySize = 0;
+    {
+        DeepSeekResponseCache cache(directory);
+        for (int i = 0; i < 3; ++i) {
+            QVERIFY2(cache.store(keys.at(i), {QString("reply %1").arg(i), {}}, &errorString),
+                     qPrintable(errorString));
+        }
+        QCOMPARE(cache.stats().entries, 3);
+        entrySize = cache.stats().bytes / 3;
+    }
+
+    // Último uso hace 300, 200 y 100 segundos
+    const QDateTime now = QDateTime::currentDateTime();
+    for (int i = 0; i < 3; ++i) {
+        QFile file(cacheFile(directory, keys.at(i)));
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.setFileTime(now.addSecs(-300 + 100 * i), QFileDevice::FileModificationTime));
+    }
+
+    DeepSeekResponseCache cache(directory);
+    cache.setMaxBytes(entrySize * 7 / 2);
+    // La más antigua pasa a ser la más reciente
+    const auto hit = cache.lookup(keys.at(0));
+    QVERIFY(hit);
+    QCOMPARE(hit->content, QString("reply 0"));
+
+    QVERIFY2(cache.store(keys.at(3), {"reply 3", {}}, &errorString), qPrintable(errorString));
+    DeepSeekResponseCache::Stats stats = cache.stats();
+    QCOMPARE(stats.evictions, 1);
+    QCOMPARE(stats.entries, 3);
+    QVERIFY(stats.bytes <= entrySize * 7 / 2);
+    QVERIFY(!QFile::exists(cacheFile(directory, keys.at(1))));
+
+    QVERIFY(cache.lookup(keys.at(0)));
+    QVERIFY(!cache.lookup(keys.at(1)));
+    QVERIFY(cache.lookup(keys.at(2)));
+    QVERIFY(cache.lookup(keys.at(3)));
+    stats = cache.stats();
+    QCOMPARE(stats.hits, 4);
+    QCOMPARE(stats.misses, 1);
+
+    cache.clear();
+    QCOMPARE(cache.stats().entries, 0);
+    QVERIFY(QDir(directory).isEmpty());
+}
+
+void DeepSeekTests::responseCacheExpiry()
+{
+    QVERIFY(DeepSeekResponseCache::isCacheable(0.0));
+    QVERIFY(!DeepSeekResponseCache::isCacheable(0.7));
+    // El mismo cuerpo en otro servidor es otra entrada
+    QVERIFY(DeepSeekResponseCache::keyFor(QUrl("https://a.example/v1/chat"), "{}")
+            != DeepSeekResponseCache::keyFor(QUrl("https://b.example/v1/chat"), "{}"));
+    QCOMPARE(DeepSeekResponseCache::keyFor(QUrl("https://a.example/v1/chat/"), "{}"),
+             DeepSeekResponseCache::keyFor(QUrl("https://a.example/v1/chat"), "{}"));
+
+    const QString directory = m_dir.filePath("cache-ttl");
+    const QByteArray key = DeepSeekResponseCache::keyFor(QUrl("https://a.example/v1/chat"), "{}");
+    const auto writeOldEntry = [&] {
+        QFile file(cacheFile(directory, key));
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        const QJsonObject entry{{"created", QDateTime::currentSecsSinceEpoch() - 7200},
+                                {"content", "old"},
+                                {"usage", QJsonObject{}}};
+        file.write(QJsonDocument(entry).toJson(QJsonDocument::Compact));
+    };
+
+    QString errorString;
+    DeepSeekResponseCache cache(directory);
+    cache.setTimeToLive(3600);
+    QVERIFY2(cache.store(key, {"fresh", {}}, &errorString), qPrintable(errorString));
+    writeOldEntry();
+    QVERIFY(!cache.lookup(key));
+    DeepSeekResponseCache::Stats stats = cache.stats();
+    QCOMPARE(stats.expired, 1);
+    QCOMPARE(stats.misses, 1);
+    QCOMPARE(stats.entries, 0);
+    QVERIFY(!QFile::exists(cacheFile(directory, key)));
+
+    // Sin caducidad se conserva
+    QVERIFY2(cache.store(key, {"fresh", {}}, &errorString), qPrintable(errorString));
+    writeOldEntry();
+    cache.setTimeToLive(0);
+    const auto hit = cache.lookup(key);
+    QVERIFY(hit);
+    QCOMPARE(hit->content, QString("old"));
+}
+
+// Líneas de un alfabeto pequeño para que haya muchas coincidencias
+static QStringList randomLines(QRandomGenerator &random, int count)
+{
+    QStringList lines;
+    for (int i = 0; i < count; ++i)
+        lines.append(QString("line %1\n").arg(random.bounded(6)));
+    return lines;
+}
+
+// Distancia de edición solo con inserciones y borrados, por programación dinámica
+static int editDistance(const QStringList &a, const QStringList &b)
+{
+    std::vector<int> row(b.size() + 1);
+    for (qsizetype j = 0; j <= b.size(); ++j)
+        row[j] = int(j);
+    for (qsizetype i = 1; i <= a.size(); ++i) {
+        int diagonal = row[0];
+        row[0] = int(i);
+        for (qsizetype j = 1; j <= b.size(); ++j) {
+            const int above = row[j];
+            row[j] = a.at(i - 1) == b.at(j - 1) ? diagonal : 1 + std::min(row[j], row[j - 1]);
+            diagonal = above;
+        }
+    }
+    return row[b.size()];
+}
+
+void DeepSeekTests::diffRoundTrip_data()
+{
+    QTest::addColumn<QString>("oldText");
+    QTest::addColumn<QString>("newText");
+    QTest::newRow("identical") << "a\nb\nc\n" << "a\nb\nc\n";
+    QTest::newRow("from empty") << "" << "a\nb\n";
+    QTest::newRow("to empty") << "a\nb\n" << "";
+    QTest::newRow("no final newline") << "a\nb\nc" << "a\nB\nc";
+    QTest::newRow("add final newline") << "a\nb" << "a\nb\n";
+    QTest::newRow("middle") << "a\nb\nc\nd\ne\n" << "a\nb\nX\nY\nd\ne\n";
+    QTest::newRow("prefix and suffix") << "x\na\nb\nc\ny\n" << "z\na\nb\nc\nw\n";
+    QTest::newRow("crlf") << "a\r\nb\r\n" << "a\r\nc\r\n";
+
+    QRandomGenerator random(2024);
+    for (int i = 0; i < 200; ++i) {
+        const QStringList oldLines = randomLines(random, random.bounded(40));
+        const QStringList newLines = randomLines(random, random.bounded(40));
+        QTest::addRow("random %d", i) << oldLines.join(QString()) << newLines.join(QString());
+    }
+}
+
+// Aplicar todas las ediciones da el texto nuevo, ninguna el antiguo, y el
+// diff es mínimo
+void DeepSeekTests::diffRoundTrip()
+{
+    QFETCH(QString, oldText);
+    QFETCH(QString, newText);
+    const QStringList oldLines = DeepSeekTextDiff::splitLines(oldText);
+    const QStringList newLines = DeepSeekTextDiff::splitLines(newText);
+    QCOMPARE(oldLines.join(QString()), oldText);
+    QCOMPARE(newLines.join(QString()), newText);
+
+    const QList<DeepSeekTextDiff::Edit> edits = DeepSeekTextDiff::diff(oldLines, newLines);
+    QCOMPARE(DeepSeekTextDiff::applyEdits(oldLines, newLines, edits), newText);
+    QCOMPARE(DeepSeekTextDiff::applyEdits(oldLines, newLines, {}), oldText);
+
+    int changedLines = 0;
+    int oldEnd = 0;
+    int newEnd = 0;
+    for (const DeepSeekTextDiff::Edit &edit : edits) {
+        QVERIFY(edit.oldCount > 0 || edit.newCount > 0);
+        // Ordenadas, sin solaparse, y lo que queda entre ellas es igual
+        QVERIFY(edit.oldStart >= oldEnd);
+        QCOMPARE(edit.oldStart - oldEnd, edit.newStart - newEnd);
+        for (int k = 0; k < edit.oldStart - oldEnd; ++k)
+            QCOMPARE(oldLines.at(oldEnd + k), newLines.at(newEnd + k));
+        oldEnd = edit.oldStart + edit.oldCount;
+        newEnd = edit.newStart + edit.newCount;
+        changedLines += edit.oldCount + edit.newCount;
+
+        // Cada edición por separado solo cambia sus líneas
+        const QString single = DeepSeekTextDiff::applyEdits(oldLines, newLines, {edit});
+        QCOMPARE(DeepSeekTextDiff::splitLines(single).size(),
+                 oldLines.size() - edit.oldCount + edit.newCount);
+    }
+    QCOMPARE(changedLines, editDistance(oldLines, newLines));
+    QCOMPARE(edits.isEmpty(), oldText == newText);
+}
+
+void DeepSeekTests::diffLimits()
+{
+    // Por encima de MaxEditDistance se sustituye la región central completa
+    QStringList oldLines;
+    QStringList newLines;
+    for (int i = 0; i < DeepSeekTextDiff::MaxEditDistance; ++i) {
+        oldLines.append(QString("old %1\n").arg(i));
+        newLines.append(QString("new %1\n").arg(i));
+    }
+    oldLines.prepend("head\n");
+    newLines.prepend("head\n");
+    oldLines.append("tail\n");
+    newLines.append("tail\n");
+    const QList<DeepSeekTextDiff::Edit> edits = DeepSeekTextDiff::diff(oldLines, newLines);
+    QCOMPARE(edits.size(), 1);
+    QCOMPARE(edits.first().oldStart, 1);
+    QCOMPARE(edits.first().oldCount, DeepSeekTextDiff::MaxEditDistance);
+    QCOMPARE(edits.first().newCount, DeepSeekTextDiff::MaxEditDistance);
+    QCOMPARE(DeepSeekTextDiff::applyEdits(oldLines, newLines, edits), newLines.join(QString()));
+
+    // Cancelado: lista vacía
+    QVERIFY(DeepSeekTextDiff::diff({"a\n"}, {"b\n"}, [] { return true; }).isEmpty());
+}
+
+static void writeFile(const QString &path, const QByteArray &content)
+{
+    QVERIFY(QDir().mkpath(QFileInfo(path).absolutePath()));
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QCOMPARE(file.write(content), content.size());
+}
+
+static QByteArray readFile(const QString &path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+// Temporales, copias o diario que hayan quedado en el directorio
+static QStringList leftovers(const QString &directory)
+{
+    return QDir(directory).entryList({"*.deepseek-*", "journal.json"}, QDir::Files);
+}
+
+void DeepSeekTests::editTransactionCommit()
+{
+    const QString directory = m_dir.filePath("edits-commit");
+    const QString crlf = directory + "/crlf.cpp";
+    const QString lf = directory + "/lf.cpp";
+    const QString created = directory + "/new/created.cpp";
+    writeFile(crlf, "int a;\r\nint b;\r\n");
+    writeFile(lf, "int x;\n");
+
+    DeepSeekEditTransaction transaction(directory + "/journal.json");
+    transaction.addFile(crlf, "int a;\nint c;\n");
+    transaction.addFile(lf, "int y;\n");
+    transaction.addFile(created, "int z;\n");
+    transaction.addFile(lf, "int w;\n"); // sustituye al anterior
+    QCOMPARE(transaction.files().size(), 3);
+
+    QString errorString;
+    QVERIFY2(transaction.commit(&errorString), qPrintable(errorString));
+    QCOMPARE(readFile(crlf), QByteArray("int a;\r\nint c;\r\n"));
+    QCOMPARE(readFile(lf), QByteArray("int w;\n"));
+    QCOMPARE(readFile(created), QByteArray("int z;\n"));
+    QVERIFY(leftovers(directory).isEmpty());
+    QVERIFY(leftovers(directory + "/new").isEmpty());
+}
+
+// Si un fichero no se puede preparar no se toca ninguno
+void DeepSeekTests::editTransactionStageFailure()
+{
+    const QString directory = m_dir.filePath("edits-failure");
+    const QString target = directory + "/target.cpp";
+    writeFile(target, "int a;\n");
+    writeFile(directory + "/blocker", "not a directory\n");
+
+    DeepSeekEditTransaction transaction(directory + "/journal.json");
+    transaction.addFile(target, "int b;\n");
+    transaction.addFile(directory + "/blocker/child.cpp", "int c;\n");
+
+    QString errorString;
+    QVERIFY(!transaction.commit(&errorString));
+    QVERIFY(!errorString.isEmpty());
+    QCOMPARE(readFile(target), QByteArray("int a;\n"));
+    QVERIFY(leftovers(directory).isEmpty());
+}
+
+static void writeJournal(const QString &path, bool committed, const QJsonArray &files)
+{
+    writeFile(path, QJsonDocument(QJsonObject{{"committed", committed}, {"files", files}})
+                        .toJson(QJsonDocument::Compact));
+}
+
+static QJsonObject journalEntry(const QString &target, const QString &temp, bool existed)
+{
+    return QJsonObject{{"target", target},
+                       {"temp", temp},
+                       {"backup", target + ".deepseek-backup"},
+                       {"existed", existed}};
+}
+
+// Estado que deja un cierre a mitad de la confirmación
+void DeepSeekTests::editTransactionRecover()
+{
+    const QString directory = m_dir.filePath("edits-recover");
+    const QString journal = directory + "/journal.json";
+    const QString replaced = directory + "/replaced.cpp";
+    const QString pending = directory + "/pending.cpp";
+    const QString created = directory + "/created.cpp";
+
+    // Ya sustituido (con su copia), aún sin tocar y nuevo ya creado
+    writeFile(replaced, "new replaced\n");
+    writeFile(replaced + ".deepseek-backup", "old replaced\n");
+    writeFile(pending, "old pending\n");
+    writeFile(pending + ".deepseek-tmp", "new pending\n");
+    writeFile(created, "new created\n");
+    writeJournal(journal, false,
+                 {journalEntry(replaced, replaced + ".deepseek-tmp", true),
+                  journalEntry(pending, pending + ".deepseek-tmp", true),
+                  journalEntry(created, created + ".deepseek-tmp", false)});
+
+    QString errorString;
+    QVERIFY2(DeepSeekEditTransaction::recover(journal, &errorString), qPrintable(errorString));
+    QCOMPARE(readFile(replaced), QByteArray("old replaced\n"));
+    QCOMPARE(readFile(pending), QByteArray("old pending\n"));
+    QVERIFY(!QFile::exists(created));
+    QVERIFY(leftovers(directory).isEmpty());
+
+    // Confirmada antes del cierre: se conserva y solo se limpian las copias
+    writeFile(replaced, "new replaced\n");
+    writeFile(replaced + ".deepseek-backup", "old replaced\n");
+    writeJournal(journal, true, {journalEntry(replaced, replaced + ".deepseek-tmp", true)});
+    QVERIFY2(DeepSeekEditTransaction::recover(journal, &errorString), qPrintable(errorString));
+    QCOMPARE(readFile(replaced), QByteArray("new replaced\n"));
+    QVERIFY(leftovers(directory).isEmpty());
+
+    // Sin diario no hay nada que hacer
+    QVERIFY(DeepSeekEditTransaction::recover(journal, &errorString));
+}
+
+static QByteArray fillerLines(int first, int count)
+{
+    QByteArray text;
+    for (int i = first; i < first + count; ++i)
+        text += "    int value" + QByteArray::number(i) + " = compute(" + QByteArray::number(i)
+                + ");\n";
+    return text;
+}
+
+void DeepSeekTests::projectIndexSearch()
+{
+    QCOMPARE(DeepSeekProjectIndex::tokenize(u"parseHttpHeader(HTTPServer *s, 42)"),
+             QStringList({"parsehttpheader", "parse", "http", "header", "httpserver", "http",
+                          "server"}));
+
+    const QString directory = m_dir.filePath("index");
+    const QString parser = directory + "/parser.cpp";
+    const QString network = directory + "/network.cpp";
+    const QString unrelated = directory + "/unrelated.cpp";
+    writeFile(parser, fillerLines(0, 50) + "HttpHeader parseHttpHeader(const QByteArray &line);\n"
+                          + fillerLines(51, 29));
+    writeFile(network, fillerLines(0, 10) + "// sends the http request\n" + fillerLines(11, 20));
+    writeFile(unrelated, fillerLines(0, 30));
+    writeFile(directory + "/binary.bin", QByteArray("http\0header", 11));
+
+    DeepSeekProjectIndex index;
+    QString errorString;
+    for (const QString &path : {parser, network, unrelated})
+        QVERIFY2(index.updateFile(path, &errorString), qPrintable(errorString));
+    QVERIFY(!index.updateFile(directory + "/binary.bin"));
+    QCOMPARE(index.fileCount(), 3);
+    QCOMPARE(index.chunkCount(), 4);
+
+    QList<DeepSeekProjectIndex::Hit> hits = index.search("parse http header", 5);
+    QCOMPARE(hits.size(), 2);
+    QCOMPARE(hits.at(0).filePath, parser);
+    QCOMPARE(hits.at(0).startLine, DeepSeekProjectIndex::ChunkLines);
+    QCOMPARE(hits.at(1).filePath, network);
+    QVERIFY(hits.at(0).score > hits.at(1).score);
+    QVERIFY(index.search("nothing matches", 5).isEmpty());
+
+    // Actualización incremental: el fragmento sustituido deja de aparecer
+    writeFile(parser, fillerLines(0, 20));
+    QVERIFY(index.updateFile(parser));
+    hits = index.search("parse http header", 5);
+    QCOMPARE(hits.size(), 1);
+    QCOMPARE(hits.first().filePath, network);
+
+    index.removeFile(network);
+    QVERIFY(!index.contains(network));
+    QVERIFY(index.search("http", 5).isEmpty());
+}
+
+void DeepSeekTests::reciprocalRankFusion()
+{
+    using Hit = DeepSeekProjectIndex::Hit;
+    const QList<Hit> lexical{{"/p/a.cpp", 0, 40, 12.0},
+                             {"/p/b.cpp", 40, 40, 9.0},
+                             {"/p/c.cpp", 0, 40, 1.0},
+                             {"/p/a.cpp", 40, 40, 0.5}};
+    const QList<Hit> semantic{{"/p/c.cpp", 0, 40, 0.91},
+                              {"/p/b.cpp", 40, 40, 0.90},
+                              {"/p/d.cpp", 80, 40, 0.2}};
+    const int k = 60;
+
+    // c: 1/63 + 1/61 supera por poco a b: 1/62 + 1/62
+    const QList<Hit> fused = DeepSeekProjectIndex::fuse({lexical, semantic}, k);
+    QCOMPARE(fused.size(), 5);
+    const QStringList order{"/p/c.cpp", "/p/b.cpp", "/p/a.cpp", "/p/d.cpp", "/p/a.cpp"};
+    for (int i = 0; i < order.size(); ++i)
+        QCOMPARE(fused.at(i).filePath, order.at(i));
+    QCOMPARE(fused.at(0).score, 1.0 / 63 + 1.0 / 61);
+    QCOMPARE(fused.at(1).score, 1.0 / 62 + 1.0 / 62);
+    QCOMPARE(fused.at(1).startLine, 40);
+    QCOMPARE(fused.at(4).startLine, 40);
+
+    // Solo cuenta el rango, no la escala de las puntuaciones
+    QList<Hit> scaled = semantic;
+    for (Hit &hit : scaled)
+        hit.score *= 1000.0;
+    const QList<Hit> rescaled = DeepSeekProjectIndex::fuse({lexical, scaled}, k);
+    for (int i = 0; i < fused.size(); ++i) {
+        QCOMPARE(rescaled.at(i).filePath, fused.at(i).filePath);
+        QCOMPARE(rescaled.at(i).score, fused.at(i).score);
+    }
+    QVERIFY(DeepSeekProjectIndex::fuse({}, k).isEmpty());
+}
+
+void DeepSeekTests::similarityMatchesScalar_data()
+{
+    QTest::addColumn<int>("dimension");
+    // Colas de todos los tamaños alrededor de los bloques de 8 y 16
+    for (int dimension : {1, 7, 8, 9, 15, 16, 17, 31, 33, 384, 768, 1023, 1536})
+        QTest::addRow("%d", dimension) << dimension;
+}
+
+// Los núcleos AVX2/NEON deben dar lo mismo que los bucles escalares
+void DeepSeekTests::similarityMatchesScalar()
+{
+    QFETCH(int, dimension);
+    const char *instructionSet = DeepSeekSimilarity::instructionSet();
+    QRandomGenerator random(quint32(dimension));
+
+    // Un elemento de más para probar también con punteros desalineados
+    std::vector<float> a(dimension + 1);
+    std::vector<float> b(dimension + 1);
+    for (int i = 0; i <= dimension; ++i) {
+        a[i] = float(random.generateDouble() * 2.0 - 1.0);
+        b[i] = float(random.generateDouble() * 2.0 - 1.0);
+    }
+    for (const int offset : {0, 1}) {
+        double expected = 0.0;
+        double magnitude = 0.0;
+        for (int i = 0; i < dimension; ++i) {
+            expected += double(a[offset + i]) * b[offset + i];
+            magnitude += std::fabs(double(a[offset + i]) * b[offset + i]);
+        }
+        const float actual
+            = DeepSeekSimilarity::dot(a.data() + offset, b.data() + offset, dimension);
+        QVERIFY2(std::fabs(actual - expected) <= 1e-5 * magnitude + 1e-6,
+                 qPrintable(QString("%1: %2 != %3")
+                                .arg(QString::fromLatin1(instructionSet))
+                                .arg(actual)
+                                .arg(expected)));
+    }
+
+    // En enteros el resultado es exacto
+    std::vector<std::int8_t> qa(dimension + 1);
+    std::vector<std::int8_t> qb(dimension + 1);
+    for (int i = 0; i <= dimension; ++i) {
+        qa[i] = std::int8_t(random.bounded(-127, 128));
+        qb[i] = std::int8_t(random.bounded(-127, 128));
+    }
+    qa[0] = 127;
+    qb[0] = -127;
+    for (const int offset : {0, 1}) {
+        std::int32_t expected = 0;
+        for (int i = 0; i < dimension; ++i)
+            expected += std::int32_t(qa[offset + i]) * qb[offset + i];
+        QCOMPARE(DeepSeekSimilarity::dotInt8(qa.data() + offset, qb.data() + offset, dimension),
+                 expected);
+    }
+
+    // Coseno cuantizado frente al de float32: error < 1%
+    std::vector<float> na(a.begin(), a.begin() + dimension);
+    std::vector<float> nb(b.begin(), b.begin() + dimension);
+    QVERIFY(DeepSeekSimilarity::normalize(na));
+    QVERIFY(DeepSeekSimilarity::normalize(nb));
+    std::vector<std::int8_t> ia(dimension);
+    std::vector<std::int8_t> ib(dimension);
+    const float scaleA = DeepSeekSimilarity::quantize(na.data(), dimension, ia.data());
+    const float scaleB = DeepSeekSimilarity::quantize(nb.data(), dimension, ib.data());
+    QVERIFY(scaleA > 0.0f && scaleB > 0.0f);
+    const float cosine = DeepSeekSimilarity::dot(na.data(), nb.data(), dimension);
+    const float quantized = float(DeepSeekSimilarity::dotInt8(ia.data(), ib.data(), dimension))
+                            / (scaleA * scaleB);
+    QVERIFY2(std::fabs(quantized - cosine) < 0.01f,
+             qPrintable(QString("%1 != %2").arg(quantized).arg(cosine)));
+
+    std::vector<float> zero(dimension, 0.0f);
+    QVERIFY(!DeepSeekSimilarity::normalize(zero));
+    QCOMPARE(DeepSeekSimilarity::quantize(zero.data(), dimension, ia.data()), 0.0f);
+}
+
+void DeepSeekTests::similarityTopK()
+{
+    QRandomGenerator random(7);
+    std::vector<DeepSeekSimilarity::Candidate> all;
+    std::vector<DeepSeekSimilarity::Candidate> heap;
+    for (std::uint32_t id = 0; id < 1000; ++id) {
+        const float score = float(random.generateDouble());
+        all.emplace_back(score, id);
+        DeepSeekSimilarity::pushTopK(heap, 10, score, id);
+    }
+    QCOMPARE(heap.size(), size_t(10));
+    DeepSeekSimilarity::sortTopK(heap);
+    std::sort(all.begin(), all.end(), std::greater<>());
+    for (size_t i = 0; i < heap.size(); ++i)
+        QCOMPARE(heap[i], all[i]);
+
+    std::vector<DeepSeekSimilarity::Candidate> none;
+    DeepSeekSimilarity::pushTopK(none, 0, 1.0f, 0);
+    QVERIFY(none.empty());
+}
+
+void DeepSeekTests::vectorStoreCompaction_data()
+{
+    QTest::addColumn<DeepSeekVectorStore::Precision>("precision");
+    QTest::newRow("float32") << DeepSeekVectorStore::Precision::Float32;
+    QTest::newRow("int8") << DeepSeekVectorStore::Precision::Int8;
+}
+
+static std::vector<float> axisVector(int dimension, int axis)
+{
+    std::vector<float> vector(dimension, 0.01f);
+    vector[axis] = 1.0f;
+    return vector;
+}
+
+// Reemplazar un fichero una y otra vez no hace crecer el almacén
+void DeepSeekTests::vectorStoreCompaction()
+{
+    QFETCH(DeepSeekVectorStore::Precision, precision);
+    const int dimension = 24;
+    const QString path = m_dir.filePath(QString("vectors/store-%1.bin").arg(int(precision)));
+    const QString keep = "/p/keep.cpp";
+    const QString churn = "/p/churn.cpp";
+    const QDateTime base = QDateTime::fromSecsSinceEpoch(1700000000);
+    QString errorString;
+
+    {
+        DeepSeekVectorStore store(path);
+        QVERIFY2(store.open("embedding-model", precision, &errorString), qPrintable(errorString));
+        QVERIFY2(store.replaceFile(keep, base, {{keep, 0, 40, axisVector(dimension, 0)}},
+                                   &errorString),
+                 qPrintable(errorString));
+
+        qint64 firstSize = 0;
+        for (int round = 0; round < 20; ++round) {
+            QList<DeepSeekVectorStore::Entry> entries;
+            for (int j = 0; j < 4; ++j)
+                entries.append({churn, j * 40, 40, axisVector(dimension, 1 + (round + j) % 20)});
+            QVERIFY2(store.replaceFile(churn, base.addSecs(round), entries, &errorString),
+                     qPrintable(errorString));
+            QCOMPARE(store.count(), qsizetype(5));
+
+            // Los registros borrados nunca superan a los vivos
+            const qint64 size = QFileInfo(path).size();
+            if (round == 0)
+                firstSize = size;
+            QVERIFY(size <= 2 * firstSize);
+            QFile paths(path + ".paths");
+            QVERIFY(paths.open(QIODevice::ReadOnly));
+            QVERIFY(paths.readAll().count('\n') <= 4);
+        }
+
+        QVERIFY(store.isCurrent(churn, base.addSecs(19)));
+        QVERIFY(!store.isCurrent(churn, base.addSecs(18)));
+        const QList<DeepSeekVectorStore::Hit> hits = store.search(axisVector(dimension, 20), 3);
+        QCOMPARE(hits.size(), 3);
+        QCOMPARE(hits.first().filePath, churn);
+        QCOMPARE(hits.first().startLine, 0);
+        QVERIFY(hits.first().score > 0.99f);
+    }
+
+    // Reabierto desde el disco
+    {
+        DeepSeekVectorStore store(path);
+        QVERIFY2(store.open("embedding-model", precision, &errorString), qPrintable(errorString));
+        QCOMPARE(store.count(), qsizetype(5));
+        QCOMPARE(store.dimension(), dimension);
+        QVERIFY(store.isCurrent(keep, base));
+        const QList<DeepSeekVectorStore::Hit> hits = store.search(axisVector(dimension, 0), 1);
+        QCOMPARE(hits.size(), 1);
+        QCOMPARE(hits.first().filePath, keep);
+        QVERIFY(hits.first().score > 0.99f);
+
+        store.removeFile(churn);
+        QCOMPARE(store.count(), qsizetype(1));
+    }
+
+    // Otro modelo: los vectores no son comparables y se empieza de cero
+    DeepSeekVectorStore store(path);
+    QVERIFY2(store.open("other-model", precision, &errorString), qPrintable(errorString));
+    QCOMPARE(store.count(), qsizetype(0));
+    QVERIFY(!store.isCurrent(keep, base));
+}
+
+// tokenizer.json mínimo: un token por byte (bytes_to_unicode de GPT-2) más
+// los resultados de las fusiones
+static QString writeTokenizer(const QString &path, const QJsonArray &merges)
+{
+    QJsonObject vocab;
+    int shifted = 0;
+    for (int byte = 0; byte < 256; ++byte) {
+        const bool printable = (byte >= 33 && byte <= 126) || (byte >= 161 && byte <= 172)
+                               || byte >= 174;
+        const char16_t symbol = printable ? char16_t(byte) : char16_t(256 + shifted++);
+        vocab.insert(QString(QChar(symbol)), byte);
+    }
+    int id = 256;
+    for (const QJsonValue &merge : merges) {
+        const QJsonArray pair = merge.toArray();
+        const QString token = merge.isArray() ? pair.at(0).toString() + pair.at(1).toString()
+                                              : QString(merge.toString()).remove(' ');
+        if (!vocab.contains(token))
+            vocab.insert(token, id++);
+    }
+
+    const QJsonObject model{{"type", "BPE"}, {"vocab", vocab}, {"merges", merges}};
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        file.write(QJsonDocument(QJsonObject{{"model", model}}).toJson(QJsonDocument::Compact));
+    return path;
+}
+
+void DeepSeekTests::tokenizerMerges_data()
+{
+    // "Ġ" es el espacio en bytes_to_unicode
+    const QList<QPair<QString, QString>> pairs{{"h", "e"}, {"l", "l"}, {"he", "ll"},
+                                              {"hell", "o"}, {"b", "c"}, {"a", "b"},
+                                              {"ab", "c"}, {"Ġ", "hello"}};
+    QJsonArray arrays;
+    QJsonArray strings;
+    for (const auto &[left, right] : pairs) {
+        arrays.append(QJsonArray{left, right});
+        strings.append(left + ' ' + right);
+    }
+    QTest::addColumn<QJsonArray>("merges");
+    QTest::newRow("pairs") << arrays;
+    QTest::newRow("strings") << strings;
+}
+
+void DeepSeekTests::tokenizerMerges()
+{
+    QFETCH(QJsonArray, merges);
+    QString errorString;
+    const QString tag = QString::fromLatin1(QTest::currentDataTag());
+    const QString path = writeTokenizer(m_dir.filePath("tokenizer-" + tag + ".json"), merges);
+    const DeepSeekTokenizer::ModelPtr model = DeepSeekTokenizer::parse(path, &errorString);
+    QVERIFY2(model, qPrintable(errorString));
+
+    DST::inst()->install(model);
+    const auto unload = qScopeGuard([] { DST::inst()->unload(); });
+    QVERIFY(DST::inst()->isLoaded());
+    QCOMPARE(DST::inst()->filePath(), path);
+
+    const DeepSeekTokenizer *tokenizer = DST::inst();
+    QCOMPARE(tokenizer->count(u"hello"), 1);
+    QCOMPARE(tokenizer->count(u"hellx"), 2);
+    QCOMPARE(tokenizer->count(u"hellhello"), 2);
+    // Primero la fusión de menor rango: b+c antes que a+b, así que no llega a "abc"
+    QCOMPARE(tokenizer->count(u"abc"), 2);
+    // El espacio va con la palabra siguiente
+    QCOMPARE(tokenizer->count(u"hello hello"), 2);
+    QCOMPARE(tokenizer->count(u" hello"), 1);
+    // Números de hasta tres cifras, sin fusiones
+    QCOMPARE(tokenizer->count(u"12345"), 5);
+    // Fuera de ASCII: un token por byte UTF-8
+    QCOMPARE(tokenizer->count(QString::fromUtf8("é")), 2);
+    QCOMPARE(tokenizer->count(u""), 0);
+    QCOMPARE(tokenizer->countCached("hello hello"), 2);
+    QCOMPARE(tokenizer->countCached("hello hello"), 2);
+
+    DST::inst()->unload();
+    QCOMPARE(tokenizer->count(u"hello"), -1);
+}
+
+void DeepSeekTests::tokenizerRejects()
+{
+    QString errorString;
+    QVERIFY(!DeepSeekTokenizer::parse(m_dir.filePath("missing.json"), &errorString));
+    QVERIFY(!errorString.isEmpty());
+
+    const QString wordPiece = m_dir.filePath("wordpiece.json");
+    writeFile(wordPiece, R"({"model":{"type":"WordPiece","vocab":{}}})");
+    errorString.clear();
+    QVERIFY(!DeepSeekTokenizer::parse(wordPiece, &errorString));
+    QVERIFY(errorString.contains("WordPiece"));
+
+    errorString.clear();
+    QVERIFY(!DeepSeekTokenizer::parse(writeTokenizer(m_dir.filePath("nomerges.json"), {}),
+                                      &errorString));
+    QVERIFY(!errorString.isEmpty());
+}
+
+void DeepSeekTests::metricsPercentiles()
+{
+    using Metrics = DeepSeekRequestMetrics;
+    Metrics metrics;
+    for (int i = 1; i <= 100; ++i) {
+        Metrics::Sample sample;
+        sample.totalMs = i;
+        sample.firstByteMs = i <= 50 ? i : -1;
+        metrics.add(sample);
+    }
+    // Las peticiones con error no cuentan
+    Metrics::Sample failed;
+    failed.totalMs = 100000;
+    failed.error = Metrics::ErrorClass::Server;
+    metrics.add(failed);
+    QCOMPARE(metrics.errorCount(), 1);
+
+    // Rango más cercano: posición ceil(p * n)
+    const Metrics::Percentiles total = metrics.percentiles(Metrics::Field::Total);
+    QCOMPARE(total.samples, 100);
+    QCOMPARE(total.p50, 50);
+    QCOMPARE(total.p95, 95);
+    QCOMPARE(total.p99, 99);
+
+    const Metrics::Percentiles firstByte = metrics.percentiles(Metrics::Field::FirstByte);
+    QCOMPARE(firstByte.samples, 50);
+    QCOMPARE(firstByte.p50, 25);
+    QCOMPARE(firstByte.p95, 48);
+    QCOMPARE(firstByte.p99, 50);
+
+    const Metrics::Percentiles connect = metrics.percentiles(Metrics::Field::Connect);
+    QCOMPARE(connect.samples, 0);
+    QCOMPARE(connect.p50, -1);
+
+    Metrics single;
+    Metrics::Sample sample;
+    sample.promptTokens = 1200;
+    single.add(sample);
+    const Metrics::Percentiles prompt = single.percentiles(Metrics::Field::PromptTokens);
+    QCOMPARE(prompt.samples, 1);
+    QCOMPARE(prompt.p50, 1200);
+    QCOMPARE(prompt.p99, 1200);
+}
+
+void DeepSeekTests::metricsRingBuffer()
+{
+    DeepSeekRequestMetrics metrics(10);
+    for (int i = 0; i < 15; ++i) {
+        DeepSeekRequestMetrics::Sample sample;
+        sample.totalMs = i;
+        metrics.add(sample);
+    }
+    QCOMPARE(metrics.size(), 10);
+    QCOMPARE(metrics.capacity(), 10);
+    const QList<DeepSeekRequestMetrics::Sample> samples = metrics.samples();
+    for (int i = 0; i < samples.size(); ++i)
+        QCOMPARE(samples.at(i).totalMs, qint64(5 + i));
+    QCOMPARE(metrics.percentiles(DeepSeekRequestMetrics::Field::Total).p50, 9);
+
+    metrics.clear();
+    QCOMPARE(metrics.size(), 0);
+    QVERIFY(metrics.samples().isEmpty());
+}
+
+// Respuesta ya terminada, sin red: estado HTTP y código de error fijos
+class FakeReply : public QNetworkReply
+{
+public:
+    FakeReply(int httpStatus, NetworkError error)
+    {
+        if (httpStatus > 0)
+            setAttribute(QNetworkRequest::HttpStatusCodeAttribute, httpStatus);
+        setError(error, QString());
+        open(QIODevice::ReadOnly);
+    }
+
+    void abort() override {}
+
+protected:
+    qint64 readData(char *, qint64) override { return -1; }
+};
+
+void DeepSeekTests::metricsClassifyFinish_data()
+{
+    using ErrorClass = DeepSeekRequestMetrics::ErrorClass;
+    using Reason = DeepSeekRequestScheduler::FinishReason;
+    QTest::addColumn<bool>("hasReply");
+    QTest::addColumn<int>("httpStatus");
+    QTest::addColumn<int>("networkError");
+    QTest::addColumn<Reason>("reason");
+    QTest::addColumn<ErrorClass>("marked");
+    QTest::addColumn<ErrorClass>("expected");
+
+    QTest::newRow("ok") << true << 200 << int(QNetworkReply::NoError) << Reason::Completed
+                        << ErrorClass::None << ErrorClass::None;
+    QTest::newRow("404") << true << 404 << int(QNetworkReply::ContentNotFoundError)
+                         << Reason::Completed << ErrorClass::None << ErrorClass::Client;
+    QTest::newRow("429") << true << 429 << int(QNetworkReply::UnknownContentError)
+                         << Reason::Completed << ErrorClass::None << ErrorClass::Client;
+    QTest::newRow("503") << true << 503 << int(QNetworkReply::ServiceUnavailableError)
+                         << Reason::Completed << ErrorClass::None << ErrorClass::Server;
+    QTest::newRow("refused") << true << 0 << int(QNetworkReply::ConnectionRefusedError)
+                             << Reason::Completed << ErrorClass::None << ErrorClass::Network;
+    QTest::newRow("timeout") << true << 0 << int(QNetworkReply::OperationCanceledError)
+                             << Reason::TimedOut << ErrorClass::None << ErrorClass::Timeout;
+    QTest::newRow("canceled") << true << 200 << int(QNetworkReply::OperationCanceledError)
+                              << Reason::Canceled << ErrorClass::None << ErrorClass::Canceled;
+    QTest::newRow("canceled in queue") << false << 0 << int(QNetworkReply::NoError)
+                                       << Reason::Completed << ErrorClass::None
+                                       << ErrorClass::Canceled;
+    // El abort() de quien interpreta la respuesta no es un error de red
+    QTest::newRow("protocol") << true << 200 << int(QNetworkReply::OperationCanceledError)
+                              << Reason::Completed << ErrorClass::Protocol << ErrorClass::Protocol;
+}
+
+void DeepSeekTests::metricsClassifyFinish()
+{
+    using ErrorClass = DeepSeekRequestMetrics::ErrorClass;
+    QFETCH(bool, hasReply);
+    QFETCH(int, httpStatus);
+    QFETCH(int, networkError);
+    QFETCH(DeepSeekRequestScheduler::FinishReason, reason);
+    QFETCH(ErrorClass, marked);
+    QFETCH(ErrorClass, expected);
+
+    FakeReply reply(httpStatus, QNetworkReply::NetworkError(networkError));
+    DeepSeekRequestMetrics::Sample sample;
+    sample.error = marked;
+    DeepSeekRequestMetrics::classifyFinish(sample, hasReply ? &reply : nullptr, reason);
+    QCOMPARE(sample.error, expected);
+    QCOMPARE(sample.httpStatus, hasReply ? httpStatus : 0);
+    QVERIFY(!DeepSeekRequestMetrics::errorClassName(expected).isEmpty());
+}
+
+QTEST_GUILESS_MAIN(DeepSeekTests)
+
+#include "tst_deepseektests.moc"
@@ -0,0 +1,705 @@
+#include "deepseekbatchanalysis.h"
+#include "deepseekreplyreader.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QLoggingCategory>
+#include <QNetworkReply>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <cmath>
+#include <limits>
+
+namespace DeepSeek {
+
+Q_LOGGING_CATEGORY(deepseekAnalysisLog, "qtc.deepseek.analysis", QtWarningMsg)
+
+static constexpr int JournalVersion = 1;
+
+static const char AnalysisSystemPrompt[]
+    = "You review source code. Apply the user's instruction to the file fragment they send; "
+      "each line of the fragment starts with its line number. Reply only with a JSON object "
+      "of the form {\"issues\": [{\"line\": <line number>, \"severity\": \"error\" or "
+      "\"warning\", \"message\": \"<one or two sentences>\"}]}. Use an empty \"issues\" array "
+      "when there is nothing to report.";
+
+static void setError(QString *errorString, const QString &message)
+{
+    if (errorString)
+        *errorString = message;
+}
+
+// =============================
+// DeepSeekTokenBucket
+// =============================
+void DeepSeekTokenBucket::setRate(double ratePerSecond, double capacity)
+{
+    m_rate = qMax(ratePerSecond, 0.001);
+    m_capacity = qMax(capacity, 1.0);
+    m_tokens = qMin(m_tokens, m_capacity);
+}
+
+void DeepSeekTokenBucket::reset(qint64 nowMs)
+{
+    m_tokens = m_capacity;
+    m_lastMs = nowMs;
+}
+
+double DeepSeekTokenBucket::available(qint64 nowMs) const
+{
+    return qMin(m_capacity, m_tokens + double(nowMs - m_lastMs) * m_rate / 1000.0);
+}
+
+bool DeepSeekTokenBucket::tryTake(qint64 nowMs)
+{
+    m_tokens = available(nowMs);
+    m_lastMs = nowMs;
+    if (m_tokens < 1.0)
+        return false;
+    m_tokens -= 1.0;
+    return true;
+}
+
+qint64 DeepSeekTokenBucket::msUntilAvailable(qint64 nowMs) const
+{
+    const double tokens = available(nowMs);
+    if (tokens >= 1.0)
+        return 0;
+    return qint64(std::ceil((1.0 - tokens) * 1000.0 / m_rate));
+}
+
+// =============================
+// DeepSeekBatchAnalysis
+// =============================
+DeepSeekBatchAnalysis::DeepSeekBatchAnalysis(DeepSeekRequestScheduler *scheduler, QObject *parent)
+    : QObject(parent)
+    , m_scheduler(scheduler)
+{
+    m_readPool.setMaxThreadCount(1);
+    m_pumpTimer.setSingleShot(true);
+    connect(&m_pumpTimer, &QTimer::timeout, this, &DeepSeekBatchAnalysis::pump);
+    connect(m_scheduler, &DeepSeekRequestScheduler::finished,
+            this, &DeepSeekBatchAnalysis::onRequestFinished);
+}
+
+DeepSeekBatchAnalysis::~DeepSeekBatchAnalysis()
+{
+    // Sin señales: el dueño puede estar destruyéndose ya
+    ++m_generation;
+    m_readPool.waitForDone();
+}
+
+void DeepSeekBatchAnalysis::setConcurrency(int maxInFlight)
+{
+    m_concurrency = qMax(1, maxInFlight);
+}
+
+void DeepSeekBatchAnalysis::setRequestsPerMinute(int requestsPerMinute)
+{
+    m_requestsPerMinute = qMax(1, requestsPerMinute);
+}
+
+void DeepSeekBatchAnalysis::setJournalDirectory(const QString &directory)
+{
+    m_journalDirectory = directory;
+}
+
+DeepSeekBatchAnalysis::Stats DeepSeekBatchAnalysis::stats() const
+{
+    Stats stats = m_stats;
+    if (m_running)
+        stats.elapsedMs = m_clock.elapsed();
+    return stats;
+}
+
+QString DeepSeekBatchAnalysis::journalFileName(const QString &projectKey, const QString &command,
+                                               const QString &model)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(projectKey.toUtf8());
+    hash.addData(QByteArrayView("\n"));
+    hash.addData(command.toUtf8());
+    hash.addData(QByteArrayView("\n"));
+    hash.addData(model.toUtf8());
+    return QString::fromLatin1(hash.result().toHex().left(16)) + ".jsonl";
+}
+
+QList<DeepSeekBatchAnalysis::Chunk> DeepSeekBatchAnalysis::chunkText(const QString &text,
+                                                                     int chunkLines, int maxChars)
+{
+    QList<Chunk> chunks;
+    const QStringList lines = text.split('\n');
+
+    Chunk chunk;
+    bool hasContent = false;
+    const auto flush = [&]() {
+        // Un fragmento solo de líneas en blanco no se envía
+        if (chunk.lineCount > 0 && hasContent)
+            chunks.append(chunk);
+        chunk = {};
+        hasContent = false;
+    };
+
+    for (qsizetype i = 0; i < lines.size(); ++i) {
+        QString line = lines.at(i);
+        if (line.endsWith('\r'))
+            line.chop(1);
+        // Una línea desmesurada (p.ej. minificada) no puede llenar ella sola la petición
+        if (line.size() > maxChars)
+            line.truncate(maxChars);
+        const QString numbered = QString::number(i + 1).rightJustified(5) + "| " + line + '\n';
+
+        if (chunk.lineCount >= chunkLines
+            || (chunk.lineCount > 0 && chunk.text.size() + numbered.size() > maxChars)) {
+            flush();
+        }
+        if (chunk.lineCount == 0)
+            chunk.startLine = int(i);
+        chunk.text += numbered;
+        ++chunk.lineCount;
+        hasContent = hasContent || !line.trimmed().isEmpty();
+    }
+    flush();
+    return chunks;
+}
+
+QList<DeepSeekBatchAnalysis::Issue> DeepSeekBatchAnalysis::parseIssues(const QString &content,
+                                                                       const QString &filePath,
+                                                                       const Chunk &chunk,
+                                                                       QString *errorString)
+{
+    // Aun pidiendo JSON, algunos modelos lo envuelven en un bloque ```json
+    QString json = content.trimmed();
+    if (json.startsWith("```")) {
+        const qsizetype begin = json.indexOf('\n');
+        const qsizetype end = json.lastIndexOf("```");
+        if (begin >= 0 && end > begin)
+            json = json.mid(begin + 1, end - begin - 1);
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(json.toUtf8(), &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        setError(errorString, tr("Invalid analysis reply: %1").arg(parseError.errorString()));
+        return {};
+    }
+    if (!doc.isArray() && !doc.object().value("issues").isArray()) {
+        setError(errorString, tr("Analysis reply without an \"issues\" array"));
+        return {};
+    }
+
+    const QJsonArray items = doc.isArray() ? doc.array() : doc.object().value("issues").toArray();
+    QList<Issue> issues;
+    for (const QJsonValue &value : items) {
+        Issue issue = fromJson(value.toObject(), filePath);
+        if (issue.message.isEmpty())
+            continue;
+        if (issue.line <= chunk.startLine || issue.line > chunk.startLine + chunk.lineCount)
+            issue.line = 0;
+        issues.append(issue);
+    }
+    return issues;
+}
+
+QJsonObject DeepSeekBatchAnalysis::toJson(const Issue &issue)
+{
+    return QJsonObject{
+        {"line", issue.line},
+        {"severity", issue.error ? "error" : "warning"},
+        {"message", issue.message}
+    };
+}
+
+DeepSeekBatchAnalysis::Issue DeepSeekBatchAnalysis::fromJson(const QJsonObject &object,
+                                                             const QString &filePath)
+{
+    Issue issue;
+    issue.filePath = filePath;
+    issue.line = object.value("line").toInt();
+    issue.error = object.value("severity").toString().compare("error", Qt::CaseInsensitive) == 0;
+    issue.message = object.value("message").toString().trimmed();
+    return issue;
+}
+
+bool DeepSeekBatchAnalysis::start(const QString &projectKey, const QStringList &files,
+                                  const QString &command, const QNetworkRequest &request,
+                                  const QJsonObject &fields, QString *errorString)
+{
+    if (m_running)
+        cancel();
+    if (!m_scheduler) {
+        setError(errorString, tr("No request scheduler"));
+        return false;
+    }
+    if (files.isEmpty()) {
+        setError(errorString, tr("The project has no source files"));
+        return false;
+    }
+
+    m_command = command;
+    m_request = request;
+    m_fields = fields;
+    if (!openJournal(projectKey, fields.value("model").toString(), errorString))
+        return false;
+
+    ++m_generation;
+    m_files = files;
+    m_nextFile = 0;
+    m_reading = false;
+    m_ready.clear();
+    m_inFlight.clear();
+    m_remaining.clear();
+    m_failed.clear();
+    m_errorString.clear();
+    m_stats = {};
+    m_stats.totalFiles = int(files.size());
+
+    m_clock.start();
+    m_pausedUntilMs = 0;
+    // La ráfaga no pasa de las peticiones que pueden estar en vuelo a la vez
+    m_bucket.setRate(m_requestsPerMinute / 60.0, m_concurrency);
+    m_bucket.reset(0);
+    m_running = true;
+
+    emit progressChanged();
+    pump();
+    return true;
+}
+
+void DeepSeekBatchAnalysis::cancel()
+{
+    if (!m_running)
+        return;
+    abortRun();
+    finish(true);
+}
+
+void DeepSeekBatchAnalysis::stop(const QString &errorString)
+{
+    qWarning().noquote() << "DeepSeek analysis: stopping:" << errorString;
+    m_errorString = errorString;
+    abortRun();
+    finish(true);
+}
+
+void DeepSeekBatchAnalysis::abortRun()
+{
+    // Primero se olvidan: cancel() puede emitir finished() de inmediato
+    const QList<DeepSeekRequestScheduler::RequestId> ids = m_inFlight.keys();
+    m_inFlight.clear();
+    m_ready.clear();
+    if (m_scheduler) {
+        for (const DeepSeekRequestScheduler::RequestId id : ids)
+            m_scheduler->cancel(id);
+    }
+}
+
+void DeepSeekBatchAnalysis::finish(bool canceled)
+{
+    m_running = false;
+    ++m_generation;
+    m_pumpTimer.stop();
+    m_stats.elapsedMs = m_clock.elapsed();
+
+    // Con todo analizado la siguiente pasada empieza de cero. Si falló algún
+    // fragmento se reanuda y solo se repiten los que no están en el diario.
+    if (!canceled && m_stats.failedFiles == 0)
+        appendJournal(QJsonObject{{"finished", true}});
+
+    qCDebug(deepseekAnalysisLog).noquote()
+        << QString("DeepSeek analysis %1: %2/%3 files (%4 resumed, %5 skipped, "
+                   "%6 failed), %7 issues, %8 files/min")
+               .arg(canceled ? "canceled" : "finished")
+               .arg(m_stats.finishedFiles())
+               .arg(m_stats.totalFiles)
+               .arg(m_stats.resumedFiles)
+               .arg(m_stats.skippedFiles)
+               .arg(m_stats.failedFiles)
+               .arg(m_stats.issues)
+               .arg(m_stats.filesPerMinute(), 0, 'f', 1);
+    emit progressChanged();
+    emit finished(canceled);
+}
+
+bool DeepSeekBatchAnalysis::openJournal(const QString &projectKey, const QString &model,
+                                        QString *errorString)
+{
+    m_journal.clear();
+    if (!QDir().mkpath(m_journalDirectory)) {
+        setError(errorString, tr("Failed to create directory: %1").arg(m_journalDirectory));
+        return false;
+    }
+    m_journalPath = QDir(m_journalDirectory).filePath(journalFileName(projectKey, m_command, model));
+
+    QFile file(m_journalPath);
+    bool resume = false;
+    if (file.open(QIODevice::ReadOnly)) {
+        bool finished = false;
+        bool header = false;
+        bool endsWithNewline = true;
+        while (!file.atEnd()) {
+            const QByteArray line = file.readLine();
+            endsWithNewline = line.endsWith('\n');
+            // Una última línea a medias (cierre inesperado) no se interpreta
+            const QJsonObject record = QJsonDocument::fromJson(line).object();
+            if (record.contains("version")) {
+                header = record.value("version").toInt() == JournalVersion;
+                continue;
+            }
+            if (record.contains("finished")) {
+                finished = true;
+                continue;
+            }
+            const QString path = record.value("file").toString();
+            if (path.isEmpty())
+                continue;
+
+            const qint64 modifiedMs = record.value("modified").toInteger();
+            const int count = record.value("chunks").toInt();
+            JournalFile &entry = m_journal[path];
+            if (entry.modifiedMs != modifiedMs || entry.count != count) {
+                // El fichero cambió entre dos pasadas interrumpidas: vale lo último
+                entry = {};
+                entry.modifiedMs = modifiedMs;
+                entry.count = count;
+            }
+            entry.done.insert(record.value("chunk").toInt());
+            for (const QJsonValue &value : record.value("issues").toArray())
+                entry.issues.append(fromJson(value.toObject(), path));
+        }
+        file.close();
+        resume = header && !finished;
+
+        if (resume && !endsWithNewline) {
+            // Lo siguiente debe empezar en una línea nueva
+            if (file.open(QIODevice::Append))
+                file.write("\n");
+            file.close();
+        }
+    }
+
+    if (resume) {
+        qCDebug(deepseekAnalysisLog) << "DeepSeek analysis: resuming" << m_journal.size()
+                                     << "files from" << m_journalPath;
+        return true;
+    }
+
+    m_journal.clear();
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        setError(errorString, tr("Failed to open file: %1").arg(file.errorString()));
+        return false;
+    }
+    const QJsonObject header{
+        {"version", JournalVersion},
+        {"project", projectKey},
+        {"command", m_command},
+        {"model", model},
+        {"started", QDateTime::currentDateTime().toString(Qt::ISODate)}
+    };
+    file.write(QJsonDocument(header).toJson(QJsonDocument::Compact) + '\n');
+    return true;
+}
+
+void DeepSeekBatchAnalysis::appendJournal(const QJsonObject &record)
+{
+    // Un registro por línea y fichero cerrado tras cada uno: lo escrito
+    // sobrevive a un cierre inesperado
+    QFile file(m_journalPath);
+    if (!file.open(QIODevice::Append)) {
+        qWarning() << "Failed to write analysis journal:" << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument(record).toJson(QJsonDocument::Compact) + '\n');
+}
+
+DeepSeekBatchAnalysis::FileChunks DeepSeekBatchAnalysis::readFile(const QString &filePath)
+{
+    // Se ejecuta en m_readPool: no debe tocar el objeto
+    FileChunks result;
+    result.filePath = filePath;
+
+    const QFileInfo info(filePath);
+    result.modified = info.lastModified();
+    if (!info.isFile() || info.size() > MaxFileSize)
+        return result;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return result;
+    const QByteArray data = file.readAll();
+    if (data.left(8192).contains('\0'))
+        return result;
+
+    result.chunks = chunkText(QString::fromUtf8(data));
+    return result;
+}
+
+void DeepSeekBatchAnalysis::pump()
+{
+    if (!m_running)
+        return;
+
+    // Lectura anticipada de un fichero cada vez, sin pasar de ReadAhead fragmentos
+    if (!m_reading && m_ready.size() < ReadAhead && m_nextFile < m_files.size()) {
+        m_reading = true;
+        const quint64 generation = m_generation;
+        QtConcurrent::run(&m_readPool, &DeepSeekBatchAnalysis::readFile, m_files.at(m_nextFile++))
+            .then(this, [this, generation](const FileChunks &file) {
+                if (generation == m_generation)
+                    onFileRead(file);
+            });
+    }
+
+    while (!m_ready.isEmpty() && m_inFlight.size() < m_concurrency) {
+        const qint64 now = m_clock.elapsed();
+        const qint64 wait = qMax(m_pausedUntilMs - now, m_bucket.msUntilAvailable(now));
+        if (wait > 0) {
+            m_pumpTimer.start(int(qMin<qint64>(wait, std::numeric_limits<int>::max())));
+            break;
+        }
+        m_bucket.tryTake(now);
+        send(m_ready.takeFirst());
+    }
+
+    if (m_inFlight.isEmpty() && m_ready.isEmpty() && !m_reading && m_nextFile >= m_files.size())
+        finish(false);
+}
+
+void DeepSeekBatchAnalysis::onFileRead(const FileChunks &file)
+{
+    m_reading = false;
+
+    if (file.chunks.isEmpty()) {
+        ++m_stats.skippedFiles;
+        emit progressChanged();
+        pump();
+        return;
+    }
+
+    const int count = int(file.chunks.size());
+    const auto journal = m_journal.constFind(file.filePath);
+    const bool known = journal != m_journal.cend()
+                       && journal->modifiedMs == file.modified.toMSecsSinceEpoch()
+                       && journal->count == count;
+    if (known && !journal->issues.isEmpty()) {
+        m_stats.issues += int(journal->issues.size());
+        emit issuesFound(journal->issues);
+    }
+
+    int remaining = 0;
+    for (int i = 0; i < count; ++i) {
+        if (known && journal->done.contains(i))
+            continue;
+        WorkItem item;
+        item.filePath = file.filePath;
+        item.modified = file.modified;
+        item.index = i;
+        item.count = count;
+        item.chunk = file.chunks.at(i);
+        m_ready.append(item);
+        ++remaining;
+    }
+
+    if (remaining == 0)
+        ++m_stats.resumedFiles;
+    else
+        m_remaining.insert(file.filePath, remaining);
+    emit progressChanged();
+    pump();
+}
+
+void DeepSeekBatchAnalysis::send(const WorkItem &item)
+{
+    const QString fragment = QString("%1\n\nFile: %2 (lines %3-%4, part %5 of %6)\n```\n%7```")
+                                 .arg(m_command,
+                                      QDir::toNativeSeparators(item.filePath),
+                                      QString::number(item.chunk.startLine + 1),
+                                      QString::number(item.chunk.startLine + item.chunk.lineCount),
+                                      QString::number(item.index + 1),
+                                      QString::number(item.count),
+                                      item.chunk.text);
+
+    QJsonObject body = m_fields;
+    body["stream"] = false;
+    body["messages"] = QJsonArray{
+        QJsonObject{{"role", "system"}, {"content", QString::fromLatin1(AnalysisSystemPrompt)}},
+        QJsonObject{{"role", "user"}, {"content", fragment}}
+    };
+
+    DeepSeekRequestScheduler::Request scheduled;
+    scheduled.request = m_request;
+    scheduled.body = QJsonDocument(body).toJson(QJsonDocument::Compact);
+    scheduled.priority = DeepSeekRequestScheduler::Priority::Background;
+    scheduled.userMessage = m_command;
+    scheduled.idleTimeoutMs = IdleTimeoutMs;
+    m_inFlight.insert(m_scheduler->enqueue(scheduled), item);
+}
+
+void DeepSeekBatchAnalysis::onRequestFinished(DeepSeekRequestScheduler::RequestId id,
+                                              QNetworkReply *reply,
+                                              DeepSeekRequestScheduler::FinishReason reason)
+{
+    const auto it = m_inFlight.find(id);
+    if (it == m_inFlight.end())
+        return; // del chat o de una pasada cancelada
+    const WorkItem item = it.value();
+    m_inFlight.erase(it);
+
+    if (!reply) {
+        retry(item, tr("Request stopped"));
+        return;
+    }
+
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    const bool timedOut = reason == DeepSeekRequestScheduler::FinishReason::TimedOut;
+    const QString httpError = tr("HTTP %1: %2").arg(status).arg(reply->errorString());
+    switch (classifyReply(status, reply->error() != QNetworkReply::NoError, timedOut)) {
+    case ReplyClass::Throttled: {
+        // Se espera lo que pida el servidor, pero no indefinidamente
+        bool ok = false;
+        const int seconds = reply->rawHeader("Retry-After").trimmed().toInt(&ok);
+        m_pausedUntilMs = m_clock.elapsed()
+                          + 1000ll * (ok && seconds > 0 ? seconds : DefaultRetryAfterSecs);
+        WorkItem throttled = item;
+        if (countAttempt(throttled.attempts, ReplyClass::Throttled))
+            m_ready.prepend(throttled);
+        else
+            giveUp(item, httpError);
+        pump();
+        return;
+    }
+    case ReplyClass::Transient:
+        retry(item, timedOut ? tr("Request timed out") : httpError);
+        return;
+    case ReplyClass::Rejected:
+        giveUp(item, httpError);
+        pump();
+        return;
+    case ReplyClass::Unauthorized:
+        // Con la clave rechazada fallarían todos: se detiene la pasada
+        stop(httpError);
+        return;
+    case ReplyClass::Ok:
+        break;
+    }
+
+    DeepSeekReplyReader reader;
+    reader.feed(reply->readAll());
+    reader.finish();
+    if (reader.hasError()) {
+        retry(item, tr("Invalid response: %1").arg(reader.error()));
+        return;
+    }
+    if (reader.hasApiError()) {
+        retry(item, tr("API error: %1").arg(reader.apiErrorMessage()));
+        return;
+    }
+
+    QString errorString;
+    const QList<Issue> issues = parseIssues(reader.content(), item.filePath, item.chunk,
+                                            &errorString);
+    if (!errorString.isEmpty()) {
+        retry(item, errorString);
+        return;
+    }
+    completeChunk(item, issues);
+    pump();
+}
+
+DeepSeekBatchAnalysis::ReplyClass DeepSeekBatchAnalysis::classifyReply(int httpStatus,
+                                                                       bool networkError,
+                                                                       bool timedOut)
+{
+    if (timedOut)
+        return ReplyClass::Transient;
+    if (httpStatus == 401 || httpStatus == 403)
+        return ReplyClass::Unauthorized;
+    if (httpStatus == 429 || httpStatus == 503)
+        return ReplyClass::Throttled;
+    if (httpStatus >= 400 && httpStatus < 500 && httpStatus != 408)
+        return ReplyClass::Rejected;
+    // Sin estado HTTP (red) o 5xx
+    return networkError || httpStatus >= 500 ? ReplyClass::Transient : ReplyClass::Ok;
+}
+
+bool DeepSeekBatchAnalysis::countAttempt(Attempts &attempts, ReplyClass replyClass)
+{
+    switch (replyClass) {
+    case ReplyClass::Throttled:
+        return ++attempts.throttles < MaxThrottles;
+    case ReplyClass::Transient:
+        return ++attempts.failures < MaxAttempts;
+    case ReplyClass::Rejected:
+    case ReplyClass::Unauthorized:
+        ++attempts.failures;
+        return false;
+    case ReplyClass::Ok:
+        break;
+    }
+    return false;
+}
+
+void DeepSeekBatchAnalysis::retry(WorkItem item, const QString &reason)
+{
+    if (countAttempt(item.attempts, ReplyClass::Transient))
+        m_ready.append(item);
+    else
+        giveUp(item, reason);
+    pump();
+}
+
+void DeepSeekBatchAnalysis::giveUp(const WorkItem &item, const QString &reason)
+{
+    // Sin anotar en el diario: la próxima pasada lo vuelve a intentar
+    qWarning().noquote() << QString("DeepSeek analysis: giving up on %1 (lines %2-%3): %4")
+                                .arg(item.filePath)
+                                .arg(item.chunk.startLine + 1)
+                                .arg(item.chunk.startLine + item.chunk.lineCount)
+                                .arg(reason);
+    finishChunk(item.filePath, true);
+}
+
+void DeepSeekBatchAnalysis::completeChunk(const WorkItem &item, const QList<Issue> &issues)
+{
+    QJsonArray values;
+    for (const Issue &issue : issues)
+        values.append(toJson(issue));
+    appendJournal(QJsonObject{
+        {"file", item.filePath},
+        {"modified", item.modified.toMSecsSinceEpoch()},
+        {"chunk", item.index},
+        {"chunks", item.count},
+        {"issues", values}
+    });
+
+    if (!issues.isEmpty()) {
+        m_stats.issues += int(issues.size());
+        emit issuesFound(issues);
+    }
+    finishChunk(item.filePath, false);
+}
+
+void DeepSeekBatchAnalysis::finishChunk(const QString &filePath, bool failed)
+{
+    if (failed)
+        m_failed.insert(filePath);
+
+    const auto it = m_remaining.find(filePath);
+    if (it == m_remaining.end() || --it.value() > 0)
+        return;
+    m_remaining.erase(it);
+
+    if (m_failed.remove(filePath))
+        ++m_stats.failedFiles;
+    else
+        ++m_stats.doneFiles;
+    emit progressChanged();
+}
+
+} // namespace DeepSeek
@@ -0,0 +1,236 @@
+#pragma once
+
+#include "deepseekrequestscheduler.h"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+
+namespace DeepSeek {
+
+// Cubo de fichas para limitar el ritmo de peticiones: se rellena a
+// ratePerSecond fichas por segundo hasta capacity (la ráfaga permitida).
+class DeepSeekTokenBucket
+{
+public:
+    void setRate(double ratePerSecond, double capacity);
+    void reset(qint64 nowMs);
+    bool tryTake(qint64 nowMs);
+    // Tiempo hasta que haya una ficha; 0 si ya la hay
+    qint64 msUntilAvailable(qint64 nowMs) const;
+
+private:
+    double available(qint64 nowMs) const;
+
+    double m_rate = 1.0;
+    double m_capacity = 1.0;
+    double m_tokens = 1.0;
+    qint64 m_lastMs = 0;
+};
+
+// Análisis de un proyecto entero con una misma instrucción ("find
+// thread-safety issues"): lee los ficheros en un hilo aparte, los parte en
+// fragmentos con los números de línea delante y envía un /chat/completions
+// por fragmento como petición de fondo del planificador, así que las del
+// chat siempre pasan delante.
+//
+// Las peticiones simultáneas están acotadas (y además por el límite por host
+// del planificador) y su ritmo lo marca un DeepSeekTokenBucket; un 429 o 503
+// detiene el envío durante el Retry-After del servidor. Un fragmento que
+// recibe MaxThrottles de esas respuestas se da por fallido.
+//
+// Cada fragmento terminado se anota en un diario JSONL. Si el análisis se
+// interrumpe, al repetirlo con el mismo proyecto, instrucción y modelo se
+// saltan los fragmentos ya anotados de los ficheros que no han cambiado y sus
+// resultados se vuelven a publicar.
+class DeepSeekBatchAnalysis : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Issue
+    {
+        QString filePath;
+        int line = 0; // base 1; 0 = sin línea
+        bool error = false;
+        QString message;
+    };
+
+    // Cómo terminó la petición de un fragmento
+    enum class ReplyClass {
+        Ok,
+        Throttled,   // 429/503: el servidor pide ir más despacio
+        Transient,   // tiempo agotado, error de red, 408 o 5xx
+        Rejected,    // otro 4xx: repetirla daría lo mismo
+        Unauthorized // 401/403
+    };
+
+    // Intentos de un fragmento; las respuestas 429/503 se cuentan aparte
+    struct Attempts
+    {
+        int failures = 0;
+        int throttles = 0;
+    };
+
+    struct Chunk
+    {
+        int startLine = 0; // base 0
+        int lineCount = 0;
+        QString text;      // con los números de línea delante
+    };
+
+    struct Stats
+    {
+        int totalFiles = 0;
+        int doneFiles = 0;    // analizados en esta pasada
+        int resumedFiles = 0; // ya completos en el diario
+        int skippedFiles = 0; // binarios, vacíos o demasiado grandes
+        int failedFiles = 0;
+        int issues = 0;
+        qint64 elapsedMs = 0;
+
+        int finishedFiles() const { return doneFiles + resumedFiles + skippedFiles + failedFiles; }
+        // Solo cuenta lo analizado en esta pasada
+        double filesPerMinute() const
+        {
+            return elapsedMs > 0 ? doneFiles * 60000.0 / double(elapsedMs) : 0.0;
+        }
+    };
+
+    static constexpr int ChunkLines = 300;
+    static constexpr int MaxChunkChars = 24000;
+    static constexpr qint64 MaxFileSize = 1024 * 1024;
+    static constexpr int DefaultConcurrency = 2;
+    static constexpr int DefaultRequestsPerMinute = 60;
+    static constexpr int MaxAttempts = 3;
+    static constexpr int MaxThrottles = 10;  // 429/503 por fragmento
+    static constexpr int ReadAhead = 16;        // fragmentos preparados por delante
+    static constexpr int DefaultRetryAfterSecs = 10;
+    // Sin streaming no llega nada hasta que el fragmento está analizado
+    static constexpr int IdleTimeoutMs = 120000;
+
+    explicit DeepSeekBatchAnalysis(DeepSeekRequestScheduler *scheduler, QObject *parent = nullptr);
+    ~DeepSeekBatchAnalysis() override;
+
+    void setConcurrency(int maxInFlight);
+    void setRequestsPerMinute(int requestsPerMinute);
+    void setJournalDirectory(const QString &directory);
+
+    // request: URL y cabeceras de /chat/completions. fields: campos del
+    // cuerpo aparte de "messages" (modelo, max_tokens...).
+    bool start(const QString &projectKey, const QStringList &files, const QString &command,
+               const QNetworkRequest &request, const QJsonObject &fields,
+               QString *errorString = nullptr);
+    // El diario se conserva para poder reanudar
+    void cancel();
+
+    bool isRunning() const { return m_running; }
+    QString command() const { return m_command; }
+    // Por qué se detuvo la última pasada (p. ej. clave rechazada); vacío si no hubo error
+    QString errorString() const { return m_errorString; }
+    Stats stats() const;
+
+    static QList<Chunk> chunkText(const QString &text, int chunkLines = ChunkLines,
+                                  int maxChars = MaxChunkChars);
+    // Respuesta del modelo: {"issues": [{"line", "severity", "message"}]}.
+    // Las líneas fuera del fragmento se descartan (quedan en 0).
+    static QList<Issue> parseIssues(const QString &content, const QString &filePath,
+                                    const Chunk &chunk, QString *errorString = nullptr);
+    static ReplyClass classifyReply(int httpStatus, bool networkError, bool timedOut);
+    // Anota el intento; true si el fragmento debe volver a enviarse
+    static bool countAttempt(Attempts &attempts, ReplyClass replyClass);
+    static QString journalFileName(const QString &projectKey, const QString &command,
+                                   const QString &model);
+
+signals:
+    void issuesFound(const QList<DeepSeek::DeepSeekBatchAnalysis::Issue> &issues);
+    void progressChanged();
+    void finished(bool canceled);
+
+private:
+    struct FileChunks
+    {
+        QString filePath;
+        QDateTime modified;
+        QList<Chunk> chunks;
+    };
+
+    struct WorkItem
+    {
+        QString filePath;
+        QDateTime modified;
+        int index = 0;
+        int count = 0;
+        Chunk chunk;
+        Attempts attempts;
+    };
+
+    // Lo anotado en el diario para un fichero
+    struct JournalFile
+    {
+        qint64 modifiedMs = 0;
+        int count = 0;
+        QSet<int> done;
+        QList<Issue> issues;
+    };
+
+    static FileChunks readFile(const QString &filePath);
+    static QJsonObject toJson(const Issue &issue);
+    static Issue fromJson(const QJsonObject &object, const QString &filePath);
+
+    bool openJournal(const QString &projectKey, const QString &model, QString *errorString);
+    void appendJournal(const QJsonObject &record);
+    void onFileRead(const FileChunks &file);
+    void pump();
+    void send(const WorkItem &item);
+    void onRequestFinished(DeepSeekRequestScheduler::RequestId id, QNetworkReply *reply,
+                           DeepSeekRequestScheduler::FinishReason reason);
+    void retry(WorkItem item, const QString &reason);
+    void giveUp(const WorkItem &item, const QString &reason);
+    void completeChunk(const WorkItem &item, const QList<Issue> &issues);
+    void finishChunk(const QString &filePath, bool failed);
+    void stop(const QString &errorString);
+    void abortRun();
+    void finish(bool canceled);
+
+    QPointer<DeepSeekRequestScheduler> m_scheduler;
+    int m_concurrency = DefaultConcurrency;
+    int m_requestsPerMinute = DefaultRequestsPerMinute;
+    QString m_journalDirectory;
+    QString m_journalPath;
+
+    bool m_running = false;
+    quint64 m_generation = 0; // descarta lecturas de pasadas anteriores
+    QString m_command;
+    QString m_errorString;
+    QNetworkRequest m_request;
+    QJsonObject m_fields;
+
+    QStringList m_files;
+    int m_nextFile = 0;
+    bool m_reading = false;
+    QThreadPool m_readPool;
+    QList<WorkItem> m_ready;
+    QHash<DeepSeekRequestScheduler::RequestId, WorkItem> m_inFlight;
+    QHash<QString, int> m_remaining; // fragmentos pendientes por fichero
+    QSet<QString> m_failed;
+    QHash<QString, JournalFile> m_journal;
+
+    DeepSeekTokenBucket m_bucket;
+    QElapsedTimer m_clock;
+    qint64 m_pausedUntilMs = 0; // Retry-After del servidor
+    QTimer m_pumpTimer;
+    Stats m_stats;
+};
+
+} // namespace DeepSeek
@@ -0,0 +1,223 @@
+#include "deepseekchatmodel.h"
+#include "deepseekmarkdownrenderer.h"
+
+#include <QColor>
+#include <QFuture>
+#include <QtConcurrent/QtConcurrentRun>
+
+namespace DeepSeek {
+
+DeepSeekChatModel::DeepSeekChatModel(QObject *parent)
+    : QAbstractListModel(parent)
+{}
+
+int DeepSeekChatModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(m_messages.size());
+}
+
+QVariant DeepSeekChatModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_messages.size())
+        return {};
+
+    const DeepSeekChatMessage &message = m_messages.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+        // Resumen de una línea para la lista del historial
+        return QString("%1: %2").arg(message.sender,
+                                     message.text.left(SummaryLength).simplified());
+    case Qt::ForegroundRole:
+        if (message.sender == "You")
+            return QColor(Qt::blue);
+        if (message.sender.startsWith("DeepSeek"))
+            return QColor(Qt::darkGreen);
+        return {};
+    case Qt::ToolTipRole:
+        return message.timestamp.toString(Qt::TextDate);
+    case SenderRole:
+        return message.sender;
+    case TextRole:
+        return message.text;
+    case IdRole:
+        return message.id;
+    case RevisionRole:
+        return message.revision;
+    case TimestampRole:
+        return message.timestamp;
+    case MarkdownRole:
+        return message.markdown;
+    case FragmentsRole:
+        return message.fragments;
+    case TailRole:
+        return message.tailHtml;
+    }
+    return {};
+}
+
+QHash<int, QByteArray> DeepSeekChatModel::roleNames() const
+{
+    QHash<int, QByteArray> names = QAbstractListModel::roleNames();
+    names.insert(SenderRole, "sender");
+    names.insert(TextRole, "text");
+    names.insert(IdRole, "messageId");
+    names.insert(RevisionRole, "revision");
+    names.insert(TimestampRole, "timestamp");
+    names.insert(MarkdownRole, "markdown");
+    names.insert(FragmentsRole, "fragments");
+    names.insert(TailRole, "tailHtml");
+    return names;
+}
+
+quint64 DeepSeekChatModel::appendMessage(const QString &sender, const QString &text,
+                                         TextFormat format, const QDateTime &timestamp)
+{
+    DeepSeekChatMessage message;
+    message.id = m_nextId++;
+    message.sender = sender;
+    message.text = text;
+    message.timestamp = timestamp;
+    message.markdown = format == Markdown;
+    if (message.markdown && !text.isEmpty()) {
+        // Se muestra como texto hasta que llega el render
+        message.tailHtml = DeepSeekMarkdownRenderer::renderPlain(text);
+    }
+
+    const int row = int(m_messages.size());
+    beginInsertRows({}, row, row);
+    m_messages.append(message);
+    endInsertRows();
+
+    if (message.markdown && !text.isEmpty())
+        render(message.id, text, true);
+    return message.id;
+}
+
+bool DeepSeekChatModel::appendText(quint64 id, const QString &delta)
+{
+    const int row = rowForId(id);
+    if (row < 0)
+        return false;
+
+    DeepSeekChatMessage &message = m_messages[row];
+    message.text.append(delta);
+
+    const QModelIndex changed = index(row);
+    if (message.markdown) {
+        // La revisión cambia cuando llega el HTML, no con el texto en bruto
+        emit dataChanged(changed, changed, {Qt::DisplayRole, TextRole});
+        render(id, delta, false);
+    } else {
+        ++message.revision;
+        emit dataChanged(changed, changed, {Qt::DisplayRole, TextRole, RevisionRole});
+    }
+    return true;
+}
+
+void DeepSeekChatModel::finishMessage(quint64 id)
+{
+    const int row = rowForId(id);
+    if (row >= 0 && m_messages.at(row).markdown)
+        render(id, QString(), true);
+}
+
+void DeepSeekChatModel::render(quint64 id, const QString &text, bool finish)
+{
+    std::shared_ptr<DeepSeekMarkdownRenderer> &renderer = m_renderers[id];
+    if (!renderer)
+        renderer = std::make_shared<DeepSeekMarkdownRenderer>();
+    const std::shared_ptr<DeepSeekMarkdownRenderer> job = renderer;
+    if (finish)
+        m_renderers.remove(id);
+
+    // El hilo de render es único, así que los trabajos de un mensaje se
+    // ejecutan en orden; la continuación vuelve al hilo del modelo.
+    QtConcurrent::run(DeepSeekMarkdownRenderer::threadPool(), [job, text, finish]() {
+        DeepSeekMarkdownRenderer::Update update = job->feed(text);
+        if (finish) {
+            const DeepSeekMarkdownRenderer::Update last = job->finish();
+            update.fragments.append(last.fragments);
+            update.tail = last.tail;
+        }
+        return update;
+    }).then(this, [this, id](const DeepSeekMarkdownRenderer::Update &update) {
+        applyRender(id, update.fragments, update.tail);
+    });
+}
+
+void DeepSeekChatModel::applyRender(quint64 id, const QStringList &fragments,
+                                    const QString &tailHtml)
+{
+    const int row = rowForId(id);
+    if (row < 0)
+        return;
+
+    DeepSeekChatMessage &message = m_messages[row];
+    if (fragments.isEmpty() && message.tailHtml == tailHtml)
+        return;
+
+    message.fragments.append(fragments);
+    message.tailHtml = tailHtml;
+    ++message.revision;
+
+    const QModelIndex changed = index(row);
+    emit dataChanged(changed, changed, {FragmentsRole, TailRole, RevisionRole});
+}
+
+QString DeepSeekChatModel::text(quint64 id) const
+{
+    const int row = rowForId(id);
+    return row < 0 ? QString() : m_messages.at(row).text;
+}
+
+int DeepSeekChatModel::rowForId(quint64 id) const
+{
+    // Los mensajes que cambian (streaming) están casi siempre al final
+    for (int row = int(m_messages.size()) - 1; row >= 0; --row) {
+        if (m_messages.at(row).id == id)
+            return row;
+    }
+    return -1;
+}
+
+void DeepSeekChatModel::setOlderMessages(const QList<DeepSeekChatMessage> &messages)
+{
+    m_older = messages;
+    for (DeepSeekChatMessage &message : m_older) {
+        message.id = m_nextId++;
+        if (message.markdown)
+            message.tailHtml = DeepSeekMarkdownRenderer::renderPlain(message.text);
+    }
+}
+
+int DeepSeekChatModel::fetchOlder(int count)
+{
+    const int fetched = int(qMin<qsizetype>(count, m_older.size()));
+    if (fetched <= 0)
+        return 0;
+
+    beginInsertRows({}, 0, fetched - 1);
+    const qsizetype first = m_older.size() - fetched;
+    const QList<DeepSeekChatMessage> batch = m_older.mid(first);
+    m_messages = batch + m_messages;
+    m_older.resize(first);
+    endInsertRows();
+
+    // El historial se convierte solo cuando llega a la vista
+    for (const DeepSeekChatMessage &message : batch) {
+        if (message.markdown && !message.text.isEmpty())
+            render(message.id, message.text, true);
+    }
+    return fetched;
+}
+
+void DeepSeekChatModel::clear()
+{
+    beginResetModel();
+    m_messages.clear();
+    m_older.clear();
+    m_renderers.clear();
+    endResetModel();
+}
+
+} // namespace DeepSeek
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include <memory>
+
+namespace DeepSeek {
+
+struct DeepSeekChatMessage
+{
+    quint64 id = 0;
+    QString sender;
+    QString text;
+    QDateTime timestamp;
+    int revision = 0; // se incrementa con cada cambio visible (streaming)
+    bool markdown = false;
+    QStringList fragments; // HTML de los bloques Markdown ya terminados
+    QString tailHtml;      // HTML provisional del bloque que sigue abierto
+};
+
+class DeepSeekMarkdownRenderer;
+
+// Modelo de la conversación mostrada en el panel. Las vistas solo piden los
+// mensajes visibles; el historial antiguo se guarda aparte y se añade por
+// arriba en bloques (fetchOlder) cuando el usuario se desplaza hasta el
+// principio. Los mensajes se identifican por id, no por fila, porque las
+// filas cambian al insertar historial antiguo.
+//
+// Los mensajes en Markdown se convierten a HTML en el hilo de
+// DeepSeekMarkdownRenderer; el modelo solo recibe los fragmentos terminados y
+// el bloque abierto, y los entrega a la vista como un cambio de revisión.
+class DeepSeekChatModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        SenderRole = Qt::UserRole + 1,
+        TextRole,
+        IdRole,
+        RevisionRole,
+        TimestampRole,
+        MarkdownRole,
+        FragmentsRole,
+        TailRole
+    };
+
+    enum TextFormat { PlainText, Markdown };
+
+    static constexpr int FetchBatchSize = 20;
+    static constexpr int SummaryLength = 50;
+
+    explicit DeepSeekChatModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = {}) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    quint64 appendMessage(const QString &sender, const QString &text,
+                          TextFormat format = PlainText,
+                          const QDateTime &timestamp = QDateTime::currentDateTime());
+    bool appendText(quint64 id, const QString &delta);
+    void finishMessage(quint64 id); // no llegará más texto para el mensaje
+    QString text(quint64 id) const;
+    int rowForId(quint64 id) const;
+
+    // Mensajes anteriores (en orden cronológico) que aún no están en el modelo
+    void setOlderMessages(const QList<DeepSeekChatMessage> &messages);
+    bool canFetchOlder() const { return !m_older.isEmpty(); }
+    int fetchOlder(int count = FetchBatchSize);
+
+    void clear();
+
+private:
+    void render(quint64 id, const QString &text, bool finish);
+    void applyRender(quint64 id, const QStringList &fragments, const QString &tailHtml);
+
+    QList<DeepSeekChatMessage> m_messages;
+    QList<DeepSeekChatMessage> m_older;
+    quint64 m_nextId = 1;
+    QHash<quint64, std::shared_ptr<DeepSeekMarkdownRenderer>> m_renderers;
+};
+
+} // namespace DeepSeek
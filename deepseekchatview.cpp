@@ -0,0 +1,301 @@
+#include "deepseekchatview.h"
+#include "deepseekchatmodel.h"
+
+#include <QAbstractTextDocumentLayout>
+#include <QApplication>
+#include <QClipboard>
+#include <QContextMenuEvent>
+#include <QKeyEvent>
+#include <QMenu>
+#include <QPainter>
+#include <QScrollBar>
+#include <QTextCursor>
+#include <QTextDocumentFragment>
+#include <QtMath>
+
+#include <algorithm>
+
+namespace DeepSeek {
+
+// =============================
+// DeepSeekChatDelegate
+// =============================
+DeepSeekChatDelegate::DeepSeekChatDelegate(QAbstractItemView *view)
+    : QStyledItemDelegate(view)
+    , m_view(view)
+    , m_layouts(MaxCachedLayouts)
+{}
+
+QString DeepSeekChatDelegate::toHtml(const QString &sender, const QString &text)
+{
+    QString formattedText = text.toHtmlEscaped().replace('\n', "<br>");
+    return QString("<b>%1:</b><br>%2").arg(sender.toHtmlEscaped(), formattedText);
+}
+
+int DeepSeekChatDelegate::textWidth() const
+{
+    return qMax(1, m_view->viewport()->width() - 2 * Margin);
+}
+
+QTextDocument *DeepSeekChatDelegate::layoutFor(const QModelIndex &index, int width) const
+{
+    const quint64 id = index.data(DeepSeekChatModel::IdRole).toULongLong();
+    const int revision = index.data(DeepSeekChatModel::RevisionRole).toInt();
+
+    Layout *layout = m_layouts.object(id);
+    if (!layout) {
+        layout = new Layout;
+        layout->document.setDocumentMargin(0);
+        m_layouts.insert(id, layout);
+    }
+
+    if (layout->revision != revision) {
+        layout->document.setDefaultFont(m_view->font());
+        if (index.data(DeepSeekChatModel::MarkdownRole).toBool()) {
+            updateMarkdown(layout, index);
+        } else {
+            layout->document.setHtml(toHtml(index.data(DeepSeekChatModel::SenderRole).toString(),
+                                            index.data(DeepSeekChatModel::TextRole).toString()));
+        }
+        layout->revision = revision;
+        layout->width = -1;
+    }
+    if (layout->width != width) {
+        layout->document.setTextWidth(width);
+        layout->width = width;
+    }
+    return &layout->document;
+}
+
+void DeepSeekChatDelegate::updateMarkdown(Layout *layout, const QModelIndex &index) const
+{
+    const QStringList fragments = index.data(DeepSeekChatModel::FragmentsRole).toStringList();
+    QTextDocument &document = layout->document;
+
+    if (layout->tailStart < 0 || fragments.size() < layout->fragmentCount) {
+        document.setHtml(QString("<b>%1:</b>")
+                             .arg(index.data(DeepSeekChatModel::SenderRole).toString().toHtmlEscaped()));
+        layout->fragmentCount = 0;
+        layout->tailStart = document.characterCount() - 1;
+    }
+
+    // Se quita el bloque abierto anterior y se añaden solo los fragmentos nuevos
+    QTextCursor cursor(&document);
+    cursor.beginEditBlock();
+    cursor.setPosition(layout->tailStart);
+    cursor.movePosition(QTextCursor::End, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+
+    for (qsizetype i = layout->fragmentCount; i < fragments.size(); ++i) {
+        cursor.insertBlock();
+        cursor.insertFragment(QTextDocumentFragment::fromHtml(fragments.at(i)));
+    }
+    layout->fragmentCount = fragments.size();
+    layout->tailStart = cursor.position();
+
+    const QString tail = index.data(DeepSeekChatModel::TailRole).toString();
+    if (!tail.isEmpty()) {
+        cursor.insertBlock();
+        cursor.insertFragment(QTextDocumentFragment::fromHtml(tail));
+    }
+    cursor.endEditBlock();
+}
+
+int DeepSeekChatDelegate::cachedHeight(const QModelIndex &index) const
+{
+    const auto it = m_extents.constFind(index.data(DeepSeekChatModel::IdRole).toULongLong());
+    if (it == m_extents.cend()
+        || it->revision != index.data(DeepSeekChatModel::RevisionRole).toInt()
+        || it->width != textWidth()) {
+        return -1;
+    }
+    return it->height;
+}
+
+QSize DeepSeekChatDelegate::sizeHint(const QStyleOptionViewItem &option,
+                                     const QModelIndex &index) const
+{
+    Q_UNUSED(option)
+    const int width = textWidth();
+    int height = cachedHeight(index);
+    if (height < 0) {
+        height = qCeil(layoutFor(index, width)->size().height());
+        const int revision = index.data(DeepSeekChatModel::RevisionRole).toInt();
+        m_extents.insert(index.data(DeepSeekChatModel::IdRole).toULongLong(),
+                         {revision, width, height});
+    }
+    return QSize(width + 2 * Margin, height + 2 * Margin);
+}
+
+void DeepSeekChatDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
+                                 const QModelIndex &index) const
+{
+    painter->save();
+
+    if (option.state & QStyle::State_Selected)
+        painter->fillRect(option.rect, option.palette.highlight().color().lighter(170));
+    else if (index.data(DeepSeekChatModel::SenderRole).toString() == "You")
+        painter->fillRect(option.rect, option.palette.alternateBase());
+
+    QTextDocument *document = layoutFor(index, textWidth());
+    painter->translate(option.rect.topLeft() + QPoint(Margin, Margin));
+
+    QAbstractTextDocumentLayout::PaintContext context;
+    context.palette = option.palette;
+    context.clip = QRectF(0, 0, option.rect.width() - 2 * Margin,
+                          option.rect.height() - 2 * Margin);
+    painter->setClipRect(context.clip);
+    document->documentLayout()->draw(painter, context);
+
+    painter->restore();
+}
+
+void DeepSeekChatDelegate::clearCache()
+{
+    m_layouts.clear();
+    m_extents.clear();
+}
+
+// =============================
+// DeepSeekChatView
+// =============================
+DeepSeekChatView::DeepSeekChatView(QWidget *parent)
+    : QListView(parent)
+    , m_delegate(new DeepSeekChatDelegate(this))
+{
+    setItemDelegate(m_delegate);
+    setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    setResizeMode(QListView::Adjust);
+    setSelectionMode(QAbstractItemView::ExtendedSelection);
+    setUniformItemSizes(false);
+    setWordWrap(true);
+
+    connect(verticalScrollBar(), &QScrollBar::valueChanged,
+            this, &DeepSeekChatView::onScrollValueChanged);
+    connect(verticalScrollBar(), &QScrollBar::rangeChanged,
+            this, &DeepSeekChatView::onScrollRangeChanged);
+}
+
+void DeepSeekChatView::setChatModel(DeepSeekChatModel *model)
+{
+    if (m_chatModel)
+        disconnect(m_chatModel, nullptr, m_delegate, nullptr);
+
+    m_chatModel = model;
+    m_delegate->clearCache();
+    setModel(model);
+    if (model) {
+        connect(model, &QAbstractItemModel::modelReset, m_delegate,
+                &DeepSeekChatDelegate::clearCache);
+    }
+    m_stickToBottom = true;
+    scrollToBottom();
+    fetchOlder();
+}
+
+void DeepSeekChatView::dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight,
+                                   const QList<int> &roles)
+{
+    // Un mensaje en streaming solo obliga a recolocar la vista si cambia de
+    // altura; si no, basta con repintar su fila.
+    bool relayout = false;
+    QStyleOptionViewItem option;
+    initViewItemOption(&option);
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+        const QModelIndex index = model()->index(row, 0);
+        const int before = m_delegate->cachedHeight(index);
+        if (before < 0) {
+            const int previous = visualRect(index).height() - 2 * DeepSeekChatDelegate::Margin;
+            const int after = m_delegate->sizeHint(option, index).height()
+                              - 2 * DeepSeekChatDelegate::Margin;
+            relayout = relayout || previous != after;
+        }
+    }
+
+    QListView::dataChanged(topLeft, bottomRight, roles);
+    if (relayout)
+        scheduleDelayedItemsLayout();
+}
+
+void DeepSeekChatView::onScrollValueChanged(int value)
+{
+    QScrollBar *scrollBar = verticalScrollBar();
+    if (m_restoreFromBottom < 0)
+        m_stickToBottom = value == scrollBar->maximum();
+
+    if (value == scrollBar->minimum() && scrollBar->maximum() > 0)
+        fetchOlder();
+}
+
+void DeepSeekChatView::onScrollRangeChanged(int min, int max)
+{
+    Q_UNUSED(min)
+    QScrollBar *scrollBar = verticalScrollBar();
+
+    if (m_restoreFromBottom >= 0) {
+        // Tras insertar historial por arriba se mantiene el mensaje que se veía
+        const int distance = m_restoreFromBottom;
+        m_restoreFromBottom = -1;
+        scrollBar->setValue(max - distance);
+        return;
+    }
+
+    if (m_stickToBottom)
+        scrollBar->setValue(max);
+
+    // Si el contenido no llena la vista no hay barra con la que pedir más
+    if (max == 0)
+        fetchOlder();
+}
+
+void DeepSeekChatView::fetchOlder()
+{
+    if (!m_chatModel || !m_chatModel->canFetchOlder() || m_restoreFromBottom >= 0)
+        return;
+
+    QScrollBar *scrollBar = verticalScrollBar();
+    const int distance = scrollBar->maximum() - scrollBar->value();
+    // Se difiere para no insertar filas dentro de la señal de la barra
+    QMetaObject::invokeMethod(this, [this, distance]() {
+        if (!m_chatModel || !m_chatModel->canFetchOlder())
+            return;
+        m_restoreFromBottom = m_stickToBottom ? -1 : distance;
+        m_chatModel->fetchOlder();
+    }, Qt::QueuedConnection);
+}
+
+void DeepSeekChatView::copySelection()
+{
+    QModelIndexList selected = selectionModel()->selectedIndexes();
+    std::sort(selected.begin(), selected.end(),
+              [](const QModelIndex &a, const QModelIndex &b) { return a.row() < b.row(); });
+
+    QStringList parts;
+    for (const QModelIndex &index : std::as_const(selected)) {
+        parts.append(QString("%1:\n%2").arg(index.data(DeepSeekChatModel::SenderRole).toString(),
+                                            index.data(DeepSeekChatModel::TextRole).toString()));
+    }
+    if (!parts.isEmpty())
+        QApplication::clipboard()->setText(parts.join("\n\n"));
+}
+
+void DeepSeekChatView::keyPressEvent(QKeyEvent *event)
+{
+    if (event == QKeySequence::Copy) {
+        copySelection();
+        event->accept();
+        return;
+    }
+    QListView::keyPressEvent(event);
+}
+
+void DeepSeekChatView::contextMenuEvent(QContextMenuEvent *event)
+{
+    QMenu menu(this);
+    QAction *copyAction = menu.addAction(tr("Copy"), this, &DeepSeekChatView::copySelection);
+    copyAction->setEnabled(selectionModel() && selectionModel()->hasSelection());
+    menu.exec(event->globalPos());
+}
+
+} // namespace DeepSeek
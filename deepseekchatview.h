@@ -0,0 +1,96 @@
+#pragma once
+
+#include <QCache>
+#include <QHash>
+#include <QListView>
+#include <QStyledItemDelegate>
+#include <QTextDocument>
+
+namespace DeepSeek {
+
+class DeepSeekChatModel;
+
+// Dibuja cada mensaje con un QTextDocument. Los documentos maquetados se
+// guardan en una caché acotada por id de mensaje, revisión y ancho, de modo
+// que solo se maquetan los mensajes nuevos o modificados; las alturas se
+// recuerdan aparte (son baratas) para que el layout de la vista no tenga que
+// volver a maquetar mensajes que no están en pantalla. En los mensajes
+// Markdown solo se insertan los fragmentos nuevos y se sustituye el bloque
+// abierto, nunca se regenera el documento completo.
+class DeepSeekChatDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    static constexpr int Margin = 6;
+    static constexpr int MaxCachedLayouts = 200;
+
+    explicit DeepSeekChatDelegate(QAbstractItemView *view);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option,
+               const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+    // Altura guardada para el mensaje, -1 si no es válida para su revisión actual
+    int cachedHeight(const QModelIndex &index) const;
+    void clearCache();
+
+    static QString toHtml(const QString &sender, const QString &text);
+
+private:
+    struct Layout
+    {
+        int revision = -1;
+        int width = -1;
+        qsizetype fragmentCount = 0; // fragmentos Markdown ya insertados
+        int tailStart = -1;          // posición donde empieza el bloque abierto
+        QTextDocument document;
+    };
+
+    struct Extent
+    {
+        int revision = -1;
+        int width = -1;
+        int height = 0;
+    };
+
+    int textWidth() const;
+    QTextDocument *layoutFor(const QModelIndex &index, int width) const;
+    void updateMarkdown(Layout *layout, const QModelIndex &index) const;
+
+    QAbstractItemView *m_view = nullptr;
+    mutable QCache<quint64, Layout> m_layouts;
+    mutable QHash<quint64, Extent> m_extents;
+};
+
+// Vista virtualizada de la conversación. Se mantiene pegada al final mientras
+// el usuario no se desplace hacia arriba y, al llegar al principio, pide al
+// modelo el siguiente bloque de historial antiguo conservando la posición.
+class DeepSeekChatView : public QListView
+{
+    Q_OBJECT
+
+public:
+    explicit DeepSeekChatView(QWidget *parent = nullptr);
+
+    void setChatModel(DeepSeekChatModel *model);
+    void copySelection();
+
+protected:
+    void dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight,
+                     const QList<int> &roles = QList<int>()) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void contextMenuEvent(QContextMenuEvent *event) override;
+
+private:
+    void onScrollValueChanged(int value);
+    void onScrollRangeChanged(int min, int max);
+    void fetchOlder();
+
+    DeepSeekChatModel *m_chatModel = nullptr;
+    DeepSeekChatDelegate *m_delegate = nullptr;
+    bool m_stickToBottom = true;
+    int m_restoreFromBottom = -1; // distancia al final a recuperar tras cargar historial
+};
+
+} // namespace DeepSeek
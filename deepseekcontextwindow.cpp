@@ -0,0 +1,182 @@
+#include "deepseekcontextwindow.h"
+#include "deepseektokenizer.h"
+
+#include <QJsonObject>
+#include <QList>
+
+#include <algorithm>
+
+namespace DeepSeek {
+
+// Coste fijo aproximado de cada mensaje (rol y separadores de la plantilla de chat)
+static constexpr int PerMessageOverhead = 4;
+
+int DeepSeekContextWindow::estimateTokens(const QString &text)
+{
+    // Recuento exacto si hay tokenizador cargado (con caché por texto)
+    const int exact = DST::inst()->countCached(text);
+    if (exact >= 0)
+        return exact;
+
+    // Estimación barata sin tokenizador: ~4 caracteres ASCII por token,
+    // un token por ideograma CJK y ~2 caracteres para el resto de Unicode.
+    qsizetype ascii = 0;
+    qsizetype cjk = 0;
+    qsizetype other = 0;
+    for (const QChar ch : text) {
+        const char16_t code = ch.unicode();
+        if (code < 0x80)
+            ++ascii;
+        else if (code >= 0x2E80 && code < 0xA000)
+            ++cjk;
+        else
+            ++other;
+    }
+    return int((ascii + 3) / 4 + cjk + (other + 1) / 2);
+}
+
+int DeepSeekContextWindow::estimateTurnTokens(const QString &message, const QString &response)
+{
+    return estimateTokens(message) + estimateTokens(response) + 2 * PerMessageOverhead;
+}
+
+int DeepSeekContextWindow::contextLengthForModel(const QString &model)
+{
+    if (model.startsWith("deepseek-chat") || model.startsWith("deepseek-reasoner"))
+        return 65536;
+    if (model.startsWith("deepseek-coder"))
+        return 16384;
+    return 32768;
+}
+
+int DeepSeekContextWindow::historyBudget(int contextLength, int maxTokens,
+                                         const QString &systemPrompt, const QString &message)
+{
+    const int fixed = maxTokens
+                      + estimateTokens(systemPrompt) + PerMessageOverhead
+                      + estimateTokens(message) + PerMessageOverhead
+                      + SafetyMargin;
+    return std::max(0, contextLength - fixed);
+}
+
+DeepSeekContextWindow::Result DeepSeekContextWindow::build(const QJsonArray &history,
+                                                           int budget,
+                                                           const QString &currentFile)
+{
+    struct Candidate
+    {
+        int index;
+        int tokens;
+        int rank; // 0 = reciente, 1 = mismo fichero, 2 = resto
+    };
+
+    Result result;
+    result.budget = std::max(0, budget);
+
+    const int count = int(history.size());
+    QList<Candidate> candidates;
+    candidates.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const QJsonObject entry = history.at(i).toObject();
+        if (entry.isEmpty())
+            continue;
+
+        const int tokens = estimateTurnTokens(entry.value("message").toString(),
+                                              entry.value("response").toString());
+        int rank = 2;
+        if (i >= count - RecentTurns)
+            rank = 0;
+        else if (!currentFile.isEmpty()
+                 && entry.value("context").toObject().value("file").toString() == currentFile)
+            rank = 1;
+        candidates.append({i, tokens, rank});
+    }
+
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const Candidate &a, const Candidate &b) {
+                         if (a.rank != b.rank)
+                             return a.rank < b.rank;
+                         return a.index > b.index;
+                     });
+
+    QList<bool> keep(count, false);
+    int used = 0;
+    for (const Candidate &candidate : std::as_const(candidates)) {
+        if (used + candidate.tokens <= result.budget) {
+            keep[candidate.index] = true;
+            used += candidate.tokens;
+            ++result.keptTurns;
+        } else {
+            result.droppedTokens += candidate.tokens;
+            ++result.droppedTurns;
+        }
+    }
+    result.keptTokens = used;
+
+    for (int i = 0; i < count; ++i) {
+        if (keep.at(i))
+            result.turns.append(i);
+    }
+
+    return result;
+}
+
+QJsonArray DeepSeekContextWindow::messages(const QJsonArray &history, const QList<int> &turns)
+{
+    QJsonArray messages;
+    for (int index : turns) {
+        const QJsonObject entry = history.at(index).toObject();
+        messages.append(QJsonObject{{"role", "user"}, {"content", entry.value("message").toString()}});
+        messages.append(QJsonObject{{"role", "assistant"},
+                                    {"content", entry.value("response").toString()}});
+    }
+    return messages;
+}
+
+DeepSeekContextWindow::Result DeepSeekContextWindow::buildStablePrefix(const QJsonArray &history,
+                                                                       int budget)
+{
+    Result result;
+    result.budget = std::max(0, budget);
+
+    const int count = int(history.size());
+    QList<int> tokens(count, 0);
+    int used = 0;
+    for (int i = 0; i < count; ++i) {
+        const QJsonObject entry = history.at(i).toObject();
+        if (entry.isEmpty())
+            continue;
+        tokens[i] = estimateTurnTokens(entry.value("message").toString(),
+                                       entry.value("response").toString());
+        used += tokens.at(i);
+    }
+
+    // Primer turno a partir del cual todo cabe, redondeado al siguiente
+    // bloque sin llegar a tocar los turnos más recientes.
+    int start = 0;
+    while (start < count && used > result.budget)
+        used -= tokens.at(start++);
+    if (start > 0) {
+        const int aligned = (start + PrefixDropStep - 1) / PrefixDropStep * PrefixDropStep;
+        const int limit = std::max(start, count - RecentTurns);
+        while (start < std::min(aligned, limit))
+            used -= tokens.at(start++);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        const QJsonObject entry = history.at(i).toObject();
+        if (entry.isEmpty())
+            continue;
+        if (i < start) {
+            result.droppedTokens += tokens.at(i);
+            ++result.droppedTurns;
+        } else {
+            result.turns.append(i);
+            ++result.keptTurns;
+        }
+    }
+    result.keptTokens = used;
+    return result;
+}
+
+} // namespace DeepSeek
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <QJsonArray>
+#include <QList>
+#include <QString>
+
+namespace DeepSeek {
+
+// Selecciona qué turnos del historial caben en la ventana de contexto del
+// modelo. Cada entrada del historial ({message, response, context}) se
+// considera un turno indivisible; se conservan primero los turnos más
+// recientes y los que se refieren al fichero actual, y el resultado se
+// devuelve en orden cronológico.
+class DeepSeekContextWindow
+{
+public:
+    struct Result
+    {
+        QList<int> turns;       // índices de los turnos conservados, en orden
+        int budget = 0;         // tokens disponibles para el historial
+        int keptTurns = 0;
+        int keptTokens = 0;
+        int droppedTurns = 0;
+        int droppedTokens = 0;
+    };
+
+    // Turnos más recientes que se intentan conservar siempre antes de
+    // aplicar la preferencia por fichero.
+    static constexpr int RecentTurns = 4;
+    // Margen para el formato de los mensajes y errores de la estimación.
+    static constexpr int SafetyMargin = 256;
+
+    // Exacto si DeepSeekTokenizer está cargado; si no, aproximado
+    static int estimateTokens(const QString &text);
+    static int estimateTurnTokens(const QString &message, const QString &response);
+    static int contextLengthForModel(const QString &model);
+
+    // contextLength: tamaño total de la ventana del modelo. Del total se
+    // descuentan la respuesta reservada (maxTokens), el prompt de sistema,
+    // el mensaje actual y el margen de seguridad.
+    static int historyBudget(int contextLength, int maxTokens,
+                             const QString &systemPrompt, const QString &message);
+
+    static Result build(const QJsonArray &history, int budget, const QString &currentFile = {});
+
+    // Para la caché de prefijos del servidor: solo se descartan los turnos
+    // más antiguos y en bloques de PrefixDropStep, así el inicio del
+    // historial (y todo lo que va detrás) no cambia en cada pregunta. Los
+    // bloques se cuentan por índice: quien recorte history por delante debe
+    // hacerlo también en múltiplos de PrefixDropStep.
+    static Result buildStablePrefix(const QJsonArray &history, int budget);
+    static constexpr int PrefixDropStep = 8;
+
+    // Mensajes user/assistant de los turnos indicados, listos para "messages"
+    static QJsonArray messages(const QJsonArray &history, const QList<int> &turns);
+};
+
+} // namespace DeepSeek
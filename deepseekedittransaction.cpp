@@ -0,0 +1,302 @@
+#include "deepseekedittransaction.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QTemporaryFile>
+#include <QtConcurrent/QtConcurrentMap>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace DeepSeek {
+
+namespace {
+
+// true si el fichero existente separa las líneas con \r\n (mira la primera)
+bool usesCrLf(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    const QByteArray head = file.read(64 * 1024);
+    const qsizetype newline = head.indexOf('\n');
+    return newline > 0 && head.at(newline - 1) == '\r';
+}
+
+// flush() solo vacía el buffer de Qt: sin esto un corte de luz tras el
+// renombrado podría dejar el destino vacío
+bool syncToDisk(QFile &file)
+{
+    if (!file.flush())
+        return false;
+#ifdef Q_OS_WIN
+    return ::_commit(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+struct StageResult
+{
+    QString temp;
+    bool existed = false;
+    QString errorString;
+};
+
+// Se ejecuta en el pool de QtConcurrent, una llamada por fichero
+StageResult stageFile(const DeepSeekEditTransaction::FileEdit &edit)
+{
+    StageResult result;
+    const QFileInfo info(edit.filePath);
+    result.existed = info.exists();
+
+    if (!QDir().mkpath(info.absolutePath())) {
+        result.errorString = QObject::tr("Failed to create directory: %1").arg(info.absolutePath());
+        return result;
+    }
+
+    // En el mismo directorio que el destino para que el renombrado sea atómico
+    QTemporaryFile temp(info.absoluteFilePath() + ".deepseek-XXXXXX");
+    temp.setAutoRemove(false);
+    if (!temp.open()) {
+        result.errorString = QObject::tr("Cannot write to file: %1").arg(temp.errorString());
+        return result;
+    }
+
+    // Se conservan los finales de línea del fichero original
+    QString content = edit.content;
+    if (result.existed && usesCrLf(edit.filePath)) {
+        content.replace("\r\n", "\n");
+        content.replace('\n', "\r\n");
+    }
+    const QByteArray data = content.toUtf8();
+    if (temp.write(data) != data.size() || !syncToDisk(temp)) {
+        result.errorString = QObject::tr("Cannot write to file: %1").arg(temp.errorString());
+        temp.remove();
+        return result;
+    }
+    temp.close();
+
+    if (result.existed)
+        QFile::setPermissions(temp.fileName(), QFile::permissions(edit.filePath));
+
+    result.temp = temp.fileName();
+    return result;
+}
+
+} // namespace
+
+DeepSeekEditTransaction::DeepSeekEditTransaction(const QString &journalPath)
+    : m_journalPath(journalPath)
+{}
+
+void DeepSeekEditTransaction::addFile(const QString &filePath, const QString &content)
+{
+    const QString absolutePath = QFileInfo(filePath).absoluteFilePath();
+    for (FileEdit &edit : m_edits) {
+        if (edit.filePath == absolutePath) {
+            edit.content = content;
+            return;
+        }
+    }
+    m_edits.append({absolutePath, content});
+}
+
+QStringList DeepSeekEditTransaction::files() const
+{
+    QStringList paths;
+    for (const FileEdit &edit : m_edits)
+        paths.append(edit.filePath);
+    return paths;
+}
+
+bool DeepSeekEditTransaction::commit(QString *errorString)
+{
+    if (m_edits.isEmpty())
+        return true;
+
+    // Una transacción anterior interrumpida se resuelve antes de empezar otra
+    if (!recover(m_journalPath, errorString))
+        return false;
+
+    // 1. Preparación en paralelo: el árbol aún no se ha tocado
+    const QList<StageResult> staged
+        = QtConcurrent::blockingMapped<QList<StageResult>>(m_edits, stageFile);
+
+    QList<Entry> entries;
+    QString stageError;
+    for (qsizetype i = 0; i < staged.size(); ++i) {
+        const StageResult &result = staged.at(i);
+        if (!result.errorString.isEmpty() && stageError.isEmpty())
+            stageError = QString("%1: %2").arg(m_edits.at(i).filePath, result.errorString);
+
+        Entry entry;
+        entry.target = m_edits.at(i).filePath;
+        entry.temp = result.temp;
+        entry.backup = entry.target + ".deepseek-backup";
+        entry.existed = result.existed;
+        entries.append(entry);
+    }
+
+    if (!stageError.isEmpty()) {
+        discardTemps(entries);
+        if (errorString)
+            *errorString = stageError;
+        return false;
+    }
+
+    // 2. Diario antes de tocar ningún destino
+    if (!writeJournal(m_journalPath, entries, false, errorString)) {
+        discardTemps(entries);
+        return false;
+    }
+
+    // 3. Confirmación: destino -> copia, temporal -> destino
+    for (qsizetype i = 0; i < entries.size(); ++i) {
+        const Entry &entry = entries.at(i);
+        QString failure;
+        if (entry.existed) {
+            QFile::remove(entry.backup);
+            if (!QFile::rename(entry.target, entry.backup))
+                failure = QObject::tr("Cannot back up %1").arg(entry.target);
+        }
+        if (failure.isEmpty() && !QFile::rename(entry.temp, entry.target)) {
+            failure = QObject::tr("Cannot replace %1").arg(entry.target);
+            if (entry.existed)
+                QFile::rename(entry.backup, entry.target);
+        }
+
+        if (!failure.isEmpty()) {
+            rollback(entries, i);
+            discardTemps(entries);
+            QFile::remove(m_journalPath);
+            if (errorString)
+                *errorString = failure;
+            return false;
+        }
+    }
+
+    // Todos los destinos tienen ya el contenido nuevo: a partir de aquí una
+    // recuperación completa la transacción en lugar de deshacerla.
+    QString journalError;
+    if (!writeJournal(m_journalPath, entries, true, &journalError))
+        qWarning() << "Failed to update edit journal:" << journalError;
+
+    for (const Entry &entry : std::as_const(entries)) {
+        if (entry.existed)
+            QFile::remove(entry.backup);
+    }
+    QFile::remove(m_journalPath);
+    return true;
+}
+
+bool DeepSeekEditTransaction::writeJournal(const QString &journalPath, const QList<Entry> &entries,
+                                           bool committed, QString *errorString)
+{
+    QJsonArray files;
+    for (const Entry &entry : entries) {
+        files.append(QJsonObject{
+            {"target", entry.target},
+            {"temp", entry.temp},
+            {"backup", entry.backup},
+            {"existed", entry.existed}
+        });
+    }
+
+    QDir().mkpath(QFileInfo(journalPath).absolutePath());
+    QSaveFile saver(journalPath);
+    if (!saver.open(QIODevice::WriteOnly)) {
+        if (errorString)
+            *errorString = saver.errorString();
+        return false;
+    }
+    saver.write(QJsonDocument(QJsonObject{{"committed", committed}, {"files", files}})
+                    .toJson(QJsonDocument::Compact));
+    if (!saver.commit()) {
+        if (errorString)
+            *errorString = saver.errorString();
+        return false;
+    }
+    return true;
+}
+
+void DeepSeekEditTransaction::rollback(const QList<Entry> &entries, qsizetype applied)
+{
+    // Deshace en orden inverso los ficheros ya sustituidos
+    for (qsizetype i = applied - 1; i >= 0; --i) {
+        const Entry &entry = entries.at(i);
+        QFile::remove(entry.target);
+        if (entry.existed && !QFile::rename(entry.backup, entry.target))
+            qWarning() << "Failed to restore" << entry.target << "from" << entry.backup;
+    }
+}
+
+void DeepSeekEditTransaction::discardTemps(const QList<Entry> &entries)
+{
+    for (const Entry &entry : entries) {
+        if (!entry.temp.isEmpty())
+            QFile::remove(entry.temp);
+    }
+}
+
+bool DeepSeekEditTransaction::recover(const QString &journalPath, QString *errorString)
+{
+    QFile file(journalPath);
+    if (!file.exists())
+        return true;
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorString)
+            *errorString = file.errorString();
+        return false;
+    }
+
+    const QJsonObject journal = QJsonDocument::fromJson(file.readAll()).object();
+    file.close();
+
+    const bool committed = journal.value("committed").toBool();
+    QList<Entry> entries;
+    for (const QJsonValue &value : journal.value("files").toArray()) {
+        const QJsonObject obj = value.toObject();
+        entries.append({obj.value("target").toString(), obj.value("temp").toString(),
+                        obj.value("backup").toString(), obj.value("existed").toBool()});
+    }
+
+    for (const Entry &entry : std::as_const(entries)) {
+        if (committed) {
+            // Solo faltaba limpiar
+            if (entry.existed)
+                QFile::remove(entry.backup);
+            continue;
+        }
+
+        if (entry.existed) {
+            // Si existe la copia, el destino se llegó a sustituir (o a mover)
+            if (QFile::exists(entry.backup)) {
+                QFile::remove(entry.target);
+                if (!QFile::rename(entry.backup, entry.target)) {
+                    if (errorString)
+                        *errorString = QObject::tr("Cannot restore %1").arg(entry.target);
+                    return false;
+                }
+            }
+        } else if (!QFile::exists(entry.temp)) {
+            // Fichero nuevo ya confirmado: se elimina
+            QFile::remove(entry.target);
+        }
+    }
+
+    discardTemps(entries);
+    QFile::remove(journalPath);
+    return true;
+}
+
+} // namespace DeepSeek
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+namespace DeepSeek {
+
+// Aplica cambios a varios ficheros como una única operación: o se escriben
+// todos o no cambia ninguno.
+//
+// 1. Preparación (en paralelo): cada contenido nuevo se escribe en un
+//    temporal junto a su destino, en el mismo sistema de ficheros, con los
+//    finales de línea del fichero que sustituye, y se lleva al disco.
+// 2. Diario: se guarda la lista de destinos, temporales y copias de seguridad.
+// 3. Confirmación: cada destino se renombra a su copia y el temporal ocupa su
+//    lugar. Si algo falla se deshace lo hecho a partir del diario.
+//
+// Si el IDE se cierra a mitad, recover() completa o deshace la transacción
+// pendiente según lo que indique el diario.
+class DeepSeekEditTransaction
+{
+public:
+    struct FileEdit
+    {
+        QString filePath;
+        QString content;
+    };
+
+    explicit DeepSeekEditTransaction(const QString &journalPath);
+
+    // Añade o sustituye el contenido nuevo de un fichero
+    void addFile(const QString &filePath, const QString &content);
+    QStringList files() const;
+    bool isEmpty() const { return m_edits.isEmpty(); }
+
+    // Bloquea hasta terminar. En caso de error el árbol queda como estaba.
+    bool commit(QString *errorString = nullptr);
+
+    static bool recover(const QString &journalPath, QString *errorString = nullptr);
+
+private:
+    struct Entry
+    {
+        QString target;
+        QString temp;
+        QString backup;
+        bool existed = false;
+    };
+
+    static bool writeJournal(const QString &journalPath, const QList<Entry> &entries,
+                             bool committed, QString *errorString);
+    static void rollback(const QList<Entry> &entries, qsizetype applied);
+    static void discardTemps(const QList<Entry> &entries);
+
+    QString m_journalPath;
+    QList<FileEdit> m_edits;
+};
+
+} // namespace DeepSeek
@@ -0,0 +1,84 @@
+#include "deepseekembeddingclient.h"
+#include "deepseeknetworkservice.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+
+namespace DeepSeek {
+
+DeepSeekEmbeddingClient::DeepSeekEmbeddingClient(QObject *parent)
+    : QObject(parent)
+{}
+
+void DeepSeekEmbeddingClient::setEndpoint(const QString &baseUrl, const QString &model,
+                                          const QString &apiKey)
+{
+    QUrl url(baseUrl);
+    if (!url.path().endsWith("/v1"))
+        url.setPath("/v1");
+    url.setPath(url.path() + "/embeddings");
+    m_url = url;
+    m_model = model;
+    m_apiKey = apiKey;
+}
+
+QNetworkReply *DeepSeekEmbeddingClient::embed(const QStringList &texts, Callback callback,
+                                              int timeoutMs)
+{
+    if (!isConfigured()) {
+        callback({}, tr("Embeddings endpoint is not configured"));
+        return nullptr;
+    }
+
+    QNetworkRequest request = DSN::inst()->createRequest(m_url);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    request.setTransferTimeout(timeoutMs);
+    if (!m_apiKey.isEmpty())
+        request.setRawHeader("Authorization", QString("Bearer %1").arg(m_apiKey).toUtf8());
+
+    const QJsonObject payload{
+        {"model", m_model},
+        {"input", QJsonArray::fromStringList(texts)},
+        {"encoding_format", "float"}
+    };
+    QNetworkReply *reply = DSN::inst()->manager()->post(
+        request, QJsonDocument(payload).toJson(QJsonDocument::Compact));
+
+    const qsizetype expected = texts.size();
+    connect(reply, &QNetworkReply::finished, this, [reply, callback, expected]() {
+        reply->deleteLater();
+        if (reply->error() != QNetworkReply::NoError) {
+            callback({}, reply->errorString());
+            return;
+        }
+
+        const QJsonArray data = QJsonDocument::fromJson(reply->readAll())
+                                    .object().value("data").toArray();
+        QList<std::vector<float>> vectors(expected);
+        for (const QJsonValue &value : data) {
+            const QJsonObject item = value.toObject();
+            const qsizetype index = item.value("index").toInteger(-1);
+            if (index < 0 || index >= expected)
+                continue;
+            const QJsonArray embedding = item.value("embedding").toArray();
+            std::vector<float> &vector = vectors[index];
+            vector.reserve(embedding.size());
+            for (const QJsonValue &component : embedding)
+                vector.push_back(float(component.toDouble()));
+        }
+
+        for (const std::vector<float> &vector : std::as_const(vectors)) {
+            if (vector.empty()) {
+                callback({}, tr("Malformed embeddings response"));
+                return;
+            }
+        }
+        callback(vectors, {});
+    });
+    return reply;
+}
+
+} // namespace DeepSeek
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QObject>
+#include <QStringList>
+#include <QUrl>
+
+#include <functional>
+#include <vector>
+
+QT_BEGIN_NAMESPACE
+class QNetworkReply;
+QT_END_NAMESPACE
+
+namespace DeepSeek {
+
+// Cliente del endpoint /embeddings compatible con OpenAI. DeepSeek no ofrece
+// embeddings, así que normalmente apunta a otro servidor (uno local basta).
+class DeepSeekEmbeddingClient : public QObject
+{
+    Q_OBJECT
+public:
+    // vectors tiene un vector por texto, en el mismo orden; vacío si hay error
+    using Callback = std::function<void(const QList<std::vector<float>> &vectors,
+                                        const QString &errorString)>;
+
+    explicit DeepSeekEmbeddingClient(QObject *parent = nullptr);
+
+    // baseUrl como la del chat: se normaliza a .../v1/embeddings
+    void setEndpoint(const QString &baseUrl, const QString &model, const QString &apiKey);
+    QString model() const { return m_model; }
+    bool isConfigured() const { return m_url.isValid() && !m_model.isEmpty(); }
+
+    QNetworkReply *embed(const QStringList &texts, Callback callback,
+                         int timeoutMs = DefaultTimeoutMs);
+
+    static constexpr int DefaultTimeoutMs = 30000;
+
+private:
+    QUrl m_url;
+    QString m_model;
+    QString m_apiKey;
+};
+
+} // namespace DeepSeek
@@ -0,0 +1,340 @@
+#include "deepseekhistorystore.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QObject>
+#include <QSaveFile>
+
+namespace DeepSeek {
+
+static constexpr quint32 IndexMagic = 0x44534958; // "DSIX"
+static constexpr quint32 IndexVersion = 1;
+static constexpr qint64 IndexHeaderSize = 2 * sizeof(quint32);
+static constexpr qint64 ScanBlockSize = 64 * 1024;
+
+static void setError(QString *errorString, const QString &message)
+{
+    if (errorString)
+        *errorString = message;
+}
+
+DeepSeekHistoryStore::DeepSeekHistoryStore(const QString &logPath)
+    : m_path(logPath)
+{}
+
+void DeepSeekHistoryStore::setPath(const QString &logPath)
+{
+    m_path = logPath;
+    m_ends.clear();
+    m_open = false;
+}
+
+QString DeepSeekHistoryStore::indexPath() const
+{
+    return m_path + ".idx";
+}
+
+void DeepSeekHistoryStore::setRetention(int keepEntries)
+{
+    m_keepEntries = qMax(1, keepEntries);
+}
+
+bool DeepSeekHistoryStore::open(QString *errorString)
+{
+    m_open = false;
+    m_ends.clear();
+
+    const QFileInfo info(m_path);
+    if (!QDir().mkpath(info.absolutePath())) {
+        setError(errorString, QObject::tr("Failed to create directory: %1").arg(info.absolutePath()));
+        return false;
+    }
+
+    const qint64 size = info.exists() ? info.size() : 0;
+
+    // Índice ausente, dañado o que describe más datos de los que hay:
+    // se reconstruye recorriendo el registro completo.
+    if (!loadIndex() || logSize() > size)
+        m_ends.clear();
+
+    // Registros escritos sin llegar a indexar (p.ej. cierre inesperado)
+    if (logSize() < size) {
+        if (!indexFrom(logSize(), errorString) || !writeIndex(errorString))
+            return false;
+    }
+
+    m_open = true;
+    return true;
+}
+
+bool DeepSeekHistoryStore::append(const QJsonObject &entry, QString *errorString)
+{
+    if (!m_open && !open(errorString))
+        return false;
+
+    QFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        setError(errorString, QObject::tr("Cannot append to file: %1").arg(file.errorString()));
+        return false;
+    }
+
+    // Otra instancia de Qt Creator puede haber escrito en el mismo registro
+    if (file.size() != logSize()) {
+        file.close();
+        if (!open(errorString) || !file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            setError(errorString, QObject::tr("Cannot append to file: %1").arg(file.errorString()));
+            return false;
+        }
+    }
+
+    QByteArray line = QJsonDocument(entry).toJson(QJsonDocument::Compact);
+    line.append('\n');
+
+    const qint64 start = file.size();
+    if (file.write(line) != line.size() || !file.flush()) {
+        setError(errorString, QObject::tr("Cannot append to file: %1").arg(file.errorString()));
+        file.resize(start);
+        return false;
+    }
+    file.close();
+
+    const qint64 end = start + line.size();
+    m_ends.append(end);
+    if (!appendIndex(end, errorString))
+        return false;
+
+    if (count() >= m_keepEntries * CompactionFactor)
+        return compact(m_keepEntries, errorString);
+    return true;
+}
+
+QJsonArray DeepSeekHistoryStore::readTail(int maxEntries, QString *errorString) const
+{
+    QJsonArray entries;
+    if (m_ends.isEmpty() || maxEntries <= 0)
+        return entries;
+
+    const int first = qMax(0, count() - maxEntries);
+    const qint64 start = first > 0 ? m_ends.at(first - 1) : 0;
+
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(start)) {
+        setError(errorString, QObject::tr("Cannot read file: %1").arg(file.errorString()));
+        return entries;
+    }
+    const QByteArray data = file.read(logSize() - start);
+
+    qsizetype from = 0;
+    qsizetype newline = -1;
+    while ((newline = data.indexOf('\n', from)) >= 0) {
+        QJsonParseError parseError;
+        const QJsonDocument doc
+            = QJsonDocument::fromJson(QByteArray::fromRawData(data.constData() + from, newline - from),
+                                      &parseError);
+        if (parseError.error == QJsonParseError::NoError && doc.isObject())
+            entries.append(doc.object());
+        else
+            qWarning() << "Skipping invalid history record at offset" << start + from << ":"
+                       << parseError.errorString();
+        from = newline + 1;
+    }
+    return entries;
+}
+
+bool DeepSeekHistoryStore::compact(int keepEntries, QString *errorString)
+{
+    if (count() <= keepEntries)
+        return true;
+
+    const int first = count() - keepEntries;
+    const qint64 start = m_ends.at(first - 1);
+
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(start)) {
+        setError(errorString, QObject::tr("Cannot read file: %1").arg(file.errorString()));
+        return false;
+    }
+    const QByteArray tail = file.read(logSize() - start);
+    file.close();
+
+    QSaveFile saver(m_path);
+    if (!saver.open(QIODevice::WriteOnly) || saver.write(tail) != tail.size() || !saver.commit()) {
+        setError(errorString, QObject::tr("Cannot write to file: %1").arg(saver.errorString()));
+        return false;
+    }
+
+    QList<qint64> ends;
+    ends.reserve(keepEntries);
+    for (int i = first; i < count(); ++i)
+        ends.append(m_ends.at(i) - start);
+    m_ends = ends;
+
+    return writeIndex(errorString);
+}
+
+bool DeepSeekHistoryStore::clear(QString *errorString)
+{
+    m_ends.clear();
+    QFile::remove(indexPath());
+    if (QFile::exists(m_path) && !QFile::remove(m_path)) {
+        setError(errorString, QObject::tr("Cannot remove file: %1").arg(m_path));
+        return false;
+    }
+    return true;
+}
+
+bool DeepSeekHistoryStore::importLegacy(const QString &jsonPath, QString *errorString)
+{
+    if (QFileInfo::exists(m_path) || !QFileInfo::exists(jsonPath))
+        return true;
+
+    QFile legacy(jsonPath);
+    if (!legacy.open(QIODevice::ReadOnly)) {
+        setError(errorString, QObject::tr("Cannot read file: %1").arg(legacy.errorString()));
+        return false;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(legacy.readAll(), &parseError);
+    legacy.close();
+    if (parseError.error != QJsonParseError::NoError || !doc.isArray()) {
+        setError(errorString, QObject::tr("History file should contain a JSON array"));
+        return false;
+    }
+
+    QByteArray data;
+    QList<qint64> ends;
+    const QJsonArray array = doc.array();
+    for (const QJsonValue &value : array) {
+        if (!value.isObject())
+            continue;
+        data.append(QJsonDocument(value.toObject()).toJson(QJsonDocument::Compact));
+        data.append('\n');
+        ends.append(data.size());
+    }
+
+    if (!QDir().mkpath(QFileInfo(m_path).absolutePath())) {
+        setError(errorString, QObject::tr("Failed to create directory: %1")
+                                  .arg(QFileInfo(m_path).absolutePath()));
+        return false;
+    }
+
+    QSaveFile saver(m_path);
+    if (!saver.open(QIODevice::WriteOnly) || saver.write(data) != data.size() || !saver.commit()) {
+        setError(errorString, QObject::tr("Cannot write to file: %1").arg(saver.errorString()));
+        return false;
+    }
+
+    m_ends = ends;
+    if (!writeIndex(errorString))
+        return false;
+
+    QFile::rename(jsonPath, jsonPath + ".migrated");
+    m_open = true;
+    return true;
+}
+
+bool DeepSeekHistoryStore::loadIndex()
+{
+    QFile file(indexPath());
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (magic != IndexMagic || version != IndexVersion)
+        return false;
+
+    const qint64 entries = (file.size() - IndexHeaderSize) / qint64(sizeof(qint64));
+    m_ends.reserve(entries);
+    qint64 previous = 0;
+    for (qint64 i = 0; i < entries; ++i) {
+        qint64 end = 0;
+        in >> end;
+        if (in.status() != QDataStream::Ok || end <= previous) {
+            m_ends.clear();
+            return false;
+        }
+        m_ends.append(end);
+        previous = end;
+    }
+    return true;
+}
+
+bool DeepSeekHistoryStore::indexFrom(qint64 position, QString *errorString)
+{
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadWrite) || !file.seek(position)) {
+        setError(errorString, QObject::tr("Cannot read file: %1").arg(file.errorString()));
+        return false;
+    }
+
+    qint64 offset = position;
+    QByteArray block;
+    while (!(block = file.read(ScanBlockSize)).isEmpty()) {
+        qsizetype from = 0;
+        qsizetype newline = -1;
+        while ((newline = block.indexOf('\n', from)) >= 0) {
+            m_ends.append(offset + newline + 1);
+            from = newline + 1;
+        }
+        offset += block.size();
+    }
+
+    // Registro incompleto al final (escritura interrumpida): se descarta
+    if (offset > logSize()) {
+        qWarning() << "Discarding incomplete history record at offset" << logSize();
+        file.resize(logSize());
+    }
+    return true;
+}
+
+bool DeepSeekHistoryStore::writeIndex(QString *errorString)
+{
+    QSaveFile saver(indexPath());
+    if (!saver.open(QIODevice::WriteOnly)) {
+        setError(errorString, QObject::tr("Cannot write to file: %1").arg(saver.errorString()));
+        return false;
+    }
+
+    QDataStream out(&saver);
+    out << IndexMagic << IndexVersion;
+    for (const qint64 end : std::as_const(m_ends))
+        out << end;
+
+    if (!saver.commit()) {
+        setError(errorString, QObject::tr("Cannot write to file: %1").arg(saver.errorString()));
+        return false;
+    }
+    return true;
+}
+
+bool DeepSeekHistoryStore::appendIndex(qint64 end, QString *errorString)
+{
+    QFile file(indexPath());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        setError(errorString, QObject::tr("Cannot append to file: %1").arg(file.errorString()));
+        return false;
+    }
+
+    // El índice debe describir exactamente los registros anteriores; si no,
+    // se reescribe entero.
+    const qint64 expected = IndexHeaderSize + qint64(m_ends.size() - 1) * qint64(sizeof(qint64));
+    if (file.size() != expected) {
+        file.close();
+        return writeIndex(errorString);
+    }
+
+    QDataStream out(&file);
+    out << end;
+    return out.status() == QDataStream::Ok;
+}
+
+} // namespace DeepSeek
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+
+namespace DeepSeek {
+
+// Historial de conversación como registro de solo-anexado (JSONL, un objeto
+// compacto por línea) con un índice binario de desplazamientos al lado
+// (<log>.idx). Guardar una respuesta cuesta un único append al registro y
+// otro al índice; cargar solo lee el índice y la cola que se pide.
+//
+// El índice guarda el final de cada registro, así que el registro i ocupa
+// [end(i-1), end(i)). Si el proceso muere entre las dos escrituras, open()
+// detecta la diferencia de tamaño e indexa solo los registros que faltan.
+class DeepSeekHistoryStore
+{
+public:
+    explicit DeepSeekHistoryStore(const QString &logPath = {});
+
+    void setPath(const QString &logPath);
+    QString path() const { return m_path; }
+    QString indexPath() const;
+
+    // Registros que se conservan al compactar. La compactación se lanza sola
+    // cuando el registro llega a CompactionFactor veces esa cantidad.
+    void setRetention(int keepEntries);
+    int retention() const { return m_keepEntries; }
+    static constexpr int CompactionFactor = 2;
+
+    bool open(QString *errorString = nullptr);
+    bool isOpen() const { return m_open; }
+    int count() const { return int(m_ends.size()); }
+    qint64 logSize() const { return m_ends.isEmpty() ? 0 : m_ends.last(); }
+
+    bool append(const QJsonObject &entry, QString *errorString = nullptr);
+    QJsonArray readTail(int maxEntries, QString *errorString = nullptr) const;
+    bool compact(int keepEntries, QString *errorString = nullptr);
+    bool clear(QString *errorString = nullptr);
+
+    // Importa el antiguo fichero JSON (un único array reescrito en cada
+    // respuesta) si el registro todavía no existe.
+    bool importLegacy(const QString &jsonPath, QString *errorString = nullptr);
+
+private:
+    bool loadIndex();
+    bool indexFrom(qint64 position, QString *errorString);
+    bool writeIndex(QString *errorString);
+    bool appendIndex(qint64 end, QString *errorString);
+
+    QString m_path;
+    QList<qint64> m_ends;
+    int m_keepEntries = 100;
+    bool m_open = false;
+};
+
+} // namespace DeepSeek
@@ -0,0 +1,347 @@
+#include "deepseekmarkdownrenderer.h"
+
+#include <KSyntaxHighlighting/AbstractHighlighter>
+#include <KSyntaxHighlighting/Definition>
+#include <KSyntaxHighlighting/Format>
+#include <KSyntaxHighlighting/Repository>
+#include <KSyntaxHighlighting/State>
+#include <KSyntaxHighlighting/Theme>
+
+#include <QColor>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QThreadPool>
+
+namespace DeepSeek {
+
+namespace {
+
+struct HighlightingConfig
+{
+    QMutex mutex;
+    QStringList searchPaths;
+    bool darkTheme = false;
+};
+
+Q_GLOBAL_STATIC(HighlightingConfig, highlightingConfig)
+
+class RenderPool : public QThreadPool
+{
+public:
+    RenderPool()
+    {
+        // Un único hilo: el orden de los trabajos se conserva y el repositorio
+        // de definiciones (no es thread-safe) solo se usa desde ese hilo.
+        setMaxThreadCount(1);
+        setExpiryTimeout(-1);
+    }
+};
+
+Q_GLOBAL_STATIC(RenderPool, renderPool)
+
+// Un repositorio propio para el hilo de render; el de Qt Creator pertenece al
+// hilo principal.
+KSyntaxHighlighting::Repository &threadRepository()
+{
+    thread_local std::unique_ptr<KSyntaxHighlighting::Repository> repository;
+    if (!repository) {
+        repository = std::make_unique<KSyntaxHighlighting::Repository>();
+        QMutexLocker locker(&highlightingConfig()->mutex);
+        for (const QString &path : std::as_const(highlightingConfig()->searchPaths))
+            repository->addCustomSearchPath(path);
+    }
+    return *repository;
+}
+
+bool useDarkTheme()
+{
+    QMutexLocker locker(&highlightingConfig()->mutex);
+    return highlightingConfig()->darkTheme;
+}
+
+QString formatEmphasis(QStringView text)
+{
+    static const QRegularExpression bold(R"(\*\*(?=\S)(.+?)(?<=\S)\*\*)");
+    static const QRegularExpression italicStar(R"((?<![*\w])\*(?=\S)(.+?)(?<=\S)\*(?![*\w]))");
+    // Sin \w alrededor para no tocar identificadores como snake_case_name
+    static const QRegularExpression italicUnderscore(R"((?<!\w)_(?=\S)(.+?)(?<=\S)_(?!\w))");
+    static const QRegularExpression link(R"(\[([^\]]+)\]\(([^)\s]+)\))");
+
+    QString html = text.toString().toHtmlEscaped();
+    html.replace(bold, "<b>\\1</b>");
+    html.replace(italicStar, "<i>\\1</i>");
+    html.replace(italicUnderscore, "<i>\\1</i>");
+    html.replace(link, "<a href=\"\\2\">\\1</a>");
+    return html;
+}
+
+} // namespace
+
+// Resalta un bloque de código línea a línea generando HTML. El estado de
+// KSyntaxHighlighting se conserva entre llamadas (comentarios de varias
+// líneas, cadenas, ...), de modo que cada línea se procesa una sola vez.
+class DeepSeekCodeHighlighter : public KSyntaxHighlighting::AbstractHighlighter
+{
+public:
+    explicit DeepSeekCodeHighlighter(const QString &language)
+    {
+        KSyntaxHighlighting::Repository &repository = threadRepository();
+        setTheme(repository.defaultTheme(useDarkTheme()
+                                             ? KSyntaxHighlighting::Repository::DarkTheme
+                                             : KSyntaxHighlighting::Repository::LightTheme));
+        if (language.isEmpty())
+            return;
+
+        // Las etiquetas de Markdown suelen ser extensiones ("cpp", "py")
+        KSyntaxHighlighting::Definition definition = repository.definitionForName(language);
+        if (!definition.isValid())
+            definition = repository.definitionForFileName("code." + language);
+        setDefinition(definition);
+    }
+
+    QString renderLine(QStringView line)
+    {
+        if (!definition().isValid())
+            return line.toString().toHtmlEscaped();
+
+        m_line = line;
+        m_position = 0;
+        m_html.clear();
+        m_state = highlightLine(line, m_state);
+        if (m_position < line.size())
+            m_html += line.mid(m_position).toString().toHtmlEscaped();
+        return m_html;
+    }
+
+    QString backgroundColor() const
+    {
+        return QColor::fromRgba(theme().editorColor(KSyntaxHighlighting::Theme::BackgroundColor))
+            .name();
+    }
+
+protected:
+    void applyFormat(int offset, int length, const KSyntaxHighlighting::Format &format) override
+    {
+        if (offset > m_position)
+            m_html += m_line.mid(m_position, offset - m_position).toString().toHtmlEscaped();
+
+        const QString text = m_line.mid(offset, length).toString().toHtmlEscaped();
+        m_position = offset + length;
+
+        const KSyntaxHighlighting::Theme &currentTheme = theme();
+        if (format.isDefaultTextStyle(currentTheme)) {
+            m_html += text;
+            return;
+        }
+
+        QString style;
+        if (format.hasTextColor(currentTheme))
+            style += QString("color:%1;").arg(format.textColor(currentTheme).name());
+        if (format.isBold(currentTheme))
+            style += "font-weight:bold;";
+        if (format.isItalic(currentTheme))
+            style += "font-style:italic;";
+        m_html += QString("<span style=\"%1\">%2</span>").arg(style, text);
+    }
+
+private:
+    KSyntaxHighlighting::State m_state;
+    QStringView m_line;
+    qsizetype m_position = 0;
+    QString m_html;
+};
+
+DeepSeekMarkdownRenderer::DeepSeekMarkdownRenderer() = default;
+
+DeepSeekMarkdownRenderer::~DeepSeekMarkdownRenderer() = default;
+
+void DeepSeekMarkdownRenderer::configureHighlighting(const QStringList &searchPaths,
+                                                     bool darkTheme)
+{
+    QMutexLocker locker(&highlightingConfig()->mutex);
+    highlightingConfig()->searchPaths = searchPaths;
+    highlightingConfig()->darkTheme = darkTheme;
+}
+
+QThreadPool *DeepSeekMarkdownRenderer::threadPool()
+{
+    return renderPool();
+}
+
+QString DeepSeekMarkdownRenderer::renderPlain(const QString &text)
+{
+    return "<p>" + text.toHtmlEscaped().replace('\n', "<br>") + "</p>";
+}
+
+QString DeepSeekMarkdownRenderer::renderInline(QStringView text)
+{
+    // Primero los `spans de código`: su contenido no lleva más formato
+    QString html;
+    qsizetype position = 0;
+    while (position < text.size()) {
+        const qsizetype open = text.indexOf('`', position);
+        if (open < 0)
+            break;
+        const qsizetype close = text.indexOf('`', open + 1);
+        if (close < 0)
+            break;
+        html += formatEmphasis(text.mid(position, open - position));
+        html += "<code>" + text.mid(open + 1, close - open - 1).toString().toHtmlEscaped()
+                + "</code>";
+        position = close + 1;
+    }
+    html += formatEmphasis(text.mid(position));
+    return html;
+}
+
+DeepSeekMarkdownRenderer::Update DeepSeekMarkdownRenderer::feed(QStringView text)
+{
+    Update update;
+    m_pending.append(text);
+
+    qsizetype start = 0;
+    for (qsizetype newline = m_pending.indexOf('\n'); newline >= 0;
+         newline = m_pending.indexOf('\n', start)) {
+        QStringView line = QStringView(m_pending).mid(start, newline - start);
+        if (line.endsWith('\r'))
+            line.chop(1);
+        processLine(line, update.fragments);
+        start = newline + 1;
+    }
+    m_pending.remove(0, start);
+
+    update.tail = tailHtml();
+    return update;
+}
+
+DeepSeekMarkdownRenderer::Update DeepSeekMarkdownRenderer::finish()
+{
+    Update update;
+    if (!m_pending.isEmpty()) {
+        const QString line = m_pending;
+        m_pending.clear();
+        processLine(line, update.fragments);
+    }
+    closeBlock(update.fragments);
+    return update;
+}
+
+void DeepSeekMarkdownRenderer::processLine(QStringView line, QStringList &fragments)
+{
+    static const QRegularExpression fence(R"(^ {0,3}(`{3,}|~{3,})\s*([^`\s]*))");
+    static const QRegularExpression heading(R"(^ {0,3}(#{1,6})\s+(.*?)\s*#*\s*$)");
+    static const QRegularExpression rule(R"(^ {0,3}([-*_])(\s*\1){2,}\s*$)");
+    static const QRegularExpression listItem(R"(^(\s*)([-*+]|\d{1,9}[.)])\s+(.*)$)");
+    static const QRegularExpression quote(R"(^ {0,3}>\s?(.*)$)");
+
+    if (m_block == BlockType::Code) {
+        const QStringView trimmed = line.trimmed();
+        if (trimmed.startsWith(m_fence)
+            && trimmed.count(m_fence.at(0)) == trimmed.size()) {
+            closeBlock(fragments);
+            return;
+        }
+        fragments.append(codeLineHtml(m_highlighter->renderLine(line)));
+        return;
+    }
+
+    if (const QRegularExpressionMatch match = fence.matchView(line); match.hasMatch()) {
+        closeBlock(fragments);
+        m_block = BlockType::Code;
+        m_fence = match.captured(1);
+        m_highlighter = std::make_unique<DeepSeekCodeHighlighter>(match.captured(2).toLower());
+        return;
+    }
+
+    if (line.trimmed().isEmpty()) {
+        closeBlock(fragments);
+        return;
+    }
+
+    if (const QRegularExpressionMatch match = heading.matchView(line); match.hasMatch()) {
+        closeBlock(fragments);
+        const int level = int(match.capturedLength(1));
+        fragments.append(QString("<h%1>%2</h%1>").arg(level).arg(renderInline(match.capturedView(2))));
+        return;
+    }
+
+    if (rule.matchView(line).hasMatch()) {
+        closeBlock(fragments);
+        fragments.append("<hr/>");
+        return;
+    }
+
+    if (const QRegularExpressionMatch match = listItem.matchView(line); match.hasMatch()) {
+        closeBlock(fragments);
+        // Cada elemento es un bloque propio: se cierra en cuanto termina su línea
+        const QStringView marker = match.capturedView(2);
+        const QString bullet = marker.front().isDigit() ? marker.toString().toHtmlEscaped()
+                                                        : QString(QChar(0x2022));
+        const int indent = 16 + int(match.capturedLength(1)) * 8;
+        fragments.append(QString("<p style=\"margin-left:%1px;\">%2 %3</p>")
+                             .arg(indent)
+                             .arg(bullet, renderInline(match.capturedView(3))));
+        return;
+    }
+
+    if (const QRegularExpressionMatch match = quote.matchView(line); match.hasMatch()) {
+        closeBlock(fragments);
+        fragments.append("<blockquote>" + renderInline(match.capturedView(1)) + "</blockquote>");
+        return;
+    }
+
+    m_block = BlockType::Paragraph;
+    m_paragraphLines.append(line.trimmed().toString());
+}
+
+void DeepSeekMarkdownRenderer::closeBlock(QStringList &fragments)
+{
+    switch (m_block) {
+    case BlockType::None:
+        return;
+    case BlockType::Paragraph:
+        fragments.append("<p>" + renderInline(m_paragraphLines.join('\n')).replace('\n', "<br>")
+                         + "</p>");
+        m_paragraphLines.clear();
+        break;
+    case BlockType::Code:
+        // Las líneas ya salieron una a una
+        m_fence.clear();
+        m_highlighter.reset();
+        break;
+    }
+    m_block = BlockType::None;
+}
+
+QString DeepSeekMarkdownRenderer::codeLineHtml(const QString &line) const
+{
+    // Sin márgenes, las líneas seguidas se ven como un único bloque; el
+    // espacio mantiene la altura y el fondo de las líneas vacías
+    return QString("<pre style=\"margin-top:0px; margin-bottom:0px; background-color:%1;\">%2</pre>")
+        .arg(m_highlighter ? m_highlighter->backgroundColor() : QString("transparent"),
+             line.isEmpty() ? QString(" ") : line);
+}
+
+QString DeepSeekMarkdownRenderer::tailHtml() const
+{
+    // Solo el bloque abierto: su coste depende de su tamaño, no del mensaje.
+    // En un bloque de código es solo la línea sin terminar.
+    switch (m_block) {
+    case BlockType::Code:
+        return m_pending.isEmpty() ? QString() : codeLineHtml(m_pending.toHtmlEscaped());
+    case BlockType::Paragraph: {
+        QStringList lines = m_paragraphLines;
+        if (!m_pending.trimmed().isEmpty())
+            lines.append(m_pending.trimmed());
+        return "<p>" + renderInline(lines.join('\n')).replace('\n', "<br>") + "</p>";
+    }
+    case BlockType::None:
+        break;
+    }
+    if (m_pending.trimmed().isEmpty())
+        return {};
+    return "<p>" + renderInline(m_pending.trimmed()) + "</p>";
+}
+
+} // namespace DeepSeek
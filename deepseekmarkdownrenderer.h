@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+
+#include <memory>
+
+QT_BEGIN_NAMESPACE
+class QThreadPool;
+QT_END_NAMESPACE
+
+namespace DeepSeek {
+
+class DeepSeekCodeHighlighter;
+
+// Convierte Markdown a HTML de forma incremental: feed() solo procesa el texto
+// recién llegado y devuelve los bloques que se han cerrado con él (párrafos,
+// encabezados, elementos de lista, bloques de código) más un HTML provisional
+// del bloque que sigue abierto. Los bloques cerrados no se vuelven a generar.
+//
+// Los bloques de código se resaltan línea a línea con las definiciones de
+// KSyntaxHighlighting de Qt Creator conservando el estado entre líneas, y cada
+// línea terminada sale como un fragmento propio: ni se vuelve a resaltar ni
+// se vuelve a generar; el provisional es solo la línea sin terminar. Una
+// instancia no es reentrante: se usa desde threadPool(), que tiene un único
+// hilo.
+class DeepSeekMarkdownRenderer
+{
+public:
+    struct Update
+    {
+        QStringList fragments; // bloques terminados nuevos, en orden
+        QString tail;          // HTML del bloque aún abierto (puede estar vacío)
+    };
+
+    DeepSeekMarkdownRenderer();
+    ~DeepSeekMarkdownRenderer();
+
+    Update feed(QStringView text);
+    Update finish(); // cierra el bloque abierto; tail queda vacío
+
+    static QString renderInline(QStringView text);
+    static QString renderPlain(const QString &text);
+
+    // Rutas de definiciones adicionales (las de Qt Creator) y tema a usar.
+    // Debe llamarse desde el hilo principal antes de encolar trabajo.
+    static void configureHighlighting(const QStringList &searchPaths, bool darkTheme);
+    static QThreadPool *threadPool();
+
+private:
+    enum class BlockType { None, Paragraph, Code };
+
+    void processLine(QStringView line, QStringList &fragments);
+    void closeBlock(QStringList &fragments);
+    QString codeLineHtml(const QString &line) const;
+    QString tailHtml() const;
+
+    QString m_pending; // línea incompleta
+    BlockType m_block = BlockType::None;
+    QStringList m_paragraphLines;
+    QString m_fence; // "```" o "~~~" (o más largo) que abrió el bloque de código
+    std::unique_ptr<DeepSeekCodeHighlighter> m_highlighter;
+};
+
+} // namespace DeepSeek
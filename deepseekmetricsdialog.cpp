@@ -0,0 +1,95 @@
+#include "deepseekmetricsdialog.h"
+#include "deepseekrequestmetrics.h"
+
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QStandardPaths>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+namespace DeepSeek {
+
+using Field = DeepSeekRequestMetrics::Field;
+
+DeepSeekMetricsDialog::DeepSeekMetricsDialog(DeepSeekRequestMetrics *metrics, QWidget *parent)
+    : QDialog(parent)
+    , m_metrics(metrics)
+{
+    setWindowTitle(tr("DeepSeek Request Metrics"));
+    resize(520, 320);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    m_summaryLabel = new QLabel(this);
+    layout->addWidget(m_summaryLabel);
+
+    m_table = new QTableWidget(6, 4, this);
+    m_table->setHorizontalHeaderLabels({tr("p50"), tr("p95"), tr("p99"), tr("Samples")});
+    m_table->setVerticalHeaderLabels({tr("Queue (ms)"), tr("Connect (ms)"), tr("First byte (ms)"),
+                                      tr("Total (ms)"), tr("Prompt tokens"),
+                                      tr("Completion tokens")});
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->setSelectionMode(QAbstractItemView::NoSelection);
+    m_table->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    layout->addWidget(m_table, 1);
+
+    QHBoxLayout *buttonsLayout = new QHBoxLayout;
+    QPushButton *exportButton = new QPushButton(tr("Export CSV..."));
+    QPushButton *clearButton = new QPushButton(tr("Clear"));
+    QPushButton *closeButton = new QPushButton(tr("Close"));
+    connect(exportButton, &QPushButton::clicked, this, &DeepSeekMetricsDialog::exportCsv);
+    connect(clearButton, &QPushButton::clicked, this, [this]() {
+        m_metrics->clear();
+        refresh();
+    });
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::close);
+    buttonsLayout->addWidget(exportButton);
+    buttonsLayout->addWidget(clearButton);
+    buttonsLayout->addStretch();
+    buttonsLayout->addWidget(closeButton);
+    layout->addLayout(buttonsLayout);
+
+    refresh();
+}
+
+void DeepSeekMetricsDialog::refresh()
+{
+    m_summaryLabel->setText(tr("%1 requests (last %2 kept), %3 failed or canceled")
+                                .arg(m_metrics->size())
+                                .arg(m_metrics->capacity())
+                                .arg(m_metrics->errorCount()));
+
+    const Field fields[] = {Field::Queue, Field::Connect, Field::FirstByte,
+                            Field::Total, Field::PromptTokens, Field::CompletionTokens};
+    for (int row = 0; row < 6; ++row) {
+        const DeepSeekRequestMetrics::Percentiles p = m_metrics->percentiles(fields[row]);
+        const qint64 values[] = {p.p50, p.p95, p.p99, p.samples};
+        for (int column = 0; column < 4; ++column) {
+            const QString text = values[column] < 0 ? QString("-") : QString::number(values[column]);
+            auto item = new QTableWidgetItem(text);
+            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            m_table->setItem(row, column, item);
+        }
+    }
+}
+
+void DeepSeekMetricsDialog::exportCsv()
+{
+    const QString defaultPath = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation)
+                                + "/deepseek_metrics.csv";
+    const QString filePath = QFileDialog::getSaveFileName(this, tr("Export Metrics"), defaultPath,
+                                                          tr("CSV files (*.csv)"));
+    if (filePath.isEmpty())
+        return;
+
+    QString errorString;
+    if (!m_metrics->exportCsv(filePath, &errorString)) {
+        QMessageBox::warning(this, tr("Export Metrics"),
+                             tr("Could not write %1: %2").arg(filePath, errorString));
+    }
+}
+
+} // namespace DeepSeek
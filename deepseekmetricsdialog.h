@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QDialog>
+
+QT_BEGIN_NAMESPACE
+class QLabel;
+class QTableWidget;
+QT_END_NAMESPACE
+
+namespace DeepSeek {
+
+class DeepSeekRequestMetrics;
+
+// Resumen de las métricas de las últimas peticiones: percentiles de cada
+// fase y de los tokens, con exportación a CSV de todas las muestras. No es
+// modal; quien lo abre llama a refresh() cuando llega una muestra nueva.
+class DeepSeekMetricsDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    // metrics debe vivir más que el diálogo
+    explicit DeepSeekMetricsDialog(DeepSeekRequestMetrics *metrics, QWidget *parent = nullptr);
+
+    void refresh();
+
+private:
+    void exportCsv();
+
+    DeepSeekRequestMetrics *m_metrics;
+    QLabel *m_summaryLabel = nullptr;
+    QTableWidget *m_table = nullptr;
+};
+
+} // namespace DeepSeek
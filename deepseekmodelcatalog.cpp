@@ -0,0 +1,381 @@
+#include "deepseekmodelcatalog.h"
+#include "deepseekcontextwindow.h"
+#include "deepseeknetworkservice.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <chrono>
+
+namespace DeepSeek {
+
+static constexpr int CacheFormatVersion = 1;
+
+// Precio por token (a veces como texto) a USD por millón de tokens
+static double perMillion(const QJsonValue &value)
+{
+    bool ok = false;
+    const double perToken = value.isString() ? value.toString().toDouble(&ok)
+                                             : value.toDouble(-1);
+    if (value.isString() && !ok)
+        return -1;
+    return perToken < 0 ? -1 : perToken * 1e6;
+}
+
+DeepSeekModelCatalog::DeepSeekModelCatalog(QObject *parent)
+    : QObject(parent)
+{
+    m_refreshTimer.setSingleShot(true);
+    connect(&m_refreshTimer, &QTimer::timeout, this, &DeepSeekModelCatalog::refresh);
+}
+
+DeepSeekModelCatalog::~DeepSeekModelCatalog()
+{
+    abortRefresh();
+}
+
+QUrl DeepSeekModelCatalog::modelsUrl(const QUrl &apiUrl)
+{
+    // La misma regla que el chat para /chat/completions
+    QUrl url(apiUrl);
+    if (!url.path().endsWith("/v1"))
+        url.setPath("/v1");
+    url.setPath(url.path() + "/models");
+    return url;
+}
+
+void DeepSeekModelCatalog::setAutoRefresh(bool enabled)
+{
+    m_autoRefresh = enabled;
+    if (enabled)
+        scheduleRefresh();
+    else
+        m_refreshTimer.stop();
+}
+
+void DeepSeekModelCatalog::setEndpoint(const QUrl &apiUrl, const QString &apiKey)
+{
+    const QUrl url = modelsUrl(apiUrl);
+    if (url == m_url && apiKey == m_apiKey)
+        return;
+
+    const bool keyChanged = url == m_url;
+    m_url = url;
+    m_apiKey = apiKey;
+    abortRefresh();
+
+    if (keyChanged) {
+        // Otra cuenta puede ver otros modelos: no se espera a que caduque
+        if (m_apiKey.isEmpty() || !m_autoRefresh)
+            m_refreshTimer.stop();
+        else
+            refresh();
+        return;
+    }
+
+    m_models.clear();
+    m_fetchedAt = {};
+    m_etag.clear();
+    m_lastModified.clear();
+    loadCache();
+    emit modelsChanged();
+    scheduleRefresh();
+}
+
+DeepSeekModelCatalog::ModelInfo DeepSeekModelCatalog::info(const QString &id) const
+{
+    for (const ModelInfo &model : m_models) {
+        if (model.id == id)
+            return model;
+    }
+    return knownModel(id);
+}
+
+int DeepSeekModelCatalog::contextLength(const QString &id) const
+{
+    const int length = info(id).contextLength;
+    return length > 0 ? length : DeepSeekContextWindow::contextLengthForModel(id);
+}
+
+int DeepSeekModelCatalog::maxOutputTokens(const QString &id) const
+{
+    return info(id).maxOutputTokens;
+}
+
+DeepSeekModelCatalog::ModelInfo DeepSeekModelCatalog::knownModel(const QString &id)
+{
+    // Precios orientativos de la API de DeepSeek; si el servidor envía los
+    // suyos, mandan los del servidor.
+    ModelInfo info;
+    info.id = id;
+    if (id.startsWith("deepseek-reasoner")) {
+        info.ownedBy = "deepseek";
+        info.description = tr("Optimizado para razonamiento lógico y matemático.");
+        info.contextLength = DeepSeekContextWindow::contextLengthForModel(id);
+        info.maxOutputTokens = 8192;
+        info.inputPrice = 0.55;
+        info.cachedInputPrice = 0.14;
+        info.outputPrice = 2.19;
+    } else if (id.startsWith("deepseek-chat")) {
+        info.ownedBy = "deepseek";
+        info.description = tr("Modelo general para conversaciones y asistencia técnica.");
+        info.contextLength = DeepSeekContextWindow::contextLengthForModel(id);
+        info.maxOutputTokens = 8192;
+        info.inputPrice = 0.27;
+        info.cachedInputPrice = 0.07;
+        info.outputPrice = 1.10;
+    } else if (id.startsWith("deepseek-coder")) {
+        info.ownedBy = "deepseek";
+        info.contextLength = DeepSeekContextWindow::contextLengthForModel(id);
+    }
+    return info;
+}
+
+DeepSeekModelCatalog::ModelInfo DeepSeekModelCatalog::parseModel(const QJsonObject &object)
+{
+    ModelInfo info = knownModel(object.value("id").toString());
+    if (object.contains("owned_by"))
+        info.ownedBy = object.value("owned_by").toString();
+    if (object.value("description").isString())
+        info.description = object.value("description").toString();
+
+    // Campos que añaden algunos servidores compatibles con OpenAI
+    const int context = object.value("context_length").toInt(object.value("context_window").toInt());
+    if (context > 0)
+        info.contextLength = context;
+    const int output = object.value("max_output_tokens")
+                           .toInt(object.value("max_completion_tokens").toInt());
+    if (output > 0)
+        info.maxOutputTokens = output;
+
+    // Formato de OpenRouter: precio por token
+    const QJsonObject pricing = object.value("pricing").toObject();
+    if (pricing.contains("prompt"))
+        info.inputPrice = perMillion(pricing.value("prompt"));
+    if (pricing.contains("input_cache_read"))
+        info.cachedInputPrice = perMillion(pricing.value("input_cache_read"));
+    if (pricing.contains("completion"))
+        info.outputPrice = perMillion(pricing.value("completion"));
+    return info;
+}
+
+QJsonObject DeepSeekModelCatalog::toJson(const ModelInfo &info)
+{
+    return QJsonObject{{"id", info.id},
+                       {"ownedBy", info.ownedBy},
+                       {"description", info.description},
+                       {"contextLength", info.contextLength},
+                       {"maxOutputTokens", info.maxOutputTokens},
+                       {"inputPrice", info.inputPrice},
+                       {"cachedInputPrice", info.cachedInputPrice},
+                       {"outputPrice", info.outputPrice}};
+}
+
+DeepSeekModelCatalog::ModelInfo DeepSeekModelCatalog::fromJson(const QJsonObject &object)
+{
+    ModelInfo info;
+    info.id = object.value("id").toString();
+    info.ownedBy = object.value("ownedBy").toString();
+    info.description = object.value("description").toString();
+    info.contextLength = object.value("contextLength").toInt();
+    info.maxOutputTokens = object.value("maxOutputTokens").toInt();
+    info.inputPrice = object.value("inputPrice").toDouble(-1);
+    info.cachedInputPrice = object.value("cachedInputPrice").toDouble(-1);
+    info.outputPrice = object.value("outputPrice").toDouble(-1);
+    return info;
+}
+
+QString DeepSeekModelCatalog::describe(const ModelInfo &info)
+{
+    QStringList lines;
+    lines << (info.description.isEmpty() ? tr("No description available.") : info.description);
+
+    QStringList limits;
+    if (info.contextLength > 0)
+        limits << tr("Contexto: %1K tokens").arg(info.contextLength / 1024);
+    if (info.maxOutputTokens > 0)
+        limits << tr("salida máxima: %1K tokens").arg(info.maxOutputTokens / 1024);
+    if (!limits.isEmpty())
+        lines << limits.join(", ");
+
+    if (info.inputPrice >= 0 && info.outputPrice >= 0) {
+        QString prices = tr("USD por millón de tokens: entrada %1").arg(info.inputPrice);
+        if (info.cachedInputPrice >= 0)
+            prices += tr(" (%1 en caché)").arg(info.cachedInputPrice);
+        prices += tr(", salida %1").arg(info.outputPrice);
+        lines << prices;
+    }
+    return lines.join('\n');
+}
+
+QString DeepSeekModelCatalog::cacheFilePath() const
+{
+    const QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    return dataDir + "/deepseek_models.json";
+}
+
+void DeepSeekModelCatalog::loadCache()
+{
+    QFile file(cacheFilePath());
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    if (root.value("version").toInt() != CacheFormatVersion)
+        return;
+
+    // Una entrada por servidor
+    const QJsonObject entry = root.value("endpoints").toObject().value(m_url.toString()).toObject();
+    if (entry.isEmpty())
+        return;
+
+    for (const QJsonValue &value : entry.value("models").toArray())
+        m_models.append(fromJson(value.toObject()));
+    m_fetchedAt = QDateTime::fromString(entry.value("fetchedAt").toString(), Qt::ISODate);
+    m_etag = entry.value("etag").toString().toUtf8();
+    m_lastModified = entry.value("lastModified").toString().toUtf8();
+}
+
+void DeepSeekModelCatalog::saveCache()
+{
+    const QString path = cacheFilePath();
+    QJsonObject root;
+    {
+        QFile file(path);
+        if (file.open(QIODevice::ReadOnly))
+            root = QJsonDocument::fromJson(file.readAll()).object();
+    }
+    if (root.value("version").toInt() != CacheFormatVersion)
+        root = QJsonObject{{"version", CacheFormatVersion}};
+
+    QJsonArray models;
+    for (const ModelInfo &model : std::as_const(m_models))
+        models.append(toJson(model));
+
+    QJsonObject endpoints = root.value("endpoints").toObject();
+    endpoints.insert(m_url.toString(),
+                     QJsonObject{{"fetchedAt", m_fetchedAt.toString(Qt::ISODate)},
+                                 {"etag", QString::fromUtf8(m_etag)},
+                                 {"lastModified", QString::fromUtf8(m_lastModified)},
+                                 {"models", models}});
+    root.insert("endpoints", endpoints);
+
+    QDir().mkpath(QFileInfo(path).path());
+    QSaveFile saver(path);
+    const QByteArray data = QJsonDocument(root).toJson(QJsonDocument::Compact);
+    if (!saver.open(QIODevice::WriteOnly) || saver.write(data) != data.size() || !saver.commit())
+        qWarning() << "Model catalog: cannot write" << path << saver.errorString();
+}
+
+void DeepSeekModelCatalog::scheduleRefresh()
+{
+    // Sin clave el servidor contestaría 401 una y otra vez
+    if (!m_autoRefresh || !m_url.isValid() || m_url.host().isEmpty() || m_apiKey.isEmpty()) {
+        m_refreshTimer.stop();
+        return;
+    }
+
+    const qint64 age = m_fetchedAt.isValid()
+                           ? m_fetchedAt.secsTo(QDateTime::currentDateTimeUtc())
+                           : DefaultTtlSecs;
+    m_refreshTimer.start(std::chrono::seconds(qBound<qint64>(0, DefaultTtlSecs - age, DefaultTtlSecs)));
+}
+
+void DeepSeekModelCatalog::abortRefresh()
+{
+    if (!m_reply)
+        return;
+    QNetworkReply *reply = m_reply;
+    m_reply = nullptr;
+    reply->disconnect(this);
+    reply->abort();
+    reply->deleteLater();
+}
+
+void DeepSeekModelCatalog::refresh()
+{
+    if (m_reply)
+        return;
+    m_refreshTimer.stop();
+    if (!m_url.isValid() || m_url.host().isEmpty()) {
+        emit refreshFinished(tr("Invalid API URL: %1").arg(m_url.toString()));
+        return;
+    }
+
+    QNetworkRequest request = DSN::inst()->createRequest(m_url);
+    if (!m_apiKey.isEmpty())
+        request.setRawHeader("Authorization", "Bearer " + m_apiKey.toUtf8());
+    // Petición condicional: solo tiene sentido si hay algo guardado que validar
+    if (!m_models.isEmpty()) {
+        if (!m_etag.isEmpty())
+            request.setRawHeader("If-None-Match", m_etag);
+        if (!m_lastModified.isEmpty())
+            request.setRawHeader("If-Modified-Since", m_lastModified);
+    }
+
+    m_reply = DSN::inst()->manager()->get(request);
+    connect(m_reply, &QNetworkReply::finished, this, &DeepSeekModelCatalog::onReplyFinished);
+}
+
+void DeepSeekModelCatalog::onReplyFinished()
+{
+    QNetworkReply *reply = m_reply;
+    m_reply = nullptr;
+    if (!reply)
+        return;
+    reply->deleteLater();
+
+    const auto fail = [this](const QString &errorString) {
+        qWarning() << "Model catalog: cannot refresh" << m_url.toString() << errorString;
+        if (m_autoRefresh)
+            m_refreshTimer.start(std::chrono::seconds(RetrySecs));
+        emit refreshFinished(errorString);
+    };
+
+    if (reply->error() != QNetworkReply::NoError) {
+        fail(reply->errorString());
+        return;
+    }
+
+    m_fetchedAt = QDateTime::currentDateTimeUtc();
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status == 304) {
+        // Sin cambios: solo se renueva la caducidad
+        saveCache();
+        scheduleRefresh();
+        emit refreshFinished({});
+        return;
+    }
+
+    const QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
+    const QJsonValue data = doc.object().value("data");
+    if (!data.isArray()) {
+        fail(tr("Unexpected response format"));
+        return;
+    }
+
+    QList<ModelInfo> models;
+    for (const QJsonValue &value : data.toArray()) {
+        const ModelInfo info = parseModel(value.toObject());
+        if (!info.id.isEmpty())
+            models.append(info);
+    }
+
+    m_models = models;
+    m_etag = reply->rawHeader("ETag");
+    m_lastModified = reply->rawHeader("Last-Modified");
+    saveCache();
+    scheduleRefresh();
+    emit modelsChanged();
+    emit refreshFinished({});
+}
+
+} // namespace DeepSeek
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <QDateTime>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QUrl>
+#include "singleton.h"
+
+QT_BEGIN_NAMESPACE
+class QNetworkReply;
+QT_END_NAMESPACE
+
+namespace DeepSeek {
+
+// Catálogo de modelos de /v1/models compartido por la página de opciones y
+// el chat. Se guarda en disco y se refresca en segundo plano cuando caduca
+// (TTL), con peticiones condicionales (If-None-Match / If-Modified-Since):
+// si nada ha cambiado el servidor responde 304 sin cuerpo.
+//
+// /v1/models solo da el id; los metadatos (contexto, salida máxima, precios)
+// se toman de la respuesta si el servidor los incluye y, si no, de una tabla
+// interna con los modelos conocidos.
+//
+// Se usa desde el hilo de la interfaz. Además del compartido (DSM) se pueden
+// crear catálogos propios, sin refresco en segundo plano, para consultar un
+// servidor sin cambiar el que usa el resto del plugin.
+class DeepSeekModelCatalog : public QObject
+{
+    Q_OBJECT
+    friend class Singleton<DeepSeekModelCatalog>;
+
+public:
+    struct ModelInfo
+    {
+        QString id;
+        QString ownedBy;
+        QString description;
+        int contextLength = 0;   // tokens; 0 = desconocido
+        int maxOutputTokens = 0; // 0 = desconocido
+        // USD por millón de tokens; negativo = desconocido
+        double inputPrice = -1;       // entrada sin acierto de caché
+        double cachedInputPrice = -1; // entrada servida desde la caché de prefijos
+        double outputPrice = -1;
+    };
+
+    static constexpr int DefaultTtlSecs = 24 * 3600;
+    static constexpr int RetrySecs = 10 * 60;
+
+    explicit DeepSeekModelCatalog(QObject *parent = nullptr);
+    ~DeepSeekModelCatalog() override;
+
+    // Desactivado solo se refresca al llamar a refresh()
+    void setAutoRefresh(bool enabled);
+
+    // Servidor del catálogo; si cambia, se carga lo guardado y se refresca si caducó
+    void setEndpoint(const QUrl &apiUrl, const QString &apiKey);
+    // Pide la lista aunque no haya caducado (sigue siendo condicional)
+    void refresh();
+
+    QList<ModelInfo> models() const { return m_models; }
+    // Entrada del catálogo o, si el servidor no lo lista, la de la tabla interna
+    ModelInfo info(const QString &id) const;
+    QDateTime fetchedAt() const { return m_fetchedAt; }
+    bool isRefreshing() const { return !m_reply.isNull(); }
+
+    // Ventana y salida máxima del modelo, del catálogo o de la tabla interna
+    int contextLength(const QString &id) const;
+    int maxOutputTokens(const QString &id) const;
+
+    static QUrl modelsUrl(const QUrl &apiUrl);
+    static QString describe(const ModelInfo &info);
+
+signals:
+    void modelsChanged();
+    // Al terminar cada refresco, también con 304; errorString vacío si fue bien
+    void refreshFinished(const QString &errorString);
+
+private:
+    static ModelInfo knownModel(const QString &id);
+    static ModelInfo parseModel(const QJsonObject &object);
+    static QJsonObject toJson(const ModelInfo &info);
+    static ModelInfo fromJson(const QJsonObject &object);
+    QString cacheFilePath() const;
+    void loadCache();
+    void saveCache();
+    void scheduleRefresh();
+    void abortRefresh();
+    void onReplyFinished();
+
+    QUrl m_url; // de /v1/models
+    QString m_apiKey;
+    QList<ModelInfo> m_models;
+    QDateTime m_fetchedAt;
+    QByteArray m_etag;
+    QByteArray m_lastModified;
+
+    QPointer<QNetworkReply> m_reply;
+    QTimer m_refreshTimer;
+    bool m_autoRefresh = true;
+};
+
+// Alias para el Singleton del catálogo de modelos
+typedef Singleton<DeepSeekModelCatalog> DSM;
+
+} // namespace DeepSeek
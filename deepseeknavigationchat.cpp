@@ -1,7 +1,31 @@
 #include "deepseeknavigationchat.h"
+#include "deepseekchatview.h"
+#include "deepseekmarkdownrenderer.h"
+#include "deepseektextdiff.h"
+#include "deepseekstartuptiming.h"
+
+#include <coreplugin/icore.h>
+#include <coreplugin/progressmanager/progressmanager.h>
+#include <projectexplorer/task.h>
+#include <projectexplorer/taskhub.h>
+#include <texteditor/highlighterhelper.h>
+#include <utils/theme/theme.h>
+
+#include <KSyntaxHighlighting/Repository>
+
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <QComboBox>
+#include <QFutureWatcher>
+#include <QLocale>
+#include <QLoggingCategory>
+#include <QSignalBlocker>
 
 using namespace DeepSeek;
 
+// Trazas por petición; apagadas salvo con QT_LOGGING_RULES="qtc.deepseek.chat.debug=true"
+Q_LOGGING_CATEGORY(deepseekChatLog, "qtc.deepseek.chat", QtWarningMsg)
+
 // =============================
 // FileUtils
 // =============================
@@ -47,82 +71,280 @@ bool FileUtils::ensureDirectoryExists(const QString &filePath, QString &errorMes
 }
 
 // =============================
-// DeepSeekPreviewDialog
+// DeepSeekNavigationChat
 // =============================
-DeepSeekPreviewDialog::DeepSeekPreviewDialog(const QString &filePath, const QString &newContent, QWidget *parent)
-    : QDialog(parent)
+DeepSeekNavigationChat::DeepSeekNavigationChat(): Core::INavigationWidgetFactory()
 {
-    setWindowTitle(tr("Preview Changes - %1").arg(QFileInfo(filePath).fileName()));
-    setModal(true);
-    resize(600, 400);
+    // El QNetworkAccessManager compartido se asigna en delayedInitialize()
+    m_scheduler = new DeepSeekRequestScheduler(nullptr, this);
+    m_chatModel = new DeepSeekChatModel(this);
+    m_batchAnalysis = new DeepSeekBatchAnalysis(m_scheduler, this);
+    m_serializePool.setMaxThreadCount(1);
+    connect(m_scheduler, &DeepSeekRequestScheduler::started,
+            this, &DeepSeekNavigationChat::onRequestStarted);
+    connect(m_scheduler, &DeepSeekRequestScheduler::finished,
+            this, &DeepSeekNavigationChat::onRequestFinished);
+    connect(m_batchAnalysis, &DeepSeekBatchAnalysis::issuesFound,
+            this, &DeepSeekNavigationChat::publishIssues);
+    connect(m_batchAnalysis, &DeepSeekBatchAnalysis::progressChanged,
+            this, &DeepSeekNavigationChat::onAnalysisProgress);
+    connect(m_batchAnalysis, &DeepSeekBatchAnalysis::finished,
+            this, &DeepSeekNavigationChat::onAnalysisFinished);
+    setDisplayName("DeepSeek Chat");
+    setPriority(100);
+    setId("DeepSeek.Chat");
+    // Nada de E/S aquí: se construye dentro de IPlugin::initialize()
+}
 
-    QVBoxLayout *layout = new QVBoxLayout(this);
-    m_previewEditor = new QTextEdit(this);
-    m_previewEditor->setPlainText(newContent);
-    layout->addWidget(m_previewEditor);
+DeepSeekNavigationChat::~DeepSeekNavigationChat()
+{
+    if (m_historyFuture.isValid())
+        m_historyFuture.waitForFinished();
+}
 
-    QHBoxLayout *buttonsLayout = new QHBoxLayout;
-    QPushButton *acceptButton = new QPushButton(tr("Apply"));
-    QPushButton *cancelButton = new QPushButton(tr("Cancel"));
-    connect(acceptButton, &QPushButton::clicked, this, [this]() { m_accepted = true; accept(); });
-    connect(cancelButton, &QPushButton::clicked, this, &QDialog::reject);
-    buttonsLayout->addWidget(acceptButton);
-    buttonsLayout->addWidget(cancelButton);
-    layout->addLayout(buttonsLayout);
+void DeepSeekNavigationChat::delayedInitialize()
+{
+    if (!m_settingsConnected) {
+        connect(DSS::inst(), &DeepSeekSettings::settingsChanged,
+                this, &DeepSeekNavigationChat::onSettingsChanged);
+        // Catálogo de modelos: ventana y salida máxima de cada uno, refrescado en segundo plano
+        connect(DSM::inst(), &DeepSeekModelCatalog::modelsChanged,
+                this, &DeepSeekNavigationChat::updateTokenLabel);
+        const auto settings = DSS::inst()->snapshot();
+        DSM::inst()->setEndpoint(settings->apiUrl, settings->apiKey);
+        m_settingsConnected = true;
+        m_scheduler->setNetworkManager(DSN::inst()->manager());
+        // Transacción de edición interrumpida por un cierre inesperado
+        QString recoverError;
+        if (!DeepSeekEditTransaction::recover(getEditJournalPath(), &recoverError))
+            qWarning() << "Failed to recover edit transaction:" << recoverError;
+        // El hilo de render usa las mismas definiciones de sintaxis que el editor
+        DeepSeekMarkdownRenderer::configureHighlighting(
+            TextEditor::HighlighterHelper::highlightRepository()->customSearchPaths(),
+            Utils::creatorTheme() && Utils::creatorTheme()->flag(Utils::Theme::DarkUserInterface));
+        // Índice de los proyectos abiertos para añadir código relevante
+        m_projectContext = new DeepSeekProjectContext(this);
+        m_projectContext->setEnabled(DSS::inst()->projectContextEnabled());
+        updateSemanticSearch();
+        loadTokenizer();
+        // Solo se carga la sesión activa del proyecto de arranque
+        loadSessions();
+        // Resultados del análisis del proyecto en el panel de Issues
+        ProjectExplorer::TaskHub::addCategory({AnalysisTaskCategory, tr("DeepSeek Analysis"),
+                                               tr("Issues reported by the DeepSeek project analysis."),
+                                               true, 0});
+        m_batchAnalysis->setJournalDirectory(
+            dataDirectory().pathAppended("deepseek_analysis").toFSPathString());
+    }
+    startHistoryLoad();
 }
 
-bool DeepSeekPreviewDialog::accepted() const { return m_accepted; }
+void DeepSeekNavigationChat::onSettingsChanged(DeepSeekSettings::Fields changed){
+    using Field = DeepSeekSettings::Field;
+    const auto settings = DSS::inst()->snapshot();
+    // La URL o la clave pueden haber cambiado: se abre ya la conexión nueva
+    if (changed & (Field::ApiUrl | Field::ApiKey)) {
+        DSN::inst()->prewarm(settings->apiUrl);
+        DSM::inst()->setEndpoint(settings->apiUrl, settings->apiKey);
+    }
+    const DeepSeekSettings::Fields projectFields
+        = Field::ProjectContextEnabled | Field::EmbeddingsEnabled | Field::EmbeddingsUrl
+          | Field::EmbeddingModel | Field::EmbeddingsQuantized | Field::ApiUrl | Field::ApiKey;
+    if (m_projectContext && (changed & projectFields)) {
+        m_projectContext->setEnabled(settings->projectContextEnabled);
+        updateSemanticSearch();
+    }
+    if (changed & Field::TokenizerPath)
+        loadTokenizer();
+    updateTokenLabel();
+}
 
-// =============================
-// DeepSeekNavigationChat
-// =============================
-DeepSeekNavigationChat::DeepSeekNavigationChat(): Core::INavigationWidgetFactory()
+int DeepSeekNavigationChat::contextLength(const DeepSeekSettings::Snapshot &settings)
 {
-    m_networkManager = new QNetworkAccessManager(this);
-    setDisplayName("DeepSeek Chat");
-    setPriority(100);
-    setId("DeepSeek.Chat");
+    return settings.contextTokens > 0 ? settings.contextTokens
+                                      : DSM::inst()->contextLength(settings.model);
+}
 
-    connect(DSS::inst(), &DeepSeekSettings::settingsChanged,
-            this, &DeepSeekNavigationChat::onSettingsChanged);
+int DeepSeekNavigationChat::replyTokens(const DeepSeekSettings::Snapshot &settings)
+{
+    // Pedir más de lo que el modelo puede generar solo quita sitio al historial
+    const int maxOutput = DSM::inst()->maxOutputTokens(settings.model);
+    return maxOutput > 0 ? qMin(settings.maxTokens, maxOutput) : settings.maxTokens;
+}
 
-    loadConversationHistory();
+void DeepSeekNavigationChat::loadTokenizer()
+{
+    const QString path = DSS::inst()->tokenizerPath();
+    if (path == m_tokenizerPath)
+        return;
+    m_tokenizerPath = path;
+
+    if (path.isEmpty()) {
+        DST::inst()->unload();
+        return;
+    }
+
+    // El vocabulario ocupa varios MB de JSON: se lee fuera del hilo de la UI
+    // y se instala aquí solo si sigue siendo el de los ajustes, así que dos
+    // cargas que terminan en otro orden no dejan el fichero anterior.
+    QtConcurrent::run([path]() {
+        QString errorString;
+        DeepSeekTokenizer::ModelPtr model = DeepSeekTokenizer::parse(path, &errorString);
+        return std::make_pair(model, errorString);
+    }).then(this, [this, path](const std::pair<DeepSeekTokenizer::ModelPtr, QString> &loaded) {
+        if (path != m_tokenizerPath)
+            return;
+        if (!loaded.first)
+            qWarning() << "Failed to load tokenizer" << path << ":" << loaded.second;
+        // Si falla se vuelve a la estimación: el anterior ya no es el configurado
+        DST::inst()->install(loaded.first);
+        updateTokenLabel();
+    });
 }
 
-DeepSeekNavigationChat::~DeepSeekNavigationChat() {}
+void DeepSeekNavigationChat::updateTokenLabel()
+{
+    if (!m_tokenLabel || !m_inputLine)
+        return;
+
+    // Se llama en cada pulsación: el mensaje se cuenta sin pasar por la caché
+    // y el historial y el prompt de sistema salen de ella.
+    const auto settings = DSS::inst()->snapshot();
+    const QString message = m_inputLine->text();
+    const bool exact = DST::inst()->isLoaded();
+    const int messageTokens = exact ? DST::inst()->count(message)
+                                    : DeepSeekContextWindow::estimateTokens(message);
+
+    const int length = contextLength(*settings);
+    const int budget = DeepSeekContextWindow::historyBudget(length, replyTokens(*settings),
+                                                            settings->systemPrompt, message);
+    const Core::IDocument *document = Core::EditorManager::currentDocument();
+    const DeepSeekContextWindow::Result window
+        = settings->prefixCacheLayout
+              ? DeepSeekContextWindow::buildStablePrefix(m_conversationHistory, budget)
+              : DeepSeekContextWindow::build(m_conversationHistory, budget,
+                                             document ? document->filePath().toFSPathString()
+                                                      : QString());
+    const int promptTokens = DeepSeekContextWindow::estimateTokens(settings->systemPrompt)
+                             + messageTokens + window.keptTokens;
+
+    const QString prefix = exact ? QString() : QString("~");
+    QString text = tr("Message: %1%2 tokens | Prompt: %1%3 / %4")
+                       .arg(prefix)
+                       .arg(messageTokens)
+                       .arg(promptTokens)
+                       .arg(length);
+    if (m_promptCacheStats.requests > 0)
+        text += tr(" | Cache hits: %1%").arg(qRound(m_promptCacheStats.hitRatio() * 100));
+    m_tokenLabel->setText(text);
+
+    const bool overflow = length - promptTokens - DeepSeekContextWindow::SafetyMargin < MinReplyTokens;
+    m_tokenLabel->setStyleSheet(overflow ? QString("color: red;") : QString());
+    m_tokenLabel->setToolTip(overflow ? tr("The message does not fit in the context window.")
+                                      : exact ? tr("Exact count from %1").arg(DST::inst()->filePath())
+                                              : tr("Approximate count: no tokenizer configured."));
+}
 
-void DeepSeekNavigationChat::onSettingsChanged(){
-    qDebug() << "DeepSeek settings changed";
+void DeepSeekNavigationChat::updateSemanticSearch()
+{
+    // Los vectores se guardan junto al historial
+    const auto settings = DSS::inst()->snapshot();
+    m_projectContext->setSemanticSearch(
+        settings->projectContextEnabled && settings->embeddingsEnabled,
+        dataDirectory().pathAppended("deepseek_vectors.bin").toFSPathString());
 }
 
 
 Core::NavigationView DeepSeekNavigationChat::createWidget()
 {
+    // El panel puede abrirse antes de delayedInitialize()
+    delayedInitialize();
+    DSN::inst()->prewarm(DSS::inst()->apiUrl());
+    ensureHistoryLoaded();
+
     m_widget = new QWidget;
     QVBoxLayout *layout = new QVBoxLayout(m_widget);
 
-    m_outputBox = new QTextEdit(m_widget);
-    m_outputBox->setReadOnly(true);
-    m_outputBox->setAcceptRichText(true);
+    // Ambas vistas muestran el mismo modelo: la conversación completa y un
+    // resumen de una línea por mensaje para saltar a él.
+    auto chatView = new DeepSeekChatView(m_widget);
+    chatView->setChatModel(m_chatModel);
 
     m_inputLine = new QLineEdit(m_widget);
     m_sendButton = new QPushButton(tr("Send"), m_widget);
-    m_historyList = new QListWidget(m_widget);
-    m_historyList->setMaximumHeight(150);
+    m_stopButton = new QPushButton(tr("Stop"), m_widget);
+    m_stopButton->setEnabled(!m_pendingChats.isEmpty());
+    auto historyList = new QListView(m_widget);
+    historyList->setModel(m_chatModel);
+    historyList->setUniformItemSizes(true);
+    historyList->setMaximumHeight(150);
+    historyList->scrollToBottom();
+    connect(historyList, &QListView::clicked, chatView, [chatView](const QModelIndex &index) {
+        chatView->scrollTo(index, QAbstractItemView::PositionAtTop);
+    });
+    connect(m_chatModel, &QAbstractItemModel::rowsInserted, historyList,
+            [historyList](const QModelIndex &, int, int last) {
+                if (last == historyList->model()->rowCount() - 1)
+                    historyList->scrollToBottom();
+            });
+
+    m_tokenLabel = new QLabel(m_widget);
+    auto metricsButton = new QPushButton(tr("Stats"), m_widget);
+    metricsButton->setToolTip(tr("Latency and token usage of recent requests"));
+    connect(metricsButton, &QPushButton::clicked, this, &DeepSeekNavigationChat::showMetricsDialog);
+    connect(m_inputLine, &QLineEdit::textChanged, this, &DeepSeekNavigationChat::updateTokenLabel);
+    // El panel puede cerrarse con peticiones en vuelo: sus respuestas no deben tocar los widgets
+    connect(m_widget, &QObject::destroyed, this, [this]() {
+        m_inputLine = nullptr;
+        m_sendButton = nullptr;
+        m_stopButton = nullptr;
+        m_tokenLabel = nullptr;
+        m_sessionCombo = nullptr;
+    });
+
+    // Sesiones del proyecto de arranque; cambiar solo abre el registro de la elegida
+    m_sessionCombo = new QComboBox(m_widget);
+    m_sessionCombo->setSizeAdjustPolicy(QComboBox::AdjustToMinimumContentsLengthWithIcon);
+    m_sessionCombo->setMinimumContentsLength(12);
+    auto newSessionButton = new QPushButton(tr("New"), m_widget);
+    newSessionButton->setToolTip(tr("Start a new session for this project"));
+    auto deleteSessionButton = new QPushButton(tr("Delete"), m_widget);
+    deleteSessionButton->setToolTip(tr("Delete this session and its history"));
+    connect(m_sessionCombo, &QComboBox::activated, this, [this](int index) {
+        if (m_sessionCombo)
+            switchSession(m_sessionCombo->itemData(index).toString());
+    });
+    connect(newSessionButton, &QPushButton::clicked, this, &DeepSeekNavigationChat::newSession);
+    connect(deleteSessionButton, &QPushButton::clicked, this, &DeepSeekNavigationChat::deleteSession);
+    updateSessionCombo();
+
+    QHBoxLayout *sessionLayout = new QHBoxLayout;
+    sessionLayout->addWidget(new QLabel(tr("Session:")));
+    sessionLayout->addWidget(m_sessionCombo, 1);
+    sessionLayout->addWidget(newSessionButton);
+    sessionLayout->addWidget(deleteSessionButton);
 
     QHBoxLayout *inputLayout = new QHBoxLayout;
     inputLayout->addWidget(m_inputLine);
     inputLayout->addWidget(m_sendButton);
+    inputLayout->addWidget(m_stopButton);
 
+    layout->addLayout(sessionLayout);
     layout->addWidget(new QLabel(tr("Chat History:")));
-    layout->addWidget(m_historyList);
+    layout->addWidget(historyList);
     layout->addWidget(new QLabel(tr("Assistant Output:")));
-    layout->addWidget(m_outputBox);
+    layout->addWidget(chatView);
     layout->addLayout(inputLayout);
+    QHBoxLayout *statusLayout = new QHBoxLayout;
+    statusLayout->addWidget(m_tokenLabel, 1);
+    statusLayout->addWidget(metricsButton);
+    layout->addLayout(statusLayout);
 
     connect(m_sendButton, &QPushButton::clicked, this, &DeepSeekNavigationChat::onSendClicked);
+    connect(m_stopButton, &QPushButton::clicked, this, &DeepSeekNavigationChat::onStopClicked);
     connect(m_inputLine, &QLineEdit::returnPressed, m_sendButton, &QPushButton::click);
 
+    updateTokenLabel();
     return {m_widget, {}};
 }
 
@@ -130,30 +352,46 @@ void DeepSeekNavigationChat::onSendClicked(){
     const QString message = m_inputLine->text().trimmed();
     if (message.isEmpty()) return;
 
-    auto settings = DSS::inst();
-    if (!settings->isValid()) {
-        appendToChatHistory("Error", settings->validationError());
+    ensureHistoryLoaded();
+
+    const auto settings = DSS::inst()->snapshot();
+    if (!settings->isValid) {
+        appendToChatHistory("Error", settings->validationError);
         return;
     }
     appendToChatHistory("You", message);
 
     QJsonObject payload;
     payload["message"] = message;
-    payload["model"] = settings->model();
-    payload["system_prompt"] = settings->systemPrompt();
-    payload["temperature"] = settings->temperature();
-    payload["max_tokens"] = settings->maxTokens();
+    payload["model"] = settings->model;
+    payload["system_prompt"] = settings->systemPrompt;
+    payload["temperature"] = settings->temperature;
+    payload["max_tokens"] = settings->maxTokens;
 
     updateContextMetadata(payload);
+    m_inputLine->clear();
+
+    // Con búsqueda semántica la pregunta se vectoriza antes de enviarla; si
+    // el servidor de embeddings no responde a tiempo se envía sin ella.
+    if (m_projectContext && m_projectContext->hasSemanticIndex()) {
+        m_projectContext->embedQuery(message, [this, payload](const std::vector<float> &embedding) {
+            QJsonObject request = payload;
+            QJsonArray values;
+            for (const float value : embedding)
+                values.append(value);
+            request["query_embedding"] = values;
+            sendApiRequest("/chat", request);
+        });
+        return;
+    }
 
     sendApiRequest("/chat", payload);
-    m_inputLine->clear();
 }
 
-void DeepSeekNavigationChat::sendApiRequest(const QString &endpoint, const QJsonObject &payload){
-    auto settings = DSS::inst();
-
-    QUrl apiUrl(settings->apiUrl());
+QNetworkRequest DeepSeekNavigationChat::chatCompletionsRequest(
+    const DeepSeekSettings::Snapshot &settings, QString *errorString)
+{
+    QUrl apiUrl(settings.apiUrl);
 
     if (!apiUrl.path().endsWith("/v1")){ apiUrl.setPath("/v1"); }
 
@@ -161,124 +399,526 @@ void DeepSeekNavigationChat::sendApiRequest(const QString &endpoint, const QJson
     apiUrl.setPath(fullPath);
 
     if (!apiUrl.isValid()) {
-        appendToChatHistory("Error", tr("Invalid API URL: %1").arg(apiUrl.toString()));
-        return;
+        *errorString = tr("Invalid API URL: %1").arg(apiUrl.toString());
+        return {};
     }
 
-    QNetworkRequest request(apiUrl);
+    QNetworkRequest request = DSN::inst()->createRequest(apiUrl);
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
 
-    if (!settings->apiKey().isEmpty()) {
+    if (!settings.apiKey.isEmpty()) {
         request.setRawHeader("Authorization",
-                             QString("Bearer %1").arg(settings->apiKey()).toUtf8());
+                             QString("Bearer %1").arg(settings.apiKey).toUtf8());
     }
+    return request;
+}
+
+void DeepSeekNavigationChat::sendApiRequest(const QString &endpoint, const QJsonObject &payload){
+    // Una sola instantánea para toda la petición
+    const auto settings = DSS::inst()->snapshot();
 
-    QJsonObject fullPayload;
-    fullPayload["model"] = settings->model();
+    QString errorString;
+    QNetworkRequest request = chatCompletionsRequest(*settings, &errorString);
+    if (!errorString.isEmpty()) {
+        appendToChatHistory("Error", errorString);
+        return;
+    }
 
-    QJsonArray messagesArray;
-    if (!settings->systemPrompt().isEmpty()) {
+    // Los mensajes se reúnen por partes: lo anterior al historial, los turnos
+    // del historial (que se serializan en el hilo reutilizando los bytes de
+    // la petición anterior) y lo posterior.
+    DeepSeekRequestSerializer::Parts parts;
+    QJsonArray &messagesArray = parts.head;
+    if (!settings->systemPrompt.isEmpty()) {
         messagesArray.append(QJsonObject{
             {"role", "system"},
-            {"content", settings->systemPrompt()}
+            {"content", settings->systemPrompt}
         });
     }
 
-    for (const auto &item : qAsConst(m_conversationHistory) ) {
-        if (item.isObject()) {
-            QJsonObject obj = item.toObject();
-            messagesArray.append(QJsonObject{
-                {"role", obj.contains("response") ? "assistant" : "user"},
-                {"content", obj.contains("response") ? obj["response"].toString() : obj["message"].toString()}
-            });
+    // Solo los turnos que caben en la ventana de contexto del modelo, dejando
+    // sitio para el prompt de sistema, el mensaje actual y la respuesta.
+    const QString message = payload["message"].toString();
+    const int contextLength = DeepSeekNavigationChat::contextLength(*settings);
+    int budget = DeepSeekContextWindow::historyBudget(contextLength,
+                                                      replyTokens(*settings),
+                                                      settings->systemPrompt,
+                                                      message);
+
+    // Con la disposición para la caché de prefijos, todo lo estable (prompt
+    // de sistema, proyecto e historial) va primero y byte a byte igual entre
+    // peticiones; lo que cambia en cada pregunta va al final, justo antes del
+    // mensaje del usuario.
+    const bool prefixLayout = settings->prefixCacheLayout;
+    if (prefixLayout && !payload["project"].toString().isEmpty()) {
+        const QString projectInfo = tr("Project: %1").arg(payload["project"].toString());
+        messagesArray.append(QJsonObject{
+            {"role", "system"},
+            {"content", projectInfo}
+        });
+        budget -= DeepSeekContextWindow::estimateTokens(projectInfo);
+    }
+
+    // Fragmentos del proyecto relevantes para el mensaje. Se les reserva como
+    // mucho la mitad del presupuesto; lo que ocupan se descuenta del historial.
+    QString projectContext;
+    if (m_projectContext && settings->projectContextEnabled) {
+        const int projectBudget = qMin(settings->projectContextTokens, budget / 2);
+        std::vector<float> queryEmbedding;
+        for (const QJsonValue &value : payload["query_embedding"].toArray())
+            queryEmbedding.push_back(float(value.toDouble()));
+        projectContext = m_projectContext->buildContext(
+            message + '\n' + payload["selection"].toString(), projectBudget, queryEmbedding);
+    }
+
+    QString volatileContext = projectContext;
+    if (prefixLayout) {
+        QStringList editorContext;
+        if (!payload["filename"].toString().isEmpty())
+            editorContext << tr("Current file: %1").arg(payload["filename"].toString());
+        if (!payload["selection"].toString().isEmpty())
+            editorContext << tr("Selected text:") + "\n```\n" + payload["selection"].toString()
+                                 + "\n```";
+        if (!editorContext.isEmpty()) {
+            if (!volatileContext.isEmpty())
+                editorContext << volatileContext;
+            volatileContext = editorContext.join("\n\n");
         }
     }
+    budget -= DeepSeekContextWindow::estimateTokens(volatileContext);
+
+    // El recorte estable descarta por bloques desde el principio; el normal
+    // prefiere los turnos que hablan del fichero actual.
+    const DeepSeekContextWindow::Result window
+        = prefixLayout ? DeepSeekContextWindow::buildStablePrefix(m_conversationHistory, budget)
+                       : DeepSeekContextWindow::build(m_conversationHistory, budget,
+                                                      payload["filename"].toString());
+
+    parts.history.reserve(window.turns.size());
+    for (int index : window.turns) {
+        const QJsonObject entry = m_conversationHistory.at(index).toObject();
+        parts.history.append({m_historyBase + index, entry.value("message").toString(),
+                              entry.value("response").toString()});
+    }
+
+    // El aviso sale solo cuando cambia lo que se deja fuera, no en cada envío
+    if (window.droppedTurns != m_droppedTurns && window.droppedTurns > 0) {
+        appendToChatHistory("Context",
+                            tr("%1 of %2 earlier turns (~%3 tokens) were left out to fit the "
+                               "%4-token history budget.")
+                                .arg(window.droppedTurns)
+                                .arg(window.droppedTurns + window.keptTurns)
+                                .arg(window.droppedTokens)
+                                .arg(window.budget));
+    }
+    m_droppedTurns = window.droppedTurns;
+
+    if (!volatileContext.isEmpty()) {
+        parts.tail.append(QJsonObject{
+            {"role", "system"},
+            {"content", volatileContext}
+        });
+    }
 
-    messagesArray.append(QJsonObject{
+    parts.tail.append(QJsonObject{
         {"role", "user"},
-        {"content", payload["message"].toString()}
+        {"content", message}
     });
 
-    fullPayload["messages"] = messagesArray;
-    fullPayload["temperature"] = settings->temperature();
-    fullPayload["max_tokens"] = settings->maxTokens();
+    // Lo que no quepa se rechaza aquí en lugar de esperar al error HTTP, y la
+    // respuesta se limita a lo que queda libre en la ventana.
+    int promptTokens = window.keptTokens;
+    for (const QJsonArray *messages : {&parts.head, &parts.tail}) {
+        for (const QJsonValue &item : *messages)
+            promptTokens += DeepSeekContextWindow::estimateTokens(item["content"].toString());
+    }
+    const int available = contextLength - promptTokens - DeepSeekContextWindow::SafetyMargin;
+    if (available < MinReplyTokens) {
+        appendToChatHistory("Error",
+                            tr("The request needs about %1 tokens and does not fit in the "
+                               "%2-token context window of %3.")
+                                .arg(promptTokens)
+                                .arg(contextLength)
+                                .arg(settings->model));
+        return;
+    }
+
+    QJsonObject fields;
+    fields["model"] = settings->model;
+    fields["temperature"] = settings->temperature;
+    fields["max_tokens"] = qMin(replyTokens(*settings), available);
+
+    // La clave se calcula sin los campos de streaming, para que la misma
+    // petición acierte con y sin streaming.
+    bool cacheable = false;
+    if (settings->responseCacheEnabled) {
+        cacheable = DeepSeekResponseCache::isCacheable(settings->temperature);
+        if (cacheable)
+            configureResponseCache();
+        else
+            m_responseCache->recordBypass();
+    }
 
-    QNetworkReply *reply = m_networkManager->post(
-        request,
-        QJsonDocument(fullPayload).toJson()
-        );
+    const bool stream = settings->streamResponses;
+    if (stream)
+        request.setRawHeader("Accept", "text/event-stream");
+
+    // La serialización, el hash y la consulta a la caché (lectura del fichero
+    // de la entrada) van a un hilo aparte. Es un único hilo, así que las
+    // peticiones se envían en el mismo orden en que se pidieron.
+    auto serializer = m_requestSerializer;
+    auto cache = m_responseCache;
+    QtConcurrent::run(&m_serializePool, [serializer, cache, parts, fields, cacheable, stream,
+                                         endpoint = request.url()]() {
+        SerializedRequest serialized;
+        const QByteArray messages = serializer->messagesJson(parts);
+        if (cacheable) {
+            serialized.cacheKey = DeepSeekResponseCache::keyFor(
+                endpoint, DeepSeekRequestSerializer::assemble(fields, messages));
+            serialized.cached = cache->lookup(serialized.cacheKey);
+            if (serialized.cached)
+                return serialized;
+        }
+
+        QJsonObject sendFields = fields;
+        sendFields["stream"] = stream;
+        if (stream)
+            sendFields["stream_options"] = QJsonObject{{"include_usage", true}};
+        serialized.body = DeepSeekRequestSerializer::assemble(sendFields, messages);
+        return serialized;
+    }).then(this, [this, request, message, sessionId = m_sessionId,
+                   stream](const SerializedRequest &serialized) {
+        const DeepSeekRequestSerializer::Stats stats = m_requestSerializer->stats();
+        qCDebug(deepseekChatLog) << "DeepSeek request body:" << serialized.body.size() << "bytes,"
+                                 << stats.reusedTurns << "turns reused,"
+                                 << stats.serializedTurns << "serialized";
+        enqueueChatRequest(request, serialized, message, sessionId, stream);
+    });
+}
+
+void DeepSeekNavigationChat::enqueueChatRequest(const QNetworkRequest &request,
+                                                const SerializedRequest &serialized,
+                                                const QString &message,
+                                                const QString &sessionId, bool stream)
+{
+    if (const auto &cached = serialized.cached) {
+        if (sessionId == m_sessionId)
+            appendToChatHistory("DeepSeek (cache)", cached->content, DeepSeekChatModel::Markdown);
+        saveConversationHistory(sessionId, message, cached->content);
+        return;
+    }
+
+    DeepSeekRequestScheduler::Request scheduled;
+    scheduled.request = request;
+    scheduled.body = serialized.body;
+    scheduled.priority = DeepSeekRequestScheduler::Priority::Interactive;
+    scheduled.userMessage = message;
+
+    PendingChat pending;
+    pending.message = message;
+    pending.sessionId = sessionId;
+    pending.cacheKey = serialized.cacheKey;
+    if (stream)
+        pending.parser = std::make_shared<DeepSeekStreamParser>();
+    else
+        pending.reader = std::make_shared<DeepSeekReplyReader>();
+    pending.timer.start();
+    pending.metrics.timestamp = QDateTime::currentDateTime();
+    pending.metrics.model = DSS::inst()->snapshot()->model;
+    pending.metrics.streamed = stream;
+    pending.metrics.requestBytes = scheduled.body.size();
+
+    m_pendingChats.insert(m_scheduler->enqueue(scheduled), pending);
+    updateStopButton();
+}
+
+void DeepSeekNavigationChat::onStopClicked()
+{
+    const QList<DeepSeekRequestScheduler::RequestId> ids = m_pendingChats.keys();
+    for (const DeepSeekRequestScheduler::RequestId id : ids)
+        m_scheduler->cancel(id);
+}
+
+void DeepSeekNavigationChat::updateStopButton()
+{
+    if (m_stopButton)
+        m_stopButton->setEnabled(!m_pendingChats.isEmpty());
+}
+
+void DeepSeekNavigationChat::onRequestStarted(DeepSeekRequestScheduler::RequestId id,
+                                              QNetworkReply *reply)
+{
+    const auto it = m_pendingChats.find(id);
+    if (it == m_pendingChats.end())
+        return;
+
+    // Un reenvío tras una interrupción no vuelve a medir la espera en cola
+    if (m_scheduler->restarts(id) == 0) {
+        it->startedMs = it->timer.elapsed();
+        it->metrics.queueMs = it->startedMs;
+    }
+    connect(reply, &QNetworkReply::requestSent, this, [this, id]() {
+        const auto it = m_pendingChats.find(id);
+        if (it != m_pendingChats.end() && it->metrics.connectMs < 0)
+            it->metrics.connectMs = it->timer.elapsed() - it->startedMs;
+    });
+    connect(reply, &QNetworkReply::metaDataChanged, this, [this, id]() {
+        const auto it = m_pendingChats.find(id);
+        if (it != m_pendingChats.end() && it->metrics.firstByteMs < 0)
+            it->metrics.firstByteMs = it->timer.elapsed() - it->startedMs;
+    });
+    connect(reply, &QNetworkReply::downloadProgress, this, [this, id](qint64 received, qint64) {
+        const auto it = m_pendingChats.find(id);
+        if (it != m_pendingChats.end())
+            it->metrics.responseBytes = received;
+    });
+
+    if (it->reader) {
+        // Reintentos del planificador: cada reply empieza un documento nuevo
+        it->reader->reset();
+        connect(reply, &QNetworkReply::readyRead, this, [this, id, reply]() {
+            const auto it = m_pendingChats.find(id);
+            if (it == m_pendingChats.end())
+                return;
+            if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() >= 400)
+                return;
+            // Respuesta demasiado grande o mal formada: no tiene sentido seguir descargando
+            if (!it->reader->feed(reply->readAll()))
+                reply->abort();
+        });
+        return;
+    }
 
-    connect(reply, &QNetworkReply::finished,
-            this, [this, reply]() { handleApiReply(reply); });
+    if (!it->parser)
+        return;
 
-    QTimer::singleShot(30000, reply, [reply]() {
-        if (reply->isRunning()) {
-            reply->abort();
+    it->parser->reset();
+    // Sin mensaje en la vista si se cambió de sesión: solo se guarda al terminar
+    if (!it->replyMessageId && it->sessionId == m_sessionId)
+        it->replyMessageId = beginStreamedReply();
+
+    connect(reply, &QNetworkReply::readyRead, this, [this, id, reply]() {
+        const auto it = m_pendingChats.find(id);
+        if (it == m_pendingChats.end())
+            return;
+        // Los cuerpos de error no son SSE; se leen completos en finished
+        if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() >= 400)
+            return;
+        for (const DeepSeekStreamParser::Event &event : it->parser->feed(reply->readAll())) {
+            if (!event.delta.isEmpty())
+                appendStreamDelta(it->replyMessageId, event.delta);
         }
     });
 }
 
-void DeepSeekNavigationChat::handleApiReply(QNetworkReply *reply){
-    reply->deleteLater();
+void DeepSeekNavigationChat::onRequestFinished(DeepSeekRequestScheduler::RequestId id,
+                                               QNetworkReply *reply,
+                                               DeepSeekRequestScheduler::FinishReason reason)
+{
+    const auto it = m_pendingChats.find(id);
+    if (it == m_pendingChats.end())
+        return;
 
-    if (reply->error() != QNetworkReply::NoError) {
-        QString errorMsg;
+    PendingChat pending = *it;
+    m_pendingChats.erase(it);
+    updateStopButton();
+
+    if (!reply) {
+        recordMetrics(pending, nullptr, reason);
+        appendToChatHistory("Error", tr("Request stopped"));
+        return;
+    }
+
+    if (pending.parser)
+        handleStreamReply(reply, pending, reason);
+    else
+        handleApiReply(reply, pending, reason);
+    recordMetrics(pending, reply, reason);
+}
+
+void DeepSeekNavigationChat::recordMetrics(PendingChat &pending, QNetworkReply *reply,
+                                           DeepSeekRequestScheduler::FinishReason reason)
+{
+    DeepSeekRequestMetrics::Sample &sample = pending.metrics;
+    sample.totalMs = pending.timer.elapsed();
+
+    // Los errores de protocolo ya los marcan handleApiReply/handleStreamReply
+    DeepSeekRequestMetrics::classifyFinish(sample, reply, reason);
+
+    m_requestMetrics.add(sample);
+    if (m_metricsDialog)
+        m_metricsDialog->refresh();
+}
+
+void DeepSeekNavigationChat::showMetricsDialog()
+{
+    if (!m_metricsDialog) {
+        m_metricsDialog = new DeepSeekMetricsDialog(&m_requestMetrics, m_widget);
+        m_metricsDialog->setAttribute(Qt::WA_DeleteOnClose);
+    }
+    m_metricsDialog->show();
+    m_metricsDialog->raise();
+    m_metricsDialog->activateWindow();
+}
+
+QString DeepSeekNavigationChat::replyErrorMessage(QNetworkReply *reply,
+                                                  DeepSeekRequestScheduler::FinishReason reason) const
+{
+    if (reason == DeepSeekRequestScheduler::FinishReason::Canceled)
+        return tr("Request stopped");
+    if (reason == DeepSeekRequestScheduler::FinishReason::TimedOut)
+        return tr("Request timed out");
 
-        if (reply->error() == QNetworkReply::OperationCanceledError) {
-            errorMsg = tr("Request timed out");
-        } else {
-            errorMsg = tr("HTTP %1: %2").arg(
-                                            reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt())
+    QString errorMsg = tr("HTTP %1: %2")
+                           .arg(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt())
                            .arg(reply->errorString());
 
-            // Leer respuesta del servidor para más detalles
-            QByteArray response = reply->readAll();
-            if (!response.isEmpty()) {
-                errorMsg += "\n" + tr("Server response: %1").arg(QString::fromUtf8(response));
-            }
+    // Leer respuesta del servidor para más detalles
+    QByteArray response = reply->readAll();
+    if (!response.isEmpty()) {
+        errorMsg += "\n" + tr("Server response: %1").arg(QString::fromUtf8(response));
+    }
+    return errorMsg;
+}
+
+void DeepSeekNavigationChat::handleStreamReply(QNetworkReply *reply,
+                                               PendingChat &pending,
+                                               DeepSeekRequestScheduler::FinishReason reason)
+{
+    DeepSeekStreamParser *parser = pending.parser.get();
+
+    if (reply->error() == QNetworkReply::NoError) {
+        for (const DeepSeekStreamParser::Event &event : parser->feed(reply->readAll())) {
+            if (!event.delta.isEmpty())
+                appendStreamDelta(pending.replyMessageId, event.delta);
+        }
+        for (const DeepSeekStreamParser::Event &event : parser->finish()) {
+            if (!event.delta.isEmpty())
+                appendStreamDelta(pending.replyMessageId, event.delta);
         }
+    }
 
-        appendToChatHistory("Error", errorMsg);
+    m_chatModel->finishMessage(pending.replyMessageId);
+    const QString content = parser->content();
+
+    if (reply->error() != QNetworkReply::NoError) {
+        appendToChatHistory("Error", replyErrorMessage(reply, reason));
         return;
     }
 
-    // Procesar respuesta exitosa
-    QByteArray responseData = reply->readAll();
-    QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(responseData, &parseError);
+    if (parser->hasError()) {
+        pending.metrics.error = DeepSeekRequestMetrics::ErrorClass::Protocol;
+        appendToChatHistory("Error", parser->error());
+        return;
+    }
 
-    if (parseError.error != QJsonParseError::NoError) {
-        appendToChatHistory("Error",
-                            tr("Invalid JSON response: %1").arg(parseError.errorString()));
+    if (content.isEmpty())
         return;
+
+    saveConversationHistory(pending.sessionId, pending.message, content);
+    recordUsage(pending, parser->usage());
+    storeInResponseCache(pending.cacheKey, content, parser->usage());
+}
+
+void DeepSeekNavigationChat::handleApiReply(QNetworkReply *reply,
+                                            PendingChat &pending,
+                                            DeepSeekRequestScheduler::FinishReason reason)
+{
+    DeepSeekReplyReader *reader = pending.reader.get();
+
+    // El lector aborta la descarga al fallar; eso no es un error HTTP
+    if (reader->hasError() || reply->error() == QNetworkReply::NoError) {
+        reader->feed(reply->readAll());
+        reader->finish();
     }
 
-    if (!doc.isObject()) {
-        appendToChatHistory("Error", tr("Unexpected response format"));
+    if (reader->hasError()) {
+        pending.metrics.error = DeepSeekRequestMetrics::ErrorClass::Protocol;
+        appendToChatHistory("Error", tr("Invalid response: %1").arg(reader->error()));
         return;
     }
 
-    QJsonObject responseObj = doc.object();
+    if (reply->error() != QNetworkReply::NoError) {
+        appendToChatHistory("Error", replyErrorMessage(reply, reason));
+        return;
+    }
+
+    if (reader->hasApiError()) {
+        pending.metrics.error = DeepSeekRequestMetrics::ErrorClass::Protocol;
+        appendToChatHistory("Error", tr("API error: %1").arg(reader->apiErrorMessage()));
+        return;
+    }
 
     // Procesar respuesta según formato esperado de DeepSeek API
-    if (responseObj.contains("choices") && responseObj["choices"].isArray()) {
-        QJsonArray choices = responseObj["choices"].toArray();
-        if (!choices.isEmpty()) {
-            QJsonObject firstChoice = choices.first().toObject();
-            if (firstChoice.contains("message") &&
-                firstChoice["message"].isObject()) {
-                QJsonObject message = firstChoice["message"].toObject();
-                QString content = message["content"].toString();
-                appendToChatHistory("DeepSeek", content);
-                saveConversationHistory(m_inputLine->text(), content);
-                return;
-            }
-        }
+    if (reader->hasMessage()) {
+        const QString content = reader->content();
+        if (reader->finishReason() == "length")
+            qWarning() << "DeepSeek: reply truncated by max_tokens";
+        // Si se cambió de sesión mientras tanto, la respuesta solo va a su registro
+        if (pending.sessionId == m_sessionId)
+            appendToChatHistory("DeepSeek", content, DeepSeekChatModel::Markdown);
+        saveConversationHistory(pending.sessionId, pending.message, content);
+        recordUsage(pending, reader->usage());
+        storeInResponseCache(pending.cacheKey, content, reader->usage());
+        return;
     }
 
-    // Si no coincide con el formato esperado, mostrar la respuesta completa
-    appendToChatHistory("Debug", tr("Full API response: %1")
-                                     .arg(QString::fromUtf8(responseData)));
+    // Si no coincide con el formato esperado, mostrar el principio de la respuesta
+    pending.metrics.error = DeepSeekRequestMetrics::ErrorClass::Protocol;
+    QString preview = QString::fromUtf8(reader->preview());
+    if (reader->bytesRead() > reader->preview().size())
+        preview += tr("\n... (%1 bytes)").arg(reader->bytesRead());
+    appendToChatHistory("Debug", tr("Unexpected API response: %1").arg(preview));
+}
+
+void DeepSeekNavigationChat::recordUsage(PendingChat &pending, const QJsonObject &usage)
+{
+    pending.metrics.promptTokens = usage["prompt_tokens"].toInt(-1);
+    pending.metrics.completionTokens = usage["completion_tokens"].toInt(-1);
+
+    // Solo la API de DeepSeek informa de la caché de contexto del servidor
+    if (!usage.contains("prompt_cache_hit_tokens") && !usage.contains("prompt_cache_miss_tokens"))
+        return;
+
+    const qint64 hit = usage["prompt_cache_hit_tokens"].toInteger();
+    const qint64 miss = usage["prompt_cache_miss_tokens"].toInteger();
+    m_promptCacheStats.hitTokens += hit;
+    m_promptCacheStats.missTokens += miss;
+    ++m_promptCacheStats.requests;
+
+    qCDebug(deepseekChatLog) << "DeepSeek prompt cache:" << hit << "hit," << miss
+                             << "miss tokens; session ratio" << m_promptCacheStats.hitRatio()
+                             << "over" << m_promptCacheStats.requests << "requests";
+    updateTokenLabel();
+}
+
+void DeepSeekNavigationChat::configureResponseCache()
+{
+    const auto settings = DSS::inst()->snapshot();
+    if (settings->version == m_responseCacheSettings)
+        return;
+    m_responseCacheSettings = settings->version;
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    m_responseCache->setDirectory(cacheDir + "/deepseek_response_cache");
+    m_responseCache->setMaxBytes(qint64(settings->responseCacheMaxMb) * 1024 * 1024);
+    m_responseCache->setTimeToLive(qint64(settings->responseCacheTtlHours) * 3600);
+}
+
+void DeepSeekNavigationChat::storeInResponseCache(const QByteArray &cacheKey,
+                                                  const QString &content,
+                                                  const QJsonObject &usage)
+{
+    if (cacheKey.isEmpty())
+        return;
+
+    QString errorString;
+    if (!m_responseCache->store(cacheKey, {content, usage}, &errorString))
+        qWarning() << "Failed to cache response:" << errorString;
+
+    const DeepSeekResponseCache::Stats stats = m_responseCache->stats();
+    qCDebug(deepseekChatLog) << "DeepSeek response cache:" << stats.hits << "hits,"
+                             << stats.misses << "misses," << stats.bypassed << "bypassed,"
+                             << stats.entries << "entries," << stats.bytes << "bytes";
 }
 
 void DeepSeekNavigationChat::applyEditToCurrentFile(const QString &text)
@@ -286,7 +926,9 @@ void DeepSeekNavigationChat::applyEditToCurrentFile(const QString &text)
     if (Core::IEditor *editor = Core::EditorManager::currentEditor()) {
         if (Core::IDocument *document = editor->document()) {
             if (auto *textEditor = qobject_cast<TextEditor::TextEditorWidget*>(editor->widget())) {
-                textEditor->setPlainText(text);
+                // Solo se tocan las líneas que cambian, en un único paso de
+                // deshacer: se conservan cursor, plegado y resaltado del resto.
+                DeepSeekTextDiff::applyToDocument(textEditor->document(), text);
             } else {
                 handleGenericEditor(document, text);
             }
@@ -318,33 +960,83 @@ void DeepSeekNavigationChat::handleGenericEditor(Core::IDocument *document, cons
 
 void DeepSeekNavigationChat::applyEditToFile(const QString &filePath, const QString &content)
 {
+    applyEditsToFiles({{filePath, content}});
+}
+
+bool DeepSeekNavigationChat::applyEditsToFiles(const QList<DeepSeekEditTransaction::FileEdit> &edits)
+{
+    DeepSeekEditTransaction transaction(getEditJournalPath());
+    for (const DeepSeekEditTransaction::FileEdit &edit : edits)
+        transaction.addFile(edit.filePath, edit.content);
+
+    // Recargar un documento con cambios sin guardar los perdería: se cancela
+    // la transacción entera antes de tocar nada.
+    QList<Core::IDocument *> documents;
+    for (const QString &path : transaction.files()) {
+        const Utils::FilePath filePath = Utils::FilePath::fromString(path);
+        if (Core::IDocument *document = Core::DocumentModel::documentForFilePath(filePath)) {
+            if (document->isModified()) {
+                QMessageBox::warning(m_widget, tr("Write Error"),
+                                     tr("%1 has unsaved changes. Save or revert it first.")
+                                         .arg(filePath.toUserOutput()));
+                return false;
+            }
+            documents.append(document);
+        }
+    }
+
+    // Los cambios los recarga el plugin: Qt Creator no debe avisar de
+    // modificaciones externas por cada fichero.
+    std::vector<std::unique_ptr<Core::FileChangeBlocker>> blockers;
+    for (const QString &path : transaction.files())
+        blockers.push_back(std::make_unique<Core::FileChangeBlocker>(Utils::FilePath::fromString(path)));
+
     QString error;
-    if (!FileUtils::writeFile(filePath, content, error)) {
-        QMessageBox::critical(m_widget, tr("Write Error"), error);
+    if (!transaction.commit(&error)) {
+        QMessageBox::critical(m_widget, tr("Write Error"),
+                              tr("No file was changed: %1").arg(error));
+        return false;
+    }
+
+    for (Core::IDocument *document : std::as_const(documents)) {
+        document->reload(Core::IDocument::ReloadFlag::FlagReload,
+                         Core::IDocument::ChangeType::TypeContents);
     }
+    return true;
 }
 
 void DeepSeekNavigationChat::showPreviewDialog(const QString &filePath, const QString &newContent)
 {
-    DeepSeekPreviewDialog dlg(filePath, newContent, m_widget);
+    // Si el fichero está abierto se compara con el contenido del editor
+    std::optional<QString> originalContent;
+    const Utils::FilePath path = Utils::FilePath::fromString(filePath);
+    if (auto *document = qobject_cast<TextEditor::TextDocument *>(
+            Core::DocumentModel::documentForFilePath(path))) {
+        originalContent = document->plainText();
+    }
+
+    DeepSeekPreviewDialog dlg(filePath, originalContent, newContent, m_widget);
     if (dlg.exec() == QDialog::Accepted && dlg.accepted()) {
-        applyEditToFile(filePath, newContent);
+        applyEditToFile(filePath, dlg.resultContent());
     }
 }
 
-void DeepSeekNavigationChat::appendToChatHistory(const QString &sender, const QString &text)
+void DeepSeekNavigationChat::appendToChatHistory(const QString &sender, const QString &text,
+                                                 DeepSeekChatModel::TextFormat format)
 {
-    QString formattedText = text.toHtmlEscaped().replace('\n', "<br>");
-    m_outputBox->append(QString("<b>%1:</b><br>%2<br>").arg(sender, formattedText));
+    m_chatModel->appendMessage(sender, text, format);
+}
 
-    QListWidgetItem *item = new QListWidgetItem(QString("%1: %2").arg(sender, text.left(50)));
-    if (sender == "You") {
-        item->setForeground(Qt::blue);
-    } else if (sender == "DeepSeek") {
-        item->setForeground(Qt::darkGreen);
-    }
-    m_historyList->addItem(item);
-    m_historyList->scrollToBottom();
+quint64 DeepSeekNavigationChat::beginStreamedReply()
+{
+    return m_chatModel->appendMessage("DeepSeek", QString(), DeepSeekChatModel::Markdown);
+}
+
+void DeepSeekNavigationChat::appendStreamDelta(quint64 messageId, const QString &delta)
+{
+    // Solo cambia el mensaje de esta respuesta; la vista repinta esa fila y
+    // vuelve a maquetar únicamente si su altura ha cambiado.
+    m_chatModel->appendText(messageId, delta);
 }
 
 void DeepSeekNavigationChat::updateContextMetadata(QJsonObject &payload)
@@ -368,43 +1060,285 @@ void DeepSeekNavigationChat::updateContextMetadata(QJsonObject &payload)
     }
 }
 
-Utils::FilePath DeepSeekNavigationChat::getHistoryFilePath() const
+QString DeepSeekNavigationChat::getEditJournalPath()
 {
     const QString configDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    return Utils::FilePath::fromString(configDir + "/deepseek_conversation_history.json");
+    return configDir + "/deepseek_edit_journal.json";
 }
 
-void DeepSeekNavigationChat::loadConversationHistory()
+Utils::FilePath DeepSeekNavigationChat::dataDirectory()
 {
-    const Utils::FilePath historyFile = getHistoryFilePath();
-    if (!historyFile.exists()) {
-        return;
+    return Utils::FilePath::fromString(
+        QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+}
+
+Utils::FilePath DeepSeekNavigationChat::getHistoryFilePath() const
+{
+    return Utils::FilePath::fromString(m_sessions.logPath(m_sessionId));
+}
+
+QString DeepSeekNavigationChat::projectKey(ProjectExplorer::Project *project)
+{
+    return project ? project->projectFilePath().toFSPathString() : QString();
+}
+
+void DeepSeekNavigationChat::loadSessions()
+{
+    const Utils::FilePath directory = dataDirectory();
+    m_sessions.setDirectory(directory.pathAppended("deepseek_sessions").toFSPathString());
+
+    // Primera vez con sesiones: el historial global pasa a ser la sesión
+    // "General", sin proyecto
+    const bool firstRun = !QFile::exists(m_sessions.indexPath());
+    QString errorString;
+    if (!m_sessions.load(&errorString))
+        qWarning() << "Failed to load session index:" << errorString;
+    const Utils::FilePath legacyLog = directory.pathAppended("deepseek_conversation_history.jsonl");
+    const Utils::FilePath legacyJson = directory.pathAppended("deepseek_conversation_history.json");
+    if (firstRun && (legacyLog.exists() || legacyJson.exists())) {
+        if (m_sessions.importLog(legacyLog.toFSPathString(), tr("General"), &errorString))
+            saveSessions();
+        else
+            qWarning() << "Failed to import conversation history:" << errorString;
     }
 
-    Utils::FileReader reader;
+    connect(ProjectExplorer::ProjectManager::instance(),
+            &ProjectExplorer::ProjectManager::startupProjectChanged,
+            this, &DeepSeekNavigationChat::onStartupProjectChanged);
+    m_projectKey = projectKey(ProjectExplorer::ProjectManager::startupProject());
+    m_sessionId = activeOrNewSession();
+}
+
+void DeepSeekNavigationChat::saveSessions()
+{
     QString errorString;
-    if (!reader.fetch(historyFile, &errorString)) {  // Usamos la versión con errorString
-        qWarning() << "Failed to load history:" << errorString;
+    if (!m_sessions.save(&errorString))
+        qWarning() << "Failed to save session index:" << errorString;
+}
+
+void DeepSeekNavigationChat::onStartupProjectChanged(ProjectExplorer::Project *project)
+{
+    const QString key = projectKey(project);
+    if (key == m_projectKey)
         return;
+    m_projectKey = key;
+    switchSession(activeOrNewSession());
+    updateSessionCombo();
+}
+
+QString DeepSeekNavigationChat::activeOrNewSession()
+{
+    QString id = m_sessions.activeSession(m_projectKey);
+    if (id.isEmpty()) {
+        id = m_sessions.create(m_projectKey, tr("New Session")).id;
+        m_sessions.setActiveSession(m_projectKey, id);
+        saveSessions();
     }
+    return id;
+}
 
-    QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(reader.data(), &parseError);
-    if (parseError.error != QJsonParseError::NoError) {
-        qWarning() << "Invalid JSON in history file at offset" << parseError.offset
-                   << ":" << parseError.errorString();
+void DeepSeekNavigationChat::switchSession(const QString &id)
+{
+    if (id == m_sessionId || !m_sessions.find(id))
+        return;
+
+    m_sessions.setActiveSession(m_projectKey, id);
+    saveSessions();
+    m_sessionId = id;
+
+    // La sesión anterior se suelta entera; si aún se estaba cargando, su
+    // resultado se descarta. Las peticiones en curso guardan su sesión.
+    m_historyFuture = {};
+    m_historyLoaded = false;
+    m_historyBase += m_conversationHistory.size();
+    m_conversationHistory = {};
+    m_droppedTurns = 0;
+    m_historyStore = DeepSeekHistoryStore();
+    m_chatModel->clear();
+
+    // Solo se lee la cola de la sesión nueva, fuera del hilo de la UI
+    startHistoryLoad();
+    const quint64 generation = ++m_sessionGeneration;
+    m_historyFuture.then(this, [this, generation](const HistoryLoadResult &) {
+        if (generation != m_sessionGeneration || m_historyLoaded)
+            return;
+        ensureHistoryLoaded();
+        // La vista solo pide historial al desplazarse: el primer bloque va aquí
+        m_chatModel->fetchOlder();
+        updateTokenLabel();
+    });
+
+    updateSessionCombo();
+    updateTokenLabel();
+}
+
+void DeepSeekNavigationChat::newSession()
+{
+    // Una sesión vacía ya sirve de sesión nueva
+    const DeepSeekSessionIndex::Session *current = m_sessions.find(m_sessionId);
+    if (current && current->turns == 0 && m_historyLoaded && m_conversationHistory.isEmpty())
+        return;
+
+    switchSession(m_sessions.create(m_projectKey, tr("New Session")).id);
+}
+
+void DeepSeekNavigationChat::deleteSession()
+{
+    const DeepSeekSessionIndex::Session *session = m_sessions.find(m_sessionId);
+    if (!session)
+        return;
+    if (QMessageBox::question(m_widget, tr("Delete Session"),
+                              tr("Delete the session \"%1\" and its history?").arg(session->name))
+        != QMessageBox::Yes) {
         return;
     }
 
-    if (!doc.isArray()) {
-        qWarning() << "History file should contain a JSON array";
+    // El registro no puede estar abierto en el hilo de carga al borrarlo
+    if (m_historyFuture.isValid())
+        m_historyFuture.waitForFinished();
+
+    QString errorString;
+    if (!m_sessions.remove(m_sessionId, &errorString))
+        qWarning() << "Failed to delete session:" << errorString;
+    switchSession(activeOrNewSession());
+}
+
+void DeepSeekNavigationChat::updateSessionCombo()
+{
+    if (!m_sessionCombo)
         return;
+
+    const QSignalBlocker blocker(m_sessionCombo);
+    m_sessionCombo->clear();
+    const QLocale locale;
+    for (const DeepSeekSessionIndex::Session &session : m_sessions.sessions(m_projectKey)) {
+        m_sessionCombo->addItem(session.name, session.id);
+        m_sessionCombo->setItemData(m_sessionCombo->count() - 1,
+                                    tr("%n turn(s), last used %1", nullptr, session.turns)
+                                        .arg(locale.toString(session.updated.toLocalTime(),
+                                                             QLocale::ShortFormat)),
+                                    Qt::ToolTipRole);
     }
+    m_sessionCombo->setCurrentIndex(m_sessionCombo->findData(m_sessionId));
+    m_sessionCombo->setToolTip(m_projectKey.isEmpty() ? tr("Sessions without a project")
+                                                      : tr("Sessions of %1").arg(m_projectKey));
+}
 
-    m_conversationHistory = doc.array();
+void DeepSeekNavigationChat::recordSessionTurn(const QString &sessionId, const QString &message)
+{
+    const DeepSeekSessionIndex::Session *session = m_sessions.find(sessionId);
+    if (!session)
+        return;
+    // Se cuentan aquí: el registro puede guardar más o menos entradas que
+    // turnos según cuándo se compacte
+    const int turns = session->turns + 1;
+
+    // Una sesión nueva toma el nombre de su primera pregunta
+    if (turns == 1 && session->id != DeepSeekSessionIndex::DefaultSessionId) {
+        QString name = message.simplified();
+        if (name.size() > MaxSessionNameLength)
+            name = name.left(MaxSessionNameLength - 1) + QChar(0x2026);
+        m_sessions.rename(sessionId, name);
+    }
+    m_sessions.touch(sessionId, turns);
+    saveSessions();
+    updateSessionCombo();
 }
 
-void DeepSeekNavigationChat::saveConversationHistory(const QString &message, const QString &response)
+DeepSeekNavigationChat::HistoryLoadResult
+DeepSeekNavigationChat::loadConversationHistory(const Utils::FilePath &historyFile,
+                                                const Utils::FilePath &legacyFile, int maxEntries)
+{
+    // Se ejecuta en un hilo de QtConcurrent: no debe tocar el objeto del chat
+    DeepSeekStartupTiming::Scope timing("history load (worker)", false);
+
+    HistoryLoadResult result;
+    result.store.setPath(historyFile.toFSPathString());
+    result.store.setRetention(maxEntries);
+
+    // Formato anterior: un único array JSON reescrito tras cada respuesta
+    if (!legacyFile.isEmpty()
+        && !result.store.importLegacy(legacyFile.toFSPathString(), &result.errorString)) {
+        qWarning() << "Failed to import legacy history:" << result.errorString;
+    }
+
+    if (!result.store.open(&result.errorString))
+        return result;
+
+    // Solo se lee la cola que se usa para el contexto
+    result.entries = result.store.readTail(maxEntries, &result.errorString);
+    return result;
+}
+
+void DeepSeekNavigationChat::startHistoryLoad()
+{
+    if (m_historyLoaded || m_historyFuture.isValid())
+        return;
+
+    // El antiguo fichero JSON solo se importa en la sesión que hereda el historial global
+    const Utils::FilePath legacyFile
+        = m_sessionId == DeepSeekSessionIndex::DefaultSessionId
+              ? dataDirectory().pathAppended("deepseek_conversation_history.json")
+              : Utils::FilePath();
+    m_historyFuture = QtConcurrent::run(&DeepSeekNavigationChat::loadConversationHistory,
+                                        getHistoryFilePath(), legacyFile, MaxHistoryEntries);
+}
+
+void DeepSeekNavigationChat::ensureHistoryLoaded()
+{
+    if (m_historyLoaded)
+        return;
+
+    startHistoryLoad();
+
+    QElapsedTimer waitTimer;
+    waitTimer.start();
+    HistoryLoadResult result = m_historyFuture.result(); // espera si aún no ha terminado
+    DeepSeekStartupTiming::record("history load (GUI wait)", waitTimer.nsecsElapsed(), false);
+
+    m_historyFuture = {};
+    m_historyLoaded = true;
+
+    if (!result.errorString.isEmpty())
+        qWarning() << "Failed to load history:" << result.errorString;
+
+    m_historyStore = result.store;
+    // Los ids de los turnos siguen creciendo: nada de lo ya serializado
+    // puede confundirse con el historial recién cargado
+    m_historyBase += m_conversationHistory.size();
+    m_conversationHistory = result.entries;
+
+    // Las conversaciones anteriores no se maquetan hasta que se desplaza hacia ellas
+    m_chatModel->setOlderMessages(historyMessages(m_conversationHistory));
+}
+
+QList<DeepSeekChatMessage> DeepSeekNavigationChat::historyMessages(const QJsonArray &entries)
+{
+    QList<DeepSeekChatMessage> messages;
+    messages.reserve(entries.size() * 2);
+    for (const QJsonValue &value : entries) {
+        const QJsonObject entry = value.toObject();
+        const QDateTime timestamp
+            = QDateTime::fromString(entry.value("timestamp").toString(), Qt::ISODate);
+        DeepSeekChatMessage message;
+        message.sender = "You";
+        message.text = entry.value("message").toString();
+        message.timestamp = timestamp;
+        messages.append(message);
+
+        DeepSeekChatMessage response;
+        response.sender = "DeepSeek";
+        response.text = entry.value("response").toString();
+        response.timestamp = timestamp;
+        response.markdown = true;
+        messages.append(response);
+    }
+    return messages;
+}
+
+void DeepSeekNavigationChat::saveConversationHistory(const QString &sessionId,
+                                                     const QString &message,
+                                                     const QString &response)
 {
     QJsonObject entry;
     entry["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
@@ -412,23 +1346,43 @@ void DeepSeekNavigationChat::saveConversationHistory(const QString &message, con
     entry["response"] = response;
     entry["context"] = getCurrentContext();
 
+    QString errorString;
+    if (sessionId != m_sessionId) {
+        // Respuesta de una sesión que ya no está activa (o que se borró):
+        // se anexa a su registro sin cargarla
+        if (!m_sessions.find(sessionId))
+            return;
+        DeepSeekHistoryStore store(m_sessions.logPath(sessionId));
+        store.setRetention(MaxHistoryEntries);
+        if (!store.append(entry, &errorString)) {
+            qWarning() << "Failed to save history:" << errorString;
+            return;
+        }
+        recordSessionTurn(sessionId, message);
+        return;
+    }
+
+    ensureHistoryLoaded();
     m_conversationHistory.append(entry);
 
-    // Keep last 100 conversations
-    const int maxHistory = 100;
-    while (m_conversationHistory.size() > maxHistory) {
-        m_conversationHistory.removeFirst();
+    // Keep last MaxHistoryEntries conversations in memory. Se recorta en
+    // bloques de PrefixDropStep para que el primer turno, y con él el prefijo
+    // que cachea el servidor, no cambie en cada pregunta.
+    if (m_conversationHistory.size() > MaxHistoryEntries) {
+        constexpr qsizetype step = DeepSeekContextWindow::PrefixDropStep;
+        const qsizetype excess = m_conversationHistory.size() - MaxHistoryEntries;
+        const qsizetype drop = (excess + step - 1) / step * step;
+        for (qsizetype i = 0; i < drop; ++i)
+            m_conversationHistory.removeFirst();
+        m_historyBase += drop;
     }
 
-    // Save to file
-    const Utils::FilePath historyFile = getHistoryFilePath();
-    historyFile.parentDir().ensureWritableDir();
-
-    Utils::FileSaver saver(getHistoryFilePath(), QIODevice::Text);
-    saver.write(QJsonDocument(m_conversationHistory).toJson());
-    if (!saver.finalize()) {
-        qWarning() << "Failed to save history:" << saver.errorString();
+    // Un único append al registro; el almacén compacta cuando hace falta
+    if (!m_historyStore.append(entry, &errorString)) {
+        qWarning() << "Failed to save history:" << errorString;
+        return;
     }
+    recordSessionTurn(sessionId, message);
 }
 
 QJsonObject DeepSeekNavigationChat::getCurrentContext() const
@@ -447,8 +1401,103 @@ QJsonObject DeepSeekNavigationChat::getCurrentContext() const
 
 void DeepSeekNavigationChat::sendSourceAnalysisCommand(const QString &command)
 {
-    QJsonObject payload;
-    payload["command"] = command;
-    updateContextMetadata(payload);
-    sendApiRequest("/analyze", payload);
+    // La acción del menú puede llegar antes que delayedInitialize()
+    delayedInitialize();
+
+    const auto settings = DSS::inst()->snapshot();
+    ProjectExplorer::Project *project = ProjectExplorer::ProjectManager::startupProject();
+    QString errorString;
+    QNetworkRequest request;
+    QStringList files;
+    if (!settings->isValid) {
+        errorString = settings->validationError;
+    } else if (!project) {
+        errorString = tr("There is no active project to analyze.");
+    } else {
+        request = chatCompletionsRequest(*settings, &errorString);
+        for (const Utils::FilePath &filePath : project->files(ProjectExplorer::Project::SourceFiles))
+            files.append(filePath.toFSPathString());
+    }
+
+    if (errorString.isEmpty()) {
+        // Temperatura 0: repetir el análisis sobre el mismo código da lo mismo
+        QJsonObject fields;
+        fields["model"] = settings->model;
+        fields["temperature"] = 0.0;
+        fields["max_tokens"] = replyTokens(*settings);
+        fields["response_format"] = QJsonObject{{"type", "json_object"}};
+
+        ProjectExplorer::TaskHub::clearTasks(AnalysisTaskCategory);
+        m_batchAnalysis->start(projectKey(project), files, command, request, fields, &errorString);
+    }
+
+    if (!errorString.isEmpty()) {
+        QMessageBox::warning(Core::ICore::dialogParent(), tr("DeepSeek Analysis"), errorString);
+        return;
+    }
+
+    // Barra de progreso de Qt Creator; cancelarla detiene el análisis
+    m_analysisProgress = std::make_unique<QFutureInterface<void>>();
+    m_analysisProgress->setProgressRange(0, int(files.size()));
+    m_analysisProgress->reportStarted();
+    auto watcher = new QFutureWatcher<void>(this);
+    connect(watcher, &QFutureWatcherBase::canceled, m_batchAnalysis, &DeepSeekBatchAnalysis::cancel);
+    connect(watcher, &QFutureWatcherBase::finished, watcher, &QObject::deleteLater);
+    watcher->setFuture(m_analysisProgress->future());
+    Core::ProgressManager::addTask(m_analysisProgress->future(), tr("DeepSeek: %1").arg(command),
+                                   AnalysisTaskCategory);
+    onAnalysisProgress();
+}
+
+void DeepSeekNavigationChat::onAnalysisProgress()
+{
+    if (!m_analysisProgress)
+        return;
+    const DeepSeekBatchAnalysis::Stats stats = m_batchAnalysis->stats();
+    m_analysisProgress->setProgressValueAndText(stats.finishedFiles(),
+                                                tr("%1/%2 files, %3 files/min")
+                                                    .arg(stats.finishedFiles())
+                                                    .arg(stats.totalFiles)
+                                                    .arg(stats.filesPerMinute(), 0, 'f', 1));
+}
+
+void DeepSeekNavigationChat::onAnalysisFinished(bool canceled)
+{
+    if (m_analysisProgress) {
+        m_analysisProgress->reportFinished();
+        m_analysisProgress.reset();
+    }
+
+    const DeepSeekBatchAnalysis::Stats stats = m_batchAnalysis->stats();
+    QString summary = tr("%1: %2 of %3 files analyzed, %4 issues, %5 files/min.")
+                          .arg(m_batchAnalysis->command())
+                          .arg(stats.doneFiles + stats.resumedFiles)
+                          .arg(stats.totalFiles)
+                          .arg(stats.issues)
+                          .arg(stats.filesPerMinute(), 0, 'f', 1);
+    if (stats.resumedFiles > 0)
+        summary += ' ' + tr("%1 files were already analyzed in an interrupted run.")
+                             .arg(stats.resumedFiles);
+    if (stats.failedFiles > 0)
+        summary += ' ' + tr("%1 files failed and will be retried next time.").arg(stats.failedFiles);
+    if (!m_batchAnalysis->errorString().isEmpty())
+        summary += ' ' + tr("Stopped by an error (%1); running the same command again resumes it.")
+                             .arg(m_batchAnalysis->errorString());
+    else if (canceled)
+        summary += ' ' + tr("Stopped; running the same command again resumes it.");
+    appendToChatHistory("Analysis", summary);
+
+    if (stats.issues > 0)
+        ProjectExplorer::TaskHub::requestPopup();
+}
+
+void DeepSeekNavigationChat::publishIssues(const QList<DeepSeekBatchAnalysis::Issue> &issues)
+{
+    for (const DeepSeekBatchAnalysis::Issue &issue : issues) {
+        ProjectExplorer::TaskHub::addTask(
+            ProjectExplorer::Task(issue.error ? ProjectExplorer::Task::Error
+                                              : ProjectExplorer::Task::Warning,
+                                  issue.message, Utils::FilePath::fromString(issue.filePath),
+                                  issue.line > 0 ? issue.line : -1, AnalysisTaskCategory));
+    }
 }
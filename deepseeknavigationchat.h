@@ -1,6 +1,8 @@
 #pragma once
 #include <coreplugin/inavigationwidgetfactory.h>
 #include <coreplugin/editormanager/editormanager.h>
+#include <coreplugin/editormanager/documentmodel.h>
+#include <coreplugin/documentmanager.h>
 #include <coreplugin/session.h>
 #include <texteditor/texteditor.h>
 #include <texteditor/textdocument.h>
@@ -20,7 +22,6 @@
 #include <QTextEdit>
 #include <QLineEdit>
 #include <QPushButton>
-#include <QListWidget>
 #include <QLabel>
 #include <QFileInfo>
 #include <QDir>
@@ -30,15 +31,39 @@
 #include <QStandardPaths>
 #include <QNetworkReply>
 #include <QTimer>
+#include <QFuture>
+#include <QFutureInterface>
+#include <QThreadPool>
+#include <QElapsedTimer>
 #include <projectexplorer/project.h>
 #include <projectexplorer/projectmanager.h>
+#include "deepseekbatchanalysis.h"
+#include "deepseekchatmodel.h"
+#include "deepseekcontextwindow.h"
+#include "deepseekedittransaction.h"
+#include "deepseekhistorystore.h"
+#include "deepseekmetricsdialog.h"
+#include "deepseekmodelcatalog.h"
+#include "deepseekpreviewdialog.h"
+#include "deepseekprojectcontext.h"
+#include "deepseeknetworkservice.h"
+#include "deepseekreplyreader.h"
+#include "deepseekrequestmetrics.h"
+#include "deepseekrequestscheduler.h"
+#include "deepseekrequestserializer.h"
+#include "deepseekresponsecache.h"
+#include "deepseeksessionindex.h"
 #include "deepseeksettings.h"
+#include "deepseekstreamparser.h"
+#include "deepseektokenizer.h"
+
+#include <memory>
 
 QT_BEGIN_NAMESPACE
+class QComboBox;
 class QTextEdit;
 class QLineEdit;
 class QPushButton;
-class QListWidget;
 QT_END_NAMESPACE
 
 namespace DeepSeek {
@@ -51,18 +76,6 @@ public:
     static bool ensureDirectoryExists(const QString &filePath, QString &errorMessage);
 };
 
-class DeepSeekPreviewDialog : public QDialog
-{
-    Q_OBJECT
-public:
-    explicit DeepSeekPreviewDialog(const QString &filePath, const QString &newContent, QWidget *parent = nullptr);
-    bool accepted() const;
-
-private:
-    QTextEdit *m_previewEditor = nullptr;
-    bool m_accepted = false;
-};
-
 class DeepSeekNavigationChat : public Core::INavigationWidgetFactory
 {
     Q_OBJECT
@@ -72,44 +85,196 @@ public:
     ~DeepSeekNavigationChat() override;
     Core::NavigationView createWidget() override;
 
+    // Trabajo diferido fuera de IPlugin::initialize(): conecta los ajustes y
+    // carga el historial en un hilo de QtConcurrent.
+    void delayedInitialize();
+
+    // Aplica command a todos los ficheros fuente del proyecto de arranque en
+    // segundo plano; los resultados van al panel de Issues.
+    void sendSourceAnalysisCommand(const QString &command);
+
 protected:
     void handleGenericEditor(Core::IDocument *document, const QString &text);
 
 private slots:
     void onSendClicked();
-    void handleApiReply(QNetworkReply *reply);
-    void onSettingsChanged();
+    void onStopClicked();
+    void onSettingsChanged(DeepSeekSettings::Fields changed);
 
 private:
+    // Estado de cada petición del chat, correlacionado por id con el planificador
+    struct PendingChat
+    {
+        QString message;  // mensaje exacto del usuario que originó la petición
+        QString sessionId; // sesión a la que va la respuesta aunque ya no sea la activa
+        QByteArray cacheKey;
+        std::shared_ptr<DeepSeekStreamParser> parser; // solo en streaming
+        std::shared_ptr<DeepSeekReplyReader> reader;  // solo sin streaming
+        quint64 replyMessageId = 0; // mensaje del modelo que recibe el streaming
+        QElapsedTimer timer;        // desde que se encola
+        qint64 startedMs = -1;      // momento de post() según timer
+        DeepSeekRequestMetrics::Sample metrics;
+    };
+
+    void onRequestStarted(DeepSeekRequestScheduler::RequestId id, QNetworkReply *reply);
+    void onRequestFinished(DeepSeekRequestScheduler::RequestId id, QNetworkReply *reply,
+                           DeepSeekRequestScheduler::FinishReason reason);
+    void handleApiReply(QNetworkReply *reply, PendingChat &pending,
+                        DeepSeekRequestScheduler::FinishReason reason);
+    void handleStreamReply(QNetworkReply *reply, PendingChat &pending,
+                           DeepSeekRequestScheduler::FinishReason reason);
+    void updateStopButton();
+
     // File operations
     void applyEditToCurrentFile(const QString &text);
     void applyEditToFile(const QString &filePath, const QString &content);
+    bool applyEditsToFiles(const QList<DeepSeekEditTransaction::FileEdit> &edits);
     void showPreviewDialog(const QString &filePath, const QString &newContent);
 
     // Chat operations
-    void appendToChatHistory(const QString &sender, const QString &text);
-    void sendSourceAnalysisCommand(const QString &command);
+    void appendToChatHistory(const QString &sender, const QString &text,
+                             DeepSeekChatModel::TextFormat format = DeepSeekChatModel::PlainText);
+    quint64 beginStreamedReply();
+    void appendStreamDelta(quint64 messageId, const QString &delta);
     void updateContextMetadata(QJsonObject &payload);
 
     // History management
-    void loadConversationHistory();
-    void saveConversationHistory(const QString &message, const QString &response);
+    struct HistoryLoadResult
+    {
+        DeepSeekHistoryStore store;
+        QJsonArray entries;
+        QString errorString;
+    };
+    static HistoryLoadResult loadConversationHistory(const Utils::FilePath &historyFile,
+                                                     const Utils::FilePath &legacyFile,
+                                                     int maxEntries);
+    void startHistoryLoad();
+    void ensureHistoryLoaded();
+    static QList<DeepSeekChatMessage> historyMessages(const QJsonArray &entries);
+    void saveConversationHistory(const QString &sessionId, const QString &message,
+                                 const QString &response);
     Utils::FilePath getHistoryFilePath() const;
+    static Utils::FilePath dataDirectory();
+
+    // Sesiones: cada proyecto tiene las suyas y solo la activa está en memoria
+    static QString projectKey(ProjectExplorer::Project *project);
+    void loadSessions();
+    void saveSessions();
+    void onStartupProjectChanged(ProjectExplorer::Project *project);
+    QString activeOrNewSession();
+    void switchSession(const QString &id);
+    void newSession();
+    void deleteSession();
+    void updateSessionCombo();
+    void recordSessionTurn(const QString &sessionId, const QString &message);
+    static constexpr int MaxSessionNameLength = 48;
+    void updateSemanticSearch();
+
+    // Tokens
+    static int contextLength(const DeepSeekSettings::Snapshot &settings);
+    static int replyTokens(const DeepSeekSettings::Snapshot &settings);
+    void loadTokenizer();
+    void updateTokenLabel();
+    static QString getEditJournalPath();
     QJsonObject getCurrentContext() const;
 
     // API communication
+    static QNetworkRequest chatCompletionsRequest(const DeepSeekSettings::Snapshot &settings,
+                                                  QString *errorString);
     void sendApiRequest(const QString &endpoint, const QJsonObject &payload);
 
+    // Project analysis
+    static constexpr char AnalysisTaskCategory[] = "DeepSeek.Analysis";
+    void onAnalysisProgress();
+    void onAnalysisFinished(bool canceled);
+    void publishIssues(const QList<DeepSeekBatchAnalysis::Issue> &issues);
+    DeepSeekBatchAnalysis *m_batchAnalysis = nullptr;
+    std::unique_ptr<QFutureInterface<void>> m_analysisProgress;
+
+    // Resultado de serializar una petición en m_serializePool
+    struct SerializedRequest
+    {
+        QByteArray body;
+        QByteArray cacheKey; // vacía si la respuesta no se puede cachear
+        std::optional<DeepSeekResponseCache::Entry> cached; // acierto en la caché
+    };
+    void enqueueChatRequest(const QNetworkRequest &request, const SerializedRequest &serialized,
+                            const QString &message, const QString &sessionId, bool stream);
+    std::shared_ptr<DeepSeekRequestSerializer> m_requestSerializer
+        = std::make_shared<DeepSeekRequestSerializer>();
+    QThreadPool m_serializePool;
+    // id del turno m_conversationHistory[i] = m_historyBase + i
+    qint64 m_historyBase = 0;
+    QString replyErrorMessage(QNetworkReply *reply,
+                              DeepSeekRequestScheduler::FinishReason reason) const;
+
+    // Response cache
+    // Tokens del prompt servidos desde la caché de contexto de DeepSeek
+    // durante esta sesión (campos prompt_cache_*_tokens de "usage").
+    struct PromptCacheStats
+    {
+        qint64 hitTokens = 0;
+        qint64 missTokens = 0;
+        int requests = 0;
+
+        double hitRatio() const
+        {
+            const qint64 total = hitTokens + missTokens;
+            return total > 0 ? double(hitTokens) / double(total) : 0.0;
+        }
+    };
+    void recordUsage(PendingChat &pending, const QJsonObject &usage);
+    PromptCacheStats m_promptCacheStats;
+
+    void recordMetrics(PendingChat &pending, QNetworkReply *reply,
+                       DeepSeekRequestScheduler::FinishReason reason);
+    void showMetricsDialog();
+    DeepSeekRequestMetrics m_requestMetrics;
+    QPointer<DeepSeekMetricsDialog> m_metricsDialog;
+
+    void configureResponseCache();
+    void storeInResponseCache(const QByteArray &cacheKey, const QString &content,
+                              const QJsonObject &usage);
+
     // UI components
     QWidget *m_widget = nullptr;
     QLineEdit *m_inputLine = nullptr;
-    QTextEdit *m_outputBox = nullptr;
     QPushButton *m_sendButton = nullptr;
-    QListWidget *m_historyList = nullptr;
+    QPushButton *m_stopButton = nullptr;
+    QLabel *m_tokenLabel = nullptr;
+    QComboBox *m_sessionCombo = nullptr;
+
+    // La conversación vive en el modelo; las vistas de cada panel lo comparten
+    DeepSeekChatModel *m_chatModel = nullptr;
 
     // Network
-    QNetworkAccessManager *m_networkManager = nullptr;
+    DeepSeekRequestScheduler *m_scheduler = nullptr;
+    DeepSeekProjectContext *m_projectContext = nullptr;
+    QHash<DeepSeekRequestScheduler::RequestId, PendingChat> m_pendingChats;
+
+    // History
+    static constexpr int MaxHistoryEntries = 100;
     QJsonArray m_conversationHistory;
+    int m_droppedTurns = 0; // del último envío, para no repetir el aviso
+    DeepSeekHistoryStore m_historyStore;
+    QFuture<HistoryLoadResult> m_historyFuture;
+    bool m_historyLoaded = false;
+    bool m_settingsConnected = false;
+
+    // Sessions
+    DeepSeekSessionIndex m_sessions;
+    QString m_projectKey; // proyecto de arranque; vacío sin proyecto
+    QString m_sessionId;  // la única sesión cargada
+    quint64 m_sessionGeneration = 0; // descarta cargas de sesiones ya abandonadas
+
+    // Compartida con m_serializePool, donde se hacen las consultas
+    std::shared_ptr<DeepSeekResponseCache> m_responseCache
+        = std::make_shared<DeepSeekResponseCache>();
+    quint64 m_responseCacheSettings = 0; // versión de los ajustes ya aplicada
+
+    // Por debajo de esto no se envía: la respuesta no cabría
+    static constexpr int MinReplyTokens = 256;
+    QString m_tokenizerPath;
 
     // Configuration - ahora con valores por defecto más seguros
     QString m_apiUrl = "";
@@ -0,0 +1,174 @@
+#include "deepseeknetworkservice.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#if QT_CONFIG(ssl)
+#include <QSslConfiguration>
+#endif
+
+namespace DeepSeek {
+
+// Vida de un ticket cuando el servidor no indica ninguna
+static constexpr int DefaultTicketLifetimeSecs = 2 * 3600;
+
+DeepSeekNetworkService::DeepSeekNetworkService(QObject *parent)
+    : QObject(parent)
+    , m_manager(new QNetworkAccessManager(this))
+{
+    connect(m_manager, &QNetworkAccessManager::finished,
+            this, &DeepSeekNetworkService::onReplyFinished);
+}
+
+DeepSeekNetworkService::~DeepSeekNetworkService() = default;
+
+QString DeepSeekNetworkService::hostKey(const QUrl &url)
+{
+    return url.host().toLower() + ':'
+           + QString::number(url.port(url.scheme() == "http" ? 80 : 443));
+}
+
+QNetworkRequest DeepSeekNetworkService::createRequest(const QUrl &url)
+{
+    QNetworkRequest request(url);
+    prepareRequest(request);
+    return request;
+}
+
+void DeepSeekNetworkService::prepareRequest(QNetworkRequest &request)
+{
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+
+#if QT_CONFIG(ssl)
+    if (request.url().scheme() != "https")
+        return;
+
+    ensureSessionsLoaded();
+
+    QSslConfiguration config = request.sslConfiguration();
+    // Necesario para que Qt exponga el ticket de sesión tras el handshake
+    config.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+    config.setAllowedNextProtocols({QSslConfiguration::ALPNProtocolHTTP2,
+                                    QSslConfiguration::NextProtocolHttp1_1});
+
+    const auto it = m_sessions.constFind(hostKey(request.url()));
+    if (it != m_sessions.cend() && it->expires > QDateTime::currentDateTimeUtc())
+        config.setSessionTicket(it->ticket);
+
+    request.setSslConfiguration(config);
+#endif
+}
+
+void DeepSeekNetworkService::prewarm(const QUrl &url)
+{
+    if (!url.isValid() || url.host().isEmpty())
+        return;
+
+    const QString key = hostKey(url);
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    const QDateTime last = m_lastPrewarm.value(key);
+    if (last.isValid() && last.secsTo(now) < PrewarmIntervalSecs)
+        return;
+    m_lastPrewarm.insert(key, now);
+
+#if QT_CONFIG(ssl)
+    if (url.scheme() == "https") {
+        // Misma configuración TLS que las peticiones reales: ALPN h2 y el
+        // ticket guardado, así la conexión abierta aquí es la que se reutiliza.
+        const QNetworkRequest request = createRequest(url);
+        m_manager->connectToHostEncrypted(url.host(), quint16(url.port(443)),
+                                          request.sslConfiguration());
+        return;
+    }
+#endif
+    m_manager->connectToHost(url.host(), quint16(url.port(80)));
+}
+
+QString DeepSeekNetworkService::sessionFilePath() const
+{
+    const QString configDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    return configDir + "/deepseek_tls_sessions.json";
+}
+
+void DeepSeekNetworkService::ensureSessionsLoaded()
+{
+    if (m_sessionsLoaded)
+        return;
+    m_sessionsLoaded = true;
+
+    QFile file(sessionFilePath());
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    const QJsonObject sessions = QJsonDocument::fromJson(file.readAll()).object();
+    for (auto it = sessions.constBegin(); it != sessions.constEnd(); ++it) {
+        const QJsonObject obj = it.value().toObject();
+        SessionTicket session;
+        session.ticket = QByteArray::fromBase64(obj.value("ticket").toString().toLatin1());
+        session.expires = QDateTime::fromString(obj.value("expires").toString(), Qt::ISODate);
+        if (!session.ticket.isEmpty() && session.expires > now)
+            m_sessions.insert(it.key(), session);
+    }
+}
+
+void DeepSeekNetworkService::saveSessions()
+{
+    QJsonObject sessions;
+    for (auto it = m_sessions.cbegin(); it != m_sessions.cend(); ++it) {
+        sessions.insert(it.key(), QJsonObject{
+            {"ticket", QString::fromLatin1(it->ticket.toBase64())},
+            {"expires", it->expires.toString(Qt::ISODate)}
+        });
+    }
+
+    const QString path = sessionFilePath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile saver(path);
+    if (!saver.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to save TLS sessions:" << saver.errorString();
+        return;
+    }
+    // El ticket permite reanudar la sesión: solo legible por el usuario
+    saver.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+    saver.write(QJsonDocument(sessions).toJson(QJsonDocument::Compact));
+    if (!saver.commit())
+        qWarning() << "Failed to save TLS sessions:" << saver.errorString();
+}
+
+void DeepSeekNetworkService::onReplyFinished(QNetworkReply *reply)
+{
+#if QT_CONFIG(ssl)
+    if (reply->url().scheme() != "https")
+        return;
+
+    const QSslConfiguration config = reply->sslConfiguration();
+    const QByteArray ticket = config.sessionTicket();
+    if (ticket.isEmpty())
+        return;
+
+    ensureSessionsLoaded();
+    SessionTicket &session = m_sessions[hostKey(reply->url())];
+    if (session.ticket == ticket)
+        return;
+
+    const int lifetime = config.sessionTicketLifeTimeHint();
+    session.ticket = ticket;
+    session.expires = QDateTime::currentDateTimeUtc().addSecs(
+        lifetime > 0 ? lifetime : DefaultTicketLifetimeSecs);
+    saveSessions();
+#else
+    Q_UNUSED(reply)
+#endif
+}
+
+} // namespace DeepSeek
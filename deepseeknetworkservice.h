@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QUrl>
+#include "singleton.h"
+
+QT_BEGIN_NAMESPACE
+class QNetworkAccessManager;
+class QNetworkReply;
+QT_END_NAMESPACE
+
+namespace DeepSeek {
+
+// Capa de red compartida por todo el plugin (chat, página de opciones, ...).
+// Un único QNetworkAccessManager mantiene las conexiones HTTP/2 abiertas entre
+// peticiones; prewarm() abre la conexión TCP+TLS por adelantado y los tickets
+// de sesión TLS se guardan en disco para que la primera conexión tras
+// reiniciar el IDE pueda reanudar la sesión en lugar de repetir el handshake.
+class DeepSeekNetworkService : public QObject
+{
+    Q_OBJECT
+    friend class Singleton<DeepSeekNetworkService>;
+
+public:
+    QNetworkAccessManager *manager() const { return m_manager; }
+
+    // Aplica la configuración común (HTTP/2, ticket TLS guardado) a una petición
+    void prepareRequest(QNetworkRequest &request);
+    QNetworkRequest createRequest(const QUrl &url);
+
+    // Abre por adelantado la conexión con el host de la URL. Las llamadas
+    // repetidas para el mismo host dentro de PrewarmInterval se ignoran.
+    void prewarm(const QUrl &url);
+    static constexpr int PrewarmIntervalSecs = 60;
+
+protected:
+    explicit DeepSeekNetworkService(QObject *parent = nullptr);
+    ~DeepSeekNetworkService() override;
+
+private:
+    struct SessionTicket
+    {
+        QByteArray ticket;
+        QDateTime expires;
+    };
+
+    static QString hostKey(const QUrl &url);
+    QString sessionFilePath() const;
+    void ensureSessionsLoaded();
+    void saveSessions();
+    void onReplyFinished(QNetworkReply *reply);
+
+    QNetworkAccessManager *m_manager = nullptr;
+    QHash<QString, SessionTicket> m_sessions;
+    QHash<QString, QDateTime> m_lastPrewarm;
+    bool m_sessionsLoaded = false;
+};
+
+// Alias para el Singleton de la capa de red
+typedef Singleton<DeepSeekNetworkService> DSN;
+
+} // namespace DeepSeek
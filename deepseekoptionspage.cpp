@@ -1,4 +1,5 @@
 #include "deepseekoptionspage.h"
+#include "deepseekmodelcatalog.h"
 #include <QSettings>
 
 namespace DeepSeek {
@@ -44,7 +45,7 @@ DeepSeekOptionsPageWidget::DeepSeekOptionsPageWidget(QWidget *parent)
 
     auto *temperatureLabel = new QLabel(tr("Temperatura:"), this);
     temperatureSpinBox = new QDoubleSpinBox(this);
-    temperatureSpinBox->setRange(0.01, 2.0);
+    temperatureSpinBox->setRange(0.0, 2.0);
     temperatureSpinBox->setSingleStep(0.1);
     temperatureSpinBox->setValue(0.7);
     formLayout->addRow(temperatureLabel, temperatureSpinBox);
@@ -55,6 +56,74 @@ DeepSeekOptionsPageWidget::DeepSeekOptionsPageWidget(QWidget *parent)
     maxTokensSpinBox->setValue(2048);
     formLayout->addRow(maxTokensLabel, maxTokensSpinBox);
 
+    auto *contextTokensLabel = new QLabel(tr("Ventana de contexto (tokens):"), this);
+    contextTokensSpinBox = new QSpinBox(this);
+    contextTokensSpinBox->setRange(0, 1048576);
+    contextTokensSpinBox->setSingleStep(1024);
+    contextTokensSpinBox->setSpecialValueText(tr("Según el modelo"));
+    contextTokensSpinBox->setValue(0);
+    formLayout->addRow(contextTokensLabel, contextTokensSpinBox);
+
+    streamCheckBox = new QCheckBox(tr("Mostrar la respuesta mientras se genera (streaming)"), this);
+    streamCheckBox->setChecked(true);
+    formLayout->addRow(QString(), streamCheckBox);
+
+    responseCacheCheckBox = new QCheckBox(tr("Reutilizar respuestas guardadas con temperatura 0"), this);
+    responseCacheCheckBox->setChecked(true);
+    formLayout->addRow(QString(), responseCacheCheckBox);
+
+    auto *responseCacheMaxMbLabel = new QLabel(tr("Tamaño máximo de la caché:"), this);
+    responseCacheSizeSpinBox = new QSpinBox(this);
+    responseCacheSizeSpinBox->setRange(1, 4096);
+    responseCacheSizeSpinBox->setSuffix(" MB");
+    responseCacheSizeSpinBox->setValue(64);
+    formLayout->addRow(responseCacheMaxMbLabel, responseCacheSizeSpinBox);
+
+    auto *responseCacheTtlHoursLabel = new QLabel(tr("Caducidad de la caché:"), this);
+    responseCacheTtlSpinBox = new QSpinBox(this);
+    responseCacheTtlSpinBox->setRange(0, 24 * 365);
+    responseCacheTtlSpinBox->setSuffix(" h");
+    responseCacheTtlSpinBox->setSpecialValueText(tr("Sin caducidad"));
+    responseCacheTtlSpinBox->setValue(168);
+    formLayout->addRow(responseCacheTtlHoursLabel, responseCacheTtlSpinBox);
+
+    projectContextCheckBox = new QCheckBox(tr("Añadir código relevante del proyecto a cada pregunta"), this);
+    projectContextCheckBox->setChecked(true);
+    formLayout->addRow(QString(), projectContextCheckBox);
+
+    auto *projectContextTokensLabel = new QLabel(tr("Tokens para código del proyecto:"), this);
+    projectContextTokensSpinBox = new QSpinBox(this);
+    projectContextTokensSpinBox->setRange(0, 32768);
+    projectContextTokensSpinBox->setSingleStep(500);
+    projectContextTokensSpinBox->setValue(2000);
+    formLayout->addRow(projectContextTokensLabel, projectContextTokensSpinBox);
+
+    embeddingsCheckBox = new QCheckBox(tr("Búsqueda semántica con embeddings"), this);
+    formLayout->addRow(QString(), embeddingsCheckBox);
+
+    auto *embeddingsUrlLabel = new QLabel(tr("URL de embeddings:"), this);
+    embeddingsUrlEdit = new QLineEdit(this);
+    embeddingsUrlEdit->setPlaceholderText(tr("Misma URL que el chat"));
+    formLayout->addRow(embeddingsUrlLabel, embeddingsUrlEdit);
+
+    auto *embeddingModelLabel = new QLabel(tr("Modelo de embeddings:"), this);
+    embeddingModelEdit = new QLineEdit(this);
+    embeddingModelEdit->setText("text-embedding-3-small");
+    formLayout->addRow(embeddingModelLabel, embeddingModelEdit);
+
+    embeddingsQuantizedCheckBox = new QCheckBox(tr("Guardar los vectores cuantizados a int8"), this);
+    embeddingsQuantizedCheckBox->setChecked(true);
+    formLayout->addRow(QString(), embeddingsQuantizedCheckBox);
+
+    auto *tokenizerPathLabel = new QLabel(tr("Tokenizador (tokenizer.json):"), this);
+    tokenizerPathEdit = new QLineEdit(this);
+    tokenizerPathEdit->setPlaceholderText(tr("Vacío: recuento aproximado"));
+    formLayout->addRow(tokenizerPathLabel, tokenizerPathEdit);
+
+    prefixCacheCheckBox = new QCheckBox(tr("Ordenar los mensajes para aprovechar la caché de contexto del servidor"), this);
+    prefixCacheCheckBox->setChecked(true);
+    formLayout->addRow(QString(), prefixCacheCheckBox);
+
     layout->addItem(new QSpacerItem(20, 40, QSizePolicy::Minimum, QSizePolicy::Expanding));
 
     connect(connectButton, &QPushButton::clicked, this, &DeepSeekOptionsPageWidget::onConnectButtonClicked);
@@ -62,6 +131,18 @@ DeepSeekOptionsPageWidget::DeepSeekOptionsPageWidget(QWidget *parent)
             this, &DeepSeekOptionsPageWidget::onModelSelectionChanged);
 
     modelComboBox->addItem("Without Model");
+
+    // Catálogo propio: probar otra URL o clave no toca el compartido, que se
+    // cambia al aplicar (settingsChanged). Empieza con lo guardado para la actual.
+    catalog = new DeepSeekModelCatalog(this);
+    catalog->setAutoRefresh(false);
+    connect(catalog, &DeepSeekModelCatalog::modelsChanged,
+            this, &DeepSeekOptionsPageWidget::populateModels);
+    connect(catalog, &DeepSeekModelCatalog::refreshFinished,
+            this, &DeepSeekOptionsPageWidget::onCatalogRefreshFinished);
+    const auto settings = DSS::inst()->snapshot();
+    catalog->setEndpoint(settings->apiUrl, settings->apiKey);
+    populateModels();
 }
 
 QString DeepSeekOptionsPageWidget::apiKey() const { return apiKeyEdit->text(); }
@@ -70,6 +151,19 @@ QString DeepSeekOptionsPageWidget::model() const { return modelComboBox->current
 QString DeepSeekOptionsPageWidget::systemPrompt() const { return systemPromptEdit->toPlainText(); }
 double DeepSeekOptionsPageWidget::temperature() const { return temperatureSpinBox->value(); }
 int DeepSeekOptionsPageWidget::maxTokens() const { return maxTokensSpinBox->value(); }
+bool DeepSeekOptionsPageWidget::streamResponses() const { return streamCheckBox->isChecked(); }
+int DeepSeekOptionsPageWidget::contextTokens() const { return contextTokensSpinBox->value(); }
+bool DeepSeekOptionsPageWidget::responseCacheEnabled() const { return responseCacheCheckBox->isChecked(); }
+int DeepSeekOptionsPageWidget::responseCacheMaxMb() const { return responseCacheSizeSpinBox->value(); }
+int DeepSeekOptionsPageWidget::responseCacheTtlHours() const { return responseCacheTtlSpinBox->value(); }
+bool DeepSeekOptionsPageWidget::projectContextEnabled() const { return projectContextCheckBox->isChecked(); }
+int DeepSeekOptionsPageWidget::projectContextTokens() const { return projectContextTokensSpinBox->value(); }
+bool DeepSeekOptionsPageWidget::embeddingsEnabled() const { return embeddingsCheckBox->isChecked(); }
+QString DeepSeekOptionsPageWidget::embeddingsUrl() const { return embeddingsUrlEdit->text().trimmed(); }
+QString DeepSeekOptionsPageWidget::embeddingModel() const { return embeddingModelEdit->text().trimmed(); }
+bool DeepSeekOptionsPageWidget::embeddingsQuantized() const { return embeddingsQuantizedCheckBox->isChecked(); }
+QString DeepSeekOptionsPageWidget::tokenizerPath() const { return tokenizerPathEdit->text().trimmed(); }
+bool DeepSeekOptionsPageWidget::prefixCacheLayout() const { return prefixCacheCheckBox->isChecked(); }
 
 // Setters para cargar configuraciones
 void DeepSeekOptionsPageWidget::setApiKey(const QString &key) { apiKeyEdit->setText(key); }
@@ -86,103 +180,81 @@ void DeepSeekOptionsPageWidget::setModel(const QString &model) {
 void DeepSeekOptionsPageWidget::setSystemPrompt(const QString &prompt) { systemPromptEdit->setPlainText(prompt); }
 void DeepSeekOptionsPageWidget::setTemperature(double temp) { temperatureSpinBox->setValue(temp); }
 void DeepSeekOptionsPageWidget::setMaxTokens(int tokens) { maxTokensSpinBox->setValue(tokens); }
+void DeepSeekOptionsPageWidget::setStreamResponses(bool stream) { streamCheckBox->setChecked(stream); }
+void DeepSeekOptionsPageWidget::setContextTokens(int tokens) { contextTokensSpinBox->setValue(tokens); }
+void DeepSeekOptionsPageWidget::setResponseCacheEnabled(bool value) { responseCacheCheckBox->setChecked(value); }
+void DeepSeekOptionsPageWidget::setResponseCacheMaxMb(int value) { responseCacheSizeSpinBox->setValue(value); }
+void DeepSeekOptionsPageWidget::setResponseCacheTtlHours(int value) { responseCacheTtlSpinBox->setValue(value); }
+void DeepSeekOptionsPageWidget::setProjectContextEnabled(bool value) { projectContextCheckBox->setChecked(value); }
+void DeepSeekOptionsPageWidget::setProjectContextTokens(int value) { projectContextTokensSpinBox->setValue(value); }
+void DeepSeekOptionsPageWidget::setEmbeddingsEnabled(bool value) { embeddingsCheckBox->setChecked(value); }
+void DeepSeekOptionsPageWidget::setEmbeddingsUrl(const QString &value) { embeddingsUrlEdit->setText(value); }
+void DeepSeekOptionsPageWidget::setEmbeddingModel(const QString &value) { embeddingModelEdit->setText(value); }
+void DeepSeekOptionsPageWidget::setEmbeddingsQuantized(bool value) { embeddingsQuantizedCheckBox->setChecked(value); }
+void DeepSeekOptionsPageWidget::setTokenizerPath(const QString &value) { tokenizerPathEdit->setText(value); }
+void DeepSeekOptionsPageWidget::setPrefixCacheLayout(bool value) { prefixCacheCheckBox->setChecked(value); }
 
 // Slots para manejo de eventos
 void DeepSeekOptionsPageWidget::onConnectButtonClicked(){
     connectButton->setEnabled(false);
     connectButton->setText(tr("Connecting..."));
     fetchModels();
+    if (!catalog->isRefreshing())
+        onCatalogRefreshFinished({}); // no se llegó a pedir nada
 }
 
 void DeepSeekOptionsPageWidget::onModelSelectionChanged(int index){
-    if (index < 0 || modelComboBox->count() <= 0) {
+    if (index <= 0 || modelComboBox->count() <= 0) { // "Without Model"
         modelDescriptionEdit->clear();
         return;
     }
 
-    QString selectedModel = modelComboBox->currentText();
-    modelDescriptionEdit->setPlainText(modelDescriptions.value(selectedModel, ""));
+    const QString selectedModel = modelComboBox->currentText();
+    modelDescriptionEdit->setPlainText(
+        DeepSeekModelCatalog::describe(catalog->info(selectedModel)));
 }
 
 void DeepSeekOptionsPageWidget::fetchModels(){
     QString url = apiUrlEdit->text().trimmed();
-    if (url.isEmpty()) { url = "https://api.deepseek.com"; }
-    if (!url.endsWith("/")) { url += "/";  }
-    if (!url.contains("/v1/")) { url += "v1/";  }
+    if (url.isEmpty()) { url = "https://api.deepseek.com/v1"; }
+
+    // Con los valores del formulario, aunque todavía no se hayan aplicado
+    fetchRequested = true;
+    catalog->setEndpoint(QUrl(url), apiKeyEdit->text());
+    catalog->refresh();
+}
 
-    QUrl apiUrl(url + "models");
-    QNetworkRequest request(apiUrl);
-    request.setRawHeader("Authorization", "Bearer " + apiKeyEdit->text().toUtf8());
+void DeepSeekOptionsPageWidget::populateModels(){
+    const QString currentModel = modelComboBox->currentText();
 
-    if (currentReply) {
-        currentReply->abort();
-        currentReply->deleteLater();
+    while (modelComboBox->count() > 1) {
+        modelComboBox->removeItem(1);
     }
 
-    currentReply = networkManager.get(request);
-    connect(currentReply, &QNetworkReply::finished, this, &DeepSeekOptionsPageWidget::handleNetworkReply);
-}
+    const QList<DeepSeekModelCatalog::ModelInfo> models = catalog->models();
+    for (const DeepSeekModelCatalog::ModelInfo &info : models)
+        modelComboBox->addItem(info.id);
 
-QString DeepSeekOptionsPageWidget::getModelDescription(const QString &modelId){
-    static QMap<QString, QString> descriptions = {
-        {"deepseek-chat", "Modelo general para conversaciones y asistencia técnica."},
-        {"deepseek-reasoner", "Optimizado para razonamiento lógico y matemático."}
-    };
-    return descriptions.value(modelId, "No description available.");
+    int index = modelComboBox->findText(currentModel);
+    if (index < 0 && currentModel != modelComboBox->itemText(0) && !currentModel.isEmpty()) {
+        // El modelo configurado se conserva aunque el servidor ya no lo liste
+        modelComboBox->addItem(currentModel);
+        index = modelComboBox->count() - 1;
+    }
+    modelComboBox->setCurrentIndex(index >= 0 ? index : (models.isEmpty() ? 0 : 1));
+    onModelSelectionChanged(modelComboBox->currentIndex());
 }
 
-void DeepSeekOptionsPageWidget::handleNetworkReply(){
+void DeepSeekOptionsPageWidget::onCatalogRefreshFinished(const QString &errorString){
     connectButton->setEnabled(true);
     connectButton->setText(tr("Conectar y obtener modelos"));
 
-    if (!currentReply){ return; }
-    QString currentModel = modelComboBox->currentText();
-
-    while (modelComboBox->count() > 1) {
-        modelComboBox->removeItem(1);
-    }
-    modelDescriptions.clear();
-
-    if (currentReply->error() == QNetworkReply::NoError) {
-        QJsonDocument doc = QJsonDocument::fromJson(currentReply->readAll());
-        if (doc.isObject() && doc.object().contains("data") && doc.object().value("data").isArray()) {
-            QJsonArray models = doc.object().value("data").toArray();
-
-            if (models.isEmpty()) {
-                modelComboBox->setCurrentIndex(0); // "Without Model"
-            } else {
-                for (const auto &modelValue : models) {
-                    if (modelValue.isObject()) {
-                        QJsonObject modelObj = modelValue.toObject();
-                        QString modelId = modelObj["id"].toString();
-                        QString modelDesc = getModelDescription(modelId);
-                        modelDescriptions[modelId] = modelDesc;
-
-                        if (!modelId.isEmpty()) {
-                            modelComboBox->addItem(modelId);
-                        }
-                    }
-                }
-
-                int index = modelComboBox->findText(currentModel);
-                if (index >= 0) {
-                    modelComboBox->setCurrentIndex(index);
-                } else {
-                    modelComboBox->setCurrentIndex(1); // Primer modelo válido
-                }
-            }
-        } else {
-            modelComboBox->setCurrentIndex(0); // "Without Model"
-        }
-    } else {
-        // Error de red
+    const bool requested = fetchRequested;
+    fetchRequested = false;
+    if (requested && !errorString.isEmpty()) {
         QMessageBox::warning(this, tr("Error de conexión"),
-                             tr("No se pudo obtener el modelo: %1").arg(currentReply->errorString()));
-        modelComboBox->setCurrentIndex(0); // "Without Model"
+                             tr("No se pudo obtener el modelo: %1").arg(errorString));
     }
-    onModelSelectionChanged(modelComboBox->currentIndex());
-    currentReply->deleteLater();
-    currentReply = nullptr;
 }
 
 
@@ -200,13 +272,26 @@ DeepSeekOptionsPage::DeepSeekOptionsPage( QObject *parent):
 DeepSeekOptionsPage::~DeepSeekOptionsPage(){}
 
 void DeepSeekOptionsPage::loadSettings(){
-    auto settings = DSS::inst();
-    m_widget->setApiKey(settings->apiKey());
-    m_widget->setApiUrl(settings->apiUrl().toString());
-    m_widget->setModel(settings->model());
-    m_widget->setSystemPrompt(settings->systemPrompt());
-    m_widget->setTemperature(settings->temperature());
-    m_widget->setMaxTokens(settings->maxTokens());
+    const auto settings = DSS::inst()->snapshot();
+    m_widget->setApiKey(settings->apiKey);
+    m_widget->setApiUrl(settings->apiUrl.toString());
+    m_widget->setModel(settings->model);
+    m_widget->setSystemPrompt(settings->systemPrompt);
+    m_widget->setTemperature(settings->temperature);
+    m_widget->setMaxTokens(settings->maxTokens);
+    m_widget->setStreamResponses(settings->streamResponses);
+    m_widget->setContextTokens(settings->contextTokens);
+    m_widget->setResponseCacheEnabled(settings->responseCacheEnabled);
+    m_widget->setResponseCacheMaxMb(settings->responseCacheMaxMb);
+    m_widget->setResponseCacheTtlHours(settings->responseCacheTtlHours);
+    m_widget->setProjectContextEnabled(settings->projectContextEnabled);
+    m_widget->setProjectContextTokens(settings->projectContextTokens);
+    m_widget->setEmbeddingsEnabled(settings->embeddingsEnabled);
+    m_widget->setEmbeddingsUrl(settings->embeddingsUrl);
+    m_widget->setEmbeddingModel(settings->embeddingModel);
+    m_widget->setEmbeddingsQuantized(settings->embeddingsQuantized);
+    m_widget->setTokenizerPath(settings->tokenizerPath);
+    m_widget->setPrefixCacheLayout(settings->prefixCacheLayout);
 }
 
 QWidget *DeepSeekOptionsPage::widget(){
@@ -220,13 +305,28 @@ QWidget *DeepSeekOptionsPage::widget(){
 void DeepSeekOptionsPage::apply(){
     if (!m_widget){ return; } // page was never shown
     auto settings = DSS::inst();
-    // QMessageBox::information(nullptr, "Debug", "1");
-    settings->setApiKey(m_widget->apiKey());
-    settings->setApiUrl(QUrl(m_widget->apiUrl()));
-    settings->setModel(m_widget->model());
-    settings->setSystemPrompt(m_widget->systemPrompt());
-    settings->setTemperature(m_widget->temperature());
-    settings->setMaxTokens(m_widget->maxTokens());
+    // Una sola publicación: los que escuchan settingsChanged reciben todo el cambio junto
+    settings->update([this](DeepSeekSettings::Snapshot &s) {
+        s.apiKey = m_widget->apiKey();
+        s.apiUrl = QUrl(m_widget->apiUrl());
+        s.model = m_widget->model();
+        s.systemPrompt = m_widget->systemPrompt();
+        s.temperature = m_widget->temperature();
+        s.maxTokens = m_widget->maxTokens();
+        s.streamResponses = m_widget->streamResponses();
+        s.contextTokens = m_widget->contextTokens();
+        s.responseCacheEnabled = m_widget->responseCacheEnabled();
+        s.responseCacheMaxMb = m_widget->responseCacheMaxMb();
+        s.responseCacheTtlHours = m_widget->responseCacheTtlHours();
+        s.projectContextEnabled = m_widget->projectContextEnabled();
+        s.projectContextTokens = m_widget->projectContextTokens();
+        s.embeddingsEnabled = m_widget->embeddingsEnabled();
+        s.embeddingsUrl = m_widget->embeddingsUrl();
+        s.embeddingModel = m_widget->embeddingModel();
+        s.embeddingsQuantized = m_widget->embeddingsQuantized();
+        s.tokenizerPath = m_widget->tokenizerPath();
+        s.prefixCacheLayout = m_widget->prefixCacheLayout();
+    });
     settings->save();
 }
 
@@ -22,6 +22,7 @@
 #include <QSizePolicy>
 #include <QPushButton>
 #include <QComboBox>
+#include <QCheckBox>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QNetworkRequest>
@@ -34,6 +35,9 @@
 #include "deepseeksettings.h"
 
 namespace DeepSeek {
+
+class DeepSeekModelCatalog;
+
 namespace Internal {
 
 class DeepSeekOptionsPageWidget : public QWidget
@@ -48,6 +52,19 @@ public:
     QString systemPrompt() const;
     double temperature() const;
     int maxTokens() const;
+    bool streamResponses() const;
+    int contextTokens() const;
+    bool responseCacheEnabled() const;
+    int responseCacheMaxMb() const;
+    int responseCacheTtlHours() const;
+    bool projectContextEnabled() const;
+    int projectContextTokens() const;
+    bool embeddingsEnabled() const;
+    QString embeddingsUrl() const;
+    QString embeddingModel() const;
+    bool embeddingsQuantized() const;
+    QString tokenizerPath() const;
+    bool prefixCacheLayout() const;
 
     // Setters para cargar configuraciones
     void setApiKey(const QString &key);
@@ -56,14 +73,28 @@ public:
     void setSystemPrompt(const QString &prompt);
     void setTemperature(double temp);
     void setMaxTokens(int tokens);
+    void setStreamResponses(bool stream);
+    void setContextTokens(int tokens);
+    void setResponseCacheEnabled(bool value);
+    void setResponseCacheMaxMb(int value);
+    void setResponseCacheTtlHours(int value);
+    void setProjectContextEnabled(bool value);
+    void setProjectContextTokens(int value);
+    void setEmbeddingsEnabled(bool value);
+    void setEmbeddingsUrl(const QString &value);
+    void setEmbeddingModel(const QString &value);
+    void setEmbeddingsQuantized(bool value);
+    void setTokenizerPath(const QString &value);
+    void setPrefixCacheLayout(bool value);
 
 private slots:
     void onConnectButtonClicked();
     void onModelSelectionChanged(int index);
-    void handleNetworkReply();
+    void onCatalogRefreshFinished(const QString &errorString);
 
 private:
     void fetchModels();
+    void populateModels();
 
     // Widgets
     QLineEdit *apiKeyEdit;
@@ -73,13 +104,23 @@ private:
     QPlainTextEdit *systemPromptEdit;
     QDoubleSpinBox *temperatureSpinBox;
     QSpinBox *maxTokensSpinBox;
+    QCheckBox *streamCheckBox;
+    QSpinBox *contextTokensSpinBox;
+    QCheckBox *responseCacheCheckBox;
+    QSpinBox *responseCacheSizeSpinBox;
+    QSpinBox *responseCacheTtlSpinBox;
+    QCheckBox *projectContextCheckBox;
+    QSpinBox *projectContextTokensSpinBox;
+    QCheckBox *embeddingsCheckBox;
+    QLineEdit *embeddingsUrlEdit;
+    QLineEdit *embeddingModelEdit;
+    QCheckBox *embeddingsQuantizedCheckBox;
+    QLineEdit *tokenizerPathEdit;
+    QCheckBox *prefixCacheCheckBox;
     QPushButton *connectButton;
+    DeepSeekModelCatalog *catalog; // no compartido, ver el constructor
 
-    QNetworkAccessManager networkManager;
-    QPointer<QNetworkReply> currentReply;
-    QMap<QString, QString> modelDescriptions;
-
-    QString getModelDescription(const QString &modelId);
+    bool fetchRequested = false; // el error solo se muestra si lo pidió el usuario
 };
 
 // Configuration page for the DeepSeek plugin
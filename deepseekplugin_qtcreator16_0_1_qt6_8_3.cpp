@@ -16,13 +16,18 @@
 #include <extensionsystem/iplugin.h>
 
 #include <QAction>
+#include <QInputDialog>
+#include <QLineEdit>
 #include <QMainWindow>
 #include <QMenu>
 #include <QMessageBox>
 
 #include "deepseekoptionspage.h"
 #include "deepseeknavigationchat.h"
+#include "deepseekmodelcatalog.h"
+#include "deepseeknetworkservice.h"
 #include "deepseeksettings.h"
+#include "deepseekstartuptiming.h"
 
 using namespace Core;
 
@@ -66,7 +71,11 @@ public:
         //     .setDefaultKeySequence(Tr::tr("Ctrl+Alt+Meta+A"))
         //     .addOnTriggered(this, &DeepSeekPlugin_QtCreator16_0_1_Qt6_8_3Plugin::triggerAction);
 
-        DeepSeek::DSS::inst();
+        DeepSeek::DeepSeekStartupTiming::Scope timing("initialize", true);
+
+        // Solo se crean los objetos registrados. Los ajustes (DSS) se crean al
+        // primer uso y el historial se carga en segundo plano desde
+        // delayedInitialize(), fuera del camino crítico del arranque.
 
         // Crear y registrar componentes
         m_optionsPage = new DeepSeek::Internal::DeepSeekOptionsPage(this);
@@ -74,25 +83,67 @@ public:
 
         ExtensionSystem::PluginManager::addObject(m_optionsPage);
         ExtensionSystem::PluginManager::addObject(m_navigationChat);
+
+        // Tools > DeepSeek > Analyze Project...
+        ActionContainer *menu = ActionManager::createMenu(Constants::MENU_ID);
+        menu->menu()->setTitle(Tr::tr("DeepSeek"));
+        ActionManager::actionContainer(Core::Constants::M_TOOLS)->addMenu(menu);
+
+        ActionBuilder(this, Constants::ANALYZE_PROJECT_ACTION_ID)
+            .addToContainer(Constants::MENU_ID)
+            .setText(Tr::tr("Analyze Project..."))
+            .addOnTriggered(this, &DeepSeekPlugin_QtCreator16_0_1_Qt6_8_3Plugin::analyzeProject);
     }
 
     void extensionsInitialized() final
     {
+        DeepSeek::DeepSeekStartupTiming::Scope timing("extensionsInitialized", true);
+
         // Retrieve objects from the plugin manager's object pool, if needed. (rare)
         // In the extensionsInitialized function, a plugin can be sure that all
         // plugins that depend on it have passed their initialize() and
         // extensionsInitialized() phase.
     }
 
+    bool delayedInitialize() final
+    {
+        {
+            DeepSeek::DeepSeekStartupTiming::Scope timing("delayedInitialize", false);
+            m_navigationChat->delayedInitialize();
+        }
+        qCDebug(DeepSeek::deepseekStartupLog).noquote()
+            << DeepSeek::DeepSeekStartupTiming::summary();
+        return true;
+    }
+
     ShutdownFlag aboutToShutdown() final
     {
         // Save settings
         // Disconnect from signals that are not needed during shutdown
         // Hide UI (if you add UI that is not in the main window directly)
+
+        // Cierra las conexiones abiertas antes de que desaparezca la aplicación
+        DeepSeek::DSM::destroyInstance();
+        DeepSeek::DSN::destroyInstance();
         return SynchronousShutdown;
     }
 
 private:
+    void analyzeProject()
+    {
+        bool ok = false;
+        const QString command
+            = QInputDialog::getText(ICore::dialogParent(), Tr::tr("Analyze Project"),
+                                    Tr::tr("Instruction to apply to every source file of the "
+                                           "active project:"),
+                                    QLineEdit::Normal, m_analysisCommand, &ok)
+                  .trimmed();
+        if (!ok || command.isEmpty())
+            return;
+        m_analysisCommand = command;
+        m_navigationChat->sendSourceAnalysisCommand(command);
+    }
+
     void triggerAction()
     {
         QMessageBox::information(
@@ -104,6 +155,7 @@ private:
 
     DeepSeek::Internal::DeepSeekOptionsPage *m_optionsPage = nullptr;
     DeepSeek::DeepSeekNavigationChat *m_navigationChat = nullptr;
+    QString m_analysisCommand = "Find thread-safety issues";
 };
 
 } // namespace DeepSeekPlugin_QtCreator16_0_1_Qt6_8_3::Internal
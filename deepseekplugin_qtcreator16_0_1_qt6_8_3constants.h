@@ -4,5 +4,6 @@ namespace DeepSeekPlugin_QtCreator16_0_1_Qt6_8_3::Constants {
 
 const char ACTION_ID[] = "DeepSeekPlugin_QtCreator16_0_1_Qt6_8_3.Action";
 const char MENU_ID[] = "DeepSeekPlugin_QtCreator16_0_1_Qt6_8_3.Menu";
+const char ANALYZE_PROJECT_ACTION_ID[] = "DeepSeekPlugin_QtCreator16_0_1_Qt6_8_3.AnalyzeProject";
 
 } // namespace DeepSeekPlugin_QtCreator16_0_1_Qt6_8_3::Constants
@@ -0,0 +1,245 @@
+#include "deepseekpreviewdialog.h"
+
+#include <QColor>
+#include <QFile>
+#include <QFileInfo>
+#include <QFontDatabase>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QListWidget>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QScrollBar>
+#include <QSplitter>
+#include <QTextBlock>
+#include <QTextEdit>
+#include <QVBoxLayout>
+#include <QtConcurrent/QtConcurrentRun>
+
+namespace DeepSeek {
+
+DeepSeekPreviewDialog::DeepSeekPreviewDialog(const QString &filePath,
+                                             const std::optional<QString> &originalContent,
+                                             const QString &newContent,
+                                             QWidget *parent)
+    : QDialog(parent)
+    , m_data(std::make_shared<DiffData>())
+{
+    setWindowTitle(tr("Preview Changes - %1").arg(QFileInfo(filePath).fileName()));
+    setModal(true);
+    resize(900, 600);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    m_statusLabel = new QLabel(tr("Computing differences..."), this);
+    layout->addWidget(m_statusLabel);
+
+    m_hunkList = new QListWidget(this);
+    m_hunkList->setMaximumHeight(150);
+    layout->addWidget(m_hunkList);
+
+    const QFont monospace = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+    QSplitter *splitter = new QSplitter(Qt::Horizontal, this);
+    m_oldView = new QPlainTextEdit(splitter);
+    m_newView = new QPlainTextEdit(splitter);
+    for (QPlainTextEdit *view : {m_oldView, m_newView}) {
+        view->setReadOnly(true);
+        view->setLineWrapMode(QPlainTextEdit::NoWrap);
+        view->setFont(monospace);
+    }
+    // Desplazamiento sincronizado: las filas de ambos lados están alineadas
+    connect(m_oldView->verticalScrollBar(), &QScrollBar::valueChanged,
+            m_newView->verticalScrollBar(), &QScrollBar::setValue);
+    connect(m_newView->verticalScrollBar(), &QScrollBar::valueChanged,
+            m_oldView->verticalScrollBar(), &QScrollBar::setValue);
+    layout->addWidget(splitter, 1);
+
+    QHBoxLayout *buttonsLayout = new QHBoxLayout;
+    QPushButton *acceptAllButton = new QPushButton(tr("Accept All"));
+    QPushButton *rejectAllButton = new QPushButton(tr("Reject All"));
+    m_applyButton = new QPushButton(tr("Apply"));
+    m_applyButton->setEnabled(false);
+    QPushButton *cancelButton = new QPushButton(tr("Cancel"));
+    connect(acceptAllButton, &QPushButton::clicked, this, [this]() { setAllChecked(true); });
+    connect(rejectAllButton, &QPushButton::clicked, this, [this]() { setAllChecked(false); });
+    connect(m_applyButton, &QPushButton::clicked, this, [this]() { m_accepted = true; accept(); });
+    connect(cancelButton, &QPushButton::clicked, this, &QDialog::reject);
+    buttonsLayout->addWidget(acceptAllButton);
+    buttonsLayout->addWidget(rejectAllButton);
+    buttonsLayout->addStretch();
+    buttonsLayout->addWidget(m_applyButton);
+    buttonsLayout->addWidget(cancelButton);
+    layout->addLayout(buttonsLayout);
+
+    connect(m_hunkList, &QListWidget::currentRowChanged, this, &DeepSeekPreviewDialog::showHunk);
+    connect(&m_watcher, &QFutureWatcherBase::resultsReadyAt,
+            this, &DeepSeekPreviewDialog::onHunksReady);
+    connect(&m_watcher, &QFutureWatcherBase::finished,
+            this, &DeepSeekPreviewDialog::onDiffFinished);
+    // Al cerrar (aplicar o cancelar) no tiene sentido seguir calculando
+    connect(this, &QDialog::finished, &m_watcher, &QFutureWatcherBase::cancel);
+
+    m_watcher.setFuture(QtConcurrent::run(&DeepSeekPreviewDialog::computeDiff, m_data, filePath,
+                                          originalContent, newContent));
+}
+
+DeepSeekPreviewDialog::~DeepSeekPreviewDialog()
+{
+    m_watcher.cancel();
+    m_watcher.waitForFinished();
+}
+
+void DeepSeekPreviewDialog::computeDiff(QPromise<DeepSeekTextDiff::Hunk> &promise,
+                                        std::shared_ptr<DiffData> data,
+                                        const QString &filePath,
+                                        const std::optional<QString> &originalContent,
+                                        const QString &newContent)
+{
+    QString oldText;
+    if (originalContent) {
+        oldText = *originalContent;
+    } else if (QFile file(filePath); file.exists()) {
+        if (!file.open(QIODevice::ReadOnly)) {
+            data->errorString = tr("Cannot read file: %1").arg(file.errorString());
+            return;
+        }
+        oldText = QString::fromUtf8(file.readAll());
+    }
+    // Se compara sin \r y resultContent() devuelve los finales del original
+    // (o los del contenido nuevo si el fichero no existía)
+    const QString &reference = oldText.isEmpty() ? newContent : oldText;
+    const qsizetype newline = reference.indexOf('\n');
+    data->crlf = newline > 0 && reference.at(newline - 1) == '\r';
+    oldText.replace("\r\n", "\n");
+    QString newText = newContent;
+    newText.replace("\r\n", "\n");
+
+    data->oldLines = DeepSeekTextDiff::splitLines(oldText);
+    data->newLines = DeepSeekTextDiff::splitLines(newText);
+    if (promise.isCanceled())
+        return;
+
+    const QList<DeepSeekTextDiff::Edit> edits = DeepSeekTextDiff::diff(
+        data->oldLines, data->newLines, [&promise]() { return promise.isCanceled(); });
+    if (promise.isCanceled())
+        return;
+
+    // El diff de Myers necesita el guion de ediciones completo, así que las
+    // regiones solo pueden salir al final; se entregan una a una para que la
+    // lista las añada por lotes y la cancelación se atienda entre ellas.
+    const QList<DeepSeekTextDiff::Hunk> hunks
+        = DeepSeekTextDiff::hunks(edits, data->oldLines, data->newLines, ContextLines);
+    promise.setProgressRange(0, int(hunks.size()));
+    for (qsizetype i = 0; i < hunks.size(); ++i) {
+        if (promise.isCanceled())
+            return;
+        promise.addResult(hunks.at(i));
+        promise.setProgressValue(int(i + 1));
+    }
+}
+
+void DeepSeekPreviewDialog::onHunksReady(int begin, int end)
+{
+    for (int i = begin; i < end; ++i) {
+        const DeepSeekTextDiff::Hunk hunk = m_watcher.resultAt(i);
+        m_hunks.append(hunk);
+
+        QListWidgetItem *item = new QListWidgetItem(
+            QString("@@ -%1,%2 +%3,%4 @@")
+                .arg(hunk.oldStart + 1).arg(hunk.oldCount)
+                .arg(hunk.newStart + 1).arg(hunk.newCount),
+            m_hunkList);
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState(Qt::Checked);
+    }
+
+    if (m_hunkList->currentRow() < 0 && m_hunkList->count() > 0)
+        m_hunkList->setCurrentRow(0);
+    m_statusLabel->setText(tr("%n change(s) found so far...", nullptr, int(m_hunks.size())));
+}
+
+void DeepSeekPreviewDialog::onDiffFinished()
+{
+    if (m_watcher.isCanceled())
+        return;
+
+    if (!m_data->errorString.isEmpty()) {
+        m_statusLabel->setText(m_data->errorString);
+        return;
+    }
+
+    if (m_hunks.isEmpty()) {
+        m_statusLabel->setText(tr("No changes."));
+        return;
+    }
+
+    m_statusLabel->setText(tr("%n change(s). Uncheck the ones you do not want to apply.",
+                              nullptr, int(m_hunks.size())));
+    m_applyButton->setEnabled(true);
+}
+
+void DeepSeekPreviewDialog::showHunk(int index)
+{
+    m_oldView->clear();
+    m_newView->clear();
+    if (index < 0 || index >= m_hunks.size())
+        return;
+
+    const DeepSeekTextDiff::Hunk &hunk = m_hunks.at(index);
+    QStringList left;
+    QStringList right;
+    for (const DeepSeekTextDiff::Hunk::Row &row : hunk.rows) {
+        left.append(row.left);
+        right.append(row.right);
+    }
+    m_oldView->setPlainText(left.join('\n'));
+    m_newView->setPlainText(right.join('\n'));
+
+    // Fondo por fila: borrado, añadido o hueco de alineación
+    const auto highlight = [&hunk](QPlainTextEdit *view, bool leftSide) {
+        QList<QTextEdit::ExtraSelection> selections;
+        QTextBlock block = view->document()->firstBlock();
+        for (const DeepSeekTextDiff::Hunk::Row &row : hunk.rows) {
+            if (!block.isValid())
+                break;
+            if (row.changed) {
+                const bool present = leftSide ? row.hasLeft : row.hasRight;
+                QTextEdit::ExtraSelection selection;
+                selection.cursor = QTextCursor(block);
+                selection.format.setProperty(QTextFormat::FullWidthSelection, true);
+                if (!present)
+                    selection.format.setBackground(QColor(0, 0, 0, 20));
+                else
+                    selection.format.setBackground(leftSide ? QColor(255, 0, 0, 50)
+                                                            : QColor(0, 200, 0, 50));
+                selections.append(selection);
+            }
+            block = block.next();
+        }
+        view->setExtraSelections(selections);
+    };
+    highlight(m_oldView, true);
+    highlight(m_newView, false);
+}
+
+void DeepSeekPreviewDialog::setAllChecked(bool checked)
+{
+    for (int i = 0; i < m_hunkList->count(); ++i)
+        m_hunkList->item(i)->setCheckState(checked ? Qt::Checked : Qt::Unchecked);
+}
+
+bool DeepSeekPreviewDialog::accepted() const { return m_accepted; }
+
+QString DeepSeekPreviewDialog::resultContent() const
+{
+    QList<DeepSeekTextDiff::Edit> edits;
+    for (qsizetype i = 0; i < m_hunks.size(); ++i) {
+        if (m_hunkList->item(int(i))->checkState() == Qt::Checked)
+            edits.append(m_hunks.at(i).edits);
+    }
+    QString content = DeepSeekTextDiff::applyEdits(m_data->oldLines, m_data->newLines, edits);
+    if (m_data->crlf)
+        content.replace('\n', "\r\n");
+    return content;
+}
+
+} // namespace DeepSeek
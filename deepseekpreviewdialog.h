@@ -0,0 +1,76 @@
+#pragma once
+
+#include "deepseektextdiff.h"
+
+#include <QDialog>
+#include <QFutureWatcher>
+#include <QPromise>
+#include <QStringList>
+
+#include <memory>
+#include <optional>
+
+QT_BEGIN_NAMESPACE
+class QLabel;
+class QListWidget;
+class QPlainTextEdit;
+class QPushButton;
+QT_END_NAMESPACE
+
+namespace DeepSeek {
+
+// Vista previa de los cambios propuestos para un fichero. El diff se calcula
+// en un hilo de QtConcurrent que entrega las regiones según las genera; al
+// cerrar el diálogo el trabajo se cancela. Cada región se puede aceptar o
+// rechazar por separado y resultContent() devuelve el fichero con solo las
+// aceptadas.
+class DeepSeekPreviewDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    // Sin originalContent el contenido actual se lee del disco en el hilo
+    DeepSeekPreviewDialog(const QString &filePath,
+                          const std::optional<QString> &originalContent,
+                          const QString &newContent,
+                          QWidget *parent = nullptr);
+    ~DeepSeekPreviewDialog() override;
+
+    bool accepted() const;
+    QString resultContent() const;
+
+    static constexpr int ContextLines = 3;
+
+private:
+    // Lo que el hilo deja preparado para el diálogo; solo se lee tras finished()
+    struct DiffData
+    {
+        QStringList oldLines;
+        QStringList newLines;
+        bool crlf = false; // el original separa las líneas con \r\n
+        QString errorString;
+    };
+
+    static void computeDiff(QPromise<DeepSeekTextDiff::Hunk> &promise,
+                            std::shared_ptr<DiffData> data,
+                            const QString &filePath,
+                            const std::optional<QString> &originalContent,
+                            const QString &newContent);
+
+    void onHunksReady(int begin, int end);
+    void onDiffFinished();
+    void showHunk(int index);
+    void setAllChecked(bool checked);
+
+    QFutureWatcher<DeepSeekTextDiff::Hunk> m_watcher;
+    std::shared_ptr<DiffData> m_data;
+    QList<DeepSeekTextDiff::Hunk> m_hunks;
+
+    QLabel *m_statusLabel = nullptr;
+    QListWidget *m_hunkList = nullptr;
+    QPlainTextEdit *m_oldView = nullptr;
+    QPlainTextEdit *m_newView = nullptr;
+    QPushButton *m_applyButton = nullptr;
+    bool m_accepted = false;
+};
+
+} // namespace DeepSeek
@@ -0,0 +1,498 @@
+#include "deepseekprojectcontext.h"
+#include "deepseekcontextwindow.h"
+#include "deepseekembeddingclient.h"
+#include "deepseeksettings.h"
+
+#include <coreplugin/editormanager/editormanager.h>
+#include <coreplugin/idocument.h>
+#include <projectexplorer/project.h>
+#include <projectexplorer/projectmanager.h>
+#include <utils/filepath.h>
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QtConcurrent/QtConcurrentRun>
+
+namespace DeepSeek {
+
+// Tiempos de indexado y de búsqueda; apagadas por defecto
+Q_LOGGING_CATEGORY(deepseekContextLog, "qtc.deepseek.context", QtWarningMsg)
+
+DeepSeekProjectContext::DeepSeekProjectContext(QObject *parent)
+    : QObject(parent)
+{
+    // Un único hilo de baja prioridad: la indexación no debe competir con el
+    // editor ni con el análisis de código.
+    m_pool.setMaxThreadCount(1);
+    m_pool.setThreadPriority(QThread::LowestPriority);
+    m_embeddings = new DeepSeekEmbeddingClient(this);
+}
+
+DeepSeekProjectContext::~DeepSeekProjectContext()
+{
+    stop();
+}
+
+void DeepSeekProjectContext::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled)
+        return;
+    m_enabled = enabled;
+
+    auto projectManager = ProjectExplorer::ProjectManager::instance();
+    if (!enabled) {
+        disconnect(projectManager, nullptr, this, nullptr);
+        disconnect(Core::EditorManager::instance(), nullptr, this, nullptr);
+        for (auto it = m_projectFiles.cbegin(); it != m_projectFiles.cend(); ++it)
+            disconnect(it.key(), nullptr, this, nullptr);
+        stop();
+        setSemanticSearch(false, {});
+        m_projectFiles.clear();
+        m_index.clear();
+        return;
+    }
+
+    connect(projectManager, &ProjectExplorer::ProjectManager::projectAdded,
+            this, &DeepSeekProjectContext::onProjectAdded);
+    connect(projectManager, &ProjectExplorer::ProjectManager::projectRemoved,
+            this, &DeepSeekProjectContext::onProjectRemoved);
+    connect(Core::EditorManager::instance(), &Core::EditorManager::saved,
+            this, &DeepSeekProjectContext::onDocumentSaved);
+
+    const QList<ProjectExplorer::Project *> projects = ProjectExplorer::ProjectManager::projects();
+    for (ProjectExplorer::Project *project : projects)
+        onProjectAdded(project);
+}
+
+void DeepSeekProjectContext::onProjectAdded(ProjectExplorer::Project *project)
+{
+    // La lista de ficheros suele llegar vacía y se completa al terminar el
+    // análisis del proyecto.
+    connect(project, &ProjectExplorer::Project::fileListChanged, this, [this, project]() {
+        syncProject(project);
+    });
+    syncProject(project);
+}
+
+void DeepSeekProjectContext::onProjectRemoved(ProjectExplorer::Project *project)
+{
+    disconnect(project, nullptr, this, nullptr);
+    dropFiles(m_projectFiles.take(project));
+}
+
+void DeepSeekProjectContext::syncProject(ProjectExplorer::Project *project)
+{
+    QSet<QString> current;
+    const Utils::FilePaths files = project->files(ProjectExplorer::Project::SourceFiles);
+    current.reserve(files.size());
+    for (const Utils::FilePath &filePath : files)
+        current.insert(filePath.toFSPathString());
+
+    QSet<QString> &known = m_projectFiles[project];
+    QSet<QString> removed = known;
+    removed.subtract(current);
+    known = current;
+
+    dropFiles(removed);
+
+    // Los ficheros sin cambios se descartan en el hilo comparando fecha y
+    // tamaño, así que se puede encolar la lista entera.
+    enqueue(QStringList(current.cbegin(), current.cend()));
+}
+
+void DeepSeekProjectContext::dropFiles(const QSet<QString> &filePaths)
+{
+    // Un fichero puede pertenecer a varios proyectos abiertos
+    QSet<QString> removed;
+    for (const QString &filePath : filePaths) {
+        if (!isTracked(filePath))
+            removed.insert(filePath);
+    }
+    if (removed.isEmpty())
+        return;
+
+    {
+        QMutexLocker locker(&m_queueMutex);
+        m_queue.removeIf([&removed](const QString &filePath) { return removed.contains(filePath); });
+        m_queued.subtract(removed);
+    }
+    m_embedQueue.removeIf([&removed](const QString &filePath) { return removed.contains(filePath); });
+    m_embedQueued.subtract(removed);
+    for (const QString &filePath : std::as_const(removed)) {
+        m_index.removeFile(filePath);
+        if (m_vectors)
+            m_vectors->removeFile(filePath);
+    }
+}
+
+void DeepSeekProjectContext::onDocumentSaved(Core::IDocument *document)
+{
+    const QString filePath = document->filePath().toFSPathString();
+    if (isTracked(filePath))
+        enqueue({filePath});
+}
+
+bool DeepSeekProjectContext::isTracked(const QString &filePath) const
+{
+    for (const QSet<QString> &files : m_projectFiles) {
+        if (files.contains(filePath))
+            return true;
+    }
+    return false;
+}
+
+void DeepSeekProjectContext::enqueue(const QStringList &filePaths)
+{
+    QMutexLocker locker(&m_queueMutex);
+    for (const QString &filePath : filePaths) {
+        if (!m_queued.contains(filePath)) {
+            m_queued.insert(filePath);
+            m_queue.append(filePath);
+        }
+    }
+    if (m_workerRunning || m_queue.isEmpty())
+        return;
+    m_workerRunning = true;
+    m_pool.start([this]() { drainQueue(); });
+}
+
+void DeepSeekProjectContext::drainQueue()
+{
+    QElapsedTimer timer;
+    timer.start();
+    int processed = 0;
+    QStringList indexed;
+    // Los ficheros indexados pasan al hilo principal por lotes para vectorizarlos
+    const auto flushIndexed = [this, &indexed]() {
+        if (!indexed.isEmpty() && m_semanticEnabled) {
+            QMetaObject::invokeMethod(this, [this, files = indexed]() { queueEmbeddings(files); },
+                                      Qt::QueuedConnection);
+        }
+        indexed.clear();
+    };
+
+    while (!m_canceled) {
+        QString filePath;
+        {
+            QMutexLocker locker(&m_queueMutex);
+            if (m_queue.isEmpty()) {
+                m_workerRunning = false;
+                break;
+            }
+            filePath = m_queue.takeFirst();
+            m_queued.remove(filePath);
+        }
+
+        QString errorString;
+        if (m_index.updateFile(filePath, &errorString))
+            indexed.append(filePath);
+        else if (!errorString.isEmpty())
+            qWarning() << "Project index: cannot read" << filePath << errorString;
+        if (++processed % 256 == 0)
+            flushIndexed();
+    }
+    flushIndexed();
+
+    qCDebug(deepseekContextLog) << "Project index:" << processed << "files checked in"
+                                << timer.elapsed() << "ms," << m_index.fileCount() << "files /"
+                                << m_index.chunkCount() << "chunks indexed";
+}
+
+void DeepSeekProjectContext::stop()
+{
+    m_canceled = true;
+    m_pool.waitForDone();
+
+    QMutexLocker locker(&m_queueMutex);
+    m_queue.clear();
+    m_queued.clear();
+    m_workerRunning = false;
+    m_canceled = false;
+}
+
+void DeepSeekProjectContext::setSemanticSearch(bool enabled, const QString &storePath)
+{
+    const auto settings = DSS::inst()->snapshot();
+    // La clave de DeepSeek solo se envía si los embeddings van al mismo servidor
+    const bool sameServer = settings->embeddingsUrl.isEmpty();
+    const QString url = sameServer ? settings->apiUrl.toString() : settings->embeddingsUrl;
+    const QString apiKey = sameServer ? settings->apiKey : QString();
+    const QString model = settings->embeddingModel;
+    const auto precision = settings->embeddingsQuantized ? DeepSeekVectorStore::Precision::Int8
+                                                           : DeepSeekVectorStore::Precision::Float32;
+
+    // settingsChanged llega por cualquier ajuste: solo se reabre si cambia algo propio
+    const QString config = enabled ? QStringList{url, apiKey, model, storePath,
+                                                 QString::number(int(precision))}.join('\n')
+                                   : QString();
+    if (config == m_semanticConfig)
+        return;
+    m_semanticConfig = config;
+
+    m_semanticEnabled = false;
+    resetEmbedQueue();
+    m_vectors.reset();
+    if (!enabled)
+        return;
+
+    m_embeddings->setEndpoint(url, model, apiKey);
+    m_vectors = std::make_unique<DeepSeekVectorStore>(storePath);
+    QString errorString;
+    if (!m_vectors->open(model, precision, &errorString)) {
+        qWarning() << "Vector store: cannot open" << storePath << errorString;
+        m_vectors.reset();
+        return;
+    }
+    m_semanticEnabled = true;
+
+    // Lo ya indexado que no tenga vectores al día
+    QSet<QString> files;
+    for (const QSet<QString> &projectFiles : std::as_const(m_projectFiles))
+        files.unite(projectFiles);
+    queueEmbeddings(QStringList(files.cbegin(), files.cend()));
+}
+
+bool DeepSeekProjectContext::hasSemanticIndex() const
+{
+    return m_semanticEnabled && m_vectors && m_vectors->count() > 0;
+}
+
+void DeepSeekProjectContext::embedQuery(const QString &query,
+                                        const std::function<void(const std::vector<float> &)> &callback)
+{
+    if (!hasSemanticIndex()) {
+        callback({});
+        return;
+    }
+    m_embeddings->embed({query}, [callback](const QList<std::vector<float>> &vectors,
+                                            const QString &errorString) {
+        if (!errorString.isEmpty())
+            qWarning() << "Query embedding failed:" << errorString;
+        callback(vectors.isEmpty() ? std::vector<float>() : vectors.first());
+    }, QueryTimeoutMs);
+}
+
+void DeepSeekProjectContext::queueEmbeddings(const QStringList &filePaths)
+{
+    if (!m_semanticEnabled || !m_vectors)
+        return;
+    for (const QString &filePath : filePaths) {
+        if (m_embedQueued.contains(filePath)
+            || m_vectors->isCurrent(filePath, QFileInfo(filePath).lastModified())) {
+            continue;
+        }
+        m_embedQueued.insert(filePath);
+        m_embedQueue.append(filePath);
+    }
+    pumpEmbeddings();
+}
+
+DeepSeekProjectContext::EmbedFile DeepSeekProjectContext::readEmbedChunks(const QString &filePath)
+{
+    EmbedFile result;
+    result.filePath = filePath;
+
+    const QFileInfo info(filePath);
+    QFile file(filePath);
+    if (info.size() > DeepSeekProjectIndex::MaxFileSize || !file.open(QIODevice::ReadOnly))
+        return result;
+    const QByteArray data = file.readAll();
+    if (data.left(8192).contains('\0'))
+        return result;
+
+    // Mismos fragmentos que el índice léxico, para poder combinar resultados
+    const QStringList lines = QString::fromUtf8(data).split('\n');
+    result.readable = true;
+    result.modified = info.lastModified();
+    for (qsizetype start = 0; start < lines.size(); start += DeepSeekProjectIndex::ChunkLines) {
+        const QStringList chunkLines = lines.mid(start, DeepSeekProjectIndex::ChunkLines);
+        const QString text = chunkLines.join('\n');
+        if (text.trimmed().isEmpty())
+            continue;
+        result.chunks.append({filePath, int(start), int(chunkLines.size()),
+                              (info.fileName() + '\n' + text).left(MaxEmbedChars)});
+    }
+    return result;
+}
+
+void DeepSeekProjectContext::loadEmbedChunks(const QString &filePath)
+{
+    // La lectura va al hilo de indexación, como la del índice léxico; un
+    // resultado de una configuración anterior se descarta.
+    m_embedReading = true;
+    const int generation = m_embedGeneration;
+    QtConcurrent::run(&m_pool, &DeepSeekProjectContext::readEmbedChunks, filePath)
+        .then(this, [this, generation](const EmbedFile &file) {
+            m_embedReading = false;
+            if (generation == m_embedGeneration && m_vectors && file.readable) {
+                if (file.chunks.isEmpty()) {
+                    m_vectors->replaceFile(file.filePath, file.modified, {});
+                } else {
+                    PendingFile pending;
+                    pending.modified = file.modified;
+                    pending.remaining = int(file.chunks.size());
+                    m_embedChunks.append(file.chunks);
+                    m_embedFiles.insert(file.filePath, pending);
+                }
+            }
+            pumpEmbeddings();
+        });
+}
+
+void DeepSeekProjectContext::pumpEmbeddings()
+{
+    if (m_embedInFlight || m_embedReading || !m_vectors)
+        return;
+
+    // Se leen ficheros hasta completar un lote; cada lectura vuelve aquí
+    while (m_embedChunks.size() < EmbedBatchSize && !m_embedQueue.isEmpty()) {
+        const QString filePath = m_embedQueue.takeFirst();
+        m_embedQueued.remove(filePath);
+        // Si ya hay una vectorización en curso, al terminar se detecta el cambio de fecha
+        if (m_embedFiles.contains(filePath))
+            continue;
+        loadEmbedChunks(filePath);
+        return;
+    }
+
+    const QList<PendingChunk> batch = m_embedChunks.first(qMin(m_embedChunks.size(),
+                                                               qsizetype(EmbedBatchSize)));
+    m_embedChunks.remove(0, batch.size());
+    if (batch.isEmpty())
+        return;
+
+    QStringList texts;
+    texts.reserve(batch.size());
+    for (const PendingChunk &chunk : std::as_const(batch))
+        texts.append(chunk.text);
+
+    m_embedInFlight = true;
+    const int generation = m_embedGeneration;
+    m_embeddings->embed(texts, [this, batch, generation](const QList<std::vector<float>> &vectors,
+                                                         const QString &errorString) {
+        m_embedInFlight = false;
+        // Respuesta de una configuración anterior
+        if (generation != m_embedGeneration) {
+            pumpEmbeddings();
+            return;
+        }
+        onEmbeddingsReady(batch, vectors, errorString);
+    });
+}
+
+void DeepSeekProjectContext::onEmbeddingsReady(const QList<PendingChunk> &batch,
+                                               const QList<std::vector<float>> &vectors,
+                                               const QString &errorString)
+{
+    if (!m_vectors)
+        return;
+
+    if (!errorString.isEmpty()) {
+        // Sin servidor no tiene sentido seguir: se reintenta con el próximo guardado
+        qWarning() << "Embeddings request failed:" << errorString;
+        resetEmbedQueue();
+        return;
+    }
+
+    QStringList changed;
+    for (qsizetype i = 0; i < batch.size(); ++i) {
+        const PendingChunk &chunk = batch.at(i);
+        auto fileIt = m_embedFiles.find(chunk.filePath);
+        if (fileIt == m_embedFiles.end())
+            continue;
+        fileIt->entries.append({chunk.filePath, chunk.startLine, chunk.lineCount, vectors.at(i)});
+        if (--fileIt->remaining > 0)
+            continue;
+
+        QString storeError;
+        if (!m_vectors->replaceFile(chunk.filePath, fileIt->modified, fileIt->entries, &storeError))
+            qWarning() << "Vector store:" << chunk.filePath << storeError;
+        if (QFileInfo(chunk.filePath).lastModified() != fileIt->modified)
+            changed.append(chunk.filePath);
+        m_embedFiles.erase(fileIt);
+    }
+
+    if (!changed.isEmpty())
+        queueEmbeddings(changed);
+    else
+        pumpEmbeddings();
+}
+
+void DeepSeekProjectContext::resetEmbedQueue()
+{
+    ++m_embedGeneration;
+    m_embedQueue.clear();
+    m_embedQueued.clear();
+    m_embedChunks.clear();
+    m_embedFiles.clear();
+}
+
+QString DeepSeekProjectContext::buildContext(const QString &query, int tokenBudget,
+                                             const std::vector<float> &queryEmbedding) const
+{
+    if (!m_enabled || tokenBudget <= 0 || query.trimmed().isEmpty())
+        return {};
+
+    QElapsedTimer timer;
+    timer.start();
+    const QList<DeepSeekProjectIndex::Hit> lexical = m_index.search(query, MaxHits);
+    QList<DeepSeekVectorStore::Hit> semantic;
+    if (!queryEmbedding.empty() && m_vectors)
+        semantic = m_vectors->search(queryEmbedding, MaxHits);
+    const qint64 searchMs = timer.elapsed();
+
+    // Fusión por rango recíproco: no depende de la escala de cada puntuación
+    QList<DeepSeekProjectIndex::Hit> semanticHits;
+    semanticHits.reserve(semantic.size());
+    for (const DeepSeekVectorStore::Hit &hit : std::as_const(semantic))
+        semanticHits.append({hit.filePath, hit.startLine, hit.lineCount, hit.score});
+    const QList<DeepSeekProjectIndex::Hit> hits
+        = DeepSeekProjectIndex::fuse({lexical, semanticHits}, FusionK);
+
+    const QString header = tr("Relevant code from the current project:\n");
+    int used = DeepSeekContextWindow::estimateTokens(header);
+    QString blocks;
+    QHash<QString, QStringList> fileLines;
+
+    // Mejor puntuación primero; un fragmento que no cabe se salta, por si
+    // alguno de los siguientes es más pequeño.
+    for (const DeepSeekProjectIndex::Hit &hit : hits) {
+        auto linesIt = fileLines.find(hit.filePath);
+        if (linesIt == fileLines.end()) {
+            QFile file(hit.filePath);
+            if (!file.open(QIODevice::ReadOnly))
+                continue;
+            linesIt = fileLines.insert(hit.filePath, QString::fromUtf8(file.readAll()).split('\n'));
+        }
+
+        const QStringList excerpt = linesIt->mid(hit.startLine, hit.lineCount);
+        if (excerpt.isEmpty())
+            continue;
+
+        QString displayPath = hit.filePath;
+        const Utils::FilePath filePath = Utils::FilePath::fromString(hit.filePath);
+        if (auto *project = ProjectExplorer::ProjectManager::projectForFile(filePath))
+            displayPath = filePath.relativeChildPath(project->projectDirectory()).toUserOutput();
+
+        const QString block = QString("\nFile: %1 (lines %2-%3)\n```\n%4\n```\n")
+                                  .arg(displayPath)
+                                  .arg(hit.startLine + 1)
+                                  .arg(hit.startLine + excerpt.size())
+                                  .arg(excerpt.join('\n'));
+        const int tokens = DeepSeekContextWindow::estimateTokens(block);
+        if (used + tokens > tokenBudget)
+            continue;
+        blocks += block;
+        used += tokens;
+    }
+
+    qCDebug(deepseekContextLog) << "Project context:" << lexical.size() << "lexical +"
+                                << semantic.size() << "semantic hits in" << searchMs << "ms,"
+                                << used << "of" << tokenBudget << "tokens used";
+    return blocks.isEmpty() ? QString() : header + blocks;
+}
+
+} // namespace DeepSeek
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "deepseekprojectindex.h"
+#include "deepseekvectorstore.h"
+
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace ProjectExplorer { class Project; }
+namespace Core { class IDocument; }
+
+namespace DeepSeek {
+
+class DeepSeekEmbeddingClient;
+
+// Mantiene DeepSeekProjectIndex al día con los proyectos abiertos: indexa
+// sus ficheros fuente en un hilo de baja prioridad, reindexa al guardar y
+// descarta los ficheros que salen del proyecto. buildContext() devuelve los
+// fragmentos más relevantes para una consulta dentro de un presupuesto de
+// tokens, listos para añadirse a la petición.
+//
+// Con la búsqueda semántica activada, los fragmentos de los ficheros
+// indexados se vectorizan además en /embeddings y se guardan en un
+// DeepSeekVectorStore; los resultados léxicos y semánticos se combinan por
+// rango recíproco.
+class DeepSeekProjectContext : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DeepSeekProjectContext(QObject *parent = nullptr);
+    ~DeepSeekProjectContext() override;
+
+    // Desactivado se detiene la indexación y se libera el índice
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return m_enabled; }
+
+    // Lee URL, modelo y precisión de los ajustes. storePath: fichero del
+    // almacén de vectores.
+    void setSemanticSearch(bool enabled, const QString &storePath);
+    bool hasSemanticIndex() const;
+    // Llama a callback con el vector de la consulta, o vacío si falla
+    void embedQuery(const QString &query,
+                    const std::function<void(const std::vector<float> &)> &callback);
+
+    QString buildContext(const QString &query, int tokenBudget,
+                         const std::vector<float> &queryEmbedding = {}) const;
+
+    const DeepSeekProjectIndex &index() const { return m_index; }
+
+    static constexpr int MaxHits = 8;
+    static constexpr int EmbedBatchSize = 32;
+    static constexpr int MaxEmbedChars = 6000;
+    // La pregunta espera al vector: sin respuesta rápida se envía sin él
+    static constexpr int QueryTimeoutMs = 3000;
+    // Constante habitual de la fusión por rango recíproco
+    static constexpr int FusionK = 60;
+
+private:
+    void onProjectAdded(ProjectExplorer::Project *project);
+    void onProjectRemoved(ProjectExplorer::Project *project);
+    void onDocumentSaved(Core::IDocument *document);
+    void syncProject(ProjectExplorer::Project *project);
+    void dropFiles(const QSet<QString> &filePaths);
+    bool isTracked(const QString &filePath) const;
+
+    void enqueue(const QStringList &filePaths);
+    void drainQueue();
+    void stop();
+
+    struct PendingChunk
+    {
+        QString filePath;
+        int startLine = 0;
+        int lineCount = 0;
+        QString text;
+    };
+    struct PendingFile
+    {
+        QDateTime modified;
+        int remaining = 0;
+        QList<DeepSeekVectorStore::Entry> entries;
+    };
+    // Fragmentos de un fichero leídos en m_pool
+    struct EmbedFile
+    {
+        QString filePath;
+        QDateTime modified;
+        bool readable = false;
+        QList<PendingChunk> chunks;
+    };
+
+    void queueEmbeddings(const QStringList &filePaths);
+    static EmbedFile readEmbedChunks(const QString &filePath);
+    void loadEmbedChunks(const QString &filePath);
+    void pumpEmbeddings();
+    void onEmbeddingsReady(const QList<PendingChunk> &batch,
+                           const QList<std::vector<float>> &vectors, const QString &errorString);
+    void resetEmbedQueue();
+
+    DeepSeekProjectIndex m_index;
+    QHash<ProjectExplorer::Project *, QSet<QString>> m_projectFiles;
+    bool m_enabled = false;
+
+    // Cola compartida con el hilo de indexación
+    QThreadPool m_pool;
+    QMutex m_queueMutex;
+    QStringList m_queue;
+    QSet<QString> m_queued;
+    bool m_workerRunning = false;
+    std::atomic_bool m_canceled = false;
+
+    // Búsqueda semántica (solo en el hilo principal salvo el indicador)
+    std::atomic_bool m_semanticEnabled = false;
+    QString m_semanticConfig;
+    std::unique_ptr<DeepSeekVectorStore> m_vectors;
+    DeepSeekEmbeddingClient *m_embeddings = nullptr;
+    QStringList m_embedQueue;
+    QSet<QString> m_embedQueued;
+    QList<PendingChunk> m_embedChunks;
+    QHash<QString, PendingFile> m_embedFiles;
+    bool m_embedInFlight = false;
+    bool m_embedReading = false;
+    int m_embedGeneration = 0;
+};
+
+} // namespace DeepSeek
@@ -0,0 +1,367 @@
+#include "deepseekprojectindex.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QPair>
+
+#include <algorithm>
+#include <cmath>
+
+namespace DeepSeek {
+
+namespace {
+
+// Parámetros habituales de BM25
+constexpr double K1 = 1.2;
+constexpr double B = 0.75;
+// Cadenas más largas suelen ser datos (hashes, base64), no identificadores
+constexpr int MaxTokenLength = 64;
+// Bytes examinados para decidir si un fichero es binario
+constexpr qsizetype BinaryProbeSize = 8192;
+
+bool isWordChar(QChar c)
+{
+    return c.isLetterOrNumber() || c == u'_';
+}
+
+bool isPartBoundary(QStringView word, qsizetype i)
+{
+    const QChar prev = word.at(i - 1);
+    const QChar cur = word.at(i);
+    if (prev == u'_' || cur == u'_')
+        return true;
+    if (prev.isLower() && cur.isUpper())
+        return true;
+    // "HTTPServer" -> HTTP, Server
+    return prev.isUpper() && cur.isUpper() && i + 1 < word.size() && word.at(i + 1).isLower();
+}
+
+} // namespace
+
+QStringList DeepSeekProjectIndex::tokenize(QStringView text)
+{
+    QStringList tokens;
+    const auto accept = [&tokens](QStringView token) {
+        if (token.size() < 2 || token.size() > MaxTokenLength)
+            return;
+        if (std::all_of(token.begin(), token.end(), [](QChar c) { return c.isDigit(); }))
+            return;
+        tokens.append(token.toString().toLower());
+    };
+
+    const qsizetype size = text.size();
+    qsizetype i = 0;
+    while (i < size) {
+        if (!isWordChar(text.at(i))) {
+            ++i;
+            continue;
+        }
+        const qsizetype start = i;
+        while (i < size && isWordChar(text.at(i)))
+            ++i;
+        const QStringView word = text.mid(start, i - start);
+        accept(word);
+
+        // Partes del identificador, solo si hay más de una
+        QList<QStringView> parts;
+        qsizetype partStart = 0;
+        for (qsizetype j = 1; j <= word.size(); ++j) {
+            if (j < word.size() && !isPartBoundary(word, j))
+                continue;
+            const QStringView part = word.mid(partStart, j - partStart);
+            if (part.front() != u'_')
+                parts.append(part);
+            partStart = j;
+        }
+        if (parts.size() > 1) {
+            for (const QStringView part : std::as_const(parts))
+                accept(part);
+        }
+    }
+    return tokens;
+}
+
+bool DeepSeekProjectIndex::updateFile(const QString &filePath, QString *errorString)
+{
+    const QFileInfo info(filePath);
+    if (!info.isFile() || info.size() > MaxFileSize) {
+        removeFile(filePath);
+        return false;
+    }
+
+    {
+        QReadLocker locker(&m_lock);
+        const auto it = m_files.constFind(filePath);
+        if (it != m_files.constEnd() && it->modified == info.lastModified()
+            && it->size == info.size()) {
+            return true;
+        }
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorString)
+            *errorString = file.errorString();
+        removeFile(filePath);
+        return false;
+    }
+    const QByteArray data = file.readAll();
+    file.close();
+
+    if (data.left(BinaryProbeSize).contains('\0')) {
+        removeFile(filePath);
+        return false;
+    }
+
+    // Tokenización fuera del candado: es la parte cara
+    const QString text = QString::fromUtf8(data);
+    const QList<QStringView> lines = QStringView(text).split(u'\n');
+    QList<PreparedChunk> prepared;
+    for (qsizetype start = 0; start < lines.size(); start += ChunkLines) {
+        const qsizetype end = qMin(lines.size(), start + ChunkLines);
+        QHash<QString, quint32> counts;
+        quint32 length = 0;
+        for (qsizetype line = start; line < end; ++line) {
+            const QStringList tokens = tokenize(lines.at(line));
+            for (const QString &token : tokens)
+                ++counts[token];
+            length += quint32(tokens.size());
+        }
+        if (counts.isEmpty())
+            continue;
+
+        PreparedChunk chunk;
+        chunk.startLine = int(start);
+        chunk.lineCount = int(end - start);
+        chunk.length = length;
+        chunk.counts.reserve(counts.size());
+        for (auto it = counts.cbegin(); it != counts.cend(); ++it)
+            chunk.counts.append({it.key(), it.value()});
+        prepared.append(chunk);
+    }
+
+    QWriteLocker locker(&m_lock);
+    removeFileLocked(filePath);
+
+    FileEntry entry;
+    entry.modified = info.lastModified();
+    entry.size = info.size();
+    entry.chunks.reserve(prepared.size());
+    for (const PreparedChunk &source : std::as_const(prepared)) {
+        quint32 id;
+        if (!m_freeChunks.empty()) {
+            id = m_freeChunks.back();
+            m_freeChunks.pop_back();
+        } else {
+            id = quint32(m_chunks.size());
+            m_chunks.emplace_back();
+        }
+
+        Chunk &chunk = m_chunks[id];
+        chunk.filePath = filePath;
+        chunk.startLine = source.startLine;
+        chunk.lineCount = source.lineCount;
+        chunk.length = source.length;
+        chunk.alive = true;
+        chunk.terms.clear();
+        chunk.terms.reserve(source.counts.size());
+        for (const auto &[token, tf] : source.counts) {
+            auto termIt = m_termIds.constFind(token);
+            if (termIt == m_termIds.constEnd()) {
+                termIt = m_termIds.insert(token, quint32(m_terms.size()));
+                m_terms.emplace_back();
+            }
+            Term &term = m_terms[*termIt];
+            term.postings.push_back({id, tf});
+            ++term.df;
+            chunk.terms.push_back(*termIt);
+        }
+
+        m_totalLength += chunk.length;
+        ++m_liveChunks;
+        entry.chunks.push_back(id);
+    }
+    m_files.insert(filePath, entry);
+    return true;
+}
+
+void DeepSeekProjectIndex::removeFile(const QString &filePath)
+{
+    QWriteLocker locker(&m_lock);
+    removeFileLocked(filePath);
+}
+
+void DeepSeekProjectIndex::removeFileLocked(const QString &filePath)
+{
+    const auto it = m_files.constFind(filePath);
+    if (it == m_files.constEnd())
+        return;
+
+    // Las entradas del fragmento se quedan en las listas hasta compactar;
+    // la búsqueda las ignora porque el fragmento ya no está vivo.
+    for (const quint32 id : it->chunks) {
+        Chunk &chunk = m_chunks[id];
+        for (const quint32 term : chunk.terms)
+            --m_terms[term].df;
+        chunk.terms.clear();
+        chunk.filePath.clear();
+        chunk.alive = false;
+        m_totalLength -= chunk.length;
+        --m_liveChunks;
+        ++m_deadChunks;
+    }
+    m_files.erase(it);
+
+    if (m_deadChunks >= MinDeadForCompaction && m_deadChunks > m_liveChunks)
+        compactLocked();
+}
+
+void DeepSeekProjectIndex::compactLocked()
+{
+    for (Term &term : m_terms) {
+        std::erase_if(term.postings, [this](const Posting &posting) {
+            return !m_chunks[posting.chunk].alive;
+        });
+        if (term.postings.empty())
+            term.postings.shrink_to_fit();
+    }
+
+    m_freeChunks.clear();
+    for (quint32 id = 0; id < quint32(m_chunks.size()); ++id) {
+        if (!m_chunks[id].alive)
+            m_freeChunks.push_back(id);
+    }
+    // Los huecos más bajos se reutilizan primero
+    std::reverse(m_freeChunks.begin(), m_freeChunks.end());
+    m_deadChunks = 0;
+}
+
+bool DeepSeekProjectIndex::contains(const QString &filePath) const
+{
+    QReadLocker locker(&m_lock);
+    return m_files.contains(filePath);
+}
+
+QList<DeepSeekProjectIndex::Hit> DeepSeekProjectIndex::search(const QString &query, int limit) const
+{
+    QList<Hit> hits;
+    if (limit <= 0)
+        return hits;
+
+    QStringList queryTokens = tokenize(query);
+    queryTokens.removeDuplicates();
+
+    QReadLocker locker(&m_lock);
+    if (m_liveChunks == 0)
+        return hits;
+
+    const double chunkTotal = m_liveChunks;
+    const double averageLength = qMax(1.0, double(m_totalLength) / chunkTotal);
+
+    QList<const Term *> terms;
+    bool hasSelectiveTerm = false;
+    for (const QString &token : std::as_const(queryTokens)) {
+        const auto it = m_termIds.constFind(token);
+        if (it == m_termIds.constEnd() || m_terms[*it].df == 0)
+            continue;
+        const Term *term = &m_terms[*it];
+        terms.append(term);
+        hasSelectiveTerm = hasSelectiveTerm || term->df <= chunkTotal / 2;
+    }
+
+    // Acumuladores densos reutilizados entre búsquedas del mismo hilo: sin
+    // reservas ni tablas hash en el bucle interno.
+    thread_local std::vector<float> scores;
+    thread_local std::vector<quint32> touched;
+    if (scores.size() < m_chunks.size())
+        scores.resize(m_chunks.size(), 0.0f);
+    touched.clear();
+
+    for (const Term *term : std::as_const(terms)) {
+        // Los términos que aparecen en más de la mitad de los fragmentos
+        // apenas discriminan y tienen las listas más largas: se omiten si la
+        // consulta tiene otros mejores.
+        if (hasSelectiveTerm && term->df > chunkTotal / 2)
+            continue;
+
+        const double idf = std::log(1.0 + (chunkTotal - term->df + 0.5) / (term->df + 0.5));
+        for (const Posting &posting : term->postings) {
+            const Chunk &chunk = m_chunks[posting.chunk];
+            if (!chunk.alive)
+                continue;
+            const double norm = K1 * (1.0 - B + B * chunk.length / averageLength);
+            float &score = scores[posting.chunk];
+            if (score == 0.0f)
+                touched.push_back(posting.chunk);
+            score += float(idf * posting.tf * (K1 + 1.0) / (posting.tf + norm));
+        }
+    }
+
+    const qsizetype count = qMin<qsizetype>(limit, qsizetype(touched.size()));
+    std::partial_sort(touched.begin(), touched.begin() + count, touched.end(),
+                      [](quint32 a, quint32 b) { return scores[a] > scores[b]; });
+
+    hits.reserve(count);
+    for (qsizetype i = 0; i < count; ++i) {
+        const Chunk &chunk = m_chunks[touched[i]];
+        hits.append({chunk.filePath, chunk.startLine, chunk.lineCount, scores[touched[i]]});
+    }
+
+    for (const quint32 id : touched)
+        scores[id] = 0.0f;
+    return hits;
+}
+
+QList<DeepSeekProjectIndex::Hit> DeepSeekProjectIndex::fuse(const QList<QList<Hit>> &rankings,
+                                                              int k)
+{
+    QList<Hit> fused;
+    QHash<QPair<QString, int>, qsizetype> positions;
+    for (const QList<Hit> &ranking : rankings) {
+        for (qsizetype rank = 0; rank < ranking.size(); ++rank) {
+            const Hit &hit = ranking.at(rank);
+            const double score = 1.0 / (k + rank + 1);
+            const auto key = qMakePair(hit.filePath, hit.startLine);
+            const auto it = positions.constFind(key);
+            if (it != positions.constEnd()) {
+                fused[*it].score += score;
+                continue;
+            }
+            positions.insert(key, fused.size());
+            fused.append({hit.filePath, hit.startLine, hit.lineCount, score});
+        }
+    }
+    // Estable: a igual puntuación queda delante la primera lista
+    std::stable_sort(fused.begin(), fused.end(), [](const Hit &a, const Hit &b) {
+        return a.score > b.score;
+    });
+    return fused;
+}
+
+int DeepSeekProjectIndex::fileCount() const
+{
+    QReadLocker locker(&m_lock);
+    return int(m_files.size());
+}
+
+int DeepSeekProjectIndex::chunkCount() const
+{
+    QReadLocker locker(&m_lock);
+    return m_liveChunks;
+}
+
+void DeepSeekProjectIndex::clear()
+{
+    QWriteLocker locker(&m_lock);
+    m_termIds.clear();
+    m_terms.clear();
+    m_chunks.clear();
+    m_freeChunks.clear();
+    m_files.clear();
+    m_totalLength = 0;
+    m_liveChunks = 0;
+    m_deadChunks = 0;
+}
+
+} // namespace DeepSeek
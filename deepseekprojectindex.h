@@ -0,0 +1,115 @@
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QReadWriteLock>
+#include <QString>
+#include <QStringList>
+
+#include <vector>
+
+namespace DeepSeek {
+
+// Índice invertido BM25 sobre los ficheros del proyecto. Cada fichero se
+// divide en fragmentos de ChunkLines líneas; el índice guarda solo términos y
+// posiciones, el texto se vuelve a leer del disco al construir el contexto.
+//
+// Las actualizaciones son incrementales: updateFile() tokeniza fuera del
+// candado y solo toma el candado de escritura para sustituir los fragmentos
+// del fichero. Los fragmentos sustituidos quedan marcados como muertos y sus
+// entradas se purgan de golpe cuando superan a los vivos.
+//
+// Todos los métodos son thread-safe; search() solo toma el candado de lectura.
+class DeepSeekProjectIndex
+{
+public:
+    struct Hit
+    {
+        QString filePath;
+        int startLine = 0;  // base 0
+        int lineCount = 0;
+        double score = 0.0;
+    };
+
+    static constexpr int ChunkLines = 40;
+    static constexpr qint64 MaxFileSize = 1024 * 1024;
+    // Por debajo de este número de fragmentos muertos no compensa compactar
+    static constexpr int MinDeadForCompaction = 1024;
+
+    // Devuelve false si el fichero no se indexa (no existe, binario o
+    // demasiado grande); errorString solo se rellena si no se pudo leer.
+    // Si la fecha y el tamaño no han cambiado no se vuelve a leer.
+    bool updateFile(const QString &filePath, QString *errorString = nullptr);
+    void removeFile(const QString &filePath);
+    bool contains(const QString &filePath) const;
+
+    QList<Hit> search(const QString &query, int limit) const;
+
+    // Fusión por rango recíproco de varias listas ordenadas de mejor a peor:
+    // cada fragmento (fichero y línea inicial) suma 1 / (k + rango + 1) por
+    // lista en la que aparece. No depende de la escala de cada puntuación.
+    static QList<Hit> fuse(const QList<QList<Hit>> &rankings, int k);
+
+    int fileCount() const;
+    int chunkCount() const;
+    void clear();
+
+    // Identificadores en minúsculas, partidos además por camelCase y '_':
+    // "parseHttpHeader" -> parsehttpheader, parse, http, header
+    static QStringList tokenize(QStringView text);
+
+private:
+    struct Posting
+    {
+        quint32 chunk;
+        quint32 tf;
+    };
+
+    struct Term
+    {
+        std::vector<Posting> postings;
+        quint32 df = 0; // fragmentos vivos que contienen el término
+    };
+
+    struct Chunk
+    {
+        QString filePath;
+        int startLine = 0;
+        int lineCount = 0;
+        quint32 length = 0;          // número de tokens
+        std::vector<quint32> terms;  // términos distintos, para ajustar df al borrar
+        bool alive = false;
+    };
+
+    struct FileEntry
+    {
+        QDateTime modified;
+        qint64 size = 0;
+        std::vector<quint32> chunks;
+    };
+
+    // Preparado fuera del candado
+    struct PreparedChunk
+    {
+        int startLine = 0;
+        int lineCount = 0;
+        quint32 length = 0;
+        QList<QPair<QString, quint32>> counts;
+    };
+
+    void removeFileLocked(const QString &filePath);
+    void compactLocked();
+
+    mutable QReadWriteLock m_lock;
+    QHash<QString, quint32> m_termIds;
+    std::vector<Term> m_terms;
+    std::vector<Chunk> m_chunks;
+    std::vector<quint32> m_freeChunks;  // huecos reutilizables (ya sin entradas)
+    QHash<QString, FileEntry> m_files;
+    quint64 m_totalLength = 0;          // tokens en fragmentos vivos
+    int m_liveChunks = 0;
+    int m_deadChunks = 0;               // muertos con entradas aún sin purgar
+};
+
+} // namespace DeepSeek
@@ -0,0 +1,469 @@
+#include "deepseekreplyreader.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QObject>
+
+namespace DeepSeek {
+
+static constexpr qsizetype MaxKeyBytes = 256;
+static constexpr qsizetype MaxScalarBytes = 64;
+static constexpr qsizetype MaxFinishReasonBytes = 64;
+static const char ReplacementCharacter[] = "\xEF\xBF\xBD"; // U+FFFD en UTF-8
+
+static bool isSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// -?(0|[1-9]\d*)(\.\d+)?([eE][+-]?\d+)? o uno de los literales
+static bool isValidScalar(const QByteArray &text)
+{
+    if (text == "true" || text == "false" || text == "null")
+        return true;
+
+    qsizetype i = 0;
+    const qsizetype n = text.size();
+    if (i < n && text.at(i) == '-')
+        ++i;
+    if (i == n || !isDigit(text.at(i)))
+        return false;
+    if (text.at(i) == '0')
+        ++i;
+    else
+        while (i < n && isDigit(text.at(i)))
+            ++i;
+    if (i < n && text.at(i) == '.') {
+        if (++i == n || !isDigit(text.at(i)))
+            return false;
+        while (i < n && isDigit(text.at(i)))
+            ++i;
+    }
+    if (i < n && (text.at(i) == 'e' || text.at(i) == 'E')) {
+        if (++i < n && (text.at(i) == '+' || text.at(i) == '-'))
+            ++i;
+        if (i == n || !isDigit(text.at(i)))
+            return false;
+        while (i < n && isDigit(text.at(i)))
+            ++i;
+    }
+    return i == n;
+}
+
+void DeepSeekReplyReader::setLimits(qint64 maxContentBytes, qint64 maxInputBytes)
+{
+    m_maxContentBytes = maxContentBytes;
+    m_maxInputBytes = maxInputBytes;
+}
+
+void DeepSeekReplyReader::reset()
+{
+    const qint64 maxContentBytes = m_maxContentBytes;
+    const qint64 maxInputBytes = m_maxInputBytes;
+    *this = DeepSeekReplyReader();
+    setLimits(maxContentBytes, maxInputBytes);
+}
+
+void DeepSeekReplyReader::setError(const QString &error)
+{
+    if (m_error.isEmpty())
+        m_error = error;
+}
+
+QString DeepSeekReplyReader::apiErrorMessage() const
+{
+    if (m_apiError.isString())
+        return m_apiError.toString();
+    const QJsonObject error = m_apiError.toObject();
+    return error.value("message").toString(error.value("type").toString());
+}
+
+bool DeepSeekReplyReader::keyIs(int depth, const char *key) const
+{
+    return m_stack.size() > depth && m_stack.at(depth).object && m_stack.at(depth).key == key;
+}
+
+bool DeepSeekReplyReader::appendBytes(QByteArrayView bytes)
+{
+    switch (m_target) {
+    case Target::None:
+        return true;
+    case Target::Key:
+        // Una clave enorme no puede ser ninguna de las que interesan
+        if (m_key.size() + bytes.size() > MaxKeyBytes)
+            m_keyOverflow = true;
+        else
+            m_key.append(bytes);
+        return true;
+    case Target::FinishReason:
+        if (m_finishReason.size() + bytes.size() <= MaxFinishReasonBytes)
+            m_finishReason.append(bytes);
+        return true;
+    case Target::Content:
+    case Target::Reasoning: {
+        QByteArray &out = m_target == Target::Content ? m_content : m_reasoning;
+        if (out.size() + bytes.size() > m_maxContentBytes) {
+            setError(QObject::tr("The reply is larger than %1 MB")
+                         .arg(m_maxContentBytes / (1024 * 1024)));
+            return false;
+        }
+        out.append(bytes);
+        return true;
+    }
+    }
+    return true;
+}
+
+bool DeepSeekReplyReader::appendString(QByteArrayView bytes)
+{
+    // Un \uD8xx sin su pareja se sustituye al llegar cualquier otra cosa
+    if (m_highSurrogate) {
+        m_highSurrogate = 0;
+        if (!appendBytes(ReplacementCharacter))
+            return false;
+    }
+    return appendBytes(bytes);
+}
+
+bool DeepSeekReplyReader::appendCodeUnit(char16_t unit)
+{
+    if (QChar::isHighSurrogate(unit)) {
+        const bool lone = m_highSurrogate != 0;
+        m_highSurrogate = unit;
+        return !lone || appendBytes(ReplacementCharacter);
+    }
+    if (QChar::isLowSurrogate(unit)) {
+        if (!m_highSurrogate)
+            return appendBytes(ReplacementCharacter);
+        const char32_t codePoint = QChar::surrogateToUcs4(m_highSurrogate, unit);
+        m_highSurrogate = 0;
+        return appendBytes(QString::fromUcs4(&codePoint, 1).toUtf8());
+    }
+    const QChar character(unit);
+    return appendString(QString(character).toUtf8());
+}
+
+void DeepSeekReplyReader::beginValue(qsizetype position)
+{
+    m_target = Target::None;
+    const int depth = int(m_stack.size());
+
+    if (depth == 1 && m_capture == Capture::None) {
+        if (keyIs(0, "usage"))
+            m_capture = Capture::Usage;
+        else if (keyIs(0, "error"))
+            m_capture = Capture::Error;
+        if (m_capture != Capture::None) {
+            m_captureDepth = depth;
+            m_captureFrom = position;
+            m_captured.clear();
+        }
+        return;
+    }
+
+    // choices[0]...
+    const bool firstChoice = keyIs(0, "choices") && depth > 1 && !m_stack.at(1).object
+                             && m_stack.at(1).index == 0;
+    if (!firstChoice)
+        return;
+    if (depth == 3 && keyIs(2, "message"))
+        m_sawMessage = true;
+    else if (depth == 3 && keyIs(2, "finish_reason"))
+        m_target = Target::FinishReason;
+    else if (depth == 4 && keyIs(2, "message") && keyIs(3, "content"))
+        m_target = Target::Content;
+    else if (depth == 4 && keyIs(2, "message") && keyIs(3, "reasoning_content"))
+        m_target = Target::Reasoning;
+}
+
+void DeepSeekReplyReader::endValue(QByteArrayView data, qsizetype end)
+{
+    m_target = Target::None;
+    if (m_capture != Capture::None && m_stack.size() == m_captureDepth) {
+        m_captured.append(data.sliced(m_captureFrom, end - m_captureFrom));
+        finishCapture();
+    }
+    m_state = m_stack.isEmpty() ? State::Done : State::AfterValue;
+}
+
+void DeepSeekReplyReader::finishCapture()
+{
+    if (m_captured.size() > MaxCaptureBytes) {
+        setError(QObject::tr("The \"usage\" or \"error\" object of the reply is too large"));
+    } else {
+        // Envuelto en un array para aceptar también valores que no son objetos
+        const QJsonValue value
+            = QJsonDocument::fromJson('[' + m_captured + ']').array().first();
+        if (m_capture == Capture::Usage)
+            m_usage = value.toObject();
+        else
+            m_apiError = value;
+    }
+    m_capture = Capture::None;
+    m_captureDepth = -1;
+    m_captured.clear();
+}
+
+bool DeepSeekReplyReader::feed(QByteArrayView data)
+{
+    if (hasError())
+        return false;
+
+    const qint64 chunkStart = m_bytesRead;
+    m_bytesRead += data.size();
+    if (m_preview.size() < PreviewBytes)
+        m_preview.append(data.first(qMin(data.size(), PreviewBytes - m_preview.size())));
+    if (m_bytesRead > m_maxInputBytes) {
+        setError(QObject::tr("The reply is larger than %1 MB").arg(m_maxInputBytes / (1024 * 1024)));
+        return false;
+    }
+
+    const auto unexpected = [this, chunkStart](qsizetype i, char c) {
+        setError(QObject::tr("Unexpected character '%1' at offset %2 of the reply")
+                     .arg(QChar::fromLatin1(c))
+                     .arg(chunkStart + i));
+    };
+
+    const char *p = data.data();
+    const qsizetype n = data.size();
+    qsizetype i = 0;
+    while (i < n && !hasError()) {
+        const char c = p[i];
+        switch (m_state) {
+        case State::Value:
+            if (isSpace(c)) {
+                ++i;
+                break;
+            }
+            beginValue(i);
+            if (c == '{' || c == '[') {
+                if (m_stack.size() >= MaxDepth) {
+                    setError(QObject::tr("The reply is nested too deeply"));
+                    break;
+                }
+                m_target = Target::None;
+                m_stack.append(Frame{c == '{', 0, {}});
+                m_state = c == '{' ? State::ObjectKey : State::ArrayFirst;
+                m_objectStart = true;
+                ++i;
+            } else if (c == '"') {
+                m_state = State::String;
+                ++i;
+            } else if (c == '-' || isDigit(c) || c == 't' || c == 'f' || c == 'n') {
+                m_target = Target::None;
+                m_scalar.clear();
+                m_state = State::Scalar;
+            } else {
+                unexpected(i, c);
+            }
+            break;
+
+        case State::ArrayFirst:
+            if (isSpace(c)) {
+                ++i;
+            } else if (c == ']') {
+                m_stack.removeLast();
+                endValue(data, ++i);
+            } else {
+                m_state = State::Value;
+            }
+            break;
+
+        case State::ObjectKey:
+            if (isSpace(c)) {
+                ++i;
+            } else if (c == '"') {
+                m_target = Target::Key;
+                m_key.clear();
+                m_keyOverflow = false;
+                m_state = State::String;
+                ++i;
+            } else if (c == '}' && m_objectStart) {
+                m_stack.removeLast();
+                endValue(data, ++i);
+            } else {
+                unexpected(i, c);
+            }
+            break;
+
+        case State::Colon:
+            if (isSpace(c)) {
+                ++i;
+            } else if (c == ':') {
+                m_state = State::Value;
+                ++i;
+            } else {
+                unexpected(i, c);
+            }
+            break;
+
+        case State::AfterValue: {
+            if (isSpace(c)) {
+                ++i;
+                break;
+            }
+            Frame &top = m_stack.last();
+            if (c == ',') {
+                if (top.object) {
+                    m_state = State::ObjectKey;
+                    m_objectStart = false;
+                } else {
+                    ++top.index;
+                    m_state = State::Value;
+                }
+                ++i;
+            } else if (c == (top.object ? '}' : ']')) {
+                m_stack.removeLast();
+                endValue(data, ++i);
+            } else {
+                unexpected(i, c);
+            }
+            break;
+        }
+
+        case State::String: {
+            // Tramos sin escapes de una vez
+            qsizetype j = i;
+            while (j < n && p[j] != '"' && p[j] != '\\')
+                ++j;
+            if (j > i && !appendString(data.sliced(i, j - i)))
+                break;
+            i = j;
+            if (i == n)
+                break;
+            if (p[i] == '\\') {
+                m_state = State::Escape;
+                ++i;
+                break;
+            }
+            ++i; // comilla de cierre
+            if (!appendString({}))
+                break;
+            if (m_target == Target::Key) {
+                m_stack.last().key = m_keyOverflow ? QByteArray() : m_key;
+                m_target = Target::None;
+                m_state = State::Colon;
+            } else {
+                endValue(data, i);
+            }
+            break;
+        }
+
+        case State::Escape: {
+            char decoded = 0;
+            switch (c) {
+            case '"': decoded = '"'; break;
+            case '\\': decoded = '\\'; break;
+            case '/': decoded = '/'; break;
+            case 'b': decoded = '\b'; break;
+            case 'f': decoded = '\f'; break;
+            case 'n': decoded = '\n'; break;
+            case 'r': decoded = '\r'; break;
+            case 't': decoded = '\t'; break;
+            case 'u':
+                m_unicode = 0;
+                m_unicodeDigits = 0;
+                m_state = State::Unicode;
+                ++i;
+                continue;
+            default:
+                unexpected(i, c);
+                continue;
+            }
+            if (appendString(QByteArrayView(&decoded, 1)))
+                m_state = State::String;
+            ++i;
+            break;
+        }
+
+        case State::Unicode: {
+            int digit = -1;
+            if (isDigit(c))
+                digit = c - '0';
+            else if (c >= 'a' && c <= 'f')
+                digit = c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                digit = c - 'A' + 10;
+            if (digit < 0) {
+                unexpected(i, c);
+                break;
+            }
+            m_unicode = char16_t(m_unicode * 16 + digit);
+            ++i;
+            if (++m_unicodeDigits == 4 && appendCodeUnit(m_unicode))
+                m_state = State::String;
+            break;
+        }
+
+        case State::Scalar:
+            if (isDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '+'
+                || c == '-' || c == '.') {
+                if (m_scalar.size() >= MaxScalarBytes) {
+                    unexpected(i, c);
+                    break;
+                }
+                m_scalar.append(c);
+                ++i;
+            } else if (!isValidScalar(m_scalar)) {
+                setError(QObject::tr("Invalid value '%1' in the reply")
+                             .arg(QString::fromLatin1(m_scalar)));
+            } else {
+                endValue(data, i); // el delimitador se procesa en el estado siguiente
+            }
+            break;
+
+        case State::Done:
+            if (isSpace(c))
+                ++i;
+            else
+                unexpected(i, c);
+            break;
+        }
+    }
+
+    if (hasError())
+        return false;
+
+    // Lo capturado de este fragmento; el siguiente empieza desde 0
+    if (m_capture != Capture::None) {
+        m_captured.append(data.sliced(m_captureFrom));
+        m_captureFrom = 0;
+        if (m_captured.size() > MaxCaptureBytes) {
+            setError(QObject::tr("The \"usage\" or \"error\" object of the reply is too large"));
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DeepSeekReplyReader::finish()
+{
+    if (hasError())
+        return false;
+
+    // Un número al final del documento no tiene delimitador detrás
+    if (m_state == State::Scalar) {
+        if (!isValidScalar(m_scalar)) {
+            setError(QObject::tr("Invalid value '%1' in the reply")
+                         .arg(QString::fromLatin1(m_scalar)));
+            return false;
+        }
+        endValue({}, 0);
+    }
+
+    if (m_state != State::Done) {
+        setError(m_bytesRead == 0 ? QObject::tr("Empty reply")
+                                  : QObject::tr("The reply ended before the JSON document "
+                                                "was complete (%1 bytes)")
+                                        .arg(m_bytesRead));
+        return false;
+    }
+    return true;
+}
+
+} // namespace DeepSeek
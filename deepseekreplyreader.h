@@ -0,0 +1,120 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QList>
+#include <QString>
+
+namespace DeepSeek {
+
+// Lector incremental de la respuesta JSON de /chat/completions sin
+// streaming. Se alimenta con los fragmentos de readyRead según llegan y
+// solo guarda lo que interesa al chat:
+//   choices[0].message.content / reasoning_content, choices[0].finish_reason,
+//   "usage" y "error" (estos dos, pequeños, se interpretan con QJsonDocument).
+// El resto del documento se valida y se descarta sin construir el DOM.
+//
+// La memoria está acotada: el contenido no puede pasar de maxContentBytes y
+// la respuesta entera de maxInputBytes; al superarlos, o ante JSON mal
+// formado, el lector queda en error y deja de consumir datos.
+class DeepSeekReplyReader
+{
+public:
+    static constexpr qint64 DefaultMaxContentBytes = 16ll * 1024 * 1024;
+    static constexpr qint64 DefaultMaxInputBytes = 64ll * 1024 * 1024;
+    static constexpr qsizetype MaxCaptureBytes = 256 * 1024; // "usage" y "error"
+    static constexpr qsizetype PreviewBytes = 1024;
+    static constexpr int MaxDepth = 128;
+
+    void setLimits(qint64 maxContentBytes, qint64 maxInputBytes);
+
+    // false si el lector está en error; no tiene sentido seguir alimentándolo
+    bool feed(QByteArrayView data);
+    // Comprueba que el documento está completo
+    bool finish();
+    void reset();
+
+    bool hasError() const { return !m_error.isEmpty(); }
+    QString error() const { return m_error; }
+
+    bool hasMessage() const { return m_sawMessage; }
+    QString content() const { return QString::fromUtf8(m_content); }
+    QString reasoningContent() const { return QString::fromUtf8(m_reasoning); }
+    QString finishReason() const { return QString::fromUtf8(m_finishReason); }
+    QJsonObject usage() const { return m_usage; }
+
+    // Objeto "error" de la API ({"error": {"message": ...}}), si lo hay
+    bool hasApiError() const { return !m_apiError.isUndefined(); }
+    QString apiErrorMessage() const;
+
+    // Principio de la respuesta, para diagnosticar formatos inesperados
+    QByteArray preview() const { return m_preview; }
+    qint64 bytesRead() const { return m_bytesRead; }
+
+private:
+    enum class State : quint8 {
+        Value,      // se espera un valor
+        ObjectKey,  // tras '{' o ',' dentro de un objeto
+        Colon,
+        ArrayFirst, // tras '[': un valor o ']'
+        AfterValue, // ',' o cierre del contenedor
+        String,
+        Escape,
+        Unicode,
+        Scalar,     // número, true, false o null
+        Done
+    };
+    enum class Target : quint8 { None, Key, Content, Reasoning, FinishReason };
+    enum class Capture : quint8 { None, Usage, Error };
+
+    struct Frame
+    {
+        bool object = false;
+        int index = 0;      // posición en el array
+        QByteArray key;     // clave actual en el objeto
+    };
+
+    void setError(const QString &error);
+    void beginValue(qsizetype position);
+    void endValue(QByteArrayView data, qsizetype end);
+    void finishCapture();
+    bool appendBytes(QByteArrayView bytes);
+    bool appendString(QByteArrayView bytes);
+    bool appendCodeUnit(char16_t unit);
+    bool keyIs(int depth, const char *key) const;
+
+    qint64 m_maxContentBytes = DefaultMaxContentBytes;
+    qint64 m_maxInputBytes = DefaultMaxInputBytes;
+
+    State m_state = State::Value;
+    bool m_objectStart = false; // "{}" vacío permitido
+    QList<Frame> m_stack;
+
+    Target m_target = Target::None;
+    QByteArray m_key;
+    bool m_keyOverflow = false;
+    char16_t m_unicode = 0;
+    int m_unicodeDigits = 0;
+    char16_t m_highSurrogate = 0;
+    QByteArray m_scalar;
+
+    Capture m_capture = Capture::None;
+    int m_captureDepth = -1;
+    qsizetype m_captureFrom = 0; // inicio dentro del fragmento actual
+    QByteArray m_captured;
+
+    QByteArray m_content;
+    QByteArray m_reasoning;
+    QByteArray m_finishReason;
+    QJsonObject m_usage;
+    QJsonValue m_apiError = QJsonValue::Undefined;
+    bool m_sawMessage = false;
+
+    QByteArray m_preview;
+    qint64 m_bytesRead = 0;
+    QString m_error;
+};
+
+} // namespace DeepSeek
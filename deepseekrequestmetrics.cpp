@@ -0,0 +1,172 @@
+#include "deepseekrequestmetrics.h"
+
+#include <QNetworkReply>
+#include <QSaveFile>
+#include <QTextStream>
+
+#include <algorithm>
+#include <vector>
+
+namespace DeepSeek {
+
+DeepSeekRequestMetrics::DeepSeekRequestMetrics(int capacity)
+    : m_capacity(std::max(1, capacity))
+{
+    m_samples.reserve(m_capacity);
+}
+
+void DeepSeekRequestMetrics::add(const Sample &sample)
+{
+    if (m_samples.size() < m_capacity) {
+        m_samples.append(sample);
+        return;
+    }
+    m_samples[m_next] = sample;
+    m_next = (m_next + 1) % m_capacity;
+}
+
+void DeepSeekRequestMetrics::clear()
+{
+    m_samples.clear();
+    m_next = 0;
+}
+
+void DeepSeekRequestMetrics::classifyFinish(Sample &sample, QNetworkReply *reply,
+                                            DeepSeekRequestScheduler::FinishReason reason)
+{
+    if (reply)
+        sample.httpStatus = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (reason == DeepSeekRequestScheduler::FinishReason::Canceled || !reply)
+        sample.error = ErrorClass::Canceled;
+    else if (reason == DeepSeekRequestScheduler::FinishReason::TimedOut)
+        sample.error = ErrorClass::Timeout;
+    else if (sample.httpStatus >= 500)
+        sample.error = ErrorClass::Server;
+    else if (sample.httpStatus >= 400)
+        sample.error = ErrorClass::Client;
+    else if (reply->error() != QNetworkReply::NoError && sample.error != ErrorClass::Protocol)
+        sample.error = ErrorClass::Network;
+}
+
+int DeepSeekRequestMetrics::errorCount() const
+{
+    return int(std::count_if(m_samples.cbegin(), m_samples.cend(), [](const Sample &sample) {
+        return sample.error != ErrorClass::None;
+    }));
+}
+
+QList<DeepSeekRequestMetrics::Sample> DeepSeekRequestMetrics::samples() const
+{
+    // Con el buffer lleno, la más antigua es la que toca sobrescribir
+    QList<Sample> ordered;
+    ordered.reserve(m_samples.size());
+    for (qsizetype i = m_next; i < m_samples.size(); ++i)
+        ordered.append(m_samples.at(i));
+    for (qsizetype i = 0; i < m_next; ++i)
+        ordered.append(m_samples.at(i));
+    return ordered;
+}
+
+qint64 DeepSeekRequestMetrics::value(const Sample &sample, Field field)
+{
+    switch (field) {
+    case Field::Queue:
+        return sample.queueMs;
+    case Field::Connect:
+        return sample.connectMs;
+    case Field::FirstByte:
+        return sample.firstByteMs;
+    case Field::Total:
+        return sample.totalMs;
+    case Field::PromptTokens:
+        return sample.promptTokens;
+    case Field::CompletionTokens:
+        return sample.completionTokens;
+    }
+    return -1;
+}
+
+DeepSeekRequestMetrics::Percentiles DeepSeekRequestMetrics::percentiles(Field field) const
+{
+    std::vector<qint64> values;
+    values.reserve(m_samples.size());
+    for (const Sample &sample : m_samples) {
+        const qint64 v = value(sample, field);
+        if (sample.error == ErrorClass::None && v >= 0)
+            values.push_back(v);
+    }
+
+    Percentiles result;
+    result.samples = int(values.size());
+    if (values.empty())
+        return result;
+
+    // Rango más cercano: el valor en la posición ceil(p * n) - 1 ordenando
+    // de menor a mayor. nth_element basta con unos pocos percentiles.
+    const auto rank = [&values](int percent) {
+        const size_t n = values.size();
+        const size_t index = std::max<size_t>(1, (n * percent + 99) / 100) - 1;
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+        return values[index];
+    };
+    result.p50 = rank(50);
+    result.p95 = rank(95);
+    result.p99 = rank(99);
+    return result;
+}
+
+bool DeepSeekRequestMetrics::exportCsv(const QString &filePath, QString *errorString) const
+{
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        if (errorString)
+            *errorString = file.errorString();
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "timestamp,model,streamed,queue_ms,connect_ms,first_byte_ms,total_ms,"
+           "request_bytes,response_bytes,prompt_tokens,completion_tokens,http_status,error\n";
+    for (const Sample &sample : samples()) {
+        // El modelo es el único campo de texto libre: se entrecomilla
+        QString model = sample.model;
+        model.replace('"', "\"\"");
+        out << sample.timestamp.toUTC().toString(Qt::ISODateWithMs) << ",\"" << model << "\","
+            << (sample.streamed ? 1 : 0) << ',' << sample.queueMs << ',' << sample.connectMs
+            << ',' << sample.firstByteMs << ',' << sample.totalMs << ',' << sample.requestBytes
+            << ',' << sample.responseBytes << ',' << sample.promptTokens << ','
+            << sample.completionTokens << ',' << sample.httpStatus << ','
+            << errorClassName(sample.error) << '\n';
+    }
+    out.flush();
+
+    if (!file.commit()) {
+        if (errorString)
+            *errorString = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+QString DeepSeekRequestMetrics::errorClassName(ErrorClass error)
+{
+    switch (error) {
+    case ErrorClass::None:
+        return "none";
+    case ErrorClass::Canceled:
+        return "canceled";
+    case ErrorClass::Timeout:
+        return "timeout";
+    case ErrorClass::Network:
+        return "network";
+    case ErrorClass::Client:
+        return "http_4xx";
+    case ErrorClass::Server:
+        return "http_5xx";
+    case ErrorClass::Protocol:
+        return "protocol";
+    }
+    return "unknown";
+}
+
+} // namespace DeepSeek
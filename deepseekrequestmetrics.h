@@ -0,0 +1,80 @@
+#pragma once
+
+#include "deepseekrequestscheduler.h"
+
+#include <QDateTime>
+#include <QList>
+#include <QString>
+
+namespace DeepSeek {
+
+// Métricas de las últimas peticiones al servicio, en un buffer circular de
+// tamaño fijo: al llenarse, cada muestra nueva sustituye a la más antigua.
+// Los tiempos son milisegundos; -1 significa que esa fase no llegó a ocurrir
+// (por ejemplo, una petición cancelada en cola no tiene tiempo de conexión).
+class DeepSeekRequestMetrics
+{
+public:
+    enum class ErrorClass { None, Canceled, Timeout, Network, Client, Server, Protocol };
+
+    struct Sample
+    {
+        QDateTime timestamp;     // momento en que se encoló
+        QString model;
+        bool streamed = false;
+        qint64 queueMs = -1;     // en el planificador hasta post()
+        qint64 connectMs = -1;   // de post() a terminar de enviar (conexión, TLS y cuerpo)
+        qint64 firstByteMs = -1; // de post() a recibir las cabeceras de la respuesta
+        qint64 totalMs = -1;     // de encolar a terminar
+        qint64 requestBytes = 0;
+        qint64 responseBytes = 0;
+        int promptTokens = -1;   // de "usage"; -1 si el servidor no lo envía
+        int completionTokens = -1;
+        int httpStatus = 0;
+        ErrorClass error = ErrorClass::None;
+    };
+
+    enum class Field { Queue, Connect, FirstByte, Total, PromptTokens, CompletionTokens };
+
+    struct Percentiles
+    {
+        int samples = 0; // muestras con valor para el campo
+        qint64 p50 = -1;
+        qint64 p95 = -1;
+        qint64 p99 = -1;
+    };
+
+    explicit DeepSeekRequestMetrics(int capacity = DefaultCapacity);
+
+    void add(const Sample &sample);
+    void clear();
+
+    int size() const { return int(m_samples.size()); }
+    int capacity() const { return m_capacity; }
+    int errorCount() const;
+    // De la más antigua a la más reciente
+    QList<Sample> samples() const;
+
+    // Percentil por rango más cercano; solo cuentan las peticiones sin error
+    Percentiles percentiles(Field field) const;
+
+    bool exportCsv(const QString &filePath, QString *errorString = nullptr) const;
+
+    static QString errorClassName(ErrorClass error);
+    // Rellena httpStatus y error según cómo terminó la petición en el
+    // planificador. Un error de protocolo ya marcado se conserva: el abort()
+    // de quien interpreta la respuesta no cuenta como error de red.
+    static void classifyFinish(Sample &sample, QNetworkReply *reply,
+                               DeepSeekRequestScheduler::FinishReason reason);
+
+    static constexpr int DefaultCapacity = 1000;
+
+private:
+    static qint64 value(const Sample &sample, Field field);
+
+    QList<Sample> m_samples;
+    int m_capacity;
+    int m_next = 0; // posición que se sobrescribe cuando el buffer está lleno
+};
+
+} // namespace DeepSeek
@@ -0,0 +1,301 @@
+#include "deepseekrequestscheduler.h"
+
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QTimer>
+
+#include <algorithm>
+
+namespace DeepSeek {
+
+DeepSeekRequestScheduler::DeepSeekRequestScheduler(QNetworkAccessManager *manager, QObject *parent)
+    : QObject(parent)
+    , m_manager(manager)
+{}
+
+DeepSeekRequestScheduler::~DeepSeekRequestScheduler()
+{
+    // Los replies pertenecen al QNetworkAccessManager; se desconectan para no
+    // recibir finished() durante la destrucción.
+    for (Running &running : m_running) {
+        if (running.reply) {
+            running.reply->disconnect(this);
+            running.reply->abort();
+            running.reply->deleteLater();
+        }
+    }
+}
+
+void DeepSeekRequestScheduler::setNetworkManager(QNetworkAccessManager *manager)
+{
+    m_manager = manager;
+    scheduleDispatch();
+}
+
+void DeepSeekRequestScheduler::setMaxConcurrentPerHost(int maxConcurrent)
+{
+    m_maxPerHost = qMax(1, maxConcurrent);
+    scheduleDispatch();
+}
+
+DeepSeekRequestScheduler::RequestId DeepSeekRequestScheduler::enqueue(const Request &request)
+{
+    const Pending pending{m_nextId++, request};
+
+    if (request.priority == Priority::Interactive)
+        m_interactiveQueue.append(pending);
+    else
+        m_backgroundQueue.append(pending);
+
+    // El arranque se difiere al bucle de eventos: quien encola recibe el id
+    // antes de que se emita started() para él.
+    scheduleDispatch();
+    emit activityChanged(runningCount(), queuedCount());
+    return pending.id;
+}
+
+bool DeepSeekRequestScheduler::cancel(RequestId id)
+{
+    const auto removeQueued = [this, id](QList<Pending> &queue) {
+        for (qsizetype i = 0; i < queue.size(); ++i) {
+            if (queue.at(i).id == id) {
+                queue.removeAt(i);
+                emit finished(id, nullptr, FinishReason::Canceled);
+                emit activityChanged(runningCount(), queuedCount());
+                return true;
+            }
+        }
+        return false;
+    };
+
+    if (removeQueued(m_interactiveQueue) || removeQueued(m_backgroundQueue))
+        return true;
+
+    const auto it = m_running.find(id);
+    if (it == m_running.end())
+        return false;
+
+    it->canceled = true;
+    if (it->reply)
+        it->reply->abort(); // finished() llega de forma síncrona
+    return true;
+}
+
+void DeepSeekRequestScheduler::cancelAll(Priority priority)
+{
+    QList<RequestId> ids;
+    const QList<Pending> &queue = priority == Priority::Interactive ? m_interactiveQueue
+                                                                    : m_backgroundQueue;
+    for (const Pending &pending : queue)
+        ids.append(pending.id);
+    for (auto it = m_running.cbegin(); it != m_running.cend(); ++it) {
+        if (it->pending.request.priority == priority)
+            ids.append(it.key());
+    }
+
+    for (const RequestId id : std::as_const(ids))
+        cancel(id);
+}
+
+bool DeepSeekRequestScheduler::contains(RequestId id) const
+{
+    if (m_running.contains(id))
+        return true;
+    const auto inQueue = [id](const QList<Pending> &queue) {
+        return std::any_of(queue.cbegin(), queue.cend(),
+                           [id](const Pending &pending) { return pending.id == id; });
+    };
+    return inQueue(m_interactiveQueue) || inQueue(m_backgroundQueue);
+}
+
+bool DeepSeekRequestScheduler::isRunning(RequestId id) const
+{
+    return m_running.contains(id);
+}
+
+QString DeepSeekRequestScheduler::userMessage(RequestId id) const
+{
+    if (const auto it = m_running.constFind(id); it != m_running.cend())
+        return it->pending.request.userMessage;
+    for (const QList<Pending> *queue : {&m_interactiveQueue, &m_backgroundQueue}) {
+        for (const Pending &pending : *queue) {
+            if (pending.id == id)
+                return pending.request.userMessage;
+        }
+    }
+    return {};
+}
+
+int DeepSeekRequestScheduler::restarts(RequestId id) const
+{
+    if (const auto it = m_running.constFind(id); it != m_running.cend())
+        return it->pending.restarts;
+    for (const QList<Pending> *queue : {&m_interactiveQueue, &m_backgroundQueue}) {
+        for (const Pending &pending : *queue) {
+            if (pending.id == id)
+                return pending.restarts;
+        }
+    }
+    return 0;
+}
+
+QString DeepSeekRequestScheduler::hostKey(const QNetworkRequest &request)
+{
+    const QUrl url = request.url();
+    return url.host() + ':' + QString::number(url.port(url.scheme() == "http" ? 80 : 443));
+}
+
+int DeepSeekRequestScheduler::runningForHost(const QString &host) const
+{
+    return int(std::count_if(m_running.cbegin(), m_running.cend(),
+                             [&host](const Running &running) { return running.host == host; }));
+}
+
+void DeepSeekRequestScheduler::scheduleDispatch()
+{
+    if (m_dispatchScheduled)
+        return;
+    m_dispatchScheduled = true;
+    QMetaObject::invokeMethod(this, &DeepSeekRequestScheduler::dispatch, Qt::QueuedConnection);
+}
+
+void DeepSeekRequestScheduler::dispatch()
+{
+    m_dispatchScheduled = false;
+
+    if (!m_manager) {
+        failQueued();
+        return;
+    }
+
+    // Primero la cola interactiva; dentro de cada cola, orden de llegada
+    for (QList<Pending> *queue : {&m_interactiveQueue, &m_backgroundQueue}) {
+        for (qsizetype i = 0; i < queue->size();) {
+            if (runningForHost(hostKey(queue->at(i).request.request)) >= m_maxPerHost) {
+                ++i;
+                continue;
+            }
+            start(queue->takeAt(i));
+        }
+    }
+
+    // Las interactivas que siguen esperando recuperan hueco interrumpiendo
+    // trabajo de fondo; arrancarán en el siguiente dispatch().
+    QHash<QString, int> waiting;
+    for (const Pending &pending : std::as_const(m_interactiveQueue))
+        ++waiting[hostKey(pending.request.request)];
+
+    for (auto it = waiting.cbegin(); it != waiting.cend(); ++it) {
+        const QString &host = it.key();
+        const int freeing = int(std::count_if(m_running.cbegin(), m_running.cend(),
+                                              [&host](const Running &running) {
+                                                  return running.host == host && running.preempting;
+                                              }));
+        int needed = it.value() - (m_maxPerHost - runningForHost(host)) - freeing;
+        while (needed-- > 0 && preemptFor(host)) {}
+    }
+}
+
+void DeepSeekRequestScheduler::failQueued()
+{
+    // Sin red no arrancarían nunca: quien espera el finished() no debe quedarse colgado
+    QList<Pending> queued = m_interactiveQueue + m_backgroundQueue;
+    m_interactiveQueue.clear();
+    m_backgroundQueue.clear();
+    if (queued.isEmpty())
+        return;
+
+    for (const Pending &pending : std::as_const(queued))
+        emit finished(pending.id, nullptr, FinishReason::Canceled);
+    emit activityChanged(runningCount(), queuedCount());
+}
+
+void DeepSeekRequestScheduler::start(const Pending &pending)
+{
+    Running running;
+    running.pending = pending;
+    running.host = hostKey(pending.request.request);
+    running.reply = m_manager->post(pending.request.request, pending.request.body);
+
+    QNetworkReply *reply = running.reply;
+    const RequestId id = pending.id;
+
+    // Timeout por inactividad: se reinicia cada vez que llegan datos
+    running.idleTimer = new QTimer(reply);
+    running.idleTimer->setSingleShot(true);
+    running.idleTimer->setInterval(pending.request.idleTimeoutMs);
+    connect(running.idleTimer, &QTimer::timeout, this, [this, id]() {
+        const auto it = m_running.find(id);
+        if (it == m_running.end() || !it->reply || !it->reply->isRunning())
+            return;
+        it->timedOut = true;
+        it->reply->abort();
+    });
+    QTimer *idleTimer = running.idleTimer;
+    connect(reply, &QNetworkReply::readyRead, idleTimer, qOverload<>(&QTimer::start));
+    connect(reply, &QNetworkReply::uploadProgress, idleTimer, qOverload<>(&QTimer::start));
+    idleTimer->start();
+
+    connect(reply, &QNetworkReply::finished, this, [this, id]() { onReplyFinished(id); });
+
+    m_running.insert(id, running);
+    emit started(id, reply);
+}
+
+bool DeepSeekRequestScheduler::preemptFor(const QString &host)
+{
+    // Se interrumpe la petición de fondo más reciente: es la que menos
+    // trabajo pierde al reiniciarse.
+    auto victim = m_running.end();
+    for (auto it = m_running.begin(); it != m_running.end(); ++it) {
+        if (it->host != host || it->preempting || it->canceled
+            || it->pending.request.priority != Priority::Background) {
+            continue;
+        }
+        if (victim == m_running.end() || it.key() > victim.key())
+            victim = it;
+    }
+
+    if (victim == m_running.end() || !victim->reply)
+        return false;
+
+    victim->preempting = true;
+    victim->reply->abort();
+    return true;
+}
+
+void DeepSeekRequestScheduler::onReplyFinished(RequestId id)
+{
+    const auto it = m_running.find(id);
+    if (it == m_running.end())
+        return;
+
+    const Running running = *it;
+    m_running.erase(it);
+
+    QNetworkReply *reply = running.reply;
+    if (running.idleTimer)
+        running.idleTimer->stop();
+
+    if (running.preempting) {
+        Pending pending = running.pending;
+        ++pending.restarts;
+        m_backgroundQueue.prepend(pending);
+        emit preempted(id);
+    } else {
+        FinishReason reason = FinishReason::Completed;
+        if (running.canceled)
+            reason = FinishReason::Canceled;
+        else if (running.timedOut)
+            reason = FinishReason::TimedOut;
+        emit finished(id, reply, reason);
+    }
+
+    if (reply)
+        reply->deleteLater();
+
+    scheduleDispatch();
+    emit activityChanged(runningCount(), queuedCount());
+}
+
+} // namespace DeepSeek
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+
+QT_BEGIN_NAMESPACE
+class QNetworkAccessManager;
+class QNetworkReply;
+class QTimer;
+QT_END_NAMESPACE
+
+namespace DeepSeek {
+
+// Planificador de peticiones HTTP. Cada petición recibe un identificador con
+// el que se puede cancelar y con el que se correlacionan sus señales. Limita
+// las peticiones simultáneas por host y da prioridad a las interactivas: si
+// un host está al límite, una petición interactiva adelanta a las de fondo
+// en cola y, si hace falta, interrumpe una de fondo en curso, que vuelve a la
+// cola y se reinicia después (se emite preempted() y luego started() otra vez;
+// restarts() distingue ese nuevo arranque del primero). Las peticiones
+// arrancan siempre desde el bucle de eventos, nunca dentro de enqueue(). Sin
+// QNetworkAccessManager las peticiones en cola terminan como Canceled.
+class DeepSeekRequestScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    using RequestId = quint64;
+
+    enum class Priority { Interactive, Background };
+    Q_ENUM(Priority)
+    enum class FinishReason { Completed, Canceled, TimedOut };
+    Q_ENUM(FinishReason)
+
+    struct Request
+    {
+        QNetworkRequest request;
+        QByteArray body;
+        Priority priority = Priority::Interactive;
+        QString userMessage;      // mensaje del usuario que originó la petición
+        int idleTimeoutMs = 30000; // sin datos durante este tiempo => TimedOut
+    };
+
+    explicit DeepSeekRequestScheduler(QNetworkAccessManager *manager, QObject *parent = nullptr);
+    ~DeepSeekRequestScheduler() override;
+
+    void setNetworkManager(QNetworkAccessManager *manager);
+    void setMaxConcurrentPerHost(int maxConcurrent);
+    int maxConcurrentPerHost() const { return m_maxPerHost; }
+
+    RequestId enqueue(const Request &request);
+    bool cancel(RequestId id);
+    void cancelAll(Priority priority);
+
+    bool contains(RequestId id) const;
+    bool isRunning(RequestId id) const;
+    QString userMessage(RequestId id) const;
+    // Veces que se ha vuelto a enviar tras una interrupción; 0 en el primer started()
+    int restarts(RequestId id) const;
+    int runningCount() const { return int(m_running.size()); }
+    int queuedCount() const { return int(m_interactiveQueue.size() + m_backgroundQueue.size()); }
+
+signals:
+    // Se emite justo después de post(); conectar aquí readyRead
+    void started(RequestId id, QNetworkReply *reply);
+    // reply es nullptr si la petición se canceló antes de empezar. El
+    // planificador borra el reply (deleteLater) después de la señal.
+    void finished(RequestId id, QNetworkReply *reply, FinishReason reason);
+    // Una petición de fondo fue interrumpida y se ha vuelto a encolar
+    void preempted(RequestId id);
+    void activityChanged(int running, int queued);
+
+private:
+    struct Pending
+    {
+        RequestId id = 0;
+        Request request;
+        int restarts = 0;
+    };
+
+    struct Running
+    {
+        Pending pending;
+        QPointer<QNetworkReply> reply;
+        QTimer *idleTimer = nullptr;
+        QString host;
+        bool canceled = false;
+        bool timedOut = false;
+        bool preempting = false;
+    };
+
+    static QString hostKey(const QNetworkRequest &request);
+    int runningForHost(const QString &host) const;
+    void scheduleDispatch();
+    void dispatch();
+    void start(const Pending &pending);
+    void failQueued();
+    bool preemptFor(const QString &host);
+    void onReplyFinished(RequestId id);
+
+    QPointer<QNetworkAccessManager> m_manager;
+    QList<Pending> m_interactiveQueue;
+    QList<Pending> m_backgroundQueue;
+    QHash<RequestId, Running> m_running;
+    RequestId m_nextId = 1;
+    int m_maxPerHost = 2;
+    bool m_dispatchScheduled = false;
+};
+
+} // namespace DeepSeek
@@ -0,0 +1,124 @@
+#include "deepseekrequestserializer.h"
+
+#include <QJsonDocument>
+#include <QMutexLocker>
+
+namespace DeepSeek {
+
+QByteArray DeepSeekRequestSerializer::compact(const QJsonObject &object)
+{
+    return QJsonDocument(object).toJson(QJsonDocument::Compact);
+}
+
+void DeepSeekRequestSerializer::appendMessage(QByteArray &out, const QString &role,
+                                              const QString &content)
+{
+    // Un objeto pequeño por mensaje; el texto se escapa igual que en QJsonDocument
+    out += compact(QJsonObject{{"role", role}, {"content", content}});
+}
+
+QByteArray DeepSeekRequestSerializer::messagesJson(const Parts &parts)
+{
+    QByteArray history;
+    {
+        QMutexLocker locker(&m_mutex);
+
+        qsizetype common = 0;
+        while (common < m_ids.size() && common < parts.history.size()
+               && m_ids.at(common) == parts.history.at(common).id) {
+            ++common;
+        }
+
+        m_ids.resize(common);
+        m_ends.resize(common);
+        m_bytes.truncate(common ? m_ends.last() : 0);
+
+        for (qsizetype i = common; i < parts.history.size(); ++i) {
+            const Turn &turn = parts.history.at(i);
+            if (!m_bytes.isEmpty())
+                m_bytes += ',';
+            appendMessage(m_bytes, "user", turn.message);
+            m_bytes += ',';
+            appendMessage(m_bytes, "assistant", turn.response);
+            m_ids.append(turn.id);
+            m_ends.append(m_bytes.size());
+        }
+
+        m_stats.reusedTurns = int(common);
+        m_stats.serializedTurns = int(parts.history.size() - common);
+        m_stats.cachedBytes = m_bytes.size();
+        history = m_bytes; // copia implícita: el caché puede cambiar después
+    }
+
+    QByteArray out;
+    out.reserve(history.size() + 4096);
+    out += '[';
+    bool first = true;
+    const auto separator = [&out, &first]() {
+        if (!first)
+            out += ',';
+        first = false;
+    };
+    for (const QJsonValue &message : parts.head) {
+        separator();
+        out += compact(message.toObject());
+    }
+    if (!history.isEmpty()) {
+        separator();
+        out += history;
+    }
+    for (const QJsonValue &message : parts.tail) {
+        separator();
+        out += compact(message.toObject());
+    }
+    out += ']';
+    return out;
+}
+
+QByteArray DeepSeekRequestSerializer::assemble(const QJsonObject &fields,
+                                               const QByteArray &messagesJson)
+{
+    // QJsonDocument escribe las claves en orden; "messages" se intercala en
+    // su sitio para que el resultado coincida con el del objeto completo.
+    QByteArray out;
+    out.reserve(messagesJson.size() + 256);
+    out += '{';
+    bool inserted = false;
+    bool first = true;
+    for (auto it = fields.constBegin(); it != fields.constEnd(); ++it) {
+        if (!inserted && it.key() > QLatin1String("messages")) {
+            out += first ? "" : ",";
+            out += "\"messages\":" + messagesJson;
+            inserted = true;
+            first = false;
+        }
+        // {"clave":valor} sin las llaves
+        const QByteArray member = compact(QJsonObject{{it.key(), it.value()}});
+        out += first ? "" : ",";
+        out += QByteArrayView(member).sliced(1, member.size() - 2);
+        first = false;
+    }
+    if (!inserted) {
+        out += first ? "" : ",";
+        out += "\"messages\":" + messagesJson;
+    }
+    out += '}';
+    return out;
+}
+
+void DeepSeekRequestSerializer::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_ids.clear();
+    m_ends.clear();
+    m_bytes.clear();
+    m_stats = {};
+}
+
+DeepSeekRequestSerializer::Stats DeepSeekRequestSerializer::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+} // namespace DeepSeek
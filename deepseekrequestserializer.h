@@ -0,0 +1,64 @@
+#pragma once
+
+#include <QByteArray>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+namespace DeepSeek {
+
+// Serializa el cuerpo de /chat/completions en JSON compacto sin construir un
+// QJsonArray con todo el historial. Los turnos del historial se identifican
+// con un id estable: los bytes ya serializados del prefijo común con la
+// petición anterior se reutilizan tal cual y solo se serializan los turnos
+// nuevos. El resultado es idéntico byte a byte al de QJsonDocument, así que
+// las claves de DeepSeekResponseCache no cambian.
+//
+// Pensado para usarse desde un hilo de trabajo; todas las llamadas son
+// seguras entre hilos.
+class DeepSeekRequestSerializer
+{
+public:
+    struct Turn
+    {
+        qint64 id = 0; // distinto para cada entrada del historial, nunca reutilizado
+        QString message;
+        QString response;
+    };
+
+    struct Parts
+    {
+        QJsonArray head;     // mensajes antes del historial (prompt de sistema, proyecto)
+        QList<Turn> history; // en orden cronológico
+        QJsonArray tail;     // mensajes después (contexto volátil, mensaje del usuario)
+    };
+
+    struct Stats
+    {
+        int reusedTurns = 0;     // en la última llamada
+        int serializedTurns = 0; // en la última llamada
+        qint64 cachedBytes = 0;
+    };
+
+    // Contenido del array "messages", con los corchetes
+    QByteArray messagesJson(const Parts &parts);
+    // Objeto completo: fields más "messages" en su posición ordenada
+    static QByteArray assemble(const QJsonObject &fields, const QByteArray &messagesJson);
+
+    void reset();
+    Stats stats() const;
+
+private:
+    static QByteArray compact(const QJsonObject &object);
+    static void appendMessage(QByteArray &out, const QString &role, const QString &content);
+
+    mutable QMutex m_mutex;
+    QList<qint64> m_ids;
+    QList<qsizetype> m_ends; // fin en m_bytes de cada turno, sin la coma siguiente
+    QByteArray m_bytes;      // turnos del prefijo, separados por comas
+    Stats m_stats;
+};
+
+} // namespace DeepSeek
@@ -0,0 +1,216 @@
+#include "deepseekresponsecache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QList>
+#include <QMutexLocker>
+#include <QObject>
+#include <QSaveFile>
+
+#include <algorithm>
+
+namespace DeepSeek {
+
+static const char CacheFileSuffix[] = ".json";
+
+DeepSeekResponseCache::DeepSeekResponseCache(const QString &directory)
+    : m_directory(directory)
+{}
+
+void DeepSeekResponseCache::setDirectory(const QString &directory)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_directory == directory)
+        return;
+    m_directory = directory;
+    m_items.clear();
+    m_totalBytes = 0;
+    m_scanned = false;
+}
+
+QString DeepSeekResponseCache::directory() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_directory;
+}
+
+void DeepSeekResponseCache::setMaxBytes(qint64 maxBytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxBytes = qMax<qint64>(0, maxBytes);
+    if (m_scanned)
+        evict();
+}
+
+void DeepSeekResponseCache::setTimeToLive(qint64 seconds)
+{
+    QMutexLocker locker(&m_mutex);
+    m_ttlSeconds = qMax<qint64>(0, seconds);
+}
+
+QByteArray DeepSeekResponseCache::keyFor(const QUrl &endpoint, const QByteArray &requestBody)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(endpoint.toString(QUrl::NormalizePathSegments | QUrl::StripTrailingSlash).toUtf8());
+    hash.addData(QByteArrayView("\n"));
+    hash.addData(requestBody);
+    return hash.result().toHex();
+}
+
+bool DeepSeekResponseCache::isCacheable(double temperature)
+{
+    return qFuzzyIsNull(temperature);
+}
+
+std::optional<DeepSeekResponseCache::Entry> DeepSeekResponseCache::lookup(const QByteArray &key)
+{
+    QMutexLocker locker(&m_mutex);
+    ensureScanned();
+
+    if (!m_items.contains(key)) {
+        ++m_stats.misses;
+        return std::nullopt;
+    }
+
+    QFile file(filePath(key));
+    if (!file.open(QIODevice::ReadWrite)) {
+        remove(key);
+        ++m_stats.misses;
+        return std::nullopt;
+    }
+
+    const QJsonObject obj = QJsonDocument::fromJson(file.readAll()).object();
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    const qint64 created = obj.value("created").toInteger();
+
+    if (obj.isEmpty() || (m_ttlSeconds > 0 && now - created > m_ttlSeconds)) {
+        file.close();
+        remove(key);
+        ++m_stats.expired;
+        ++m_stats.misses;
+        return std::nullopt;
+    }
+
+    // La fecha de modificación es el "último uso" del orden LRU
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    m_items[key].lastAccess = now;
+    ++m_stats.hits;
+
+    return Entry{obj.value("content").toString(), obj.value("usage").toObject()};
+}
+
+bool DeepSeekResponseCache::store(const QByteArray &key, const Entry &entry, QString *errorString)
+{
+    QMutexLocker locker(&m_mutex);
+    ensureScanned();
+
+    if (!QDir().mkpath(m_directory)) {
+        if (errorString)
+            *errorString = QObject::tr("Failed to create directory: %1").arg(m_directory);
+        return false;
+    }
+
+    const QJsonObject obj{{"created", QDateTime::currentSecsSinceEpoch()},
+                          {"content", entry.content},
+                          {"usage", entry.usage}};
+    const QByteArray data = QJsonDocument(obj).toJson(QJsonDocument::Compact);
+
+    QSaveFile saver(filePath(key));
+    if (!saver.open(QIODevice::WriteOnly) || saver.write(data) != data.size() || !saver.commit()) {
+        if (errorString)
+            *errorString = QObject::tr("Cannot write to file: %1").arg(saver.errorString());
+        return false;
+    }
+
+    m_totalBytes -= m_items.value(key).size;
+    m_items.insert(key, {data.size(), QDateTime::currentSecsSinceEpoch()});
+    m_totalBytes += data.size();
+    ++m_stats.stores;
+
+    evict();
+    return true;
+}
+
+void DeepSeekResponseCache::recordBypass()
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_stats.bypassed;
+}
+
+void DeepSeekResponseCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    ensureScanned();
+    const QList<QByteArray> keys = m_items.keys();
+    for (const QByteArray &key : keys)
+        remove(key);
+}
+
+DeepSeekResponseCache::Stats DeepSeekResponseCache::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    Stats stats = m_stats;
+    stats.bytes = m_totalBytes;
+    stats.entries = int(m_items.size());
+    return stats;
+}
+
+QString DeepSeekResponseCache::filePath(const QByteArray &key) const
+{
+    return m_directory + '/' + QString::fromLatin1(key) + CacheFileSuffix;
+}
+
+void DeepSeekResponseCache::ensureScanned()
+{
+    if (m_scanned)
+        return;
+    m_scanned = true;
+
+    // Solo metadatos del directorio (tamaño y fecha); el contenido se lee en lookup()
+    const QFileInfoList files = QDir(m_directory).entryInfoList({QString("*") + CacheFileSuffix},
+                                                                QDir::Files);
+    for (const QFileInfo &info : files) {
+        const QByteArray key = info.completeBaseName().toLatin1();
+        m_items.insert(key, {info.size(), info.lastModified().toSecsSinceEpoch()});
+        m_totalBytes += info.size();
+    }
+    evict();
+}
+
+void DeepSeekResponseCache::remove(const QByteArray &key)
+{
+    const auto it = m_items.constFind(key);
+    if (it == m_items.constEnd())
+        return;
+    m_totalBytes -= it->size;
+    m_items.erase(it);
+    QFile::remove(filePath(key));
+}
+
+void DeepSeekResponseCache::evict()
+{
+    if (m_totalBytes <= m_maxBytes)
+        return;
+
+    QList<QPair<qint64, QByteArray>> byAccess;
+    byAccess.reserve(m_items.size());
+    for (auto it = m_items.cbegin(); it != m_items.cend(); ++it)
+        byAccess.append({it->lastAccess, it.key()});
+    std::sort(byAccess.begin(), byAccess.end());
+
+    // Se libera hasta el 90 % para no desalojar en cada inserción
+    const qint64 target = m_maxBytes - m_maxBytes / 10;
+    for (const auto &[lastAccess, key] : std::as_const(byAccess)) {
+        if (m_totalBytes <= target)
+            break;
+        remove(key);
+        ++m_stats.evictions;
+    }
+}
+
+} // namespace DeepSeek
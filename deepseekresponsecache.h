@@ -0,0 +1,82 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QJsonObject>
+#include <QMutex>
+#include <QString>
+#include <QUrl>
+
+#include <optional>
+
+namespace DeepSeek {
+
+// Caché en disco de respuestas completas, direccionada por contenido: la
+// clave es el SHA-256 del endpoint y del cuerpo de la petición (modelo, prompt
+// de sistema, mensajes y parámetros), así que dos peticiones idénticas al
+// mismo servidor comparten entrada; el mismo modelo en otro servidor no.
+// Un fichero por entrada; el orden LRU se mantiene con la fecha de
+// modificación, que se actualiza en cada acierto. Solo tiene sentido con
+// temperatura 0: con otra temperatura la respuesta no es reproducible.
+// Se puede usar desde varios hilos: lookup() corre fuera del hilo de la GUI.
+class DeepSeekResponseCache
+{
+public:
+    struct Entry
+    {
+        QString content;
+        QJsonObject usage;
+    };
+
+    struct Stats
+    {
+        qint64 hits = 0;
+        qint64 misses = 0;
+        qint64 bypassed = 0;
+        qint64 stores = 0;
+        qint64 evictions = 0;
+        qint64 expired = 0;
+        qint64 bytes = 0;
+        int entries = 0;
+    };
+
+    explicit DeepSeekResponseCache(const QString &directory = {});
+
+    void setDirectory(const QString &directory);
+    QString directory() const;
+    void setMaxBytes(qint64 maxBytes);
+    void setTimeToLive(qint64 seconds);
+
+    static QByteArray keyFor(const QUrl &endpoint, const QByteArray &requestBody);
+    static bool isCacheable(double temperature);
+
+    std::optional<Entry> lookup(const QByteArray &key);
+    bool store(const QByteArray &key, const Entry &entry, QString *errorString = nullptr);
+    void recordBypass();
+    void clear();
+
+    Stats stats() const;
+
+private:
+    struct Item
+    {
+        qint64 size = 0;
+        qint64 lastAccess = 0; // segundos desde epoch
+    };
+
+    QString filePath(const QByteArray &key) const;
+    void ensureScanned();
+    void remove(const QByteArray &key);
+    void evict();
+
+    mutable QMutex m_mutex;
+    QString m_directory;
+    QHash<QByteArray, Item> m_items;
+    qint64 m_totalBytes = 0;
+    qint64 m_maxBytes = 64ll * 1024 * 1024;
+    qint64 m_ttlSeconds = 7 * 24 * 3600;
+    bool m_scanned = false;
+    Stats m_stats;
+};
+
+} // namespace DeepSeek
@@ -0,0 +1,263 @@
+#include "deepseeksessionindex.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonParseError>
+#include <QObject>
+#include <QSaveFile>
+#include <QUuid>
+
+#include <algorithm>
+
+namespace DeepSeek {
+
+static constexpr int IndexVersion = 1;
+
+static void setError(QString *errorString, const QString &message)
+{
+    if (errorString)
+        *errorString = message;
+}
+
+DeepSeekSessionIndex::DeepSeekSessionIndex(const QString &directory)
+    : m_directory(directory)
+{}
+
+void DeepSeekSessionIndex::setDirectory(const QString &directory)
+{
+    m_directory = directory;
+    m_sessions.clear();
+    m_active.clear();
+}
+
+QString DeepSeekSessionIndex::indexPath() const
+{
+    return QDir(m_directory).filePath("index.json");
+}
+
+QString DeepSeekSessionIndex::logPath(const QString &id) const
+{
+    return QDir(m_directory).filePath(id + ".jsonl");
+}
+
+bool DeepSeekSessionIndex::load(QString *errorString)
+{
+    m_sessions.clear();
+    m_active.clear();
+
+    QFile file(indexPath());
+    if (!file.exists())
+        return true;
+    if (!file.open(QIODevice::ReadOnly)) {
+        setError(errorString, QObject::tr("Failed to open file: %1").arg(file.errorString()));
+        return false;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+        setError(errorString, QObject::tr("Invalid session index: %1").arg(parseError.errorString()));
+        return false;
+    }
+
+    const QJsonObject root = doc.object();
+    if (root.value("version").toInt() != IndexVersion) {
+        setError(errorString, QObject::tr("Unsupported session index version"));
+        return false;
+    }
+
+    for (const QJsonValue &value : root.value("sessions").toArray()) {
+        const QJsonObject object = value.toObject();
+        Session session;
+        session.id = object.value("id").toString();
+        // El id acaba en una ruta: nada de separadores ni ids vacíos
+        if (session.id.isEmpty() || session.id.contains('/') || session.id.contains('\\')
+            || session.id.startsWith('.'))
+            continue;
+        session.projectKey = object.value("project").toString();
+        session.name = object.value("name").toString();
+        session.created = QDateTime::fromString(object.value("created").toString(), Qt::ISODate);
+        session.updated = QDateTime::fromString(object.value("updated").toString(), Qt::ISODate);
+        session.turns = object.value("turns").toInt();
+        m_sessions.insert(session.id, session);
+    }
+
+    const QJsonObject active = root.value("active").toObject();
+    for (auto it = active.begin(); it != active.end(); ++it) {
+        const QString id = it.value().toString();
+        if (m_sessions.contains(id))
+            m_active.insert(it.key(), id);
+    }
+    return true;
+}
+
+bool DeepSeekSessionIndex::save(QString *errorString) const
+{
+    if (!QDir().mkpath(m_directory)) {
+        setError(errorString, QObject::tr("Failed to create directory: %1").arg(m_directory));
+        return false;
+    }
+
+    QJsonArray sessions;
+    for (const Session &session : m_sessions) {
+        QJsonObject object;
+        object["id"] = session.id;
+        object["project"] = session.projectKey;
+        object["name"] = session.name;
+        object["created"] = session.created.toString(Qt::ISODate);
+        object["updated"] = session.updated.toString(Qt::ISODate);
+        object["turns"] = session.turns;
+        sessions.append(object);
+    }
+
+    QJsonObject active;
+    for (auto it = m_active.cbegin(); it != m_active.cend(); ++it)
+        active[it.key()] = it.value();
+
+    QJsonObject root;
+    root["version"] = IndexVersion;
+    root["sessions"] = sessions;
+    root["active"] = active;
+
+    QSaveFile file(indexPath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        setError(errorString, QObject::tr("Failed to open file: %1").arg(file.errorString()));
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        setError(errorString, QObject::tr("Failed to save file: %1").arg(file.errorString()));
+        return false;
+    }
+    return true;
+}
+
+bool DeepSeekSessionIndex::importLog(const QString &logPath, const QString &name,
+                                     QString *errorString)
+{
+    if (m_sessions.contains(DefaultSessionId))
+        return true;
+
+    if (!QDir().mkpath(m_directory)) {
+        setError(errorString, QObject::tr("Failed to create directory: %1").arg(m_directory));
+        return false;
+    }
+
+    // Se mueve, no se copia: el registro puede ser grande. El índice binario
+    // va con él; si falta, DeepSeekHistoryStore lo reconstruye al abrir.
+    const QString target = this->logPath(DefaultSessionId);
+    if (QFile::exists(logPath)) {
+        if (!QFile::rename(logPath, target)) {
+            setError(errorString, QObject::tr("Failed to move %1 to %2").arg(logPath, target));
+            return false;
+        }
+        if (QFile::exists(logPath + ".idx") && !QFile::rename(logPath + ".idx", target + ".idx"))
+            QFile::remove(logPath + ".idx");
+    }
+
+    const QFileInfo info(target);
+    Session session;
+    session.id = DefaultSessionId;
+    session.name = name;
+    session.created = info.exists() ? info.lastModified() : QDateTime::currentDateTimeUtc();
+    session.updated = session.created;
+    m_sessions.insert(session.id, session);
+    if (!m_active.contains(QString()))
+        m_active.insert(QString(), session.id);
+    return true;
+}
+
+QList<DeepSeekSessionIndex::Session> DeepSeekSessionIndex::sessions(const QString &projectKey) const
+{
+    QList<Session> result;
+    for (const Session &session : m_sessions) {
+        if (session.projectKey == projectKey)
+            result.append(session);
+    }
+    std::sort(result.begin(), result.end(), [](const Session &a, const Session &b) {
+        if (a.updated != b.updated)
+            return a.updated > b.updated;
+        return a.created > b.created;
+    });
+    return result;
+}
+
+const DeepSeekSessionIndex::Session *DeepSeekSessionIndex::find(const QString &id) const
+{
+    const auto it = m_sessions.constFind(id);
+    return it == m_sessions.cend() ? nullptr : &it.value();
+}
+
+DeepSeekSessionIndex::Session DeepSeekSessionIndex::create(const QString &projectKey,
+                                                           const QString &name)
+{
+    Session session;
+    session.id = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    session.projectKey = projectKey;
+    session.name = name;
+    session.created = QDateTime::currentDateTimeUtc();
+    session.updated = session.created;
+    m_sessions.insert(session.id, session);
+    return session;
+}
+
+bool DeepSeekSessionIndex::remove(const QString &id, QString *errorString)
+{
+    const auto it = m_sessions.constFind(id);
+    if (it == m_sessions.cend())
+        return true;
+
+    const QString projectKey = it->projectKey;
+    m_sessions.erase(it);
+    if (m_active.value(projectKey) == id)
+        m_active.remove(projectKey);
+
+    const QString log = logPath(id);
+    bool ok = true;
+    for (const QString &path : {log, log + ".idx"}) {
+        if (QFile::exists(path) && !QFile::remove(path)) {
+            setError(errorString, QObject::tr("Failed to remove file: %1").arg(path));
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+void DeepSeekSessionIndex::rename(const QString &id, const QString &name)
+{
+    const auto it = m_sessions.find(id);
+    if (it != m_sessions.end())
+        it->name = name;
+}
+
+void DeepSeekSessionIndex::touch(const QString &id, int turns)
+{
+    const auto it = m_sessions.find(id);
+    if (it == m_sessions.end())
+        return;
+    it->turns = turns;
+    it->updated = QDateTime::currentDateTimeUtc();
+}
+
+QString DeepSeekSessionIndex::activeSession(const QString &projectKey) const
+{
+    const QString id = m_active.value(projectKey);
+    if (m_sessions.contains(id))
+        return id;
+
+    // Sin sesión activa recordada: la más reciente del proyecto
+    const QList<Session> candidates = sessions(projectKey);
+    return candidates.isEmpty() ? QString() : candidates.first().id;
+}
+
+void DeepSeekSessionIndex::setActiveSession(const QString &projectKey, const QString &id)
+{
+    if (m_sessions.contains(id))
+        m_active.insert(projectKey, id);
+}
+
+} // namespace DeepSeek
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+namespace DeepSeek {
+
+// Índice de las sesiones de conversación: qué sesiones hay, de qué proyecto
+// es cada una y cuál está activa en cada proyecto. Es un único JSON pequeño
+// (index.json) que se lee entero al arrancar; el historial de cada sesión
+// vive aparte, en su propio registro de DeepSeekHistoryStore (<id>.jsonl), y
+// solo se abre el de la sesión activa. Cambiar de sesión no toca los demás.
+//
+// El proyecto se identifica por la ruta de su fichero de proyecto; la clave
+// vacía agrupa lo que se pregunta sin proyecto abierto.
+class DeepSeekSessionIndex
+{
+public:
+    struct Session
+    {
+        QString id;
+        QString projectKey;
+        QString name;
+        QDateTime created;
+        QDateTime updated; // último turno guardado
+        int turns = 0;
+    };
+
+    static constexpr char DefaultSessionId[] = "default";
+
+    explicit DeepSeekSessionIndex(const QString &directory = {});
+
+    void setDirectory(const QString &directory);
+    QString directory() const { return m_directory; }
+    QString indexPath() const;
+    QString logPath(const QString &id) const;
+
+    bool load(QString *errorString = nullptr);
+    bool save(QString *errorString = nullptr) const;
+
+    // Registra la sesión DefaultSessionId, sin proyecto, y le mueve el
+    // registro global anterior a las sesiones si existe. No hace nada si ya
+    // está registrada.
+    bool importLog(const QString &logPath, const QString &name, QString *errorString = nullptr);
+
+    // Las del proyecto, la usada más recientemente primero
+    QList<Session> sessions(const QString &projectKey) const;
+    const Session *find(const QString &id) const;
+    int count() const { return int(m_sessions.size()); }
+
+    Session create(const QString &projectKey, const QString &name);
+    bool remove(const QString &id, QString *errorString = nullptr);
+    void rename(const QString &id, const QString &name);
+    void touch(const QString &id, int turns);
+
+    // Vacío si el proyecto no tiene ninguna
+    QString activeSession(const QString &projectKey) const;
+    void setActiveSession(const QString &projectKey, const QString &id);
+
+private:
+    QString m_directory;
+    QHash<QString, Session> m_sessions;
+    QHash<QString, QString> m_active; // proyecto -> sesión
+};
+
+} // namespace DeepSeek
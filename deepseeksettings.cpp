@@ -4,195 +4,249 @@
 namespace DeepSeek {
 
 DeepSeekSettings::DeepSeekSettings(QObject *parent)
-    : QObject(parent),
-      m_isValid(false),
-      m_temperature(0.7),
-      m_maxTokens(2048)
+    : QObject(parent)
 {
-    initDefaults();
+    auto defaults = std::make_shared<Snapshot>();
+    defaults->version = 1;
+    validate(*defaults);
+    publish(std::move(defaults));
     load();
 }
 
-void DeepSeekSettings::initDefaults()
+DeepSeekSettings::SnapshotPtr DeepSeekSettings::snapshot() const
 {
-    QMutexLocker locker(&m_dataMutex);
-    m_apiUrl = QUrl("https://api.deepseek.com/v1");
-    m_model = "Without Model";
-    m_systemPrompt = "You are a helpful AI assistant";
+#ifdef __cpp_lib_atomic_shared_ptr
+    return m_snapshot.load(std::memory_order_acquire);
+#else
+    return std::atomic_load_explicit(&m_snapshot, std::memory_order_acquire);
+#endif
 }
 
-// Implementación de getters (thread-safe)
-QString DeepSeekSettings::apiKey() const {
-    QMutexLocker locker(&m_dataMutex);
-    return m_apiKey;
-}
-
-QUrl DeepSeekSettings::apiUrl() const {
-    QMutexLocker locker(&m_dataMutex);
-    return m_apiUrl;
+void DeepSeekSettings::publish(SnapshotPtr snapshot)
+{
+    // La instantánea anterior vive mientras alguien la tenga
+#ifdef __cpp_lib_atomic_shared_ptr
+    m_snapshot.store(std::move(snapshot), std::memory_order_release);
+#else
+    std::atomic_store_explicit(&m_snapshot, std::move(snapshot), std::memory_order_release);
+#endif
 }
 
-void DeepSeekSettings::setModel(const QString &model)
+void DeepSeekSettings::update(const std::function<void(Snapshot &)> &change)
 {
+    Fields changed;
     {
-        QMutexLocker locker(&m_dataMutex);
-        if (m_model == model)
+        QMutexLocker locker(&m_writeMutex);
+        const SnapshotPtr current = snapshot();
+        auto next = std::make_shared<Snapshot>(*current);
+        change(*next);
+        changed = diff(*current, *next);
+        if (!changed)
             return;
-        m_model = model;
+        next->version = current->version + 1;
+        validate(*next);
+        publish(std::move(next));
     }
-    emit modelChanged();
-    emit settingsChanged();
+    emit settingsChanged(changed);
+}
+
+DeepSeekSettings::Fields DeepSeekSettings::diff(const Snapshot &before, const Snapshot &after)
+{
+    Fields changed;
+    changed.setFlag(ApiKey, before.apiKey != after.apiKey);
+    changed.setFlag(ApiUrl, before.apiUrl != after.apiUrl);
+    changed.setFlag(Model, before.model != after.model);
+    changed.setFlag(SystemPrompt, before.systemPrompt != after.systemPrompt);
+    changed.setFlag(Temperature, !qFuzzyCompare(before.temperature, after.temperature));
+    changed.setFlag(MaxTokens, before.maxTokens != after.maxTokens);
+    changed.setFlag(StreamResponses, before.streamResponses != after.streamResponses);
+    changed.setFlag(ContextTokens, before.contextTokens != after.contextTokens);
+    changed.setFlag(ResponseCacheEnabled, before.responseCacheEnabled != after.responseCacheEnabled);
+    changed.setFlag(ResponseCacheMaxMb, before.responseCacheMaxMb != after.responseCacheMaxMb);
+    changed.setFlag(ResponseCacheTtlHours,
+                    before.responseCacheTtlHours != after.responseCacheTtlHours);
+    changed.setFlag(ProjectContextEnabled,
+                    before.projectContextEnabled != after.projectContextEnabled);
+    changed.setFlag(ProjectContextTokens, before.projectContextTokens != after.projectContextTokens);
+    changed.setFlag(EmbeddingsEnabled, before.embeddingsEnabled != after.embeddingsEnabled);
+    changed.setFlag(EmbeddingsUrl, before.embeddingsUrl != after.embeddingsUrl);
+    changed.setFlag(EmbeddingModel, before.embeddingModel != after.embeddingModel);
+    changed.setFlag(EmbeddingsQuantized, before.embeddingsQuantized != after.embeddingsQuantized);
+    changed.setFlag(TokenizerPath, before.tokenizerPath != after.tokenizerPath);
+    changed.setFlag(PrefixCacheLayout, before.prefixCacheLayout != after.prefixCacheLayout);
+    return changed;
+}
+
+void DeepSeekSettings::validate(Snapshot &snapshot)
+{
+    snapshot.isValid = false;
+    snapshot.validationError.clear();
+    if (snapshot.apiKey.isEmpty())
+        snapshot.validationError = tr("API Key is required");
+    else if (!snapshot.apiUrl.isValid())
+        snapshot.validationError = tr("Invalid API URL");
+    else if (snapshot.model.isEmpty())
+        snapshot.validationError = tr("Model is required");
+    else
+        snapshot.isValid = true;
+}
+
+// Implementación de setters (thread-safe)
+void DeepSeekSettings::setApiKey(const QString &apiKey)
+{
+    update([&apiKey](Snapshot &s) { s.apiKey = apiKey; });
+}
+
+void DeepSeekSettings::setApiUrl(const QUrl &apiUrl)
+{
+    update([&apiUrl](Snapshot &s) { s.apiUrl = apiUrl; });
+}
+
+void DeepSeekSettings::setModel(const QString &model)
+{
+    update([&model](Snapshot &s) { s.model = model; });
 }
 
 void DeepSeekSettings::setSystemPrompt(const QString &systemPrompt)
 {
-    {
-        QMutexLocker locker(&m_dataMutex);
-        if (m_systemPrompt == systemPrompt)
-            return;
-        m_systemPrompt = systemPrompt;
-    }
-    emit systemPromptChanged();
-    emit settingsChanged();
+    update([&systemPrompt](Snapshot &s) { s.systemPrompt = systemPrompt; });
 }
 
 void DeepSeekSettings::setTemperature(double temperature)
 {
-    {
-        QMutexLocker locker(&m_dataMutex);
-        if (qFuzzyCompare(m_temperature, temperature))
-            return;
-        m_temperature = temperature;
-    }
-    emit temperatureChanged();
-    emit settingsChanged();
+    update([temperature](Snapshot &s) { s.temperature = temperature; });
 }
 
 void DeepSeekSettings::setMaxTokens(int maxTokens)
 {
-    {
-        QMutexLocker locker(&m_dataMutex);
-        if (m_maxTokens == maxTokens)
-            return;
-        m_maxTokens = maxTokens;
-    }
-    emit maxTokensChanged();
-    emit settingsChanged();
+    update([maxTokens](Snapshot &s) { s.maxTokens = maxTokens; });
 }
 
-QString DeepSeekSettings::model() const {
-    QMutexLocker locker(&m_dataMutex);
-    return m_model;
+void DeepSeekSettings::setStreamResponses(bool stream)
+{
+    update([stream](Snapshot &s) { s.streamResponses = stream; });
 }
 
-QString DeepSeekSettings::systemPrompt() const {
-    QMutexLocker locker(&m_dataMutex);
-    return m_systemPrompt;
+void DeepSeekSettings::setContextTokens(int contextTokens)
+{
+    update([contextTokens](Snapshot &s) { s.contextTokens = contextTokens; });
 }
 
-double DeepSeekSettings::temperature() const {
-    QMutexLocker locker(&m_dataMutex);
-    return m_temperature;
+void DeepSeekSettings::setResponseCacheEnabled(bool responseCacheEnabled)
+{
+    update([responseCacheEnabled](Snapshot &s) { s.responseCacheEnabled = responseCacheEnabled; });
 }
 
-int DeepSeekSettings::maxTokens() const {
-    QMutexLocker locker(&m_dataMutex);
-    return m_maxTokens;
+void DeepSeekSettings::setResponseCacheMaxMb(int responseCacheMaxMb)
+{
+    update([responseCacheMaxMb](Snapshot &s) { s.responseCacheMaxMb = responseCacheMaxMb; });
 }
 
-// Implementación de setters (thread-safe)
-void DeepSeekSettings::setApiKey(const QString &apiKey) {
-    {
-        QMutexLocker locker(&m_dataMutex);
-        if (m_apiKey == apiKey) return;
-        m_apiKey = apiKey;
-    }
-    validateSettings();
-    emit apiKeyChanged();
-    emit settingsChanged();
+void DeepSeekSettings::setResponseCacheTtlHours(int responseCacheTtlHours)
+{
+    update([responseCacheTtlHours](Snapshot &s) { s.responseCacheTtlHours = responseCacheTtlHours; });
 }
 
-void DeepSeekSettings::setApiUrl(const QUrl &apiUrl) {
-    {
-        QMutexLocker locker(&m_dataMutex);
-        if (m_apiUrl == apiUrl) return;
-        m_apiUrl = apiUrl;
-    }
-    validateSettings();
-    emit apiUrlChanged();
-    emit settingsChanged();
+void DeepSeekSettings::setProjectContextEnabled(bool projectContextEnabled)
+{
+    update([projectContextEnabled](Snapshot &s) { s.projectContextEnabled = projectContextEnabled; });
 }
 
-// ... (implementaciones similares para otros setters)
+void DeepSeekSettings::setProjectContextTokens(int projectContextTokens)
+{
+    update([projectContextTokens](Snapshot &s) { s.projectContextTokens = projectContextTokens; });
+}
 
-bool DeepSeekSettings::isValid() const {
-    QMutexLocker locker(&m_dataMutex);
-    return m_isValid;
+void DeepSeekSettings::setEmbeddingsEnabled(bool embeddingsEnabled)
+{
+    update([embeddingsEnabled](Snapshot &s) { s.embeddingsEnabled = embeddingsEnabled; });
 }
 
-QString DeepSeekSettings::validationError() const {
-    QMutexLocker locker(&m_dataMutex);
-    return m_validationError;
+void DeepSeekSettings::setEmbeddingsUrl(const QString &embeddingsUrl)
+{
+    update([&embeddingsUrl](Snapshot &s) { s.embeddingsUrl = embeddingsUrl; });
 }
 
-void DeepSeekSettings::validateSettings() {
-    QMutexLocker locker(&m_dataMutex);
-    
-    m_isValid = true;
-    m_validationError.clear();
+void DeepSeekSettings::setEmbeddingModel(const QString &embeddingModel)
+{
+    update([&embeddingModel](Snapshot &s) { s.embeddingModel = embeddingModel; });
+}
 
-    if (m_apiKey.isEmpty()) {
-        m_isValid = false;
-        m_validationError = tr("API Key is required");
-        return;
-    }
+void DeepSeekSettings::setEmbeddingsQuantized(bool embeddingsQuantized)
+{
+    update([embeddingsQuantized](Snapshot &s) { s.embeddingsQuantized = embeddingsQuantized; });
+}
 
-    if (!m_apiUrl.isValid()) {
-        m_isValid = false;
-        m_validationError = tr("Invalid API URL");
-        return;
-    }
+void DeepSeekSettings::setTokenizerPath(const QString &tokenizerPath)
+{
+    update([&tokenizerPath](Snapshot &s) { s.tokenizerPath = tokenizerPath; });
+}
 
-    if (m_model.isEmpty()) {
-        m_isValid = false;
-        m_validationError = tr("Model is required");
-        return;
-    }
+void DeepSeekSettings::setPrefixCacheLayout(bool prefixCacheLayout)
+{
+    update([prefixCacheLayout](Snapshot &s) { s.prefixCacheLayout = prefixCacheLayout; });
 }
 
 void DeepSeekSettings::load() {
     auto *settings = Core::ICore::settings();
     settings->beginGroup("DeepSeek");
 
-    setApiKey(settings->value("ApiKey").toString());
-    setApiUrl(settings->value("ApiUrl", m_apiUrl.toString()).toString());
-    setModel(settings->value("Model", m_model).toString());
-    setSystemPrompt(settings->value("SystemPrompt", m_systemPrompt).toString());
-    setTemperature(settings->value("Temperature", m_temperature).toDouble());
-    setMaxTokens(settings->value("MaxTokens", m_maxTokens).toInt());
+    // Todo en una publicación: una sola señal y una sola validación
+    update([settings](Snapshot &s) {
+        s.apiKey = settings->value("ApiKey").toString();
+        s.apiUrl = QUrl(settings->value("ApiUrl", s.apiUrl.toString()).toString());
+        s.model = settings->value("Model", s.model).toString();
+        s.systemPrompt = settings->value("SystemPrompt", s.systemPrompt).toString();
+        s.temperature = settings->value("Temperature", s.temperature).toDouble();
+        s.maxTokens = settings->value("MaxTokens", s.maxTokens).toInt();
+        s.streamResponses = settings->value("StreamResponses", s.streamResponses).toBool();
+        s.contextTokens = settings->value("ContextTokens", s.contextTokens).toInt();
+        s.responseCacheEnabled = settings->value("ResponseCache", s.responseCacheEnabled).toBool();
+        s.responseCacheMaxMb = settings->value("ResponseCacheMaxMB", s.responseCacheMaxMb).toInt();
+        s.responseCacheTtlHours
+            = settings->value("ResponseCacheTtlHours", s.responseCacheTtlHours).toInt();
+        s.projectContextEnabled = settings->value("ProjectContext", s.projectContextEnabled).toBool();
+        s.projectContextTokens
+            = settings->value("ProjectContextTokens", s.projectContextTokens).toInt();
+        s.embeddingsEnabled = settings->value("Embeddings", s.embeddingsEnabled).toBool();
+        s.embeddingsUrl = settings->value("EmbeddingsUrl", s.embeddingsUrl).toString();
+        s.embeddingModel = settings->value("EmbeddingModel", s.embeddingModel).toString();
+        s.embeddingsQuantized = settings->value("EmbeddingsInt8", s.embeddingsQuantized).toBool();
+        s.tokenizerPath = settings->value("TokenizerPath", s.tokenizerPath).toString();
+        s.prefixCacheLayout = settings->value("PrefixCacheLayout", s.prefixCacheLayout).toBool();
+    });
 
     settings->endGroup();
-    validateSettings();
 }
 
 void DeepSeekSettings::save() {
     auto settings = Core::ICore::settings();
     settings->beginGroup("DeepSeek");
 
-    {
-        QMutexLocker locker(&m_dataMutex);
-        settings->setValue("ApiKey", m_apiKey);
-        settings->setValue("ApiUrl", m_apiUrl.toString());
-        settings->setValue("Model", m_model);
-        settings->setValue("SystemPrompt", m_systemPrompt);
-        settings->setValue("Temperature", m_temperature);
-        settings->setValue("MaxTokens", m_maxTokens);
-    }
-
+    const SnapshotPtr s = snapshot();
+    settings->setValue("ApiKey", s->apiKey);
+    settings->setValue("ApiUrl", s->apiUrl.toString());
+    settings->setValue("Model", s->model);
+    settings->setValue("SystemPrompt", s->systemPrompt);
+    settings->setValue("Temperature", s->temperature);
+    settings->setValue("MaxTokens", s->maxTokens);
+    settings->setValue("StreamResponses", s->streamResponses);
+    settings->setValue("ContextTokens", s->contextTokens);
+    settings->setValue("ResponseCache", s->responseCacheEnabled);
+    settings->setValue("ResponseCacheMaxMB", s->responseCacheMaxMb);
+    settings->setValue("ResponseCacheTtlHours", s->responseCacheTtlHours);
+    settings->setValue("ProjectContext", s->projectContextEnabled);
+    settings->setValue("ProjectContextTokens", s->projectContextTokens);
+    settings->setValue("Embeddings", s->embeddingsEnabled);
+    settings->setValue("EmbeddingsUrl", s->embeddingsUrl);
+    settings->setValue("EmbeddingModel", s->embeddingModel);
+    settings->setValue("EmbeddingsInt8", s->embeddingsQuantized);
+    settings->setValue("TokenizerPath", s->tokenizerPath);
+    settings->setValue("PrefixCacheLayout", s->prefixCacheLayout);
+
+    // Los valores ya se publicaron al cambiarlos: no hay nada que notificar
     settings->endGroup();
     settings->sync();
-    validateSettings();
-    emit settingsChanged();
 }
 
 } // namespace DeepSeek
@@ -5,71 +5,158 @@
 #include <QUrl>
 #include "singleton.h"
 
+#include <atomic>
+#include <functional>
+#include <memory>
+
 namespace DeepSeek {
 
+// Los ajustes se publican como instantáneas inmutables con número de versión.
+// Leer es lock-free: snapshot() devuelve la instantánea vigente y quien la
+// tiene la puede usar entera sin que cambie a mitad de una petición. Las
+// escrituras se serializan con m_writeMutex, construyen una copia nueva y la
+// publican de una vez; settingsChanged() se emite una sola vez por escritura
+// con los campos que han cambiado.
 class DeepSeekSettings : public QObject
 {
     Q_OBJECT
     friend class Singleton<DeepSeekSettings>;
 
 public:
-    // Getters (const para thread-safety)
-    QString apiKey() const;
-    QUrl apiUrl() const;
-    QString model() const;
-    QString systemPrompt() const;
-    double temperature() const;
-    int maxTokens() const;
-
-    // Setters con mutex interno
+    enum Field : quint32 {
+        ApiKey = 1u << 0,
+        ApiUrl = 1u << 1,
+        Model = 1u << 2,
+        SystemPrompt = 1u << 3,
+        Temperature = 1u << 4,
+        MaxTokens = 1u << 5,
+        StreamResponses = 1u << 6,
+        ContextTokens = 1u << 7,
+        ResponseCacheEnabled = 1u << 8,
+        ResponseCacheMaxMb = 1u << 9,
+        ResponseCacheTtlHours = 1u << 10,
+        ProjectContextEnabled = 1u << 11,
+        ProjectContextTokens = 1u << 12,
+        EmbeddingsEnabled = 1u << 13,
+        EmbeddingsUrl = 1u << 14,
+        EmbeddingModel = 1u << 15,
+        EmbeddingsQuantized = 1u << 16,
+        TokenizerPath = 1u << 17,
+        PrefixCacheLayout = 1u << 18
+    };
+    Q_DECLARE_FLAGS(Fields, Field)
+    Q_FLAG(Fields)
+
+    struct Snapshot
+    {
+        quint64 version = 0; // crece en cada publicación; la primera es la 1
+
+        QString apiKey;
+        QUrl apiUrl = QUrl("https://api.deepseek.com/v1");
+        QString model = "Without Model";
+        QString systemPrompt = "You are a helpful AI assistant";
+        double temperature = 0.7;
+        int maxTokens = 2048;
+        bool streamResponses = true;
+        int contextTokens = 0; // 0 = según el modelo
+        bool responseCacheEnabled = true;
+        int responseCacheMaxMb = 64; // MB en disco
+        int responseCacheTtlHours = 168;
+        bool projectContextEnabled = true;
+        int projectContextTokens = 2000;
+        bool embeddingsEnabled = false;
+        QString embeddingsUrl; // vacío: la misma URL que el chat
+        QString embeddingModel = "text-embedding-3-small";
+        bool embeddingsQuantized = true; // vectores int8 en lugar de float32
+        QString tokenizerPath; // tokenizer.json del modelo; vacío: estimación aproximada
+        bool prefixCacheLayout = true; // orden de mensajes estable para la caché de prefijos del servidor
+
+        // Calculado al publicar
+        bool isValid = false;
+        QString validationError;
+    };
+    using SnapshotPtr = std::shared_ptr<const Snapshot>;
+
+    // Instantánea vigente, sin bloqueos; para las rutas calientes
+    SnapshotPtr snapshot() const;
+
+    // Cambia varios ajustes en una sola publicación y una sola señal
+    void update(const std::function<void(Snapshot &)> &change);
+
+    static Fields diff(const Snapshot &before, const Snapshot &after);
+
+    // Getters de conveniencia: leen un campo de la instantánea vigente
+    QString apiKey() const { return snapshot()->apiKey; }
+    QUrl apiUrl() const { return snapshot()->apiUrl; }
+    QString model() const { return snapshot()->model; }
+    QString systemPrompt() const { return snapshot()->systemPrompt; }
+    double temperature() const { return snapshot()->temperature; }
+    int maxTokens() const { return snapshot()->maxTokens; }
+    bool streamResponses() const { return snapshot()->streamResponses; }
+    int contextTokens() const { return snapshot()->contextTokens; }
+    bool responseCacheEnabled() const { return snapshot()->responseCacheEnabled; }
+    int responseCacheMaxMb() const { return snapshot()->responseCacheMaxMb; }
+    int responseCacheTtlHours() const { return snapshot()->responseCacheTtlHours; }
+    bool projectContextEnabled() const { return snapshot()->projectContextEnabled; }
+    int projectContextTokens() const { return snapshot()->projectContextTokens; }
+    bool embeddingsEnabled() const { return snapshot()->embeddingsEnabled; }
+    QString embeddingsUrl() const { return snapshot()->embeddingsUrl; }
+    QString embeddingModel() const { return snapshot()->embeddingModel; }
+    bool embeddingsQuantized() const { return snapshot()->embeddingsQuantized; }
+    QString tokenizerPath() const { return snapshot()->tokenizerPath; }
+    bool prefixCacheLayout() const { return snapshot()->prefixCacheLayout; }
+
+    // Setters: una publicación cada uno; para varios a la vez, update()
     void setApiKey(const QString &apiKey);
     void setApiUrl(const QUrl &apiUrl);
     void setModel(const QString &model);
     void setSystemPrompt(const QString &systemPrompt);
     void setTemperature(double temperature);
     void setMaxTokens(int maxTokens);
+    void setStreamResponses(bool stream);
+    void setContextTokens(int contextTokens);
+    void setResponseCacheEnabled(bool responseCacheEnabled);
+    void setResponseCacheMaxMb(int responseCacheMaxMb);
+    void setResponseCacheTtlHours(int responseCacheTtlHours);
+    void setProjectContextEnabled(bool projectContextEnabled);
+    void setProjectContextTokens(int projectContextTokens);
+    void setEmbeddingsEnabled(bool embeddingsEnabled);
+    void setEmbeddingsUrl(const QString &embeddingsUrl);
+    void setEmbeddingModel(const QString &embeddingModel);
+    void setEmbeddingsQuantized(bool embeddingsQuantized);
+    void setTokenizerPath(const QString &tokenizerPath);
+    void setPrefixCacheLayout(bool prefixCacheLayout);
 
-    // Validación (const para thread-safety)
-    bool isValid() const;
-    QString validationError() const;
+    bool isValid() const { return snapshot()->isValid; }
+    QString validationError() const { return snapshot()->validationError; }
 
-    // Cargar/Guardar con mutex interno
     void load();
     void save();
 
 signals:
-    // Las señales son thread-safe en Qt
-    void settingsChanged();
-    void apiKeyChanged();
-    void apiUrlChanged();
-    void modelChanged();
-    void systemPromptChanged();
-    void temperatureChanged();
-    void maxTokensChanged();
+    // Una vez por publicación, con los campos que han cambiado
+    void settingsChanged(DeepSeek::DeepSeekSettings::Fields changed);
 
 protected:
     explicit DeepSeekSettings(QObject *parent = nullptr);
     ~DeepSeekSettings() override = default;
 
 private:
-    void initDefaults();
-    void validateSettings();
-
-    // Datos protegidos por mutex
-    mutable QMutex m_dataMutex;
-    QString m_apiKey;
-    QUrl m_apiUrl;
-    QString m_model;
-    QString m_systemPrompt;
-    double m_temperature;
-    int m_maxTokens;
-
-    // Estado de validación
-    bool m_isValid;
-    QString m_validationError;
+    static void validate(Snapshot &snapshot);
+
+    void publish(SnapshotPtr snapshot);
+
+    QMutex m_writeMutex; // solo entre escritores
+#ifdef __cpp_lib_atomic_shared_ptr
+    std::atomic<SnapshotPtr> m_snapshot;
+#else
+    SnapshotPtr m_snapshot; // con std::atomic_load/atomic_store (libc++ aún sin atomic<shared_ptr>)
+#endif
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(DeepSeekSettings::Fields)
+
 // Alias para el Singleton thread-safe
 typedef Singleton<DeepSeekSettings> DSS;
 
-} // namespace DeepSeek
\ No newline at end of file
+} // namespace DeepSeek
@@ -0,0 +1,205 @@
+#include "deepseeksimilarity.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define DEEPSEEK_AVX2_TARGET __attribute__((target("avx2,fma")))
+#define DEEPSEEK_HAVE_AVX2 1
+#elif defined(__AVX2__)
+// MSVC solo genera AVX2 con /arch:AVX2 y entonces ya está garantizado
+#define DEEPSEEK_AVX2_TARGET
+#define DEEPSEEK_HAVE_AVX2 1
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define DEEPSEEK_HAVE_NEON 1
+#endif
+
+namespace DeepSeek {
+
+namespace {
+
+float dotScalar(const float *a, const float *b, int dimension)
+{
+    float sum = 0.0f;
+    for (int i = 0; i < dimension; ++i)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+std::int32_t dotInt8Scalar(const std::int8_t *a, const std::int8_t *b, int dimension)
+{
+    std::int32_t sum = 0;
+    for (int i = 0; i < dimension; ++i)
+        sum += std::int32_t(a[i]) * std::int32_t(b[i]);
+    return sum;
+}
+
+#ifdef DEEPSEEK_HAVE_AVX2
+
+DEEPSEEK_AVX2_TARGET float dotAvx2(const float *a, const float *b, int dimension)
+{
+    // Dos acumuladores para no encadenar la latencia de cada FMA
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 16 <= dimension; i += 16) {
+        sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), sum0);
+        sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), sum1);
+    }
+    for (; i + 8 <= dimension; i += 8)
+        sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), sum0);
+
+    const __m256 sum = _mm256_add_ps(sum0, sum1);
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_add_ss(half, _mm_movehdup_ps(half));
+    return _mm_cvtss_f32(half) + dotScalar(a + i, b + i, dimension - i);
+}
+
+DEEPSEEK_AVX2_TARGET std::int32_t dotInt8Avx2(const std::int8_t *a, const std::int8_t *b,
+                                               int dimension)
+{
+    // 16 bytes -> 16 enteros de 16 bits -> madd suma pares en 8 enteros de 32
+    __m256i sum = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 16 <= dimension; i += 16) {
+        const __m256i va = _mm256_cvtepi8_epi16(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)));
+        const __m256i vb = _mm256_cvtepi8_epi16(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i)));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(va, vb));
+    }
+
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(half) + dotInt8Scalar(a + i, b + i, dimension - i);
+}
+
+bool cpuHasAvx2()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return supported;
+#else
+    return true;
+#endif
+}
+
+#endif // DEEPSEEK_HAVE_AVX2
+
+#ifdef DEEPSEEK_HAVE_NEON
+
+float dotNeon(const float *a, const float *b, int dimension)
+{
+    float32x4_t sum0 = vdupq_n_f32(0.0f);
+    float32x4_t sum1 = vdupq_n_f32(0.0f);
+    int i = 0;
+    for (; i + 8 <= dimension; i += 8) {
+        sum0 = vfmaq_f32(sum0, vld1q_f32(a + i), vld1q_f32(b + i));
+        sum1 = vfmaq_f32(sum1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    return vaddvq_f32(vaddq_f32(sum0, sum1)) + dotScalar(a + i, b + i, dimension - i);
+}
+
+std::int32_t dotInt8Neon(const std::int8_t *a, const std::int8_t *b, int dimension)
+{
+    int32x4_t sum = vdupq_n_s32(0);
+    int i = 0;
+    for (; i + 16 <= dimension; i += 16) {
+        const int8x16_t va = vld1q_s8(a + i);
+        const int8x16_t vb = vld1q_s8(b + i);
+        sum = vpadalq_s16(sum, vmull_s8(vget_low_s8(va), vget_low_s8(vb)));
+        sum = vpadalq_s16(sum, vmull_s8(vget_high_s8(va), vget_high_s8(vb)));
+    }
+    return vaddvq_s32(sum) + dotInt8Scalar(a + i, b + i, dimension - i);
+}
+
+#endif // DEEPSEEK_HAVE_NEON
+
+} // namespace
+
+float DeepSeekSimilarity::dot(const float *a, const float *b, int dimension)
+{
+#if defined(DEEPSEEK_HAVE_AVX2)
+    if (cpuHasAvx2())
+        return dotAvx2(a, b, dimension);
+#elif defined(DEEPSEEK_HAVE_NEON)
+    return dotNeon(a, b, dimension);
+#endif
+    return dotScalar(a, b, dimension);
+}
+
+std::int32_t DeepSeekSimilarity::dotInt8(const std::int8_t *a, const std::int8_t *b, int dimension)
+{
+#if defined(DEEPSEEK_HAVE_AVX2)
+    if (cpuHasAvx2())
+        return dotInt8Avx2(a, b, dimension);
+#elif defined(DEEPSEEK_HAVE_NEON)
+    return dotInt8Neon(a, b, dimension);
+#endif
+    return dotInt8Scalar(a, b, dimension);
+}
+
+bool DeepSeekSimilarity::normalize(std::vector<float> &vector)
+{
+    const float norm = std::sqrt(dot(vector.data(), vector.data(), int(vector.size())));
+    if (norm <= 0.0f || !std::isfinite(norm))
+        return false;
+    for (float &value : vector)
+        value /= norm;
+    return true;
+}
+
+float DeepSeekSimilarity::quantize(const float *vector, int dimension, std::int8_t *out)
+{
+    float maxAbs = 0.0f;
+    for (int i = 0; i < dimension; ++i)
+        maxAbs = std::max(maxAbs, std::fabs(vector[i]));
+    if (maxAbs <= 0.0f) {
+        std::fill(out, out + dimension, std::int8_t(0));
+        return 0.0f;
+    }
+
+    const float scale = 127.0f / maxAbs;
+    for (int i = 0; i < dimension; ++i)
+        out[i] = std::int8_t(std::lround(std::clamp(vector[i] * scale, -127.0f, 127.0f)));
+    return scale;
+}
+
+void DeepSeekSimilarity::pushTopK(std::vector<Candidate> &heap, int limit, float score,
+                                  std::uint32_t id)
+{
+    // Min-heap: la raíz es el peor de los candidatos guardados
+    if (int(heap.size()) < limit) {
+        heap.emplace_back(score, id);
+        std::push_heap(heap.begin(), heap.end(), std::greater<>());
+    } else if (limit > 0 && score > heap.front().first) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<>());
+        heap.back() = {score, id};
+        std::push_heap(heap.begin(), heap.end(), std::greater<>());
+    }
+}
+
+void DeepSeekSimilarity::sortTopK(std::vector<Candidate> &heap)
+{
+    std::sort(heap.begin(), heap.end(), std::greater<>());
+}
+
+const char *DeepSeekSimilarity::instructionSet()
+{
+#if defined(DEEPSEEK_HAVE_AVX2)
+    return cpuHasAvx2() ? "AVX2" : "scalar";
+#elif defined(DEEPSEEK_HAVE_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+} // namespace DeepSeek
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace DeepSeek {
+
+// Núcleos de similitud para la búsqueda por embeddings. Los vectores se
+// guardan normalizados, así que la similitud coseno es el producto escalar.
+//
+// En x86-64 se usa AVX2+FMA si la CPU lo admite (detección en tiempo de
+// ejecución); en ARM64 siempre NEON. En el resto, bucles escalares.
+//
+// Modo int8: cada vector se escala para que su mayor componente valga ±127
+// y se guarda la escala; el producto se hace en enteros y se divide por el
+// producto de las escalas. Ocupa la cuarta parte y el error es < 1%.
+class DeepSeekSimilarity
+{
+public:
+    static float dot(const float *a, const float *b, int dimension);
+    static std::int32_t dotInt8(const std::int8_t *a, const std::int8_t *b, int dimension);
+
+    // Normaliza a longitud 1; devuelve false si el vector es nulo
+    static bool normalize(std::vector<float> &vector);
+    // Devuelve la escala aplicada (0 si el vector es nulo)
+    static float quantize(const float *vector, int dimension, std::int8_t *out);
+
+    // Inserta (score, id) en un min-heap de como mucho limit elementos
+    using Candidate = std::pair<float, std::uint32_t>;
+    static void pushTopK(std::vector<Candidate> &heap, int limit, float score, std::uint32_t id);
+    // Ordena de mayor a menor puntuación (destruye el heap)
+    static void sortTopK(std::vector<Candidate> &heap);
+
+    // "AVX2", "NEON" o "scalar"
+    static const char *instructionSet();
+};
+
+} // namespace DeepSeek
@@ -0,0 +1,62 @@
+#include "deepseekstartuptiming.h"
+
+#include <QMutexLocker>
+#include <QStringList>
+
+namespace DeepSeek {
+
+Q_LOGGING_CATEGORY(deepseekStartupLog, "qtc.deepseek.startup", QtWarningMsg)
+
+QMutex DeepSeekStartupTiming::s_mutex;
+QList<DeepSeekStartupTiming::Phase> DeepSeekStartupTiming::s_phases;
+
+DeepSeekStartupTiming::Scope::Scope(const char *name, bool criticalPath)
+    : m_name(name)
+    , m_criticalPath(criticalPath)
+{
+    m_timer.start();
+}
+
+DeepSeekStartupTiming::Scope::~Scope()
+{
+    record(QString::fromLatin1(m_name), m_timer.nsecsElapsed(), m_criticalPath);
+}
+
+void DeepSeekStartupTiming::record(const QString &name, qint64 nsecs, bool criticalPath)
+{
+    {
+        QMutexLocker locker(&s_mutex);
+        s_phases.append({name, nsecs, criticalPath});
+    }
+    qCDebug(deepseekStartupLog).noquote()
+        << QString("%1: %2 ms%3").arg(name).arg(nsecs / 1e6, 0, 'f', 3)
+               .arg(criticalPath ? QString(" (critical path)") : QString());
+}
+
+QList<DeepSeekStartupTiming::Phase> DeepSeekStartupTiming::phases()
+{
+    QMutexLocker locker(&s_mutex);
+    return s_phases;
+}
+
+qint64 DeepSeekStartupTiming::criticalPathNsecs()
+{
+    QMutexLocker locker(&s_mutex);
+    qint64 total = 0;
+    for (const Phase &phase : std::as_const(s_phases)) {
+        if (phase.criticalPath)
+            total += phase.nsecs;
+    }
+    return total;
+}
+
+QString DeepSeekStartupTiming::summary()
+{
+    QStringList lines;
+    for (const Phase &phase : phases())
+        lines << QString("%1: %2 ms").arg(phase.name).arg(phase.nsecs / 1e6, 0, 'f', 3);
+    lines << QString("Critical path total: %1 ms").arg(criticalPathNsecs() / 1e6, 0, 'f', 3);
+    return lines.join('\n');
+}
+
+} // namespace DeepSeek
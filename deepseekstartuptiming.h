@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QLoggingCategory>
+#include <QMutex>
+#include <QString>
+
+namespace DeepSeek {
+
+Q_DECLARE_LOGGING_CATEGORY(deepseekStartupLog)
+
+// Tiempos de arranque del plugin. Cada fase se registra al terminar y se
+// escribe en la categoría "qtc.deepseek.startup"; para verlos:
+//   QT_LOGGING_RULES="qtc.deepseek.startup=true" qtcreator
+// Solo initialize() y extensionsInitialized() están en el camino crítico del
+// arranque del IDE; el resto se ejecuta diferido o en segundo plano.
+class DeepSeekStartupTiming
+{
+public:
+    struct Phase
+    {
+        QString name;
+        qint64 nsecs = 0;
+        bool criticalPath = false;
+    };
+
+    // Mide desde su construcción hasta su destrucción
+    class Scope
+    {
+    public:
+        Scope(const char *name, bool criticalPath);
+        ~Scope();
+
+    private:
+        const char *m_name;
+        bool m_criticalPath;
+        QElapsedTimer m_timer;
+    };
+
+    static void record(const QString &name, qint64 nsecs, bool criticalPath);
+    static QList<Phase> phases();
+    static qint64 criticalPathNsecs();
+    static QString summary();
+
+private:
+    static QMutex s_mutex;
+    static QList<Phase> s_phases;
+};
+
+} // namespace DeepSeek
@@ -0,0 +1,127 @@
+#include "deepseekstreamparser.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QObject>
+
+#include <utility>
+
+namespace DeepSeek {
+
+QList<DeepSeekStreamParser::Event> DeepSeekStreamParser::feed(const QByteArray &chunk)
+{
+    QList<Event> events;
+    m_buffer.append(chunk);
+
+    qsizetype start = 0;
+    qsizetype newline = -1;
+    while ((newline = m_buffer.indexOf('\n', start)) >= 0) {
+        QByteArrayView line(m_buffer.constData() + start, newline - start);
+        if (line.endsWith('\r'))
+            line.chop(1);
+        processLine(line, events);
+        start = newline + 1;
+    }
+    m_buffer.remove(0, start);
+    return events;
+}
+
+QList<DeepSeekStreamParser::Event> DeepSeekStreamParser::finish()
+{
+    QList<Event> events;
+    if (!m_buffer.isEmpty()) {
+        QByteArrayView line(m_buffer);
+        if (line.endsWith('\r'))
+            line.chop(1);
+        processLine(line, events);
+        m_buffer.clear();
+    }
+    dispatch(events);
+    return events;
+}
+
+void DeepSeekStreamParser::reset()
+{
+    m_buffer.clear();
+    m_data.clear();
+    m_content.clear();
+    m_error.clear();
+    m_usage = {};
+    m_done = false;
+}
+
+void DeepSeekStreamParser::processLine(QByteArrayView line, QList<Event> &events)
+{
+    // Una línea vacía cierra el evento actual
+    if (line.isEmpty()) {
+        dispatch(events);
+        return;
+    }
+
+    // Comentarios SSE, p.ej. ": keep-alive" mientras el modelo piensa
+    if (line.startsWith(':'))
+        return;
+
+    if (!line.startsWith("data:"))
+        return; // event:, id: y retry: no se usan en esta API
+
+    QByteArrayView value = line.sliced(5);
+    if (value.startsWith(' '))
+        value = value.sliced(1);
+
+    if (!m_data.isEmpty())
+        m_data.append('\n');
+    m_data.append(value);
+}
+
+void DeepSeekStreamParser::dispatch(QList<Event> &events)
+{
+    if (m_data.isEmpty())
+        return;
+
+    const QByteArray data = std::exchange(m_data, {});
+    Event event;
+
+    if (data == "[DONE]") {
+        m_done = true;
+        event.done = true;
+        events.append(event);
+        return;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+        event.error = QObject::tr("Invalid stream chunk: %1").arg(parseError.errorString());
+        m_error = event.error;
+        events.append(event);
+        return;
+    }
+
+    const QJsonObject obj = doc.object();
+
+    if (obj.value("error").isObject()) {
+        event.error = obj.value("error").toObject().value("message").toString();
+        m_error = event.error;
+    }
+
+    const QJsonArray choices = obj.value("choices").toArray();
+    if (!choices.isEmpty()) {
+        const QJsonObject firstChoice = choices.first().toObject();
+        const QJsonObject delta = firstChoice.value("delta").toObject();
+        event.delta = delta.value("content").toString();
+        event.reasoningDelta = delta.value("reasoning_content").toString();
+        event.finishReason = firstChoice.value("finish_reason").toString();
+    }
+
+    if (obj.value("usage").isObject()) {
+        m_usage = obj.value("usage").toObject();
+        event.usage = m_usage;
+    }
+
+    m_content += event.delta;
+    events.append(event);
+}
+
+} // namespace DeepSeek
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+
+namespace DeepSeek {
+
+// Parser incremental para el flujo Server-Sent Events que devuelve
+// /chat/completions cuando se envía "stream": true. Se alimenta con los
+// fragmentos de readyRead tal y como llegan; las líneas incompletas se
+// guardan hasta el siguiente fragmento.
+class DeepSeekStreamParser
+{
+public:
+    struct Event
+    {
+        QString delta;          // choices[0].delta.content
+        QString reasoningDelta; // choices[0].delta.reasoning_content (deepseek-reasoner)
+        QString finishReason;
+        QJsonObject usage;
+        QString error;
+        bool done = false;      // "data: [DONE]"
+    };
+
+    QList<Event> feed(const QByteArray &chunk);
+    QList<Event> finish();
+    void reset();
+
+    bool isDone() const { return m_done; }
+    bool hasError() const { return !m_error.isEmpty(); }
+    QString error() const { return m_error; }
+    QString content() const { return m_content; }
+    QJsonObject usage() const { return m_usage; }
+
+private:
+    void processLine(QByteArrayView line, QList<Event> &events);
+    void dispatch(QList<Event> &events);
+
+    QByteArray m_buffer;
+    QByteArray m_data;
+    QString m_content;
+    QString m_error;
+    QJsonObject m_usage;
+    bool m_done = false;
+};
+
+} // namespace DeepSeek
@@ -0,0 +1,360 @@
+#include "deepseektextdiff.h"
+
+#include <QHash>
+#include <QTextCursor>
+#include <QTextDocument>
+
+#include <algorithm>
+#include <vector>
+
+namespace DeepSeek {
+
+namespace {
+
+// Variante de Myers con la "serpiente central": busca a la vez desde el
+// principio y desde el final hasta que los dos caminos se cruzan, y repite a
+// cada lado del cruce. Memoria O(N + M) en lugar de guardar un V por cada d.
+class MyersSearch
+{
+public:
+    enum Result { Found, TooFar, Canceled };
+
+    MyersSearch(const int *a, const int *b, int maxD, const std::function<bool()> &isCanceled)
+        : m_a(a)
+        , m_b(b)
+        , m_maxD(maxD)
+        , m_offset((maxD + 1) / 2 + 1)
+        , m_forward(2 * size_t(m_offset) + 1, 0)
+        , m_backward(2 * size_t(m_offset) + 1, 0)
+        , m_isCanceled(isCanceled)
+    {}
+
+    Result run(int n, int m, std::vector<bool> &deleted, std::vector<bool> &inserted)
+    {
+        m_deleted = &deleted;
+        m_inserted = &inserted;
+        // Solo la primera búsqueda puede pasarse del límite: las de cada lado
+        // del cruce tienen siempre menos distancia
+        Snake snake;
+        const int d = middleSnake(0, n, 0, m, snake);
+        if (d < 0)
+            return m_canceled ? Canceled : TooFar;
+        return split(0, n, 0, m, d, snake) ? Found : Canceled;
+    }
+
+private:
+    struct Snake
+    {
+        int x = 0; // inicio
+        int y = 0;
+        int u = 0; // fin
+        int v = 0;
+    };
+
+    // Distancia de edición de a[x0, x1) frente a b[y0, y1) y el tramo común
+    // central del camino mínimo; -1 si pasa de m_maxD o se cancela
+    int middleSnake(int x0, int x1, int y0, int y1, Snake &snake)
+    {
+        const int *a = m_a + x0;
+        const int *b = m_b + y0;
+        const int n = x1 - x0;
+        const int m = y1 - y0;
+        const int delta = n - m;
+        const bool odd = delta & 1;
+        const int limit = (std::min(n + m, m_maxD) + 1) / 2;
+        const auto vf = [this](int k) -> int & { return m_forward[m_offset + k]; };
+        const auto vb = [this](int k) -> int & { return m_backward[m_offset + k]; };
+        vf(1) = 0;
+        vb(1) = 0;
+
+        for (int d = 0; d <= limit; ++d) {
+            if (m_isCanceled && m_isCanceled()) {
+                m_canceled = true;
+                return -1;
+            }
+            for (int k = -d; k <= d; k += 2) {
+                int x = (k == -d || (k != d && vf(k - 1) < vf(k + 1))) ? vf(k + 1) : vf(k - 1) + 1;
+                int y = x - k;
+                const int startX = x;
+                const int startY = y;
+                while (x < n && y < m && a[x] == b[y]) {
+                    ++x;
+                    ++y;
+                }
+                vf(k) = x;
+                const int c = delta - k; // la misma diagonal vista desde el final
+                if (odd && c >= -(d - 1) && c <= d - 1 && x + vb(c) >= n) {
+                    snake = {x0 + startX, y0 + startY, x0 + x, y0 + y};
+                    return 2 * d - 1;
+                }
+            }
+            for (int k = -d; k <= d; k += 2) {
+                int x = (k == -d || (k != d && vb(k - 1) < vb(k + 1))) ? vb(k + 1) : vb(k - 1) + 1;
+                int y = x - k;
+                const int startX = x;
+                const int startY = y;
+                while (x < n && y < m && a[n - x - 1] == b[m - y - 1]) {
+                    ++x;
+                    ++y;
+                }
+                vb(k) = x;
+                const int c = delta - k;
+                if (!odd && c >= -d && c <= d && x + vf(c) >= n) {
+                    snake = {x1 - x, y1 - y, x1 - startX, y1 - startY};
+                    return 2 * d;
+                }
+            }
+        }
+        return -1;
+    }
+
+    bool solve(int x0, int x1, int y0, int y1)
+    {
+        Snake snake;
+        const int d = middleSnake(x0, x1, y0, y1, snake);
+        return d >= 0 && split(x0, x1, y0, y1, d, snake);
+    }
+
+    bool split(int x0, int x1, int y0, int y1, int d, const Snake &snake)
+    {
+        if (d > 1) {
+            return solve(x0, snake.x, y0, snake.y) && solve(snake.u, x1, snake.v, y1);
+        }
+        // Con distancia 0 o 1 una secuencia contiene a la otra: sobra una línea
+        int x = x0;
+        int y = y0;
+        while (x < x1 && y < y1 && m_a[x] == m_b[y]) {
+            ++x;
+            ++y;
+        }
+        if (x1 - x0 > y1 - y0)
+            (*m_deleted)[x] = true;
+        else if (y1 - y0 > x1 - x0)
+            (*m_inserted)[y] = true;
+        return true;
+    }
+
+    const int *m_a;
+    const int *m_b;
+    const int m_maxD;
+    const int m_offset;
+    std::vector<int> m_forward;  // x más lejano por diagonal desde el principio
+    std::vector<int> m_backward; // lo mismo desde el final
+    const std::function<bool()> &m_isCanceled;
+    bool m_canceled = false;
+    std::vector<bool> *m_deleted = nullptr;
+    std::vector<bool> *m_inserted = nullptr;
+};
+
+} // namespace
+
+QStringList DeepSeekTextDiff::splitLines(const QString &text)
+{
+    QStringList lines;
+    qsizetype start = 0;
+    for (qsizetype newline = text.indexOf('\n'); newline >= 0;
+         newline = text.indexOf('\n', start)) {
+        lines.append(text.mid(start, newline - start + 1));
+        start = newline + 1;
+    }
+    if (start < text.size())
+        lines.append(text.mid(start));
+    return lines;
+}
+
+QList<DeepSeekTextDiff::Edit> DeepSeekTextDiff::diff(const QStringList &oldLines,
+                                                     const QStringList &newLines,
+                                                     const std::function<bool()> &isCanceled)
+{
+    const int oldSize = int(oldLines.size());
+    const int newSize = int(newLines.size());
+
+    int prefix = 0;
+    while (prefix < oldSize && prefix < newSize && oldLines.at(prefix) == newLines.at(prefix))
+        ++prefix;
+    int suffix = 0;
+    while (suffix < oldSize - prefix && suffix < newSize - prefix
+           && oldLines.at(oldSize - 1 - suffix) == newLines.at(newSize - 1 - suffix)) {
+        ++suffix;
+    }
+
+    const int n = oldSize - prefix - suffix;
+    const int m = newSize - prefix - suffix;
+    if (n == 0 && m == 0)
+        return {};
+
+    const Edit replaceAll{prefix, n, prefix, m};
+    if (n == 0 || m == 0)
+        return {replaceAll};
+
+    // Cada línea distinta recibe un entero: las comparaciones del bucle
+    // principal pasan a ser de enteros.
+    QHash<QStringView, int> ids;
+    const auto idFor = [&ids](QStringView line) {
+        const auto it = ids.constFind(line);
+        return it != ids.cend() ? *it : *ids.insert(line, int(ids.size()));
+    };
+    std::vector<int> a(n), b(m);
+    for (int i = 0; i < n; ++i)
+        a[i] = idFor(oldLines.at(prefix + i));
+    for (int j = 0; j < m; ++j)
+        b[j] = idFor(newLines.at(prefix + j));
+
+    // Myers en espacio lineal: solo dos vectores V, sea cual sea la distancia
+    MyersSearch search(a.data(), b.data(), std::min(n + m, MaxEditDistance), isCanceled);
+    std::vector<bool> deleted(n, false), inserted(m, false);
+    switch (search.run(n, m, deleted, inserted)) {
+    case MyersSearch::Canceled:
+        return {};
+    case MyersSearch::TooFar:
+        return {replaceAll};
+    case MyersSearch::Found:
+        break;
+    }
+
+    // Agrupa las líneas marcadas consecutivas en regiones
+    QList<Edit> edits;
+    int i = 0;
+    int j = 0;
+    while (i < n || j < m) {
+        if (i < n && j < m && !deleted[i] && !inserted[j]) {
+            ++i;
+            ++j;
+            continue;
+        }
+        Edit edit{prefix + i, 0, prefix + j, 0};
+        while (i < n && deleted[i]) {
+            ++i;
+            ++edit.oldCount;
+        }
+        while (j < m && inserted[j]) {
+            ++j;
+            ++edit.newCount;
+        }
+        edits.append(edit);
+    }
+    return edits;
+}
+
+QList<DeepSeekTextDiff::Hunk> DeepSeekTextDiff::hunks(const QList<Edit> &edits,
+                                                      const QStringList &oldLines,
+                                                      const QStringList &newLines,
+                                                      int contextLines)
+{
+    const auto chopped = [](const QString &line) {
+        return line.endsWith('\n') ? line.chopped(1) : line;
+    };
+
+    QList<Hunk> result;
+    for (qsizetype i = 0; i < edits.size();) {
+        // Ediciones cuyo contexto se solapa van en la misma región
+        qsizetype last = i;
+        while (last + 1 < edits.size()
+               && edits.at(last + 1).oldStart
+                      - (edits.at(last).oldStart + edits.at(last).oldCount)
+                  <= 2 * contextLines) {
+            ++last;
+        }
+
+        const Edit &first = edits.at(i);
+        const Edit &end = edits.at(last);
+        const int before = qMin(contextLines, first.oldStart);
+        const int oldEnd = end.oldStart + end.oldCount;
+        const int after = qMin(contextLines, int(oldLines.size()) - oldEnd);
+
+        Hunk hunk;
+        hunk.oldStart = first.oldStart - before;
+        hunk.newStart = first.newStart - before;
+        hunk.oldCount = oldEnd + after - hunk.oldStart;
+        hunk.newCount = end.newStart + end.newCount + after - hunk.newStart;
+
+        int oldLine = hunk.oldStart;
+        for (qsizetype e = i; e <= last; ++e) {
+            const Edit &edit = edits.at(e);
+            for (; oldLine < edit.oldStart; ++oldLine) {
+                const QString line = chopped(oldLines.at(oldLine));
+                hunk.rows.append({line, line, false});
+            }
+            for (int row = 0; row < qMax(edit.oldCount, edit.newCount); ++row) {
+                Hunk::Row changed;
+                changed.changed = true;
+                changed.hasLeft = row < edit.oldCount;
+                changed.hasRight = row < edit.newCount;
+                if (changed.hasLeft)
+                    changed.left = chopped(oldLines.at(edit.oldStart + row));
+                if (changed.hasRight)
+                    changed.right = chopped(newLines.at(edit.newStart + row));
+                hunk.rows.append(changed);
+            }
+            oldLine = edit.oldStart + edit.oldCount;
+            hunk.edits.append(edit);
+        }
+        for (; oldLine < hunk.oldStart + hunk.oldCount; ++oldLine) {
+            const QString line = chopped(oldLines.at(oldLine));
+            hunk.rows.append({line, line, false});
+        }
+
+        result.append(hunk);
+        i = last + 1;
+    }
+    return result;
+}
+
+QString DeepSeekTextDiff::applyEdits(const QStringList &oldLines, const QStringList &newLines,
+                                     const QList<Edit> &edits)
+{
+    QString result;
+    int oldLine = 0;
+    for (const Edit &edit : edits) {
+        for (; oldLine < edit.oldStart; ++oldLine)
+            result += oldLines.at(oldLine);
+        for (int line = edit.newStart; line < edit.newStart + edit.newCount; ++line)
+            result += newLines.at(line);
+        oldLine = edit.oldStart + edit.oldCount;
+    }
+    for (; oldLine < oldLines.size(); ++oldLine)
+        result += oldLines.at(oldLine);
+    return result;
+}
+
+int DeepSeekTextDiff::applyToDocument(QTextDocument *document, const QString &newText)
+{
+    if (!document)
+        return 0;
+
+    QString normalized = newText;
+    normalized.replace("\r\n", "\n");
+
+    const QString oldText = document->toPlainText();
+    if (oldText == normalized)
+        return 0;
+
+    const QStringList oldLines = splitLines(oldText);
+    const QStringList newLines = splitLines(normalized);
+    const QList<Edit> edits = diff(oldLines, newLines);
+
+    // Las posiciones del documento coinciden con los offsets de toPlainText()
+    QList<int> offsets(oldLines.size() + 1, 0);
+    for (qsizetype i = 0; i < oldLines.size(); ++i)
+        offsets[i + 1] = offsets[i] + int(oldLines.at(i).size());
+
+    QTextCursor cursor(document);
+    cursor.beginEditBlock();
+    // De abajo arriba para que las posiciones pendientes sigan siendo válidas
+    for (auto it = edits.crbegin(); it != edits.crend(); ++it) {
+        QString replacement;
+        for (int line = it->newStart; line < it->newStart + it->newCount; ++line)
+            replacement += newLines.at(line);
+
+        cursor.setPosition(offsets.at(it->oldStart));
+        cursor.setPosition(offsets.at(it->oldStart + it->oldCount), QTextCursor::KeepAnchor);
+        if (replacement.isEmpty())
+            cursor.removeSelectedText();
+        else
+            cursor.insertText(replacement);
+    }
+    cursor.endEditBlock();
+    return int(edits.size());
+}
+
+} // namespace DeepSeek
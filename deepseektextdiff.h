@@ -0,0 +1,78 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+
+QT_BEGIN_NAMESPACE
+class QTextDocument;
+QT_END_NAMESPACE
+
+namespace DeepSeek {
+
+// Diff por líneas (Myers) para aplicar ediciones tocando solo las regiones
+// que cambian. El prefijo y el sufijo comunes se descartan antes de ejecutar
+// el algoritmo, así que el coste depende sobre todo del tamaño del cambio y
+// no del tamaño del fichero.
+class DeepSeekTextDiff
+{
+public:
+    // Sustitución de oldCount líneas desde oldStart por newCount líneas desde newStart
+    struct Edit
+    {
+        int oldStart = 0;
+        int oldCount = 0;
+        int newStart = 0;
+        int newCount = 0;
+    };
+
+    // Región mostrada en la vista previa: las ediciones cercanas más unas
+    // líneas de contexto, en filas alineadas para verlas lado a lado.
+    struct Hunk
+    {
+        struct Row
+        {
+            QString left;
+            QString right;
+            bool changed = false;
+            bool hasLeft = true;  // false: hueco de alineación en la columna izquierda
+            bool hasRight = true;
+        };
+
+        int oldStart = 0;
+        int oldCount = 0;
+        int newStart = 0;
+        int newCount = 0;
+        QList<Edit> edits;
+        QList<Row> rows;
+    };
+
+    // Por encima de esta distancia de edición se reemplaza la región central
+    // completa: el diff mínimo deja de compensar en tiempo. La memoria es
+    // lineal (variante de la serpiente central) y no depende de ella.
+    static constexpr int MaxEditDistance = 4000;
+
+    // Divide conservando el '\n' final de cada línea, para que unir las líneas
+    // devuelva exactamente el texto original.
+    static QStringList splitLines(const QString &text);
+
+    // isCanceled se consulta en cada paso del algoritmo; si devuelve true el
+    // resultado es una lista vacía.
+    static QList<Edit> diff(const QStringList &oldLines, const QStringList &newLines,
+                            const std::function<bool()> &isCanceled = {});
+
+    static QList<Hunk> hunks(const QList<Edit> &edits, const QStringList &oldLines,
+                             const QStringList &newLines, int contextLines = 3);
+
+    // Texto resultante de aplicar solo las ediciones indicadas (ordenadas)
+    static QString applyEdits(const QStringList &oldLines, const QStringList &newLines,
+                              const QList<Edit> &edits);
+
+    // Aplica newText sobre el documento con un único bloque de edición (un
+    // solo paso de deshacer). Devuelve el número de regiones modificadas.
+    static int applyToDocument(QTextDocument *document, const QString &newText);
+};
+
+} // namespace DeepSeek
@@ -0,0 +1,444 @@
+#include "deepseektokenizer.h"
+
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <array>
+#include <atomic>
+#include <climits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define DEEPSEEK_TOKENIZER_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define DEEPSEEK_TOKENIZER_NEON 1
+#endif
+
+namespace DeepSeek {
+
+namespace {
+
+// Clases de byte para la pretokenización. Los bytes >= 0x80 (texto no
+// ASCII) cuentan como letras: el pretokenizador del modelo los agrupa igual.
+enum ByteClass : quint8 { Letter = 1, Digit = 2, Space = 3, Newline = 4, Punct = 5 };
+
+// Palabras más largas se cuentan sin guardarlas en la caché
+constexpr size_t MaxCachedWord = 64;
+constexpr size_t MaxWordCacheSize = 1 << 16;
+// El coste de BPE es cuadrático en la longitud de la palabra
+constexpr size_t MaxPieceBytes = 256;
+
+std::atomic<quint64> s_generation = 0;
+
+quint8 classifyByte(unsigned char c)
+{
+    if (c >= 0x80 || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z'))
+        return Letter;
+    if (c >= '0' && c <= '9')
+        return Digit;
+    if (c == ' ' || c == '\t')
+        return Space;
+    if (c == '\n' || c == '\r')
+        return Newline;
+    return Punct;
+}
+
+#if defined(DEEPSEEK_TOKENIZER_SSE2)
+
+// lo <= x <= hi como enteros sin signo
+inline __m128i inRange(__m128i x, char lo, char hi)
+{
+    const __m128i offset = _mm_sub_epi8(x, _mm_set1_epi8(lo));
+    const __m128i limit = _mm_set1_epi8(char(hi - lo));
+    return _mm_cmpeq_epi8(_mm_max_epu8(offset, limit), limit);
+}
+
+void classifyBlock(const char *in, quint8 *out)
+{
+    const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+    const __m128i letter = _mm_or_si128(inRange(_mm_or_si128(c, _mm_set1_epi8(0x20)), 'a', 'z'),
+                                        _mm_cmplt_epi8(c, _mm_setzero_si128()));
+    const __m128i digit = inRange(c, '0', '9');
+    const __m128i space = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')),
+                                       _mm_cmpeq_epi8(c, _mm_set1_epi8('\t')));
+    const __m128i newline = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('\n')),
+                                         _mm_cmpeq_epi8(c, _mm_set1_epi8('\r')));
+
+    __m128i cls = _mm_and_si128(letter, _mm_set1_epi8(Letter));
+    cls = _mm_or_si128(cls, _mm_and_si128(digit, _mm_set1_epi8(Digit)));
+    cls = _mm_or_si128(cls, _mm_and_si128(space, _mm_set1_epi8(Space)));
+    cls = _mm_or_si128(cls, _mm_and_si128(newline, _mm_set1_epi8(Newline)));
+    cls = _mm_or_si128(cls, _mm_and_si128(_mm_cmpeq_epi8(cls, _mm_setzero_si128()),
+                                          _mm_set1_epi8(Punct)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), cls);
+}
+
+#elif defined(DEEPSEEK_TOKENIZER_NEON)
+
+inline uint8x16_t inRange(uint8x16_t x, quint8 lo, quint8 hi)
+{
+    return vcleq_u8(vsubq_u8(x, vdupq_n_u8(lo)), vdupq_n_u8(quint8(hi - lo)));
+}
+
+void classifyBlock(const char *in, quint8 *out)
+{
+    const uint8x16_t c = vld1q_u8(reinterpret_cast<const uint8_t *>(in));
+    const uint8x16_t letter = vorrq_u8(inRange(vorrq_u8(c, vdupq_n_u8(0x20)), 'a', 'z'),
+                                       vcgeq_u8(c, vdupq_n_u8(0x80)));
+    const uint8x16_t digit = inRange(c, '0', '9');
+    const uint8x16_t space = vorrq_u8(vceqq_u8(c, vdupq_n_u8(' ')), vceqq_u8(c, vdupq_n_u8('\t')));
+    const uint8x16_t newline = vorrq_u8(vceqq_u8(c, vdupq_n_u8('\n')),
+                                        vceqq_u8(c, vdupq_n_u8('\r')));
+
+    uint8x16_t cls = vandq_u8(letter, vdupq_n_u8(Letter));
+    cls = vorrq_u8(cls, vandq_u8(digit, vdupq_n_u8(Digit)));
+    cls = vorrq_u8(cls, vandq_u8(space, vdupq_n_u8(Space)));
+    cls = vorrq_u8(cls, vandq_u8(newline, vdupq_n_u8(Newline)));
+    cls = vorrq_u8(cls, vandq_u8(vceqzq_u8(cls), vdupq_n_u8(Punct)));
+    vst1q_u8(out, cls);
+}
+
+#endif
+
+void classify(const std::string &text, std::vector<quint8> &classes)
+{
+    const size_t size = text.size();
+    classes.resize(size);
+    size_t i = 0;
+#if defined(DEEPSEEK_TOKENIZER_SSE2) || defined(DEEPSEEK_TOKENIZER_NEON)
+    for (; i + 16 <= size; i += 16)
+        classifyBlock(text.data() + i, classes.data() + i);
+#endif
+    for (; i < size; ++i)
+        classes[i] = classifyByte(static_cast<unsigned char>(text[i]));
+}
+
+// Trocea como el pretokenizador del modelo: palabras (con el espacio que
+// las precede), números de hasta 3 cifras, puntuación con los saltos de
+// línea que la siguen y bloques de espacio.
+template<typename Emit>
+void pretokenize(const std::vector<quint8> &classes, Emit emit)
+{
+    const size_t size = classes.size();
+    const auto runEnd = [&classes, size](size_t from, quint8 cls) {
+        while (from < size && classes[from] == cls)
+            ++from;
+        return from;
+    };
+
+    size_t i = 0;
+    while (i < size) {
+        const quint8 cls = classes[i];
+        size_t end = runEnd(i, cls);
+        switch (cls) {
+        case Digit:
+            for (; i + 3 < end; i += 3)
+                emit(i, i + 3);
+            break;
+        case Punct:
+            end = runEnd(end, Newline);
+            break;
+        case Space:
+            if (end < size && classes[end] == Newline) {
+                end = runEnd(end, Newline);
+            } else if (end < size && (classes[end] == Letter || classes[end] == Punct)) {
+                // El último espacio va con lo que sigue
+                if (end - 1 > i)
+                    emit(i, end - 1);
+                i = end - 1;
+                const quint8 next = classes[end];
+                end = runEnd(end, next);
+                if (next == Punct)
+                    end = runEnd(end, Newline);
+            }
+            break;
+        default:
+            break;
+        }
+        emit(i, end);
+        i = end;
+    }
+}
+
+void appendUtf8(QStringView text, std::string &out)
+{
+    out.clear();
+    out.reserve(size_t(text.size()) * 3);
+    const qsizetype size = text.size();
+    for (qsizetype i = 0; i < size; ++i) {
+        char32_t code = text[i].unicode();
+        if (QChar::isHighSurrogate(code) && i + 1 < size && text[i + 1].isLowSurrogate())
+            code = QChar::surrogateToUcs4(char16_t(code), text[++i].unicode());
+
+        if (code < 0x80) {
+            out.push_back(char(code));
+        } else if (code < 0x800) {
+            out.push_back(char(0xC0 | (code >> 6)));
+            out.push_back(char(0x80 | (code & 0x3F)));
+        } else if (code < 0x10000) {
+            out.push_back(char(0xE0 | (code >> 12)));
+            out.push_back(char(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(char(0x80 | (code & 0x3F)));
+        } else {
+            out.push_back(char(0xF0 | (code >> 18)));
+            out.push_back(char(0x80 | ((code >> 12) & 0x3F)));
+            out.push_back(char(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(char(0x80 | (code & 0x3F)));
+        }
+    }
+}
+
+struct StringHash
+{
+    using is_transparent = void;
+    size_t operator()(std::string_view text) const { return std::hash<std::string_view>{}(text); }
+};
+
+} // namespace
+
+struct DeepSeekTokenizer::Model
+{
+    struct Merge
+    {
+        int rank;
+        int id;
+    };
+
+    static quint64 pairKey(int left, int right) { return (quint64(quint32(left)) << 32) | quint32(right); }
+
+    int bpeCount(std::string_view piece) const;
+
+    QString filePath;
+    quint64 generation = 0;
+    std::array<int, 256> byteTokens{};  // id del token de cada byte suelto
+    std::unordered_map<quint64, Merge> merges;
+};
+
+int DeepSeekTokenizer::Model::bpeCount(std::string_view piece) const
+{
+    // Reutilizado entre llamadas del mismo hilo
+    thread_local std::vector<int> symbols;
+    symbols.clear();
+    for (const char byte : piece)
+        symbols.push_back(byteTokens[static_cast<unsigned char>(byte)]);
+
+    // Se aplica siempre la fusión de menor rango, como el BPE original
+    while (symbols.size() > 1) {
+        int bestRank = INT_MAX;
+        int bestId = -1;
+        size_t bestPos = 0;
+        for (size_t k = 0; k + 1 < symbols.size(); ++k) {
+            if (symbols[k] < 0 || symbols[k + 1] < 0)
+                continue;
+            const auto it = merges.find(pairKey(symbols[k], symbols[k + 1]));
+            if (it != merges.end() && it->second.rank < bestRank) {
+                bestRank = it->second.rank;
+                bestId = it->second.id;
+                bestPos = k;
+            }
+        }
+        if (bestId < 0)
+            break;
+        symbols[bestPos] = bestId;
+        symbols.erase(symbols.begin() + bestPos + 1);
+    }
+    return int(symbols.size());
+}
+
+DeepSeekTokenizer::DeepSeekTokenizer()
+    : m_cache(MaxCachedTexts)
+{}
+
+DeepSeekTokenizer::~DeepSeekTokenizer() = default;
+
+DeepSeekTokenizer::ModelPtr DeepSeekTokenizer::parse(const QString &filePath, QString *errorString)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorString)
+            *errorString = file.errorString();
+        return {};
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        if (errorString)
+            *errorString = parseError.errorString();
+        return {};
+    }
+
+    const QJsonObject modelObject = document.object().value("model").toObject();
+    if (modelObject.value("type").toString() != "BPE") {
+        if (errorString)
+            *errorString = QObject::tr("Unsupported tokenizer model: %1")
+                               .arg(modelObject.value("type").toString());
+        return {};
+    }
+
+    QHash<QString, int> vocab;
+    const QJsonObject vocabObject = modelObject.value("vocab").toObject();
+    vocab.reserve(vocabObject.size());
+    for (auto it = vocabObject.constBegin(); it != vocabObject.constEnd(); ++it)
+        vocab.insert(it.key(), it.value().toInt(-1));
+
+    auto model = std::make_shared<Model>();
+    model->filePath = filePath;
+    model->generation = ++s_generation;
+
+    // bytes_to_unicode de GPT-2: los bytes imprimibles se representan a sí
+    // mismos y el resto se desplaza a partir de U+0100.
+    int shifted = 0;
+    for (int byte = 0; byte < 256; ++byte) {
+        const bool printable = (byte >= 33 && byte <= 126) || (byte >= 161 && byte <= 172)
+                               || byte >= 174;
+        const char16_t symbol = printable ? char16_t(byte) : char16_t(256 + shifted++);
+        model->byteTokens[byte] = vocab.value(QString(QChar(symbol)), -1);
+    }
+
+    const QJsonArray merges = modelObject.value("merges").toArray();
+    model->merges.reserve(size_t(merges.size()));
+    for (qsizetype rank = 0; rank < merges.size(); ++rank) {
+        // "a b" en el formato clásico, ["a", "b"] en el actual
+        QString left;
+        QString right;
+        const QJsonValue value = merges.at(rank);
+        if (value.isArray()) {
+            left = value.toArray().at(0).toString();
+            right = value.toArray().at(1).toString();
+        } else {
+            const QString merge = value.toString();
+            const qsizetype separator = merge.indexOf(' ');
+            if (separator <= 0)
+                continue;
+            left = merge.left(separator);
+            right = merge.mid(separator + 1);
+        }
+
+        const int leftId = vocab.value(left, -1);
+        const int rightId = vocab.value(right, -1);
+        const int mergedId = vocab.value(left + right, -1);
+        if (leftId < 0 || rightId < 0 || mergedId < 0)
+            continue;
+        model->merges.emplace(Model::pairKey(leftId, rightId), Model::Merge{int(rank), mergedId});
+    }
+
+    if (model->merges.empty()) {
+        if (errorString)
+            *errorString = QObject::tr("Tokenizer has no merges: %1").arg(filePath);
+        return {};
+    }
+
+    return model;
+}
+
+void DeepSeekTokenizer::install(const ModelPtr &model)
+{
+    QMutexLocker locker(&m_mutex);
+    m_model = model;
+    m_cache.clear();
+}
+
+bool DeepSeekTokenizer::load(const QString &filePath, QString *errorString)
+{
+    const ModelPtr model = parse(filePath, errorString);
+    if (!model)
+        return false;
+    install(model);
+    return true;
+}
+
+void DeepSeekTokenizer::unload()
+{
+    QMutexLocker locker(&m_mutex);
+    m_model.reset();
+    m_cache.clear();
+}
+
+DeepSeekTokenizer::ModelPtr DeepSeekTokenizer::model() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_model;
+}
+
+bool DeepSeekTokenizer::isLoaded() const
+{
+    return model() != nullptr;
+}
+
+QString DeepSeekTokenizer::filePath() const
+{
+    const std::shared_ptr<const Model> current = model();
+    return current ? current->filePath : QString();
+}
+
+int DeepSeekTokenizer::count(QStringView text) const
+{
+    const std::shared_ptr<const Model> current = model();
+    if (!current)
+        return -1;
+
+    // Búferes y caché de palabras por hilo: sin reservas en el caso habitual
+    thread_local std::string utf8;
+    thread_local std::vector<quint8> classes;
+    thread_local quint64 cacheGeneration = 0;
+    thread_local std::unordered_map<std::string, int, StringHash, std::equal_to<>> wordCounts;
+    if (cacheGeneration != current->generation) {
+        wordCounts.clear();
+        cacheGeneration = current->generation;
+    }
+
+    appendUtf8(text, utf8);
+    classify(utf8, classes);
+
+    int total = 0;
+    pretokenize(classes, [&](size_t begin, size_t end) {
+        for (; begin < end; begin += MaxPieceBytes) {
+            const std::string_view piece(utf8.data() + begin, std::min(end - begin, MaxPieceBytes));
+            const auto it = wordCounts.find(piece);
+            if (it != wordCounts.end()) {
+                total += it->second;
+                continue;
+            }
+            const int tokens = current->bpeCount(piece);
+            if (piece.size() <= MaxCachedWord) {
+                if (wordCounts.size() >= MaxWordCacheSize)
+                    wordCounts.clear();
+                wordCounts.emplace(piece, tokens);
+            }
+            total += tokens;
+        }
+    });
+    return total;
+}
+
+int DeepSeekTokenizer::countCached(const QString &text) const
+{
+    std::shared_ptr<const Model> current;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_model)
+            return -1;
+        if (const int *cached = m_cache.object(text))
+            return *cached;
+        current = m_model;
+    }
+
+    const int tokens = count(text);
+
+    QMutexLocker locker(&m_mutex);
+    // Si se cargó otro modelo mientras tanto el resultado ya no vale
+    if (m_model == current)
+        m_cache.insert(text, new int(tokens));
+    return tokens;
+}
+
+} // namespace DeepSeek
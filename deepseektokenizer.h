@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QCache>
+#include <QMutex>
+#include <QString>
+#include "singleton.h"
+
+#include <memory>
+
+namespace DeepSeek {
+
+// Tokenizador BPE a nivel de byte compatible con el tokenizer.json de
+// Hugging Face que publican los modelos de DeepSeek. Solo cuenta tokens: no
+// hace falta decodificar ni conocer los ids finales.
+//
+// La pretokenización clasifica los bytes de 16 en 16 (SSE2/NEON) y trocea
+// palabras, números, puntuación y espacios siguiendo las reglas del
+// pretokenizador del modelo. Cada palabra se reduce con la tabla de fusiones
+// y su resultado se guarda en una caché por hilo, así que el texto habitual
+// se cuenta sin reservas de memoria por token.
+class DeepSeekTokenizer
+{
+    friend class Singleton<DeepSeekTokenizer>;
+
+public:
+    struct Model;
+    using ModelPtr = std::shared_ptr<const Model>;
+
+    // Lee vocabulario y fusiones sin tocar el tokenizador en uso; puede
+    // llamarse desde cualquier hilo. nullptr si falla.
+    static ModelPtr parse(const QString &filePath, QString *errorString = nullptr);
+    // Sustituye el modelo en uso; nullptr equivale a unload()
+    void install(const ModelPtr &model);
+    // parse() + install()
+    bool load(const QString &filePath, QString *errorString = nullptr);
+    void unload();
+    bool isLoaded() const;
+    QString filePath() const;
+
+    // Número exacto de tokens, o -1 si no hay tokenizador cargado
+    int count(QStringView text) const;
+    // Igual que count() pero recordando el resultado por texto: para los
+    // mensajes del historial y el prompt de sistema, que se repiten.
+    int countCached(const QString &text) const;
+
+    static constexpr int MaxCachedTexts = 4096;
+
+protected:
+    DeepSeekTokenizer();
+    ~DeepSeekTokenizer();
+
+private:
+    ModelPtr model() const;
+
+    mutable QMutex m_mutex;
+    ModelPtr m_model;
+    mutable QCache<QString, int> m_cache;
+};
+
+// Alias para el Singleton del tokenizador
+typedef Singleton<DeepSeekTokenizer> DST;
+
+} // namespace DeepSeek
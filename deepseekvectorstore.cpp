@@ -0,0 +1,533 @@
+#include "deepseekvectorstore.h"
+#include "deepseeksimilarity.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QSaveFile>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <cstring>
+
+namespace DeepSeek {
+
+Q_LOGGING_CATEGORY(deepseekVectorsLog, "qtc.deepseek.vectors", QtWarningMsg)
+
+namespace {
+
+constexpr char Magic[8] = {'D', 'S', 'V', 'E', 'C', 'T', 'O', 'R'};
+constexpr quint32 Version = 1;
+constexpr quint32 DeadPath = 0xffffffffu;
+
+struct FileHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 dimension;
+    quint32 precision;
+    quint32 modelHash;
+    quint64 count;
+    char reserved[32];
+};
+static_assert(sizeof(FileHeader) == 64);
+
+QByteArray pathLine(quint32 id, const QDateTime &modified, const QString &filePath)
+{
+    return QString("%1\t%2\t%3\n")
+        .arg(id)
+        .arg(modified.toMSecsSinceEpoch())
+        .arg(filePath)
+        .toUtf8();
+}
+
+quint32 hashModel(const QString &model)
+{
+    // Estable entre ejecuciones, a diferencia de qHash()
+    const QByteArray digest = QCryptographicHash::hash(model.toUtf8(), QCryptographicHash::Sha1);
+    quint32 value;
+    std::memcpy(&value, digest.constData(), sizeof(value));
+    return value;
+}
+
+} // namespace
+
+struct DeepSeekVectorStore::RecordHeader
+{
+    quint32 pathId;
+    quint32 startLine;
+    quint32 lineCount;
+    float scale;  // solo int8: factor aplicado al cuantizar
+};
+static_assert(sizeof(DeepSeekVectorStore::RecordHeader) == 16);
+
+DeepSeekVectorStore::DeepSeekVectorStore(const QString &filePath)
+    : m_filePath(filePath)
+{}
+
+DeepSeekVectorStore::~DeepSeekVectorStore()
+{
+    close();
+}
+
+bool DeepSeekVectorStore::open(const QString &model, Precision precision, QString *errorString)
+{
+    QWriteLocker locker(&m_lock);
+    unmapLocked();
+    m_file.close();
+    m_paths.clear();
+    m_pathIds.clear();
+    m_modified.clear();
+    m_fileRecords.clear();
+    m_precision = precision;
+    m_modelHash = hashModel(model);
+    m_dimension = 0;
+    m_count = 0;
+    m_live = 0;
+    m_pathLines = 0;
+
+    QDir().mkpath(QFileInfo(m_filePath).absolutePath());
+    m_file.setFileName(m_filePath);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        if (errorString)
+            *errorString = m_file.errorString();
+        return false;
+    }
+
+    FileHeader header;
+    bool valid = m_file.read(reinterpret_cast<char *>(&header), sizeof(header)) == sizeof(header)
+                 && std::memcmp(header.magic, Magic, sizeof(Magic)) == 0
+                 && header.version == Version && header.precision == quint32(precision)
+                 && header.modelHash == m_modelHash;
+    if (valid) {
+        m_dimension = int(header.dimension);
+        m_count = qsizetype(header.count);
+        const qint64 expected = qint64(sizeof(FileHeader)) + qint64(m_count) * recordSize();
+        valid = m_file.size() >= expected;
+        // Restos de un append interrumpido antes de actualizar la cabecera
+        if (valid && m_file.size() > expected)
+            m_file.resize(expected);
+    }
+    if (!valid) {
+        qCDebug(deepseekVectorsLog) << "Vector store: starting empty" << m_filePath;
+        return resetLocked(errorString);
+    }
+
+    QFile paths(pathsFilePath());
+    if (paths.open(QIODevice::ReadOnly)) {
+        while (!paths.atEnd()) {
+            QString line = QString::fromUtf8(paths.readLine());
+            // Una línea sin '\n' final es de una escritura interrumpida
+            if (!line.endsWith('\n'))
+                continue;
+            line.chop(1);
+            const qsizetype first = line.indexOf('\t');
+            const qsizetype second = line.indexOf('\t', first + 1);
+            if (first < 0 || second < 0)
+                continue;
+            bool ok = false;
+            const quint32 id = line.left(first).toUInt(&ok);
+            if (!ok || id > quint32(m_paths.size()))
+                continue;
+            const QString filePath = line.mid(second + 1);
+            if (id == quint32(m_paths.size())) {
+                m_paths.append(filePath);
+                m_pathIds.insert(filePath, id);
+            }
+            m_modified.insert(id, QDateTime::fromMSecsSinceEpoch(
+                                      line.mid(first + 1, second - first - 1).toLongLong()));
+            ++m_pathLines;
+        }
+    }
+
+    if (!mapLocked(errorString))
+        return false;
+
+    for (qsizetype i = 0; i < m_count; ++i) {
+        RecordHeader *record = recordAt(i);
+        if (record->pathId >= quint32(m_paths.size())) {
+            record->pathId = DeadPath;
+            continue;
+        }
+        m_fileRecords[record->pathId].push_back(quint32(i));
+        ++m_live;
+    }
+
+    if (needsCompaction()) {
+        QString compactError;
+        if (!compactLocked(&compactError))
+            qWarning() << "Vector store: compaction failed:" << compactError;
+    }
+    return m_map != nullptr;
+}
+
+void DeepSeekVectorStore::close()
+{
+    QWriteLocker locker(&m_lock);
+    unmapLocked();
+    m_file.close();
+}
+
+bool DeepSeekVectorStore::isOpen() const
+{
+    QReadLocker locker(&m_lock);
+    return m_map != nullptr;
+}
+
+int DeepSeekVectorStore::dimension() const
+{
+    QReadLocker locker(&m_lock);
+    return m_dimension;
+}
+
+qsizetype DeepSeekVectorStore::count() const
+{
+    QReadLocker locker(&m_lock);
+    return m_live;
+}
+
+qsizetype DeepSeekVectorStore::payloadSize() const
+{
+    if (m_precision == Precision::Int8)
+        return (qsizetype(m_dimension) + 15) / 16 * 16; // bloques completos para el núcleo
+    return qsizetype(m_dimension) * qsizetype(sizeof(float));
+}
+
+DeepSeekVectorStore::RecordHeader *DeepSeekVectorStore::recordAt(qsizetype index) const
+{
+    return reinterpret_cast<RecordHeader *>(m_map + sizeof(FileHeader) + index * recordSize());
+}
+
+bool DeepSeekVectorStore::writeHeaderLocked(QString *errorString)
+{
+    FileHeader header{};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.dimension = quint32(m_dimension);
+    header.precision = quint32(m_precision);
+    header.modelHash = m_modelHash;
+    header.count = quint64(m_count);
+
+    if (!m_file.seek(0)
+        || m_file.write(reinterpret_cast<const char *>(&header), sizeof(header)) != sizeof(header)
+        || !m_file.flush()) {
+        if (errorString)
+            *errorString = m_file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool DeepSeekVectorStore::resetLocked(QString *errorString)
+{
+    unmapLocked();
+    m_paths.clear();
+    m_pathIds.clear();
+    m_modified.clear();
+    m_fileRecords.clear();
+    m_dimension = 0;
+    m_count = 0;
+    m_live = 0;
+    m_pathLines = 0;
+
+    QFile::remove(pathsFilePath());
+    if (!m_file.resize(0) || !writeHeaderLocked(errorString))
+        return false;
+    return mapLocked(errorString);
+}
+
+bool DeepSeekVectorStore::mapLocked(QString *errorString)
+{
+    m_mapSize = qint64(sizeof(FileHeader)) + qint64(m_count) * recordSize();
+    m_map = m_file.map(0, m_mapSize);
+    if (!m_map) {
+        if (errorString)
+            *errorString = m_file.errorString();
+        return false;
+    }
+    return true;
+}
+
+void DeepSeekVectorStore::unmapLocked()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+        m_mapSize = 0;
+    }
+}
+
+bool DeepSeekVectorStore::compactLocked(QString *errorString)
+{
+    QSaveFile saver(m_filePath);
+    if (!saver.open(QIODevice::WriteOnly)) {
+        if (errorString)
+            *errorString = saver.errorString();
+        return false;
+    }
+
+    // Se copian solo los vivos, agrupados por fichero
+    saver.write(reinterpret_cast<const char *>(m_map), sizeof(FileHeader));
+    QHash<quint32, std::vector<quint32>> fileRecords;
+    quint32 next = 0;
+    for (auto it = m_fileRecords.cbegin(); it != m_fileRecords.cend(); ++it) {
+        std::vector<quint32> &records = fileRecords[it.key()];
+        for (const quint32 index : it.value()) {
+            saver.write(reinterpret_cast<const char *>(recordAt(index)), recordSize());
+            records.push_back(next++);
+        }
+    }
+    FileHeader header;
+    std::memcpy(&header, m_map, sizeof(header));
+    header.count = next;
+    saver.seek(0);
+    saver.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    // En Windows no se puede sustituir un fichero abierto
+    unmapLocked();
+    m_file.close();
+    const bool committed = saver.commit();
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        if (errorString)
+            *errorString = m_file.errorString();
+        return false;
+    }
+    if (committed) {
+        qCDebug(deepseekVectorsLog) << "Vector store: compacted" << m_count << "->" << next
+                                    << "records";
+        m_fileRecords = fileRecords;
+        m_count = next;
+    } else if (errorString) {
+        *errorString = saver.errorString();
+    }
+    if (!mapLocked(errorString) || !committed)
+        return false;
+    return compactPathsLocked(errorString);
+}
+
+bool DeepSeekVectorStore::compactPathsLocked(QString *errorString)
+{
+    // Una línea por ruta con su fecha actual. Los ids no cambian, así que da
+    // igual cuál de los dos ficheros se interrumpa: siguen casando.
+    QSaveFile saver(pathsFilePath());
+    if (!saver.open(QIODevice::WriteOnly)) {
+        if (errorString)
+            *errorString = saver.errorString();
+        return false;
+    }
+    for (qsizetype id = 0; id < m_paths.size(); ++id)
+        saver.write(pathLine(quint32(id), m_modified.value(quint32(id)), m_paths.at(id)));
+    if (!saver.commit()) {
+        if (errorString)
+            *errorString = saver.errorString();
+        return false;
+    }
+    m_pathLines = m_paths.size();
+    return true;
+}
+
+bool DeepSeekVectorStore::needsCompaction() const
+{
+    return m_count - m_live > m_live || m_pathLines > 2 * m_paths.size();
+}
+
+bool DeepSeekVectorStore::appendPathLocked(quint32 id, const QString &filePath,
+                                           const QDateTime &modified, QString *errorString)
+{
+    QFile paths(pathsFilePath());
+    if (!paths.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        if (errorString)
+            *errorString = paths.errorString();
+        return false;
+    }
+    paths.write(pathLine(id, modified, filePath));
+    m_modified.insert(id, modified);
+    ++m_pathLines;
+    return true;
+}
+
+bool DeepSeekVectorStore::replaceFile(const QString &filePath, const QDateTime &modified,
+                                      const QList<Entry> &entries, QString *errorString)
+{
+    QWriteLocker locker(&m_lock);
+    if (!m_map) {
+        if (errorString)
+            *errorString = QObject::tr("Vector store is not open");
+        return false;
+    }
+
+    const int dimension = m_dimension > 0 || entries.isEmpty()
+                              ? m_dimension
+                              : int(entries.first().vector.size());
+    for (const Entry &entry : entries) {
+        if (int(entry.vector.size()) != dimension || dimension == 0) {
+            if (errorString)
+                *errorString = QObject::tr("Embedding dimension mismatch: expected %1, got %2")
+                                   .arg(dimension)
+                                   .arg(entry.vector.size());
+            return false;
+        }
+    }
+
+    removeFileLocked(filePath);
+
+    auto idIt = m_pathIds.constFind(filePath);
+    if (idIt == m_pathIds.constEnd()) {
+        idIt = m_pathIds.insert(filePath, quint32(m_paths.size()));
+        m_paths.append(filePath);
+    }
+    const quint32 id = *idIt;
+
+    if (!entries.isEmpty()) {
+        m_dimension = dimension;
+        const qsizetype stride = recordSize();
+        QByteArray buffer(entries.size() * stride, '\0');
+        for (qsizetype i = 0; i < entries.size(); ++i) {
+            const Entry &entry = entries.at(i);
+            char *out = buffer.data() + i * stride;
+            std::vector<float> vector = entry.vector;
+            DeepSeekSimilarity::normalize(vector);
+
+            RecordHeader record{id, quint32(entry.startLine), quint32(entry.lineCount), 1.0f};
+            if (m_precision == Precision::Int8) {
+                record.scale = DeepSeekSimilarity::quantize(
+                    vector.data(), m_dimension, reinterpret_cast<std::int8_t *>(out + sizeof(record)));
+            } else {
+                std::memcpy(out + sizeof(record), vector.data(), vector.size() * sizeof(float));
+            }
+            std::memcpy(out, &record, sizeof(record));
+        }
+
+        // Primero los registros y después la cabecera que los cuenta: si se
+        // interrumpe, al abrir se descarta lo que sobra.
+        unmapLocked();
+        const qint64 offset = qint64(sizeof(FileHeader)) + qint64(m_count) * stride;
+        if (!m_file.seek(offset) || m_file.write(buffer) != buffer.size()) {
+            if (errorString)
+                *errorString = m_file.errorString();
+            m_file.resize(offset);
+            mapLocked(nullptr);
+            return false;
+        }
+        std::vector<quint32> &records = m_fileRecords[id];
+        for (qsizetype i = 0; i < entries.size(); ++i)
+            records.push_back(quint32(m_count + i));
+        m_count += entries.size();
+        m_live += entries.size();
+        if (!writeHeaderLocked(errorString) || !mapLocked(errorString))
+            return false;
+    }
+
+    if (!appendPathLocked(id, filePath, modified, errorString))
+        return false;
+
+    // Lo sustituido se recupera sin esperar a la próxima apertura
+    if (needsCompaction()) {
+        QString compactError;
+        if (!compactLocked(&compactError))
+            qWarning() << "Vector store: compaction failed:" << compactError;
+    }
+    return true;
+}
+
+void DeepSeekVectorStore::removeFile(const QString &filePath)
+{
+    QWriteLocker locker(&m_lock);
+    removeFileLocked(filePath);
+}
+
+void DeepSeekVectorStore::removeFileLocked(const QString &filePath)
+{
+    const auto idIt = m_pathIds.constFind(filePath);
+    if (idIt == m_pathIds.constEnd() || !m_map)
+        return;
+
+    // Se marcan en el propio mapa; el espacio se recupera al compactar
+    const std::vector<quint32> records = m_fileRecords.take(*idIt);
+    for (const quint32 index : records)
+        recordAt(index)->pathId = DeadPath;
+    m_live -= qsizetype(records.size());
+}
+
+bool DeepSeekVectorStore::isCurrent(const QString &filePath, const QDateTime &modified) const
+{
+    QReadLocker locker(&m_lock);
+    const auto idIt = m_pathIds.constFind(filePath);
+    return idIt != m_pathIds.constEnd() && m_fileRecords.contains(*idIt)
+           && m_modified.value(*idIt) == modified;
+}
+
+QList<DeepSeekVectorStore::Hit> DeepSeekVectorStore::search(const std::vector<float> &query,
+                                                           int limit) const
+{
+    QList<Hit> hits;
+    QReadLocker locker(&m_lock);
+    if (!m_map || limit <= 0 || m_live == 0 || int(query.size()) != m_dimension)
+        return hits;
+
+    std::vector<float> normalized = query;
+    if (!DeepSeekSimilarity::normalize(normalized))
+        return hits;
+
+    // La consulta se cuantiza igual que los registros, con el mismo relleno
+    std::vector<std::int8_t> quantized;
+    float queryScale = 1.0f;
+    if (m_precision == Precision::Int8) {
+        quantized.assign(payloadSize(), 0);
+        queryScale = DeepSeekSimilarity::quantize(normalized.data(), m_dimension, quantized.data());
+        if (queryScale == 0.0f)
+            return hits;
+    }
+
+    QList<qsizetype> blocks;
+    for (qsizetype start = 0; start < m_count; start += SearchBlockSize)
+        blocks.append(start);
+
+    using Candidate = DeepSeekSimilarity::Candidate;
+    const auto scanBlock = [&](qsizetype start) {
+        std::vector<Candidate> heap;
+        heap.reserve(limit);
+        const qsizetype end = qMin(m_count, start + SearchBlockSize);
+        const int payload = int(payloadSize());
+        for (qsizetype i = start; i < end; ++i) {
+            const RecordHeader *record = recordAt(i);
+            if (record->pathId == DeadPath)
+                continue;
+            float score;
+            if (m_precision == Precision::Int8) {
+                if (record->scale == 0.0f)
+                    continue;
+                score = float(DeepSeekSimilarity::dotInt8(
+                            quantized.data(), reinterpret_cast<const std::int8_t *>(record + 1), payload))
+                        / (queryScale * record->scale);
+            } else {
+                score = DeepSeekSimilarity::dot(normalized.data(),
+                                                reinterpret_cast<const float *>(record + 1), m_dimension);
+            }
+            DeepSeekSimilarity::pushTopK(heap, limit, score, quint32(i));
+        }
+        return heap;
+    };
+
+    // Un bloque por tarea: el coste lo marca el ancho de banda de memoria
+    const QList<std::vector<Candidate>> partial
+        = QtConcurrent::blockingMapped<QList<std::vector<Candidate>>>(blocks, scanBlock);
+
+    std::vector<Candidate> best;
+    for (const std::vector<Candidate> &heap : partial) {
+        for (const Candidate &candidate : heap)
+            DeepSeekSimilarity::pushTopK(best, limit, candidate.first, candidate.second);
+    }
+    DeepSeekSimilarity::sortTopK(best);
+
+    hits.reserve(qsizetype(best.size()));
+    for (const Candidate &candidate : best) {
+        const RecordHeader *record = recordAt(candidate.second);
+        hits.append({m_paths.at(record->pathId), int(record->startLine), int(record->lineCount),
+                     candidate.first});
+    }
+    return hits;
+}
+
+} // namespace DeepSeek
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QReadWriteLock>
+#include <QString>
+#include <QStringList>
+
+#include <vector>
+
+namespace DeepSeek {
+
+// Almacén de embeddings en disco, proyectado en memoria con QFile::map().
+//
+// <fichero>       cabecera de 64 bytes + registros de tamaño fijo
+//                 (fichero, línea inicial, nº de líneas, escala, vector)
+// <fichero>.paths una línea "id<TAB>fecha<TAB>ruta" por fichero; la última
+//                 línea de cada ruta indica la fecha de los vectores guardados
+//
+// Los vectores se guardan normalizados, en float32 o cuantizados a int8.
+// Los registros de un fichero sustituido se marcan como borrados en el propio
+// mapa. Cuando superan a los vivos, o el .paths dobla el número de rutas, se
+// compactan los dos ficheros: el .paths queda con una línea por ruta. La
+// búsqueda recorre los registros por bloques en paralelo con DeepSeekSimilarity.
+class DeepSeekVectorStore
+{
+public:
+    enum class Precision : quint32 { Float32 = 0, Int8 = 1 };
+
+    struct Entry
+    {
+        QString filePath;
+        int startLine = 0;
+        int lineCount = 0;
+        std::vector<float> vector;
+    };
+
+    struct Hit
+    {
+        QString filePath;
+        int startLine = 0;
+        int lineCount = 0;
+        float score = 0.0f;
+    };
+
+    // Registros por tarea de búsqueda
+    static constexpr qsizetype SearchBlockSize = 65536;
+
+    explicit DeepSeekVectorStore(const QString &filePath);
+    ~DeepSeekVectorStore();
+
+    // Abre o crea el almacén. Si el existente es de otro modelo o de otra
+    // precisión se vacía. La dimensión la fija el primer append().
+    bool open(const QString &model, Precision precision, QString *errorString = nullptr);
+    void close();
+    bool isOpen() const;
+
+    int dimension() const;
+    qsizetype count() const;
+
+    // modified: fecha del contenido del que salen los vectores de filePath.
+    // Sustituye los vectores anteriores del fichero.
+    bool replaceFile(const QString &filePath, const QDateTime &modified,
+                     const QList<Entry> &entries, QString *errorString = nullptr);
+    void removeFile(const QString &filePath);
+    // true si los vectores guardados corresponden a esa fecha
+    bool isCurrent(const QString &filePath, const QDateTime &modified) const;
+
+    QList<Hit> search(const std::vector<float> &query, int limit) const;
+
+private:
+    struct RecordHeader;
+
+    bool resetLocked(QString *errorString);
+    bool writeHeaderLocked(QString *errorString);
+    bool mapLocked(QString *errorString);
+    void unmapLocked();
+    bool compactLocked(QString *errorString);
+    bool compactPathsLocked(QString *errorString);
+    bool needsCompaction() const;
+    bool appendPathLocked(quint32 id, const QString &filePath, const QDateTime &modified,
+                          QString *errorString);
+    void removeFileLocked(const QString &filePath);
+
+    qsizetype payloadSize() const;
+    qsizetype recordSize() const { return qsizetype(16) + payloadSize(); }
+    RecordHeader *recordAt(qsizetype index) const;
+    QString pathsFilePath() const { return m_filePath + ".paths"; }
+
+    mutable QReadWriteLock m_lock;
+    QString m_filePath;
+    QFile m_file;
+    uchar *m_map = nullptr;
+    qint64 m_mapSize = 0;
+    Precision m_precision = Precision::Float32;
+    quint32 m_modelHash = 0;
+    int m_dimension = 0;
+    qsizetype m_count = 0;   // registros en el fichero, vivos o no
+    qsizetype m_live = 0;
+    qsizetype m_pathLines = 0; // líneas del .paths, con las ya sustituidas
+
+    QStringList m_paths;                 // id -> ruta
+    QHash<QString, quint32> m_pathIds;
+    QHash<quint32, QDateTime> m_modified;
+    QHash<quint32, std::vector<quint32>> m_fileRecords;
+};
+
+} // namespace DeepSeek